@@ -1,5 +1,6 @@
 #include "config.h"
 
+#include <algorithm>
 #include <chrono>
 #include <ctime>
 #include <iomanip>
@@ -57,6 +58,13 @@ bool ValidateTLPageFillPct(const char* flagname, uint32_t pct) {
   return false;
 }
 
+bool ValidateFraction(const char* flagname, double value) {
+  if (value >= 0.0 && value <= 1.0) return true;
+  std::cerr << "ERROR: --" << flagname << " must be between 0 and 1 inclusive."
+            << std::endl;
+  return false;
+}
+
 }  // namespace
 
 DEFINE_string(db, "all",
@@ -118,6 +126,17 @@ DEFINE_uint32(latency_sample_period, 1,
               "measure latency every N-th request).");
 DEFINE_validator(latency_sample_period, &EnsureNonZero);
 
+DEFINE_bool(perf_counters, false,
+            "If set, hardware performance counters will be measured on each "
+            "worker thread (per workload phase) and written to "
+            "`perf_counters.csv` in the output directory.");
+
+DEFINE_string(capture_trace, "",
+              "If set, TreeLine and PGTreeLine will record the operations "
+              "issued against them (type, key, value size, scan length, and "
+              "timestamp) to a binary trace file at this path. The trace can "
+              "be re-issued using `replay_trace`.");
+
 DEFINE_uint32(rdb_bloom_bits, 0,
               "The number of bloom filter bits to use in RocksDB. Set to 0 to "
               "disable the use of bloom filters.");
@@ -136,6 +155,14 @@ DEFINE_uint64(reorg_length, 5,
 DEFINE_uint64(records_per_page_goal, 44, "Page grouping fill rate goal.");
 DEFINE_double(records_per_page_epsilon, 5,
               "Page grouping model error tolerance.");
+DEFINE_bool(pg_compress_pages, false,
+            "If set, pages that cannot hold their records in the regular "
+            "format are compressed when they are written by bulk loads and "
+            "reorganizations. Use with a larger --records_per_page_goal.");
+DEFINE_uint64(pg_delta_pages_per_segment, 0,
+              "If set to N > 0, records that do not fit on their page are "
+              "appended to a per-segment delta log of up to N pages instead "
+              "of to overflow pages.");
 DEFINE_bool(pg_use_segments, true,
             "If set to false, all segments will be a single page (emulates not "
             "using page grouping).");
@@ -143,10 +170,63 @@ DEFINE_bool(
     pg_use_memory_based_io, false,
     "If set, PGTreeLine will use memory-based I/O (only meant for setup; "
     "not for use during evaluation).");
+DEFINE_bool(pg_use_simulated_device, false,
+            "If set, PGTreeLine will keep its pages in memory and delay each "
+            "I/O based on a model of a storage device (see the "
+            "--pg_sim_* flags).");
+DEFINE_uint64(pg_sim_read_latency_us, 80,
+              "The simulated device's read latency (in microseconds).");
+DEFINE_uint64(pg_sim_write_latency_us, 20,
+              "The simulated device's write latency (in microseconds).");
+DEFINE_uint64(pg_sim_read_bandwidth_mib, 2500,
+              "The simulated device's read bandwidth in MiB/s (0 means "
+              "unlimited).");
+DEFINE_uint64(pg_sim_write_bandwidth_mib, 1500,
+              "The simulated device's write bandwidth in MiB/s (0 means "
+              "unlimited).");
+DEFINE_uint64(pg_sim_queue_depth, 64,
+              "The number of requests the simulated device serves "
+              "concurrently (0 means unlimited).");
+DEFINE_bool(pg_use_in_memory_storage, false,
+            "If set, PGTreeLine will store its segments in anonymous memory "
+            "instead of files. The DB's contents are not persisted.");
+DEFINE_bool(pg_in_memory_use_huge_pages, false,
+            "If set, PGTreeLine's in-memory storage will be backed by "
+            "transparent huge pages.");
+DEFINE_string(pg_capacity_tier_path, "",
+              "If set, PGTreeLine will move cold segments into segment files "
+              "stored in this directory (e.g., on a slower, cheaper device).");
+DEFINE_uint64(pg_migration_interval_ms, 1000,
+              "How often PGTreeLine looks for cold segments to move to the "
+              "capacity tier (in milliseconds).");
+DEFINE_uint64(pg_cold_access_threshold, 0,
+              "A segment is moved to the capacity tier if it had at most "
+              "this many accesses since the previous migration pass.");
+DEFINE_uint64(pg_scrub_interval_ms, 0,
+              "How long PGTreeLine's background scrubber waits between passes "
+              "over the DB (in milliseconds). Set to 0 to disable the "
+              "scrubber.");
+DEFINE_uint64(pg_scrub_max_pages_per_sec, 1024,
+              "The maximum rate at which PGTreeLine's background scrubber "
+              "reads pages (0 means no limit).");
 DEFINE_bool(
     pg_bypass_cache, false,
     "If set, PGTreeLine will bypass the record cache. All requests will "
     "incur I/O.");
+DEFINE_double(pg_page_cache_fraction, 0.0,
+              "The fraction of `--cache_size_mib` that PGTreeLine should use "
+              "for its page cache (the rest is used for the record cache).");
+DEFINE_validator(pg_page_cache_fraction, &ValidateFraction);
+DEFINE_bool(pg_coalesce_page_reads, false,
+            "If set, concurrent point reads of the same page in PGTreeLine "
+            "share one I/O.");
+DEFINE_bool(pg_verify_page_checksums, true,
+            "If set, PGTreeLine will verify the checksum of each page it "
+            "reads.");
+DEFINE_bool(pg_persist_hot_keys, false,
+            "If set, PGTreeLine will save the keys of its hottest cached "
+            "records on shutdown and read them back into the record cache "
+            "in the background when it is reopened.");
 DEFINE_bool(pg_parallelize_final_flush, false,
             "If set, PGTreeLine will attempt to parallelize its flush of dirty "
             "records from the cache when it shuts down.");
@@ -162,10 +242,33 @@ DEFINE_bool(pg_disable_overflow_creation, false,
             "If set, PGTreeLine will not create any overflow pages. If a page "
             "becomes full, PGTreeLine will start a reorganization.");
 
+DEFINE_bool(pg_write_reorg_log, false,
+            "If set, PGTreeLine will append an entry for each reorganization "
+            "to `debug/reorg_log.csv` in the database directory.");
+DEFINE_uint64(pg_access_sample_interval, 0,
+              "If set to N > 0, PGTreeLine will record one out of every N "
+              "segment accesses in per-segment access counters.");
+DEFINE_bool(pg_write_access_heatmap, false,
+            "If set (and `pg_access_sample_interval` > 0), PGTreeLine will "
+            "write the per-segment access counters to "
+            "`debug/access_heatmap.csv` in the database directory when it "
+            "shuts down.");
+
 DEFINE_bool(rec_cache_batch_writeout, true,
             "If true, the record cache will try to batch writes for the same "
             "page when writing out a dirty entry.");
 
+DEFINE_bool(rec_cache_segment_writeout, false,
+            "If true (and `rec_cache_batch_writeout` is true), PGTreeLine's "
+            "record cache will write out all the dirty records in the evicted "
+            "record's segment instead of its page.");
+
+DEFINE_uint64(pg_deferred_io_batch_size, 1,
+              "PGTreeLine's record cache will defer writing out an evicted "
+              "dirty record if fewer than this many dirty records would be "
+              "written to its page. The number of deferrals per record is "
+              "bounded by `--max_deferrals`.");
+
 DEFINE_bool(optimistic_rec_caching, false,
             "If true, PGTreeLine and TreeLine will optimistically cache "
             "records present on a page that was read in, even if the record(s) "
@@ -292,6 +395,7 @@ tl::Options BuildTreeLineOptions() {
   options.rec_cache_batch_writeout = FLAGS_rec_cache_batch_writeout;
   options.optimistic_caching = FLAGS_optimistic_rec_caching;
   options.rec_cache_use_lru = FLAGS_rec_cache_use_lru;
+  options.trace_path = FLAGS_capture_trace;
   return options;
 }
 
@@ -300,19 +404,52 @@ tl::pg::PageGroupedDBOptions BuildPGTreeLineOptions() {
   options.use_segments = FLAGS_pg_use_segments;
   options.records_per_page_goal = FLAGS_records_per_page_goal;
   options.records_per_page_epsilon = FLAGS_records_per_page_epsilon;
+  options.compress_pages = FLAGS_pg_compress_pages;
+  options.delta_pages_per_segment = FLAGS_pg_delta_pages_per_segment;
   options.num_bg_threads = FLAGS_bg_threads;
+  // The cache memory is split between the page cache and the record cache.
   // Each record cache entry takes 96 bytes of space (metadata).
-  options.record_cache_capacity = (FLAGS_cache_size_mib * 1024ULL * 1024ULL) /
+  const uint64_t cache_bytes = FLAGS_cache_size_mib * 1024ULL * 1024ULL;
+  const uint64_t page_cache_bytes =
+      static_cast<uint64_t>(cache_bytes * FLAGS_pg_page_cache_fraction);
+  options.page_cache_pages = page_cache_bytes / tl::Page::kSize;
+  options.coalesce_page_reads = FLAGS_pg_coalesce_page_reads;
+  options.verify_page_checksums = FLAGS_pg_verify_page_checksums;
+  options.record_cache_capacity = (cache_bytes - page_cache_bytes) /
                                   (FLAGS_record_size_bytes + 96ULL);
   options.use_memory_based_io = FLAGS_pg_use_memory_based_io;
+  options.use_simulated_device = FLAGS_pg_use_simulated_device;
+  options.simulated_device.read_latency_us = FLAGS_pg_sim_read_latency_us;
+  options.simulated_device.write_latency_us = FLAGS_pg_sim_write_latency_us;
+  options.simulated_device.read_bandwidth_mib = FLAGS_pg_sim_read_bandwidth_mib;
+  options.simulated_device.write_bandwidth_mib =
+      FLAGS_pg_sim_write_bandwidth_mib;
+  options.simulated_device.queue_depth = FLAGS_pg_sim_queue_depth;
+  options.use_in_memory_storage = FLAGS_pg_use_in_memory_storage;
+  options.in_memory_use_huge_pages = FLAGS_pg_in_memory_use_huge_pages;
+  options.tiering.capacity_tier_path = FLAGS_pg_capacity_tier_path;
+  options.tiering.migration_interval_ms = FLAGS_pg_migration_interval_ms;
+  options.tiering.cold_access_threshold = FLAGS_pg_cold_access_threshold;
+  options.scrubber.interval_ms = FLAGS_pg_scrub_interval_ms;
+  options.scrubber.max_pages_per_second = FLAGS_pg_scrub_max_pages_per_sec;
   options.bypass_cache = FLAGS_pg_bypass_cache;
   options.rec_cache_batch_writeout = FLAGS_rec_cache_batch_writeout;
+  options.rec_cache_segment_writeout = FLAGS_rec_cache_segment_writeout;
+  options.deferred_io_batch_size = FLAGS_pg_deferred_io_batch_size;
+  // Saturate instead of truncating so that `Open()` rejects large values.
+  options.deferred_io_max_deferrals = static_cast<uint8_t>(
+      std::min<uint64_t>(FLAGS_max_deferrals, UINT8_MAX));
   options.parallelize_final_flush = FLAGS_pg_parallelize_final_flush;
+  options.persist_hot_keys = FLAGS_pg_persist_hot_keys;
   options.optimistic_caching = FLAGS_optimistic_rec_caching;
   options.rec_cache_use_lru = FLAGS_rec_cache_use_lru;
   options.use_pgm_builder = FLAGS_pg_use_pgm_builder;
   options.disable_overflow_creation = FLAGS_pg_disable_overflow_creation;
+  options.write_reorg_log = FLAGS_pg_write_reorg_log;
+  options.access_sample_interval = FLAGS_pg_access_sample_interval;
+  options.write_access_heatmap = FLAGS_pg_write_access_heatmap;
   options.rewrite_search_radius = FLAGS_pg_rewrite_search_radius;
+  options.trace_path = FLAGS_capture_trace;
 
   options.forecasting.use_insert_forecasting = FLAGS_use_insert_forecasting;
   options.forecasting.num_inserts_per_epoch = FLAGS_num_inserts_per_epoch;
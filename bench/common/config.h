@@ -71,6 +71,15 @@ DECLARE_bool(verbose);
 // every N-th request).
 DECLARE_uint32(latency_sample_period);
 
+// If true, the benchmark will measure hardware performance counters (cycles,
+// instructions, LLC misses, branch misses, context switches) on each worker
+// thread and write them to `perf_counters.csv` in the output directory.
+DECLARE_bool(perf_counters);
+
+// If non-empty, TreeLine and PGTreeLine will record the operations issued
+// against them to a binary trace file at this path (see `replay_trace`).
+DECLARE_string(capture_trace);
+
 // The minimum length of an overflow chain for which reorganization is
 // triggered.
 DECLARE_uint64(reorg_length);
@@ -88,9 +97,37 @@ DECLARE_uint32(rdb_prefix_bloom_size);
 DECLARE_bool(pg_use_segments);
 DECLARE_uint64(records_per_page_goal);
 DECLARE_double(records_per_page_epsilon);
+DECLARE_bool(pg_compress_pages);
+DECLARE_uint64(pg_delta_pages_per_segment);
 DECLARE_bool(pg_use_memory_based_io);
+
+// Used to simulate a storage device with the given performance
+// characteristics (see `pg::SimulatedDeviceOptions`).
+DECLARE_bool(pg_use_simulated_device);
+DECLARE_uint64(pg_sim_read_latency_us);
+DECLARE_uint64(pg_sim_write_latency_us);
+DECLARE_uint64(pg_sim_read_bandwidth_mib);
+DECLARE_uint64(pg_sim_write_bandwidth_mib);
+DECLARE_uint64(pg_sim_queue_depth);
+DECLARE_bool(pg_use_in_memory_storage);
+DECLARE_bool(pg_in_memory_use_huge_pages);
+
+// Used to store cold segments on a second storage tier (see
+// `pg::TieringOptions`).
+DECLARE_string(pg_capacity_tier_path);
+DECLARE_uint64(pg_migration_interval_ms);
+DECLARE_uint64(pg_cold_access_threshold);
+
+// Options for PGTreeLine's background scrubber (see `pg::ScrubberOptions`).
+DECLARE_uint64(pg_scrub_interval_ms);
+DECLARE_uint64(pg_scrub_max_pages_per_sec);
+
 DECLARE_bool(pg_bypass_cache);
 DECLARE_bool(pg_parallelize_final_flush);
+DECLARE_double(pg_page_cache_fraction);
+DECLARE_bool(pg_coalesce_page_reads);
+DECLARE_bool(pg_verify_page_checksums);
+DECLARE_bool(pg_persist_hot_keys);
 DECLARE_uint32(pg_rewrite_search_radius);
 
 // If set, PGTreeLine will use the PGM piecewise linear regression algorithm for
@@ -101,9 +138,21 @@ DECLARE_bool(pg_use_pgm_builder);
 // full, PGTreeLine will start a reorganization.
 DECLARE_bool(pg_disable_overflow_creation);
 
+// If set, PGTreeLine will append an entry for each reorganization to
+// `debug/reorg_log.csv` in the database directory.
+DECLARE_bool(pg_write_reorg_log);
+
+// If set to N > 0, PGTreeLine will record one out of every N segment accesses
+// in per-segment access counters. If `pg_write_access_heatmap` is also set, the
+// counters are written to `debug/access_heatmap.csv` on shutdown.
+DECLARE_uint64(pg_access_sample_interval);
+DECLARE_bool(pg_write_access_heatmap);
+
 // If true, the record cache will try to batch writes for the same page when
 // writing out a dirty entry.
 DECLARE_bool(rec_cache_batch_writeout);
+DECLARE_bool(rec_cache_segment_writeout);
+DECLARE_uint64(pg_deferred_io_batch_size);
 
 // If true, PGTreeLine and TreeLine will optimistically cache records
 // present on a page that was read in, even if the record(s) were not
@@ -0,0 +1,331 @@
+#include "key_distributions.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace {
+
+using namespace tl::bench;
+
+// Used to give up on key sets that cannot be generated (e.g., when the
+// distribution is too narrow for the requested number of unique keys).
+constexpr size_t kMaxAttemptsPerKey = 100;
+
+void CheckKeyRange(const uint64_t min_key, const uint64_t max_key,
+                   const size_t num_keys) {
+  if (min_key > max_key) {
+    throw std::invalid_argument("The minimum key must not exceed the maximum.");
+  }
+  if (num_keys > 0 && max_key - min_key < num_keys - 1) {
+    throw std::invalid_argument(
+        "The key range is too small for the requested number of keys.");
+  }
+}
+
+// Draws keys from `sampler` until `num_keys` unique keys have been generated.
+// The sampler returns an empty optional if a draw should be discarded.
+template <typename Sampler>
+std::vector<uint64_t> SampleUnique(const size_t num_keys, Sampler&& sampler) {
+  std::unordered_set<uint64_t> keys;
+  keys.reserve(num_keys);
+  const size_t max_attempts = num_keys * kMaxAttemptsPerKey;
+  for (size_t attempts = 0; keys.size() < num_keys; ++attempts) {
+    if (attempts >= max_attempts) {
+      throw std::invalid_argument(
+          "Failed to generate enough unique keys. The distribution is too "
+          "narrow for the requested number of keys.");
+    }
+    const std::optional<uint64_t> key = sampler();
+    if (key.has_value()) keys.insert(*key);
+  }
+  std::vector<uint64_t> results(keys.begin(), keys.end());
+  std::sort(results.begin(), results.end());
+  return results;
+}
+
+// Maps `fraction` (in [0, 1)) onto the key range.
+uint64_t ScaleToRange(const double fraction, const uint64_t min_key,
+                      const uint64_t max_key) {
+  const double span = static_cast<double>(max_key - min_key);
+  const uint64_t offset = static_cast<uint64_t>(fraction * span);
+  return min_key + std::min(offset, max_key - min_key);
+}
+
+// Selects an item in [0, num_items) with probability proportional to
+// 1 / (rank + 1)^theta.
+class ZipfSampler {
+ public:
+  ZipfSampler(const size_t num_items, const double theta) : cdf_(num_items) {
+    double total = 0.0;
+    for (size_t i = 0; i < num_items; ++i) {
+      total += 1.0 / std::pow(static_cast<double>(i + 1), theta);
+      cdf_[i] = total;
+    }
+    for (auto& val : cdf_) {
+      val /= total;
+    }
+  }
+
+  size_t operator()(std::mt19937_64& prng) {
+    const double u = dist_(prng);
+    const auto it = std::lower_bound(cdf_.begin(), cdf_.end(), u);
+    return std::min<size_t>(it - cdf_.begin(), cdf_.size() - 1);
+  }
+
+ private:
+  std::vector<double> cdf_;
+  std::uniform_real_distribution<double> dist_;
+};
+
+std::vector<uint64_t> GenerateUniform(const size_t num_keys,
+                                      const KeyGenOptions& options,
+                                      std::mt19937_64& prng) {
+  std::uniform_int_distribution<uint64_t> dist(options.min_key,
+                                               options.max_key);
+  return SampleUnique(num_keys,
+                      [&]() -> std::optional<uint64_t> { return dist(prng); });
+}
+
+std::vector<uint64_t> GenerateClustered(const size_t num_keys,
+                                        const KeyGenOptions& options,
+                                        std::mt19937_64& prng) {
+  if (options.num_clusters == 0) {
+    throw std::invalid_argument("The number of clusters must be positive.");
+  }
+  std::uniform_int_distribution<uint64_t> center_dist(options.min_key,
+                                                      options.max_key);
+  std::vector<double> centers(options.num_clusters);
+  for (auto& center : centers) {
+    center = static_cast<double>(center_dist(prng));
+  }
+  const double stddev = std::max(
+      1.0, options.cluster_stddev_fraction *
+               static_cast<double>(options.max_key - options.min_key));
+  std::uniform_int_distribution<size_t> cluster_dist(0, centers.size() - 1);
+  std::normal_distribution<double> offset_dist(0.0, stddev);
+  const double min_key = static_cast<double>(options.min_key);
+  const double max_key = static_cast<double>(options.max_key);
+  return SampleUnique(num_keys, [&]() -> std::optional<uint64_t> {
+    const double key =
+        std::round(centers[cluster_dist(prng)] + offset_dist(prng));
+    if (key < min_key || key > max_key) return std::optional<uint64_t>();
+    return static_cast<uint64_t>(key);
+  });
+}
+
+std::vector<uint64_t> GeneratePiecewiseDense(const size_t num_keys,
+                                             const KeyGenOptions& options,
+                                             std::mt19937_64& prng) {
+  if (options.num_runs == 0 || options.max_run_step == 0) {
+    throw std::invalid_argument(
+        "The number of runs and the maximum run step must be positive.");
+  }
+  const size_t num_runs = std::min(options.num_runs, num_keys);
+  const uint64_t region_size =
+      std::max<uint64_t>(1, (options.max_key - options.min_key) / num_runs);
+  std::uniform_int_distribution<uint64_t> step_dist(1, options.max_run_step);
+
+  std::vector<uint64_t> keys;
+  keys.reserve(num_keys);
+  for (size_t run = 0; run < num_runs; ++run) {
+    const uint64_t run_keys =
+        num_keys / num_runs + (run < num_keys % num_runs ? 1 : 0);
+    if (run_keys > region_size) {
+      throw std::invalid_argument(
+          "The key range is too small for the requested number of keys.");
+    }
+    uint64_t step = step_dist(prng);
+    if (run_keys > 1) {
+      step = std::min(step, (region_size - 1) / (run_keys - 1));
+    }
+    const uint64_t run_span = (run_keys - 1) * step + 1;
+    std::uniform_int_distribution<uint64_t> offset_dist(
+        0, region_size - run_span);
+    const uint64_t run_start =
+        options.min_key + run * region_size + offset_dist(prng);
+    for (uint64_t i = 0; i < run_keys; ++i) {
+      keys.push_back(run_start + i * step);
+    }
+  }
+  return keys;
+}
+
+std::vector<uint64_t> GenerateLognormal(const size_t num_keys,
+                                        const KeyGenOptions& options,
+                                        std::mt19937_64& prng) {
+  std::lognormal_distribution<double> dist(options.lognormal_mu,
+                                           options.lognormal_sigma);
+  // Samples are scaled so that the key range covers all but the top ~0.0001%
+  // of the distribution (the normal distribution's 1 - 1e-6 quantile is about
+  // 4.75 standard deviations above its mean). Larger samples are discarded.
+  const double cap =
+      std::exp(options.lognormal_mu + 4.75 * options.lognormal_sigma);
+  return SampleUnique(num_keys, [&]() -> std::optional<uint64_t> {
+    const double sample = dist(prng);
+    if (sample >= cap) return std::optional<uint64_t>();
+    return ScaleToRange(sample / cap, options.min_key, options.max_key);
+  });
+}
+
+std::vector<uint64_t> GenerateZipfHotspot(const size_t num_keys,
+                                          const KeyGenOptions& options,
+                                          std::mt19937_64& prng) {
+  if (options.num_buckets == 0) {
+    throw std::invalid_argument("The number of buckets must be positive.");
+  }
+  const uint64_t bucket_size =
+      (options.max_key - options.min_key) / options.num_buckets + 1;
+  // Scatter the hot buckets across the key range.
+  std::vector<size_t> bucket_for_rank(options.num_buckets);
+  std::iota(bucket_for_rank.begin(), bucket_for_rank.end(), 0);
+  std::shuffle(bucket_for_rank.begin(), bucket_for_rank.end(), prng);
+
+  ZipfSampler zipf(options.num_buckets, options.zipf_theta);
+  std::uniform_int_distribution<uint64_t> offset_dist(0, bucket_size - 1);
+  return SampleUnique(num_keys, [&]() -> std::optional<uint64_t> {
+    const uint64_t bucket = bucket_for_rank[zipf(prng)];
+    const uint64_t offset = bucket * bucket_size + offset_dist(prng);
+    if (offset > options.max_key - options.min_key) {
+      return std::optional<uint64_t>();
+    }
+    return options.min_key + offset;
+  });
+}
+
+std::vector<uint64_t> GenerateTimeSeries(const size_t num_keys,
+                                         const KeyGenOptions& options,
+                                         std::mt19937_64& prng) {
+  // Keys are always at least 1 apart, so the extra interval has a mean of
+  // `mean_interval - 1`.
+  std::exponential_distribution<double> interval_dist(
+      1.0 / std::max(options.mean_interval - 1.0, 1e-9));
+  std::exponential_distribution<double> gap_dist(
+      1.0 / std::max(options.mean_gap, 1e-9));
+  std::bernoulli_distribution has_gap(options.gap_probability);
+
+  std::vector<uint64_t> keys;
+  keys.reserve(num_keys);
+  uint64_t next_key = options.min_key;
+  for (size_t i = 0; i < num_keys; ++i) {
+    keys.push_back(next_key);
+    if (i + 1 == num_keys) break;
+
+    double advance = 1.0;
+    if (options.mean_interval > 1.0) advance += interval_dist(prng);
+    if (has_gap(prng)) advance += gap_dist(prng);
+    const double remaining = static_cast<double>(options.max_key - next_key);
+    if (advance > remaining) {
+      throw std::invalid_argument(
+          "The key range is too small for the requested time series.");
+    }
+    next_key += static_cast<uint64_t>(advance);
+  }
+  return keys;
+}
+
+}  // namespace
+
+namespace tl {
+namespace bench {
+
+std::optional<KeyDistribution> ParseKeyDistribution(const std::string& name) {
+  if (name == "uniform") {
+    return KeyDistribution::kUniform;
+  } else if (name == "clustered") {
+    return KeyDistribution::kClustered;
+  } else if (name == "piecewise_dense") {
+    return KeyDistribution::kPiecewiseDense;
+  } else if (name == "lognormal") {
+    return KeyDistribution::kLognormal;
+  } else if (name == "zipf_hotspot") {
+    return KeyDistribution::kZipfHotspot;
+  } else if (name == "time_series") {
+    return KeyDistribution::kTimeSeries;
+  } else {
+    return std::optional<KeyDistribution>();
+  }
+}
+
+std::vector<uint64_t> GenerateKeys(const KeyDistribution dist,
+                                   const size_t num_keys,
+                                   const KeyGenOptions& options) {
+  CheckKeyRange(options.min_key, options.max_key, num_keys);
+  if (num_keys == 0) return std::vector<uint64_t>();
+
+  std::mt19937_64 prng(options.rng_seed);
+  switch (dist) {
+    case KeyDistribution::kUniform:
+      return GenerateUniform(num_keys, options, prng);
+    case KeyDistribution::kClustered:
+      return GenerateClustered(num_keys, options, prng);
+    case KeyDistribution::kPiecewiseDense:
+      return GeneratePiecewiseDense(num_keys, options, prng);
+    case KeyDistribution::kLognormal:
+      return GenerateLognormal(num_keys, options, prng);
+    case KeyDistribution::kZipfHotspot:
+      return GenerateZipfHotspot(num_keys, options, prng);
+    case KeyDistribution::kTimeSeries:
+      return GenerateTimeSeries(num_keys, options, prng);
+  }
+  throw std::invalid_argument("Unknown key distribution.");
+}
+
+std::vector<uint64_t> GenerateShiftingHotspotInserts(
+    const std::vector<uint64_t>& existing_keys, const size_t num_inserts,
+    const InsertStreamOptions& options) {
+  CheckKeyRange(options.min_key, options.max_key,
+                num_inserts + existing_keys.size());
+  if (options.num_phases == 0) {
+    throw std::invalid_argument("The number of phases must be positive.");
+  }
+  std::mt19937_64 prng(options.rng_seed);
+
+  const uint64_t span = options.max_key - options.min_key;
+  const uint64_t hot_range_size = std::max<uint64_t>(
+      1, static_cast<uint64_t>(options.hot_range_fraction *
+                               static_cast<double>(span)));
+  std::uniform_int_distribution<uint64_t> hot_start_dist(
+      options.min_key, options.max_key - std::min(hot_range_size - 1, span));
+  std::uniform_int_distribution<uint64_t> uniform_dist(options.min_key,
+                                                       options.max_key);
+  std::bernoulli_distribution is_hot(options.hot_insert_fraction);
+
+  std::vector<uint64_t> inserts;
+  inserts.reserve(num_inserts);
+  std::unordered_set<uint64_t> generated;
+  generated.reserve(num_inserts);
+  for (size_t phase = 0; phase < options.num_phases; ++phase) {
+    const size_t phase_inserts =
+        num_inserts / options.num_phases +
+        (phase < num_inserts % options.num_phases ? 1 : 0);
+    const uint64_t hot_start = hot_start_dist(prng);
+    std::uniform_int_distribution<uint64_t> hot_dist(
+        hot_start, hot_start + (hot_range_size - 1));
+
+    const size_t max_attempts = phase_inserts * kMaxAttemptsPerKey;
+    size_t attempts = 0;
+    for (size_t i = 0; i < phase_inserts; ++attempts) {
+      if (attempts >= max_attempts) {
+        throw std::invalid_argument(
+            "Failed to generate enough unique inserts. The hot range is too "
+            "small for the requested number of inserts.");
+      }
+      const uint64_t key = is_hot(prng) ? hot_dist(prng) : uniform_dist(prng);
+      if (std::binary_search(existing_keys.begin(), existing_keys.end(),
+                             key) ||
+          !generated.insert(key).second) {
+        continue;
+      }
+      inserts.push_back(key);
+      ++i;
+    }
+  }
+  return inserts;
+}
+
+}  // namespace bench
+}  // namespace tl
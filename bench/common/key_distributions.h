@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace tl {
+namespace bench {
+
+// Built-in synthetic key distributions. These are meant to mimic the shapes of
+// real-world key sets (e.g., auto-incremented IDs, timestamps) without needing
+// to ship large dataset files.
+enum class KeyDistribution {
+  // Keys are drawn uniformly from the key range.
+  kUniform,
+  // Keys are normally distributed around a number of uniformly placed cluster
+  // centers.
+  kClustered,
+  // The key range is split into equally sized regions. Each region holds one
+  // run of evenly spaced keys (the spacing differs between runs), separated
+  // from the next run by an empty gap.
+  kPiecewiseDense,
+  // Keys follow a lognormal distribution (most keys are near the start of the
+  // key range, with a long tail).
+  kLognormal,
+  // The key range is split into equally sized buckets. Buckets are selected
+  // using a Zipf distribution and keys are drawn uniformly from the selected
+  // bucket. The hot buckets are scattered across the key range.
+  kZipfHotspot,
+  // Ascending "timestamps" with exponentially distributed inter-arrival times
+  // and occasional large gaps (e.g., an outage in a time series).
+  kTimeSeries,
+};
+
+// Parses a distribution name (e.g., "zipf_hotspot"). Returns an empty optional
+// if the name is not recognized.
+std::optional<KeyDistribution> ParseKeyDistribution(const std::string& name);
+
+// Options used to configure the generated key set. The distribution-specific
+// options are ignored by the other distributions.
+struct KeyGenOptions {
+  // The generated keys will be in the range [min_key, max_key].
+  uint64_t min_key = 1;
+  uint64_t max_key = 2000000000;
+  uint32_t rng_seed = 42;
+
+  // `kClustered`: The cluster standard deviation is specified as a fraction of
+  // the key range.
+  size_t num_clusters = 100;
+  double cluster_stddev_fraction = 0.001;
+
+  // `kPiecewiseDense`: The spacing between keys in a run is selected uniformly
+  // from [1, max_run_step].
+  size_t num_runs = 1000;
+  uint64_t max_run_step = 4;
+
+  // `kLognormal`: The parameters of the underlying normal distribution.
+  double lognormal_mu = 0.0;
+  double lognormal_sigma = 2.0;
+
+  // `kZipfHotspot`
+  size_t num_buckets = 1000;
+  double zipf_theta = 0.99;
+
+  // `kTimeSeries`: A gap is inserted before a key with probability
+  // `gap_probability`.
+  double mean_interval = 10.0;
+  double gap_probability = 0.0001;
+  double mean_gap = 1000000.0;
+};
+
+// Generates `num_keys` unique keys drawn from `dist`. The keys are returned in
+// ascending order.
+//
+// This function throws `std::invalid_argument` if the requested keys do not
+// fit in the key range.
+std::vector<uint64_t> GenerateKeys(KeyDistribution dist, size_t num_keys,
+                                   const KeyGenOptions& options);
+
+// Options used to configure a generated insert stream.
+struct InsertStreamOptions {
+  // The generated keys will be in the range [min_key, max_key].
+  uint64_t min_key = 1;
+  uint64_t max_key = 2000000000;
+  uint32_t rng_seed = 42;
+
+  // The stream is split into `num_phases` equally sized phases. Each phase
+  // selects a new hot range, sized as a fraction of the key range.
+  size_t num_phases = 10;
+  double hot_range_fraction = 0.01;
+  // The fraction of a phase's inserts that go to its hot range. The rest are
+  // drawn uniformly from the key range.
+  double hot_insert_fraction = 0.9;
+};
+
+// Generates an insert stream of `num_inserts` unique keys whose hot range
+// shifts over time. None of the generated keys will be in `existing_keys`,
+// which must be sorted. The keys are returned in insert order.
+//
+// This function throws `std::invalid_argument` if the requested keys do not
+// fit in the key range.
+std::vector<uint64_t> GenerateShiftingHotspotInserts(
+    const std::vector<uint64_t>& existing_keys, size_t num_inserts,
+    const InsertStreamOptions& options);
+
+}  // namespace bench
+}  // namespace tl
@@ -0,0 +1,197 @@
+#include "perf_counters.h"
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <iostream>
+#include <map>
+
+namespace {
+
+using namespace tl::bench;
+
+int OpenCounter(const uint32_t type, const uint64_t config,
+                const bool exclude_kernel) {
+  perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = type;
+  attr.config = config;
+  attr.disabled = 1;
+  attr.exclude_kernel = exclude_kernel ? 1 : 0;
+  attr.exclude_hv = 1;
+  return syscall(SYS_perf_event_open, &attr, /*pid=*/0, /*cpu=*/-1,
+                 /*group_fd=*/-1, /*flags=*/0);
+}
+
+void PrintValues(std::ostream& out, const PerfCounterValues& values,
+                 const uint64_t ops) {
+  const auto per_op = [ops](const uint64_t value) {
+    return ops > 0 ? static_cast<double>(value) / ops : 0.0;
+  };
+  out << ops << "," << values.cycles << "," << values.instructions << ","
+      << values.llc_misses << "," << values.branch_misses << ","
+      << values.context_switches << "," << per_op(values.cycles) << ","
+      << per_op(values.instructions) << "," << per_op(values.llc_misses) << ","
+      << per_op(values.branch_misses) << "," << per_op(values.context_switches)
+      << std::endl;
+}
+
+}  // namespace
+
+namespace tl {
+namespace bench {
+
+PerfCounterValues& PerfCounterValues::operator+=(
+    const PerfCounterValues& other) {
+  cycles += other.cycles;
+  instructions += other.instructions;
+  llc_misses += other.llc_misses;
+  branch_misses += other.branch_misses;
+  context_switches += other.context_switches;
+  return *this;
+}
+
+PerfCounters::PerfCounters() {
+  // The hardware counters only count user-space events so that they can be
+  // opened under the default `perf_event_paranoid` setting. Context switches
+  // happen in the kernel, so that counter must include kernel events.
+  fds_[kCycles] = OpenCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES,
+                              /*exclude_kernel=*/true);
+  fds_[kInstructions] = OpenCounter(
+      PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, /*exclude_kernel=*/true);
+  fds_[kLLCMisses] = OpenCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES,
+                                 /*exclude_kernel=*/true);
+  fds_[kBranchMisses] = OpenCounter(
+      PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, /*exclude_kernel=*/true);
+  fds_[kContextSwitches] =
+      OpenCounter(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES,
+                  /*exclude_kernel=*/false);
+}
+
+PerfCounters::~PerfCounters() {
+  for (const int fd : fds_) {
+    if (fd >= 0) close(fd);
+  }
+}
+
+bool PerfCounters::AllAvailable() const {
+  for (const int fd : fds_) {
+    if (fd < 0) return false;
+  }
+  return true;
+}
+
+void PerfCounters::Start() {
+  for (const int fd : fds_) {
+    if (fd < 0) continue;
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+  }
+}
+
+PerfCounterValues PerfCounters::Stop() {
+  std::array<uint64_t, kNumEvents> raw;
+  for (size_t i = 0; i < kNumEvents; ++i) {
+    raw[i] = 0;
+    if (fds_[i] < 0) continue;
+    ioctl(fds_[i], PERF_EVENT_IOC_DISABLE, 0);
+    if (read(fds_[i], &raw[i], sizeof(uint64_t)) != sizeof(uint64_t)) {
+      raw[i] = 0;
+    }
+  }
+  PerfCounterValues values;
+  values.cycles = raw[kCycles];
+  values.instructions = raw[kInstructions];
+  values.llc_misses = raw[kLLCMisses];
+  values.branch_misses = raw[kBranchMisses];
+  values.context_switches = raw[kContextSwitches];
+  return values;
+}
+
+thread_local PerfCounterCollector::ThreadState
+    PerfCounterCollector::thread_state_;
+
+PerfCounterCollector::PerfCounterCollector()
+    : next_worker_id_(0), warned_unavailable_(false) {}
+
+void PerfCounterCollector::BeginPhase(const std::string& phase) {
+  EndPhase();
+  ThreadState& state = thread_state_;
+  if (state.owner != this) {
+    state.owner = this;
+    state.worker_id = next_worker_id_.fetch_add(1);
+  }
+  state.counters = std::make_unique<PerfCounters>();
+  if (!state.counters->AllAvailable() &&
+      !warned_unavailable_.exchange(true)) {
+    std::cerr << "> WARNING: Some performance counters could not be opened "
+                 "(check /proc/sys/kernel/perf_event_paranoid). Their values "
+                 "will be reported as 0."
+              << std::endl;
+  }
+  state.phase = phase;
+  state.ops = 0;
+  state.counters->Start();
+}
+
+std::optional<std::string> PerfCounterCollector::EndPhase() {
+  ThreadState& state = thread_state_;
+  if (state.counters == nullptr || state.owner != this) {
+    return std::optional<std::string>();
+  }
+  const PerfCounterValues values = state.counters->Stop();
+  state.counters.reset();
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    results_.push_back(Result{state.phase, state.worker_id, state.ops, values});
+  }
+  state.ops = 0;
+  return std::move(state.phase);
+}
+
+bool PerfCounterCollector::HasResults() const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return !results_.empty();
+}
+
+void PerfCounterCollector::PrintAsCsv(std::ostream& out) const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  out << "phase,worker,ops,cycles,instructions,llc_misses,branch_misses,"
+         "context_switches,cycles_per_op,instructions_per_op,llc_misses_per_op,"
+         "branch_misses_per_op,context_switches_per_op"
+      << std::endl;
+
+  // A phase's totals are keyed by its name; totals are printed in name order.
+  std::map<std::string, std::pair<uint64_t, PerfCounterValues>> totals;
+  for (const auto& result : results_) {
+    out << result.phase << "," << result.worker_id << ",";
+    PrintValues(out, result.values, result.ops);
+    auto& total = totals[result.phase];
+    total.first += result.ops;
+    total.second += result.values;
+  }
+  for (const auto& [phase, total] : totals) {
+    out << phase << ",all,";
+    PrintValues(out, total.second, total.first);
+  }
+}
+
+PerfCounterCollector::ScopedPhase::ScopedPhase(PerfCounterCollector* collector,
+                                               const std::string& phase)
+    : collector_(collector), previous_phase_(collector->EndPhase()) {
+  collector_->BeginPhase(phase);
+}
+
+PerfCounterCollector::ScopedPhase::~ScopedPhase() {
+  collector_->EndPhase();
+  if (previous_phase_.has_value()) {
+    collector_->BeginPhase(*previous_phase_);
+  }
+}
+
+}  // namespace bench
+}  // namespace tl
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace tl {
+namespace bench {
+
+// Values read from the hardware (and software) performance counters. Counters
+// that are not supported on the current machine always read as 0.
+struct PerfCounterValues {
+  uint64_t cycles = 0;
+  uint64_t instructions = 0;
+  uint64_t llc_misses = 0;
+  uint64_t branch_misses = 0;
+  uint64_t context_switches = 0;
+
+  PerfCounterValues& operator+=(const PerfCounterValues& other);
+};
+
+// Measures the performance counters of the thread that created this object,
+// using `perf_event_open()`. The counters start out disabled.
+//
+// Counters that cannot be opened (e.g., because of the system's
+// `perf_event_paranoid` setting or because the machine is virtualized) are
+// skipped.
+class PerfCounters {
+ public:
+  PerfCounters();
+  ~PerfCounters();
+
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+
+  // Returns true iff all the counters could be opened.
+  bool AllAvailable() const;
+
+  // Resets and enables the counters.
+  void Start();
+
+  // Disables the counters and returns their values (since `Start()`).
+  PerfCounterValues Stop();
+
+ private:
+  enum Event : size_t {
+    kCycles = 0,
+    kInstructions = 1,
+    kLLCMisses = 2,
+    kBranchMisses = 3,
+    kContextSwitches = 4,
+    kNumEvents = 5,
+  };
+  std::array<int, kNumEvents> fds_;
+};
+
+// Collects performance counter values from each worker thread, split by
+// workload phase (e.g., "load" and "run"). Each thread can be in at most one
+// phase at a time.
+//
+// This class' methods are thread-safe.
+class PerfCounterCollector {
+ public:
+  PerfCounterCollector();
+
+  // Starts measuring the calling thread under `phase`. If the calling thread is
+  // already in a phase, that phase is ended first.
+  void BeginPhase(const std::string& phase);
+
+  // Ends the calling thread's current phase (if any) and records its counter
+  // values. Returns the name of the phase that was ended.
+  std::optional<std::string> EndPhase();
+
+  // Starts measuring the calling thread under `phase` unless the calling
+  // thread is already in a phase. Cheap enough to call on every operation.
+  void EnsurePhase(const std::string& phase) {
+    if (thread_state_.counters != nullptr && thread_state_.owner == this) {
+      return;
+    }
+    BeginPhase(phase);
+  }
+
+  // Counts `num_ops` operations towards the calling thread's current phase
+  // (used to normalize the counter values).
+  static void CountOps(uint64_t num_ops) { thread_state_.ops += num_ops; }
+
+  // Writes the recorded counter values as CSV: one row per thread and phase,
+  // followed by one row per phase with the totals across all threads
+  // (`worker` is set to "all"). Each counter is also reported per operation.
+  void PrintAsCsv(std::ostream& out) const;
+
+  // Returns true iff at least one phase has been recorded.
+  bool HasResults() const;
+
+  // Ends the calling thread's current phase (if any) on construction and
+  // starts `phase`. On destruction, ends `phase` and resumes the previously
+  // running phase (if any).
+  class ScopedPhase {
+   public:
+    ScopedPhase(PerfCounterCollector* collector, const std::string& phase);
+    ~ScopedPhase();
+
+   private:
+    PerfCounterCollector* collector_;
+    std::optional<std::string> previous_phase_;
+  };
+
+ private:
+  struct ThreadState {
+    // Set to `nullptr` when the thread is not in a phase.
+    std::unique_ptr<PerfCounters> counters;
+    std::string phase;
+    uint64_t ops = 0;
+    size_t worker_id = 0;
+    // The collector that assigned `worker_id` (worker IDs are only unique
+    // within a collector).
+    const PerfCounterCollector* owner = nullptr;
+  };
+
+  struct Result {
+    std::string phase;
+    size_t worker_id;
+    uint64_t ops;
+    PerfCounterValues values;
+  };
+
+  static thread_local ThreadState thread_state_;
+
+  std::atomic<size_t> next_worker_id_;
+  std::atomic<bool> warned_unavailable_;
+  mutable std::mutex mutex_;
+  std::vector<Result> results_;
+};
+
+}  // namespace bench
+}  // namespace tl
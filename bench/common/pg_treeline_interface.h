@@ -2,10 +2,12 @@
 
 #include <cstdint>
 #include <filesystem>
+#include <optional>
 #include <string>
 #include <thread>
 
 #include "config.h"
+#include "perf_counters.h"
 #include "treeline/pg_db.h"
 #include "treeline/pg_stats.h"
 #include "util/key.h"
@@ -20,6 +22,7 @@ class PGTreeLineInterface {
   }
 
   void ShutdownWorker(const std::thread::id& id) {
+    perf_counters_.EndPhase();
     tl::pg::PageGroupedDBStats::Local().PostToGlobal();
   }
 
@@ -36,11 +39,20 @@ class PGTreeLineInterface {
       out << "cache_misses," << stats.GetCacheMisses() << std::endl;
       out << "cache_clean_evictions," << stats.GetCacheCleanEvictions() << std::endl;
       out << "cache_dirty_evictions," << stats.GetCacheDirtyEvictions() << std::endl;
+      out << "cache_warmup_records," << stats.GetCacheWarmupRecords() << std::endl;
+      out << "cache_warmup_read_errors," << stats.GetCacheWarmupReadErrors() << std::endl;
+      out << "hot_keys_save_errors," << stats.GetHotKeysSaveErrors() << std::endl;
+      out << "cache_deferred_write_outs," << stats.GetCacheDeferredWriteOuts() << std::endl;
 
       out << "overflows_created," << stats.GetOverflowsCreated() << std::endl;
       out << "rewrites," << stats.GetRewrites() << std::endl;
       out << "rewrite_input_pages," << stats.GetRewriteInputPages() << std::endl;
       out << "rewrite_output_pages," << stats.GetRewriteOutputPages() << std::endl;
+      out << "pages_compressed," << stats.GetPagesCompressed() << std::endl;
+      out << "delta_pages_created," << stats.GetDeltaPagesCreated() << std::endl;
+      out << "delta_page_reads," << stats.GetDeltaPageReads() << std::endl;
+      out << "segments_migrated," << stats.GetSegmentsMigrated() << std::endl;
+      out << "pages_migrated," << stats.GetPagesMigrated() << std::endl;
 
       out << "segments," << stats.GetSegments() << std::endl;
       out << "segment_index_bytes," << stats.GetSegmentIndexBytes() << std::endl;
@@ -49,8 +61,29 @@ class PGTreeLineInterface {
       out << "cache_bytes," << stats.GetCacheBytes() << std::endl;
 
       out << "overfetched_pages," << stats.GetOverfetchedPages() << std::endl;
+      out << "page_cache_hits," << stats.GetPageCacheHits() << std::endl;
+      out << "page_cache_misses," << stats.GetPageCacheMisses() << std::endl;
+      out << "coalesced_page_reads," << stats.GetCoalescedPageReads()
+          << std::endl;
+
+      out << "pages_verified," << stats.GetPagesVerified() << std::endl;
+      out << "page_checksum_failures," << stats.GetPageChecksumFailures() << std::endl;
+      out << "scrubbed_segments," << stats.GetScrubbedSegments() << std::endl;
+      out << "scrubbed_pages," << stats.GetScrubbedPages() << std::endl;
+      out << "scrub_checksum_failures," << stats.GetScrubChecksumFailures() << std::endl;
+      out << "scrub_invariant_violations," << stats.GetScrubInvariantViolations() << std::endl;
+
+      out << "segment_lock_waits," << stats.GetSegmentLockWaits() << std::endl;
+      out << "page_lock_waits," << stats.GetPageLockWaits() << std::endl;
+      out << "reorg_reader_waits," << stats.GetReorgReaderWaits() << std::endl;
+      out << "write_retries," << stats.GetWriteRetries() << std::endl;
       // clang-format on
     });
+
+    if (perf_counters_.HasResults()) {
+      std::ofstream perf_out(out_dir / "perf_counters.csv");
+      perf_counters_.PrintAsCsv(perf_out);
+    }
   }
 
   // Called once before the benchmark.
@@ -101,6 +134,12 @@ class PGTreeLineInterface {
 
   // Load the records into the database.
   void BulkLoad(const ycsbr::BulkLoadTrace& load) {
+    std::optional<tl::bench::PerfCounterCollector::ScopedPhase> perf_phase;
+    if (FLAGS_perf_counters) {
+      perf_phase.emplace(&perf_counters_, "load");
+    }
+    tl::bench::PerfCounterCollector::CountOps(load.size());
+
     std::vector<tl::pg::Record> records;
     records.reserve(load.size());
     for (const auto& req : load) {
@@ -115,6 +154,8 @@ class PGTreeLineInterface {
 
   // Update the value at the specified key. Return true if the update succeeded.
   bool Update(ycsbr::Request::Key key, const char* value, size_t value_size) {
+    BeginRunPhase();
+    tl::bench::PerfCounterCollector::CountOps(1);
     tl::pg::WriteOptions options;
     options.is_update = true;
     return db_->Put(options, key, tl::Slice(value, value_size)).ok();
@@ -122,6 +163,8 @@ class PGTreeLineInterface {
 
   // Insert the specified key value pair. Return true if the insert succeeded.
   bool Insert(ycsbr::Request::Key key, const char* value, size_t value_size) {
+    BeginRunPhase();
+    tl::bench::PerfCounterCollector::CountOps(1);
     tl::pg::WriteOptions options;
     options.is_update = false;
     return db_->Put(options, key, tl::Slice(value, value_size)).ok();
@@ -129,6 +172,8 @@ class PGTreeLineInterface {
 
   // Read the value at the specified key. Return true if the read succeeded.
   bool Read(ycsbr::Request::Key key, std::string* value_out) {
+    BeginRunPhase();
+    tl::bench::PerfCounterCollector::CountOps(1);
     return db_->Get(key, value_out).ok();
   }
 
@@ -137,6 +182,8 @@ class PGTreeLineInterface {
   bool Scan(
       const ycsbr::Request::Key key, const size_t amount,
       std::vector<std::pair<ycsbr::Request::Key, std::string>>* scan_out) {
+    BeginRunPhase();
+    tl::bench::PerfCounterCollector::CountOps(1);
     return db_
         ->GetRange(key, amount, scan_out,
                    FLAGS_use_experimental_scan_prefetching)
@@ -144,6 +191,14 @@ class PGTreeLineInterface {
   }
 
  private:
+  // The "run" phase starts with a worker's first run operation, so that the
+  // worker that bulk loads the records reports one "load" and one "run" phase.
+  void BeginRunPhase() {
+    if (FLAGS_perf_counters) {
+      perf_counters_.EnsurePhase("run");
+    }
+  }
+
   // Returns a path to the PGTreeLine database checkpoint (used for
   // benchmarking).  This function helps with handling checkpoints saved using
   // the legacy name (pg_llsm).
@@ -162,4 +217,5 @@ class PGTreeLineInterface {
   }
 
   tl::pg::PageGroupedDB* db_;
+  tl::bench::PerfCounterCollector perf_counters_;
 };
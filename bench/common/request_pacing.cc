@@ -0,0 +1,67 @@
+#include "request_pacing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace tl {
+namespace bench {
+
+using Clock = std::chrono::steady_clock;
+
+void WaitUntil(const Clock::time_point target) {
+  constexpr auto kSpinThreshold = std::chrono::microseconds(50);
+  const auto now = Clock::now();
+  if (target - now > kSpinThreshold) {
+    std::this_thread::sleep_until(target - kSpinThreshold);
+  }
+  while (Clock::now() < target) {
+  }
+}
+
+StartBarrier::StartBarrier(const size_t num_workers)
+    : num_workers_(num_workers), num_ready_(0), started_(false) {}
+
+Clock::time_point StartBarrier::WorkerWait() {
+  ++num_ready_;
+  while (!started_.load(std::memory_order_acquire)) {
+  }
+  return start_;
+}
+
+Clock::time_point StartBarrier::Release() {
+  while (num_ready_.load() < num_workers_) {
+  }
+  // Leave time for the workers to observe the start signal.
+  start_ = Clock::now() + std::chrono::milliseconds(10);
+  started_.store(true, std::memory_order_release);
+  return start_;
+}
+
+LatencySummary LatencySummary::From(std::vector<uint64_t>* latencies_ns) {
+  LatencySummary summary;
+  auto& lat = *latencies_ns;
+  if (lat.empty()) return summary;
+  std::sort(lat.begin(), lat.end());
+  const auto percentile_us = [&lat](const double p) -> double {
+    const size_t idx = std::min(
+        lat.size() - 1, static_cast<size_t>(std::ceil(p * lat.size())) - 1);
+    return lat[idx] / 1000.0;
+  };
+  for (const auto l : lat) summary.mean_us += l / 1000.0;
+  summary.mean_us /= lat.size();
+  summary.p50_us = percentile_us(0.5);
+  summary.p99_us = percentile_us(0.99);
+  summary.p999_us = percentile_us(0.999);
+  summary.max_us = lat.back() / 1000.0;
+  return summary;
+}
+
+std::ostream& operator<<(std::ostream& out, const LatencySummary& summary) {
+  return out << summary.mean_us << "," << summary.p50_us << ","
+             << summary.p99_us << "," << summary.p999_us << ","
+             << summary.max_us;
+}
+
+}  // namespace bench
+}  // namespace tl
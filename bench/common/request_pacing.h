@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// Utilities shared by the benchmark drivers that issue requests on a schedule
+// and measure their latencies (`open_loop` and `replay_trace`).
+
+namespace tl {
+namespace bench {
+
+// Waits until `target`. Sleeps for most of the wait and spins for the rest to
+// keep the send times accurate.
+void WaitUntil(std::chrono::steady_clock::time_point target);
+
+// Starts a fixed number of worker threads at the same time.
+class StartBarrier {
+ public:
+  explicit StartBarrier(size_t num_workers);
+
+  // Called by each worker once it is ready to issue requests. Returns the
+  // common start time after `Release()` is called.
+  std::chrono::steady_clock::time_point WorkerWait();
+
+  // Waits until all the workers are ready and then releases them. Returns the
+  // common start time.
+  std::chrono::steady_clock::time_point Release();
+
+ private:
+  const size_t num_workers_;
+  std::atomic<size_t> num_ready_;
+  std::atomic<bool> started_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+// Summarizes request latencies, in microseconds.
+struct LatencySummary {
+  double mean_us = 0.0;
+  double p50_us = 0.0;
+  double p99_us = 0.0;
+  double p999_us = 0.0;
+  double max_us = 0.0;
+
+  // Computes the summary of `latencies_ns` (in nanoseconds). The latencies are
+  // sorted in place.
+  static LatencySummary From(std::vector<uint64_t>* latencies_ns);
+};
+
+// The CSV header for the columns written by `operator<<` below.
+constexpr char kLatencySummaryCSVHeader[] =
+    "mean_us,p50_us,p99_us,p999_us,max_us";
+
+// Writes `summary` as comma separated values.
+std::ostream& operator<<(std::ostream& out, const LatencySummary& summary);
+
+}  // namespace bench
+}  // namespace tl
@@ -0,0 +1,215 @@
+// Benchmarks for the page grouping engine's in-memory bookkeeping structures:
+// the `SegmentIndex`, the `LockManager`, and the `FreeList`.
+//
+// Build the benchmarks by enabling the `TL_BUILD_BENCHMARKS` option when
+// configuring the project. Then run the `pg_microbench` executable under
+// `bench`.
+//
+//   mkdir build && cd build
+//   cmake -DCMAKE_BUILD_TYPE=Release -DTL_BUILD_BENCHMARKS=ON ..
+//   make -j
+//   ./bench/microbench/pg_microbench --benchmark_filter=SegmentIndex*
+
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "page_grouping/free_list.h"
+#include "page_grouping/lock_manager.h"
+#include "page_grouping/persist/segment_id.h"
+#include "page_grouping/segment_index.h"
+
+namespace {
+
+using namespace tl;
+using namespace tl::pg;
+
+// Segments are spaced `kKeyGap` keys apart.
+constexpr Key kKeyGap = 1000;
+
+std::unique_ptr<SegmentIndex> CreateIndex(
+    const size_t num_segments, std::shared_ptr<LockManager> lock_manager) {
+  auto index = std::make_unique<SegmentIndex>(std::move(lock_manager));
+  std::vector<std::pair<Key, SegmentInfo>> entries;
+  entries.reserve(num_segments);
+  for (size_t i = 0; i < num_segments; ++i) {
+    entries.emplace_back(
+        i * kKeyGap,
+        SegmentInfo(SegmentId(/*file_id=*/0, /*offset=*/i), std::nullopt));
+  }
+  index->BulkLoadFromEmpty(entries.begin(), entries.end());
+  return index;
+}
+
+// Shared by all threads running a benchmark. Set up by thread 0 before the
+// timed loop starts (Google Benchmark synchronizes the threads at the start of
+// the loop).
+std::unique_ptr<SegmentIndex> shared_index;
+std::shared_ptr<LockManager> shared_lock_manager;
+std::unique_ptr<FreeList> shared_free_list;
+
+// Arguments: {number of segments in the index}
+void BM_SegmentIndexLookup(benchmark::State& state) {
+  const size_t num_segments = state.range(0);
+  if (state.thread_index() == 0) {
+    shared_index =
+        CreateIndex(num_segments, std::make_shared<LockManager>());
+  }
+  std::mt19937 prng(42 + state.thread_index());
+  std::uniform_int_distribution<Key> dist(0, num_segments * kKeyGap - 1);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(shared_index->SegmentForKey(dist(prng)));
+  }
+  state.SetItemsProcessed(state.iterations());
+
+  if (state.thread_index() == 0) {
+    shared_index.reset();
+  }
+}
+
+// Measures the lookup + segment lock acquire/release path used by reads.
+// Arguments: {number of segments in the index}
+void BM_SegmentIndexLookupWithLock(benchmark::State& state) {
+  const size_t num_segments = state.range(0);
+  if (state.thread_index() == 0) {
+    shared_lock_manager = std::make_shared<LockManager>();
+    shared_index = CreateIndex(num_segments, shared_lock_manager);
+  }
+  std::mt19937 prng(42 + state.thread_index());
+  std::uniform_int_distribution<Key> dist(0, num_segments * kKeyGap - 1);
+
+  for (auto _ : state) {
+    const auto entry = shared_index->SegmentForKeyWithLock(
+        dist(prng), LockManager::SegmentMode::kPageRead);
+    shared_lock_manager->ReleaseSegmentLock(
+        entry.sinfo.id(), LockManager::SegmentMode::kPageRead);
+  }
+  state.SetItemsProcessed(state.iterations());
+
+  if (state.thread_index() == 0) {
+    shared_index.reset();
+    shared_lock_manager.reset();
+  }
+}
+
+// Arguments: {number of distinct segments locked (1 means all threads contend
+// on the same lock)}
+void BM_LockManagerSegmentLock(benchmark::State& state) {
+  const size_t num_segments = state.range(0);
+  if (state.thread_index() == 0) {
+    shared_lock_manager = std::make_shared<LockManager>();
+  }
+  std::mt19937 prng(42 + state.thread_index());
+  std::uniform_int_distribution<size_t> dist(0, num_segments - 1);
+
+  for (auto _ : state) {
+    const SegmentId id(/*file_id=*/0, /*offset=*/dist(prng));
+    const bool acquired = shared_lock_manager->TryAcquireSegmentLock(
+        id, LockManager::SegmentMode::kPageRead);
+    if (acquired) {
+      shared_lock_manager->ReleaseSegmentLock(
+          id, LockManager::SegmentMode::kPageRead);
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+
+  if (state.thread_index() == 0) {
+    shared_lock_manager.reset();
+  }
+}
+
+// Arguments: {number of distinct pages locked (1 means all threads contend on
+// the same lock)}
+void BM_LockManagerPageLock(benchmark::State& state,
+                            const LockManager::PageMode mode) {
+  const size_t num_pages = state.range(0);
+  if (state.thread_index() == 0) {
+    shared_lock_manager = std::make_shared<LockManager>();
+  }
+  std::mt19937 prng(42 + state.thread_index());
+  std::uniform_int_distribution<size_t> dist(0, num_pages - 1);
+  const SegmentId id(/*file_id=*/4, /*offset=*/0);
+
+  for (auto _ : state) {
+    const size_t page_idx = dist(prng);
+    shared_lock_manager->AcquirePageLock(id, page_idx, mode);
+    shared_lock_manager->ReleasePageLock(id, page_idx, mode);
+  }
+  state.SetItemsProcessed(state.iterations());
+
+  if (state.thread_index() == 0) {
+    shared_lock_manager.reset();
+  }
+}
+
+// Measures a `Get()` followed by an `Add()` (i.e., a segment allocation that is
+// later freed by a reorganization).
+// Arguments: {number of entries initially in the free list}
+void BM_FreeListGetAdd(benchmark::State& state) {
+  const size_t num_entries = state.range(0);
+  if (state.thread_index() == 0) {
+    shared_free_list = std::make_unique<FreeList>();
+    std::vector<SegmentId> ids;
+    ids.reserve(num_entries);
+    for (size_t i = 0; i < num_entries; ++i) {
+      ids.emplace_back(/*file_id=*/i % 5, /*offset=*/i);
+    }
+    shared_free_list->AddBatch(ids);
+  }
+  std::mt19937 prng(42 + state.thread_index());
+  std::uniform_int_distribution<size_t> dist(0, 4);
+
+  for (auto _ : state) {
+    const size_t page_count = 1ULL << dist(prng);
+    const auto id = shared_free_list->Get(page_count);
+    if (id.has_value()) {
+      shared_free_list->Add(*id);
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+
+  if (state.thread_index() == 0) {
+    shared_free_list.reset();
+  }
+}
+
+BENCHMARK(BM_SegmentIndexLookup)
+    ->Arg(1 << 10)
+    ->Arg(1 << 20)
+    ->ThreadRange(1, 16)
+    ->UseRealTime();
+
+BENCHMARK(BM_SegmentIndexLookupWithLock)
+    ->Arg(1 << 20)
+    ->ThreadRange(1, 16)
+    ->UseRealTime();
+
+BENCHMARK(BM_LockManagerSegmentLock)
+    ->Arg(1)
+    ->Arg(1 << 16)
+    ->ThreadRange(1, 16)
+    ->UseRealTime();
+
+BENCHMARK_CAPTURE(BM_LockManagerPageLock, shared,
+                  LockManager::PageMode::kShared)
+    ->Arg(1)
+    ->Arg(16)
+    ->ThreadRange(1, 16)
+    ->UseRealTime();
+
+BENCHMARK_CAPTURE(BM_LockManagerPageLock, exclusive,
+                  LockManager::PageMode::kExclusive)
+    ->Arg(16)
+    ->ThreadRange(1, 16)
+    ->UseRealTime();
+
+BENCHMARK(BM_FreeListGetAdd)
+    ->Arg(1 << 10)
+    ->Arg(1 << 16)
+    ->ThreadRange(1, 16)
+    ->UseRealTime();
+
+}  // namespace
@@ -0,0 +1,198 @@
+// Benchmarks for the page grouping engine's on-disk page format (`pg::Page`),
+// including its checksums, and for the `PageMergeIterator` used during
+// reorganizations and scans.
+//
+// Build the benchmarks by enabling the `TL_BUILD_BENCHMARKS` option when
+// configuring the project. Then run the `pg_microbench` executable under
+// `bench`.
+//
+//   mkdir build && cd build
+//   cmake -DCMAKE_BUILD_TYPE=Release -DTL_BUILD_BENCHMARKS=ON ..
+//   make -j
+//   ./bench/microbench/pg_microbench --benchmark_filter=PGPage*
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "bufmgr/page_memory_allocator.h"
+#include "page_grouping/key.h"
+#include "page_grouping/persist/merge_iterator.h"
+#include "page_grouping/persist/page.h"
+#include "util/key.h"
+
+namespace {
+
+using namespace tl::pg;
+using tl::PageBuffer;
+using tl::PageMemoryAllocator;
+using tl::Slice;
+namespace key_utils = tl::key_utils;
+
+// Keys are spaced `kKeyGap` apart so that records can be "inserted" between
+// the existing records.
+constexpr Key kKeyGap = 10;
+
+// Returns the number of records that were written into the page.
+size_t FillPage(Page page, const size_t num_records,
+                const size_t value_size, const Key first_key) {
+  const std::string value(value_size, 0xFF);
+  size_t written = 0;
+  for (size_t i = 0; i < num_records; ++i) {
+    const key_utils::IntKeyAsSlice key(first_key + i * kKeyGap);
+    if (!page.Put(key.as<Slice>(), value).ok()) break;
+    ++written;
+  }
+  return written;
+}
+
+Page CreatePage(const PageBuffer& buf, const size_t page_idx) {
+  const key_utils::IntKeyAsSlice lower(0), upper(UINT64_MAX);
+  return Page(buf.get() + page_idx * Page::kSize, lower.as<Slice>(),
+              upper.as<Slice>());
+}
+
+// Arguments: {value size (bytes), number of records to insert}
+void BM_PGPagePut(benchmark::State& state, const bool shuffle) {
+  const size_t value_size = state.range(0);
+  const size_t num_records = state.range(1);
+  std::vector<Key> keys;
+  keys.reserve(num_records);
+  for (size_t i = 0; i < num_records; ++i) {
+    keys.push_back(i * kKeyGap);
+  }
+  if (shuffle) {
+    std::mt19937 prng(42);
+    std::shuffle(keys.begin(), keys.end(), prng);
+  }
+  const std::string value(value_size, 0xFF);
+  PageBuffer buf = PageMemoryAllocator::Allocate(/*num_pages=*/1);
+
+  size_t inserted = 0;
+  for (auto _ : state) {
+    Page page = CreatePage(buf, 0);
+    for (const Key k : keys) {
+      const key_utils::IntKeyAsSlice key(k);
+      if (!page.Put(key.as<Slice>(), value).ok()) break;
+      ++inserted;
+    }
+  }
+  state.SetItemsProcessed(inserted);
+}
+
+// Arguments: {value size (bytes), number of records in the page}
+void BM_PGPageGet(benchmark::State& state) {
+  const size_t value_size = state.range(0);
+  PageBuffer buf = PageMemoryAllocator::Allocate(/*num_pages=*/1);
+  Page page = CreatePage(buf, 0);
+  const size_t num_records =
+      FillPage(page, state.range(1), value_size, /*first_key=*/0);
+
+  std::mt19937 prng(42);
+  std::uniform_int_distribution<size_t> dist(0, num_records - 1);
+  std::string value_out;
+  for (auto _ : state) {
+    const key_utils::IntKeyAsSlice key(dist(prng) * kKeyGap);
+    benchmark::DoNotOptimize(page.Get(key.as<Slice>(), &value_out));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Arguments: {value size (bytes), number of records in the page}
+void BM_PGPageIterate(benchmark::State& state) {
+  const size_t value_size = state.range(0);
+  PageBuffer buf = PageMemoryAllocator::Allocate(/*num_pages=*/1);
+  Page page = CreatePage(buf, 0);
+  const size_t num_records =
+      FillPage(page, state.range(1), value_size, /*first_key=*/0);
+
+  for (auto _ : state) {
+    for (auto it = page.GetIterator(); it.Valid(); it.Next()) {
+      benchmark::DoNotOptimize(it.key());
+      benchmark::DoNotOptimize(it.value());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * num_records);
+}
+
+// Merges a main page with its overflow page(s) (the keys are interleaved).
+// Arguments: {number of pages to merge, number of records per page}
+void BM_PGPageMergeIterator(benchmark::State& state) {
+  const size_t num_pages = state.range(0);
+  const size_t records_per_page = state.range(1);
+  constexpr size_t kValueSize = 16;
+  if (num_pages > kKeyGap) {
+    throw std::invalid_argument("Too many pages to merge.");
+  }
+  PageBuffer buf = PageMemoryAllocator::Allocate(num_pages);
+
+  size_t total_records = 0;
+  for (size_t i = 0; i < num_pages; ++i) {
+    Page page = CreatePage(buf, i);
+    // Each page stores records with keys that are congruent to `i` modulo
+    // `kKeyGap`, so the merge has to interleave all the pages.
+    total_records += FillPage(page, records_per_page, kValueSize,
+                              /*first_key=*/i % kKeyGap);
+  }
+
+  for (auto _ : state) {
+    std::vector<Page::Iterator> iterators;
+    iterators.reserve(num_pages);
+    for (size_t i = 0; i < num_pages; ++i) {
+      iterators.push_back(Page(buf.get() + i * Page::kSize).GetIterator());
+    }
+    for (PageMergeIterator it(std::move(iterators)); it.Valid(); it.Next()) {
+      benchmark::DoNotOptimize(it.key());
+      benchmark::DoNotOptimize(it.value());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * total_records);
+}
+
+// Computes (or verifies) the checksum of one full page. The cost is
+// independent of the page's contents because the whole page is covered.
+void BM_PGPageChecksum(benchmark::State& state, const bool verify) {
+  PageBuffer buf = PageMemoryAllocator::Allocate(/*num_pages=*/1);
+  Page page = CreatePage(buf, 0);
+  FillPage(page, /*num_records=*/44, /*value_size=*/64, /*first_key=*/0);
+  page.ComputeAndSetPageChecksum();
+
+  for (auto _ : state) {
+    if (verify) {
+      benchmark::DoNotOptimize(page.CheckPageChecksum());
+    } else {
+      page.ComputeAndSetPageChecksum();
+      benchmark::ClobberMemory();
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * Page::kSize);
+}
+
+BENCHMARK_CAPTURE(BM_PGPagePut, sequential, /*shuffle=*/false)
+    ->Args({16, 64})
+    ->Args({64, 64})
+    ->Args({16, 256});
+
+BENCHMARK_CAPTURE(BM_PGPagePut, shuffled, /*shuffle=*/true)
+    ->Args({16, 64})
+    ->Args({64, 64})
+    ->Args({16, 256});
+
+BENCHMARK(BM_PGPageGet)->Args({16, 44})->Args({16, 128})->Args({64, 44});
+
+BENCHMARK(BM_PGPageIterate)->Args({16, 44})->Args({16, 128})->Args({64, 44});
+
+BENCHMARK(BM_PGPageMergeIterator)
+    ->Args({1, 44})
+    ->Args({2, 44})
+    ->Args({2, 128})
+    ->Args({4, 44});
+
+BENCHMARK_CAPTURE(BM_PGPageChecksum, compute, /*verify=*/false);
+BENCHMARK_CAPTURE(BM_PGPageChecksum, verify, /*verify=*/true);
+
+}  // namespace
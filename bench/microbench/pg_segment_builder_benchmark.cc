@@ -0,0 +1,119 @@
+// Benchmarks for the page grouping engine's `SegmentBuilder` (used by bulk
+// loads and reorganizations) and for the `InsertTracker` (used for insert
+// forecasting on the write path).
+//
+// Build the benchmarks by enabling the `TL_BUILD_BENCHMARKS` option when
+// configuring the project. Then run the `pg_microbench` executable under
+// `bench`.
+//
+//   mkdir build && cd build
+//   cmake -DCMAKE_BUILD_TYPE=Release -DTL_BUILD_BENCHMARKS=ON ..
+//   make -j
+//   ./bench/microbench/pg_microbench --benchmark_filter=SegmentBuilder*
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "page_grouping/key.h"
+#include "page_grouping/segment_builder.h"
+#include "treeline/slice.h"
+#include "util/insert_tracker.h"
+
+namespace {
+
+using namespace tl;
+using namespace tl::pg;
+
+// Returns a sorted dataset of `num_records` records. If `uniform` is false, the
+// keys are consecutive integers (a perfectly linear key distribution).
+std::vector<std::pair<Key, Slice>> GenerateDataset(const size_t num_records,
+                                                   const bool uniform,
+                                                   const Slice& value) {
+  std::vector<Key> keys;
+  keys.reserve(num_records);
+  if (uniform) {
+    std::mt19937_64 prng(42);
+    // Keys in `[1, 2^48)` to avoid the keys reserved by the `Manager`.
+    std::uniform_int_distribution<Key> dist(1, (1ULL << 48) - 1);
+    while (keys.size() < num_records) {
+      keys.push_back(dist(prng));
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+  } else {
+    for (size_t i = 1; i <= num_records; ++i) {
+      keys.push_back(i);
+    }
+  }
+
+  std::vector<std::pair<Key, Slice>> dataset;
+  dataset.reserve(keys.size());
+  for (const Key key : keys) {
+    dataset.emplace_back(key, value);
+  }
+  return dataset;
+}
+
+// Arguments: {number of records, uniform keys (0/1)}
+void BM_SegmentBuilder(benchmark::State& state,
+                       const SegmentBuilder::Strategy strategy) {
+  const std::string value(16, 0xFF);
+  const auto dataset =
+      GenerateDataset(state.range(0), state.range(1) != 0, Slice(value));
+
+  size_t num_segments = 0;
+  for (auto _ : state) {
+    SegmentBuilder builder(/*records_per_page_goal=*/44,
+                           /*records_per_page_epsilon=*/5, strategy);
+    const auto segments = builder.BuildFromDataset(dataset);
+    num_segments = segments.size();
+    benchmark::DoNotOptimize(segments.data());
+  }
+  state.SetItemsProcessed(state.iterations() * dataset.size());
+  state.counters["segments"] = num_segments;
+}
+
+// Shared by all threads running the benchmark. Set up by thread 0 before the
+// timed loop starts.
+std::unique_ptr<InsertTracker> shared_tracker;
+
+// Arguments: {number of inserts per epoch}
+void BM_InsertTrackerAdd(benchmark::State& state) {
+  if (state.thread_index() == 0) {
+    shared_tracker = std::make_unique<InsertTracker>(
+        /*num_inserts_per_epoch=*/state.range(0), /*num_partitions=*/10,
+        /*sample_size=*/1000);
+  }
+  std::mt19937_64 prng(42 + state.thread_index());
+
+  for (auto _ : state) {
+    shared_tracker->Add(prng());
+  }
+  state.SetItemsProcessed(state.iterations());
+
+  if (state.thread_index() == 0) {
+    shared_tracker.reset();
+  }
+}
+
+BENCHMARK_CAPTURE(BM_SegmentBuilder, greedy, SegmentBuilder::Strategy::kGreedy)
+    ->Args({1000000, 0})
+    ->Args({1000000, 1})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_CAPTURE(BM_SegmentBuilder, pgm, SegmentBuilder::Strategy::kPGM)
+    ->Args({1000000, 0})
+    ->Args({1000000, 1})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_InsertTrackerAdd)
+    ->Arg(1000000)
+    ->ThreadRange(1, 16)
+    ->UseRealTime();
+
+}  // namespace
@@ -0,0 +1,307 @@
+// Open Loop: Runs YCSBR-generated workloads against TreeLine, PGTreeLine, and
+// RocksDB using an open-loop load generator.
+//
+// Unlike `run_custom` (which issues the next request as soon as the previous
+// one completes), this runner issues requests on a fixed schedule at a target
+// rate. Each request's latency is measured from its *intended* send time, so
+// stalls in the database (e.g., a synchronous reorganization) show up in the
+// latency distribution instead of silently lowering the offered load (i.e.,
+// this runner avoids coordinated omission).
+//
+// The runner sweeps over one or more target rates and prints one CSV row per
+// database and rate. Plotting `p99_us` against `achieved_rate` gives a
+// throughput vs. tail latency curve.
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "bench/common/config.h"
+#include "bench/common/load_data.h"
+#include "bench/common/pg_treeline_interface.h"
+#include "bench/common/request_pacing.h"
+#include "bench/common/rocksdb_interface.h"
+#include "bench/common/treeline_interface.h"
+#include "gflags/gflags.h"
+#include "ycsbr/gen.h"
+
+namespace {
+
+namespace fs = std::filesystem;
+using namespace tl::bench;
+using Clock = std::chrono::steady_clock;
+
+DEFINE_uint32(threads, 1,
+              "The number of threads used to issue requests. The target rate "
+              "is split evenly across the threads.");
+DEFINE_string(workload_config, "",
+              "The path to the workload configuration file");
+DEFINE_string(custom_dataset, "", "A path to a custom dataset.");
+DEFINE_string(output_path, "",
+              "A path to where additional output should be written (e.g., "
+              "statistics).");
+
+DEFINE_string(target_rates, "10000",
+              "A comma-separated list of target request rates (in requests "
+              "per second) to sweep over. Each rate is run for "
+              "`rate_duration_s` seconds (or until the workload is exhausted), "
+              "replaying the workload's run phases from the beginning.");
+DEFINE_uint32(rate_duration_s, 10,
+              "The maximum number of seconds to spend issuing requests at each "
+              "target rate.");
+DEFINE_string(arrivals, "poisson",
+              "The request arrival process {poisson, constant}. With "
+              "`poisson`, inter-arrival times are exponentially distributed.");
+
+enum class ArrivalProcess { kPoisson, kConstant };
+
+ArrivalProcess ParseArrivalProcess(const std::string& candidate) {
+  if (candidate == "poisson") return ArrivalProcess::kPoisson;
+  if (candidate == "constant") return ArrivalProcess::kConstant;
+  throw std::invalid_argument("Unknown arrival process: " + candidate);
+}
+
+std::vector<double> ParseRates(const std::string& rates) {
+  std::vector<double> parsed;
+  std::string_view remaining(rates);
+  while (!remaining.empty()) {
+    const auto pos = remaining.find(',');
+    const std::string entry(remaining.substr(0, pos));
+    remaining = pos == std::string_view::npos ? std::string_view()
+                                              : remaining.substr(pos + 1);
+    const double rate = std::stod(entry);
+    if (rate <= 0) {
+      throw std::invalid_argument("Target rates must be positive.");
+    }
+    parsed.push_back(rate);
+  }
+  return parsed;
+}
+
+struct RateResult {
+  double target_rate;
+  double achieved_rate;
+  uint64_t requests;
+  uint64_t failed;
+  // The maximum amount of time a request was issued after its intended send
+  // time (indicates whether the generator itself kept up).
+  std::chrono::nanoseconds max_send_lag;
+  // Latencies (measured from the intended send time), in nanoseconds.
+  std::vector<uint64_t> latencies_ns;
+};
+
+void PrintCSVHeader() {
+  std::cout << "db,target_rate,achieved_rate,requests,failed,"
+            << kLatencySummaryCSVHeader << ",max_send_lag_us" << std::endl;
+}
+
+void PrintResult(const std::string& db, RateResult& result) {
+  std::cout << db << "," << result.target_rate << "," << result.achieved_rate
+            << "," << result.requests << "," << result.failed << ","
+            << LatencySummary::From(&result.latencies_ns) << ","
+            << result.max_send_lag.count() / 1000.0 << std::endl;
+}
+
+template <class DatabaseInterface>
+bool IssueRequest(DatabaseInterface& db, const ycsbr::Request& req,
+                  std::string* value_out,
+                  std::vector<std::pair<ycsbr::Request::Key, std::string>>*
+                      scan_out) {
+  switch (req.op) {
+    case ycsbr::Request::Operation::kInsert:
+      return db.Insert(req.key, req.value, req.value_size);
+    case ycsbr::Request::Operation::kUpdate:
+      return db.Update(req.key, req.value, req.value_size);
+    case ycsbr::Request::Operation::kScan:
+      scan_out->clear();
+      return db.Scan(req.key, req.scan_amount, scan_out);
+    default:
+      return db.Read(req.key, value_out);
+  }
+}
+
+template <class DatabaseInterface>
+RateResult RunAtRate(DatabaseInterface& db,
+                     const ycsbr::gen::PhasedWorkload& workload,
+                     const double target_rate, const ArrivalProcess arrivals) {
+  const size_t num_threads = FLAGS_threads;
+  const double per_thread_rate = target_rate / num_threads;
+  auto producers = workload.GetProducers(num_threads);
+
+  std::vector<RateResult> thread_results(num_threads);
+  StartBarrier barrier(num_threads);
+
+  const auto worker = [&](const size_t thread_id) {
+    db.InitializeWorker(std::this_thread::get_id());
+    auto& producer = producers[thread_id];
+    producer.Prepare();
+    RateResult& result = thread_results[thread_id];
+    result.requests = 0;
+    result.failed = 0;
+    result.max_send_lag = std::chrono::nanoseconds(0);
+
+    std::mt19937_64 prng(FLAGS_seed + thread_id);
+    std::exponential_distribution<double> poisson_gap(per_thread_rate);
+    const auto next_gap = [&]() {
+      const double gap_s = arrivals == ArrivalProcess::kPoisson
+                               ? poisson_gap(prng)
+                               : 1.0 / per_thread_rate;
+      return std::chrono::duration_cast<Clock::duration>(
+          std::chrono::duration<double>(gap_s));
+    };
+
+    std::string value_out;
+    std::vector<std::pair<ycsbr::Request::Key, std::string>> scan_out;
+
+    const Clock::time_point start = barrier.WorkerWait();
+    const auto deadline = start + std::chrono::seconds(FLAGS_rate_duration_s);
+    Clock::time_point intended = start + next_gap();
+
+    while (producer.HasNext() && intended < deadline) {
+      const auto& req = producer.Next();
+      WaitUntil(intended);
+      const auto sent = Clock::now();
+      const bool succeeded = IssueRequest(db, req, &value_out, &scan_out);
+      const auto done = Clock::now();
+
+      // If the database falls behind, `sent` will be later than `intended`;
+      // the latency still includes the time the request spent "queued".
+      result.latencies_ns.push_back(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(done - intended)
+              .count());
+      result.max_send_lag = std::max(
+          result.max_send_lag,
+          std::chrono::duration_cast<std::chrono::nanoseconds>(sent -
+                                                               intended));
+      ++result.requests;
+      if (!succeeded) ++result.failed;
+      intended += next_gap();
+    }
+    db.ShutdownWorker(std::this_thread::get_id());
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads);
+  for (size_t i = 0; i < num_threads; ++i) {
+    threads.emplace_back(worker, i);
+  }
+  const Clock::time_point start = barrier.Release();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  const auto elapsed = Clock::now() - start;
+
+  RateResult combined;
+  combined.target_rate = target_rate;
+  combined.requests = 0;
+  combined.failed = 0;
+  combined.max_send_lag = std::chrono::nanoseconds(0);
+  for (auto& result : thread_results) {
+    combined.requests += result.requests;
+    combined.failed += result.failed;
+    combined.max_send_lag =
+        std::max(combined.max_send_lag, result.max_send_lag);
+    combined.latencies_ns.insert(combined.latencies_ns.end(),
+                                 result.latencies_ns.begin(),
+                                 result.latencies_ns.end());
+  }
+  combined.achieved_rate =
+      combined.requests / std::chrono::duration<double>(elapsed).count();
+  return combined;
+}
+
+template <class DatabaseInterface>
+void RunSweep(const std::string& db_name,
+              const ycsbr::gen::PhasedWorkload& workload,
+              const std::vector<double>& target_rates,
+              const ArrivalProcess arrivals) {
+  DatabaseInterface db;
+  if (!FLAGS_skip_load) {
+    const auto load = workload.GetLoadTrace(/*sort_requests=*/true);
+    const auto minmax = load.GetKeyRange();
+    db.SetKeyDistHints(/*min_key=*/minmax.min, /*max_key=*/minmax.max,
+                       /*num_keys=*/load.size());
+    db.InitializeDatabase();
+    if (FLAGS_verbose) {
+      std::cerr << "> Loading " << load.size() << " records..." << std::endl;
+    }
+    db.BulkLoad(load);
+  } else {
+    db.InitializeDatabase();
+  }
+
+  for (const double rate : target_rates) {
+    if (FLAGS_verbose) {
+      std::cerr << "> Running " << db_name << " at " << rate
+                << " requests/s using " << FLAGS_threads << " thread(s)."
+                << std::endl;
+    }
+    RateResult result = RunAtRate(db, workload, rate, arrivals);
+    PrintResult(db_name, result);
+  }
+
+  db.ShutdownDatabase();
+  if (!FLAGS_output_path.empty()) {
+    db.WriteOutStats(fs::path(FLAGS_output_path));
+  }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  gflags::SetUsageMessage(
+      "Measure throughput vs. tail latency using an open-loop load generator.");
+  gflags::ParseCommandLineFlags(&argc, &argv, /*remove_flags=*/true);
+  if (FLAGS_workload_config.empty()) {
+    std::cerr << "ERROR: Please provide a workload configuration file."
+              << std::endl;
+    return 1;
+  }
+  if (FLAGS_threads == 0) {
+    std::cerr << "ERROR: --threads must be positive." << std::endl;
+    return 1;
+  }
+
+  const DBType db = tl::bench::ParseDBType(FLAGS_db).value();
+  const ArrivalProcess arrivals = ParseArrivalProcess(FLAGS_arrivals);
+  const std::vector<double> target_rates = ParseRates(FLAGS_target_rates);
+
+  std::unique_ptr<ycsbr::gen::PhasedWorkload> workload =
+      ycsbr::gen::PhasedWorkload::LoadFrom(FLAGS_workload_config, FLAGS_seed,
+                                           FLAGS_record_size_bytes);
+  if (!FLAGS_custom_dataset.empty()) {
+    std::vector<ycsbr::Request::Key> keys = LoadDatasetFromTextFile(
+        FLAGS_custom_dataset, /*warn_on_duplicates=*/FLAGS_verbose);
+    workload->SetCustomLoadDataset(std::move(keys));
+  }
+  FLAGS_record_size_bytes = workload->GetRecordSizeBytes();
+
+  if (!fs::exists(FLAGS_db_path)) {
+    fs::create_directory(FLAGS_db_path);
+  }
+  if (!FLAGS_output_path.empty() && !fs::exists(FLAGS_output_path)) {
+    fs::create_directory(FLAGS_output_path);
+  }
+
+  PrintCSVHeader();
+  if (db == DBType::kAll || db == DBType::kRocksDB) {
+    RunSweep<RocksDBInterface>("rocksdb", *workload, target_rates, arrivals);
+  }
+  if (db == DBType::kAll || db == DBType::kTreeLine) {
+    RunSweep<TreeLineInterface>("llsm", *workload, target_rates, arrivals);
+  }
+  if (db == DBType::kAll || db == DBType::kPGTreeLine) {
+    RunSweep<PGTreeLineInterface>("pg_llsm", *workload, target_rates,
+                                  arrivals);
+  }
+
+  return 0;
+}
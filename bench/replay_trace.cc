@@ -0,0 +1,301 @@
+// Replay Trace: Re-issues an operation trace captured by TreeLine or
+// PGTreeLine (see `--capture_trace`, `Options::trace_path`, and
+// `PageGroupedDBOptions::trace_path`) against TreeLine, PGTreeLine, and
+// RocksDB.
+//
+// The traced bulk load (if any) is used to load the database. Then each traced
+// thread's operations are replayed in their original order. Traced threads are
+// mapped onto `--threads` replay threads; operations from traced threads that
+// share a replay thread are interleaved by their timestamps.
+//
+// With `--replay_timing=original`, each operation is issued at its original
+// offset from the start of the trace and its latency is measured from that
+// intended send time (so that stalls are not hidden). With
+// `--replay_timing=asap`, operations are issued back-to-back.
+//
+// Traced values are not recorded; replayed writes use synthetic values of the
+// traced sizes. The benchmark interfaces do not support deletes, so traced
+// deletes are skipped (and counted in the output).
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "bench/common/config.h"
+#include "bench/common/pg_treeline_interface.h"
+#include "bench/common/request_pacing.h"
+#include "bench/common/rocksdb_interface.h"
+#include "bench/common/treeline_interface.h"
+#include "gflags/gflags.h"
+#include "util/op_trace.h"
+#include "ycsbr/ycsbr.h"
+
+namespace {
+
+namespace fs = std::filesystem;
+using namespace tl::bench;
+using tl::TraceOp;
+using tl::TraceRecord;
+using Clock = std::chrono::steady_clock;
+
+DEFINE_string(trace, "", "The path to the operation trace to replay.");
+DEFINE_uint32(threads, 0,
+              "The number of threads used to replay the trace. Set to 0 to use "
+              "one replay thread per traced thread.");
+DEFINE_string(replay_timing, "original",
+              "How to pace the replayed operations {original, asap}.");
+DEFINE_string(output_path, "",
+              "A path to where additional output should be written (e.g., "
+              "statistics).");
+
+enum class ReplayTiming { kOriginal, kAsap };
+
+ReplayTiming ParseReplayTiming(const std::string& candidate) {
+  if (candidate == "original") return ReplayTiming::kOriginal;
+  if (candidate == "asap") return ReplayTiming::kAsap;
+  throw std::invalid_argument("Unknown replay timing: " + candidate);
+}
+
+struct ParsedTrace {
+  std::vector<ycsbr::Request::Key> load_keys;
+  uint32_t load_value_size = 0;
+  // The operations issued by each replay thread, in issue order.
+  std::vector<std::vector<TraceRecord>> per_thread;
+  // The timestamp of the first non-bulk load operation.
+  uint64_t first_timestamp_ns = 0;
+  uint32_t max_value_size = 0;
+};
+
+ParsedTrace ParseTrace(std::vector<TraceRecord> records,
+                       const size_t num_threads) {
+  ParsedTrace parsed;
+  size_t num_traced_threads = 0;
+  bool found_first = false;
+  for (const auto& record : records) {
+    if (record.op == TraceOp::kBulkLoad) {
+      parsed.load_keys.push_back(record.key);
+      parsed.load_value_size =
+          std::max(parsed.load_value_size, record.value_size);
+      continue;
+    }
+    if (!found_first || record.timestamp_ns < parsed.first_timestamp_ns) {
+      parsed.first_timestamp_ns = record.timestamp_ns;
+      found_first = true;
+    }
+    num_traced_threads =
+        std::max(num_traced_threads, static_cast<size_t>(record.thread_id) + 1);
+    parsed.max_value_size = std::max(parsed.max_value_size, record.value_size);
+  }
+
+  const size_t replay_threads =
+      num_threads == 0 ? std::max<size_t>(num_traced_threads, 1) : num_threads;
+  parsed.per_thread.resize(replay_threads);
+  for (const auto& record : records) {
+    if (record.op == TraceOp::kBulkLoad) continue;
+    parsed.per_thread[record.thread_id % replay_threads].push_back(record);
+  }
+  // The trace contains each traced thread's records in issue order (and their
+  // timestamps are non-decreasing), so a stable sort by timestamp interleaves
+  // the traced threads without reordering any one thread's operations.
+  for (auto& ops : parsed.per_thread) {
+    std::stable_sort(ops.begin(), ops.end(),
+                     [](const TraceRecord& left, const TraceRecord& right) {
+                       return left.timestamp_ns < right.timestamp_ns;
+                     });
+  }
+  return parsed;
+}
+
+struct ReplayResult {
+  uint64_t requests = 0;
+  uint64_t failed = 0;
+  uint64_t skipped = 0;
+  // Latencies, in nanoseconds.
+  std::vector<uint64_t> latencies_ns;
+};
+
+void PrintCSVHeader() {
+  std::cout << "db,timing,threads,requests,failed,skipped,elapsed_s,"
+               "throughput_ops_s,"
+            << kLatencySummaryCSVHeader << std::endl;
+}
+
+void PrintResult(const std::string& db, const std::string& timing,
+                 const size_t threads, ReplayResult& result,
+                 const Clock::duration elapsed) {
+  const double elapsed_s = std::chrono::duration<double>(elapsed).count();
+  std::cout << db << "," << timing << "," << threads << "," << result.requests
+            << "," << result.failed << "," << result.skipped << ","
+            << elapsed_s << "," << result.requests / elapsed_s << ","
+            << LatencySummary::From(&result.latencies_ns) << std::endl;
+}
+
+template <class DatabaseInterface>
+ReplayResult Replay(DatabaseInterface& db, const ParsedTrace& trace,
+                    const ReplayTiming timing, Clock::duration* elapsed_out) {
+  const size_t num_threads = trace.per_thread.size();
+  const std::string value(std::max<uint32_t>(trace.max_value_size, 1), 0xFF);
+
+  std::vector<ReplayResult> thread_results(num_threads);
+  StartBarrier barrier(num_threads);
+
+  const auto worker = [&](const size_t thread_id) {
+    db.InitializeWorker(std::this_thread::get_id());
+    ReplayResult& result = thread_results[thread_id];
+    result.latencies_ns.reserve(trace.per_thread[thread_id].size());
+    std::string value_out;
+    std::vector<std::pair<ycsbr::Request::Key, std::string>> scan_out;
+
+    const Clock::time_point start = barrier.WorkerWait();
+
+    for (const auto& op : trace.per_thread[thread_id]) {
+      Clock::time_point intended;
+      if (timing == ReplayTiming::kOriginal) {
+        intended = start + std::chrono::nanoseconds(op.timestamp_ns -
+                                                    trace.first_timestamp_ns);
+        WaitUntil(intended);
+      } else {
+        intended = Clock::now();
+      }
+
+      bool succeeded = true;
+      switch (op.op) {
+        case TraceOp::kRead:
+          succeeded = db.Read(op.key, &value_out);
+          break;
+        case TraceOp::kInsert:
+          succeeded = db.Insert(op.key, value.data(), op.value_size);
+          break;
+        case TraceOp::kUpdate:
+          succeeded = db.Update(op.key, value.data(), op.value_size);
+          break;
+        case TraceOp::kScan:
+          scan_out.clear();
+          succeeded = db.Scan(op.key, op.scan_length, &scan_out);
+          break;
+        default:
+          ++result.skipped;
+          continue;
+      }
+      const auto done = Clock::now();
+      result.latencies_ns.push_back(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(done - intended)
+              .count());
+      ++result.requests;
+      if (!succeeded) ++result.failed;
+    }
+    db.ShutdownWorker(std::this_thread::get_id());
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads);
+  for (size_t i = 0; i < num_threads; ++i) {
+    threads.emplace_back(worker, i);
+  }
+  const Clock::time_point start = barrier.Release();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  *elapsed_out = Clock::now() - start;
+
+  ReplayResult combined;
+  for (auto& result : thread_results) {
+    combined.requests += result.requests;
+    combined.failed += result.failed;
+    combined.skipped += result.skipped;
+    combined.latencies_ns.insert(combined.latencies_ns.end(),
+                                 result.latencies_ns.begin(),
+                                 result.latencies_ns.end());
+  }
+  return combined;
+}
+
+template <class DatabaseInterface>
+void RunReplay(const std::string& db_name, const ParsedTrace& trace,
+               const ReplayTiming timing) {
+  DatabaseInterface db;
+  if (!FLAGS_skip_load && !trace.load_keys.empty()) {
+    ycsbr::Trace::Options options;
+    options.value_size = trace.load_value_size;
+    options.sort_requests = true;
+    const auto load =
+        ycsbr::BulkLoadTrace::LoadFromKeys(trace.load_keys, options);
+    const auto minmax = load.GetKeyRange();
+    db.SetKeyDistHints(/*min_key=*/minmax.min, /*max_key=*/minmax.max,
+                       /*num_keys=*/load.size());
+    db.InitializeDatabase();
+    if (FLAGS_verbose) {
+      std::cerr << "> Loading " << load.size() << " records..." << std::endl;
+    }
+    db.BulkLoad(load);
+  } else {
+    db.InitializeDatabase();
+  }
+
+  if (FLAGS_verbose) {
+    std::cerr << "> Replaying the trace against " << db_name << " using "
+              << trace.per_thread.size() << " thread(s)." << std::endl;
+  }
+  Clock::duration elapsed;
+  ReplayResult result = Replay(db, trace, timing, &elapsed);
+  PrintResult(db_name, FLAGS_replay_timing, trace.per_thread.size(), result,
+              elapsed);
+
+  db.ShutdownDatabase();
+  if (!FLAGS_output_path.empty()) {
+    db.WriteOutStats(fs::path(FLAGS_output_path));
+  }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  gflags::SetUsageMessage(
+      "Replay an operation trace captured by TreeLine or PGTreeLine.");
+  gflags::ParseCommandLineFlags(&argc, &argv, /*remove_flags=*/true);
+  if (FLAGS_trace.empty()) {
+    std::cerr << "ERROR: Please provide a trace to replay." << std::endl;
+    return 1;
+  }
+
+  const DBType db = tl::bench::ParseDBType(FLAGS_db).value();
+  const ReplayTiming timing = ParseReplayTiming(FLAGS_replay_timing);
+
+  std::vector<TraceRecord> records;
+  const tl::Status s = tl::ReadOpTrace(FLAGS_trace, &records);
+  if (!s.ok()) {
+    std::cerr << "ERROR: " << s.ToString() << std::endl;
+    return 1;
+  }
+  const ParsedTrace trace = ParseTrace(std::move(records), FLAGS_threads);
+  if (trace.load_value_size > 0) {
+    // Used by the database interfaces to size their caches.
+    FLAGS_record_size_bytes = trace.load_value_size + sizeof(uint64_t);
+  }
+
+  if (!fs::exists(FLAGS_db_path)) {
+    fs::create_directory(FLAGS_db_path);
+  }
+  if (!FLAGS_output_path.empty() && !fs::exists(FLAGS_output_path)) {
+    fs::create_directory(FLAGS_output_path);
+  }
+
+  PrintCSVHeader();
+  if (db == DBType::kAll || db == DBType::kRocksDB) {
+    RunReplay<RocksDBInterface>("rocksdb", trace, timing);
+  }
+  if (db == DBType::kAll || db == DBType::kTreeLine) {
+    RunReplay<TreeLineInterface>("llsm", trace, timing);
+  }
+  if (db == DBType::kAll || db == DBType::kPGTreeLine) {
+    RunReplay<PGTreeLineInterface>("pg_llsm", trace, timing);
+  }
+
+  return 0;
+}
@@ -1,8 +1,12 @@
+#include <algorithm>
 #include <filesystem>
 #include <iostream>
 #include <string_view>
+#include <utility>
+#include <vector>
 
 #include "bench/common/config.h"
+#include "bench/common/key_distributions.h"
 #include "bench/common/leanstore_interface.h"
 #include "bench/common/load_data.h"
 #include "bench/common/pg_treeline_interface.h"
@@ -42,6 +46,29 @@ DEFINE_string(
     "Expected format: <name>:<path>. To specify more than one custom insert "
     "list, separate the entries using a comma.");
 
+DEFINE_string(synthetic_dataset, "",
+              "Generate the load dataset using a built-in key distribution "
+              "instead of loading it from a file. Expected format: "
+              "<distribution>:<num_keys> (e.g., zipf_hotspot:20000000). The "
+              "supported distributions are uniform, clustered, "
+              "piecewise_dense, lognormal, zipf_hotspot, and time_series.");
+DEFINE_uint64(synthetic_min_key, 1,
+              "The smallest key that the synthetic generators may produce.");
+DEFINE_uint64(synthetic_max_key, 2000000000,
+              "The largest key that the synthetic generators may produce.");
+DEFINE_string(
+    synthetic_inserts, "",
+    "Use this flag to generate custom insert lists whose hot key range shifts "
+    "over time. The names should correspond to names in the workload "
+    "configuration file. Expected format: <name>:<num_inserts>. To specify "
+    "more than one list, separate the entries using a comma. Requires "
+    "--custom_dataset or --synthetic_dataset.");
+DEFINE_uint32(synthetic_insert_phases, 10,
+              "The number of hot range shifts in each synthetic insert list.");
+DEFINE_double(synthetic_hot_range, 0.01,
+              "The size of a synthetic insert list's hot range, as a fraction "
+              "of the key range.");
+
 template <class DatabaseInterface>
 ycsbr::BenchmarkResult Run(const ycsbr::gen::PhasedWorkload& workload) {
   ycsbr::Session<DatabaseInterface> session(FLAGS_threads);
@@ -95,11 +122,11 @@ void PrintExperimentResult(const std::string& db,
   result.PrintAsCSV(std::cout, /*print_header=*/false);
 }
 
-void ProcessCustomInserts(
-    std::unique_ptr<ycsbr::gen::PhasedWorkload>& workload) {
-  if (FLAGS_custom_inserts.empty()) return;
-
-  std::string_view remaining(FLAGS_custom_inserts);
+// Parses a comma-separated list of `<name>:<value>` entries.
+std::vector<std::pair<std::string, std::string>> ParseNamedEntries(
+    const std::string& flag_value, const std::string& flag_name) {
+  std::vector<std::pair<std::string, std::string>> entries;
+  std::string_view remaining(flag_value);
   while (!remaining.empty()) {
     const auto pos = remaining.find(',');
     const auto entry = remaining.substr(0, pos);
@@ -111,11 +138,98 @@ void ProcessCustomInserts(
 
     const auto sep_pos = entry.find(':');
     if (sep_pos == std::string_view::npos) {
+      throw std::invalid_argument("Invalid format for --" + flag_name +
+                                  " (missing ':' separator).");
+    }
+    entries.emplace_back(std::string(entry.substr(0, sep_pos)),
+                         std::string(entry.substr(sep_pos + 1)));
+  }
+  return entries;
+}
+
+// Returns the keys in the load dataset specified by `--custom_dataset` or
+// `--synthetic_dataset`. The returned list is empty if neither flag is set.
+std::vector<ycsbr::Request::Key> LoadOrGenerateDataset() {
+  if (!FLAGS_custom_dataset.empty()) {
+    if (!FLAGS_synthetic_dataset.empty()) {
       throw std::invalid_argument(
-          "Invalid format for --custom_inserts (missing ':' separator).");
+          "Only one of --custom_dataset and --synthetic_dataset can be set.");
     }
-    const std::string name = std::string(entry.substr(0, sep_pos));
-    const std::string path = std::string(entry.substr(sep_pos + 1));
+    std::vector<ycsbr::Request::Key> keys = LoadDatasetFromTextFile(
+        FLAGS_custom_dataset, /*warn_on_duplicates=*/FLAGS_verbose);
+    if (FLAGS_verbose) {
+      std::cerr << "> Loaded a custom dataset with " << keys.size() << " keys."
+                << std::endl;
+    }
+    return keys;
+  }
+  if (FLAGS_synthetic_dataset.empty()) return {};
+
+  const auto entries =
+      ParseNamedEntries(FLAGS_synthetic_dataset, "synthetic_dataset");
+  if (entries.size() != 1) {
+    throw std::invalid_argument(
+        "Invalid format for --synthetic_dataset (expected one entry).");
+  }
+  const auto& [dist_name, num_keys] = entries.front();
+  const auto dist = ParseKeyDistribution(dist_name);
+  if (!dist.has_value()) {
+    throw std::invalid_argument("Unknown key distribution: " + dist_name);
+  }
+  KeyGenOptions options;
+  options.min_key = FLAGS_synthetic_min_key;
+  options.max_key = FLAGS_synthetic_max_key;
+  options.rng_seed = FLAGS_seed;
+  std::vector<ycsbr::Request::Key> keys =
+      GenerateKeys(*dist, std::stoull(num_keys), options);
+  if (FLAGS_verbose) {
+    std::cerr << "> Generated a synthetic " << dist_name << " dataset with "
+              << keys.size() << " keys." << std::endl;
+  }
+  return keys;
+}
+
+// The generated inserts will not collide with the keys in `dataset`.
+void ProcessSyntheticInserts(
+    std::unique_ptr<ycsbr::gen::PhasedWorkload>& workload,
+    const std::vector<ycsbr::Request::Key>& dataset) {
+  if (FLAGS_synthetic_inserts.empty()) return;
+  if (dataset.empty()) {
+    throw std::invalid_argument(
+        "--synthetic_inserts requires --custom_dataset or "
+        "--synthetic_dataset.");
+  }
+  std::vector<ycsbr::Request::Key> used_keys(dataset);
+  std::sort(used_keys.begin(), used_keys.end());
+
+  InsertStreamOptions options;
+  options.min_key = FLAGS_synthetic_min_key;
+  options.max_key = FLAGS_synthetic_max_key;
+  options.num_phases = FLAGS_synthetic_insert_phases;
+  options.hot_range_fraction = FLAGS_synthetic_hot_range;
+  uint32_t seed = FLAGS_seed;
+  for (const auto& [name, num_inserts] :
+       ParseNamedEntries(FLAGS_synthetic_inserts, "synthetic_inserts")) {
+    // Each list uses a different seed so that their hot ranges differ.
+    options.rng_seed = seed++;
+    std::vector<ycsbr::Request::Key> keys = GenerateShiftingHotspotInserts(
+        used_keys, std::stoull(num_inserts), options);
+    // The inserted keys must also be unique across lists.
+    const size_t num_used_keys = used_keys.size();
+    used_keys.insert(used_keys.end(), keys.begin(), keys.end());
+    std::sort(used_keys.begin() + num_used_keys, used_keys.end());
+    std::inplace_merge(used_keys.begin(), used_keys.begin() + num_used_keys,
+                       used_keys.end());
+    workload->AddCustomInsertList(name, keys);
+  }
+}
+
+void ProcessCustomInserts(
+    std::unique_ptr<ycsbr::gen::PhasedWorkload>& workload) {
+  if (FLAGS_custom_inserts.empty()) return;
+
+  for (const auto& [name, path] :
+       ParseNamedEntries(FLAGS_custom_inserts, "custom_inserts")) {
     std::vector<ycsbr::Request::Key> keys =
         LoadDatasetFromTextFile(path, /*warn_on_duplicates=*/FLAGS_verbose);
     if (keys.empty()) {
@@ -141,14 +255,10 @@ int main(int argc, char* argv[]) {
       ycsbr::gen::PhasedWorkload::LoadFrom(FLAGS_workload_config, FLAGS_seed,
                                            FLAGS_record_size_bytes);
 
-  if (!FLAGS_custom_dataset.empty()) {
-    std::vector<ycsbr::Request::Key> keys = LoadDatasetFromTextFile(
-        FLAGS_custom_dataset, /*warn_on_duplicates=*/FLAGS_verbose);
-    if (FLAGS_verbose) {
-      std::cerr << "> Loaded a custom dataset with " << keys.size() << " keys."
-                << std::endl;
-    }
-    workload->SetCustomLoadDataset(std::move(keys));
+  std::vector<ycsbr::Request::Key> load_keys = LoadOrGenerateDataset();
+  ProcessSyntheticInserts(workload, load_keys);
+  if (!load_keys.empty()) {
+    workload->SetCustomLoadDataset(std::move(load_keys));
   }
   ProcessCustomInserts(workload);
 
@@ -104,7 +104,11 @@ Status DBImpl::Initialize() {
 
     // Finish initializing the DB based on whether we are creating a completely
     // new DB or if we are opening an existing DB.
-    return db_exists ? InitializeExistingDB() : InitializeNewDB();
+    const Status s = db_exists ? InitializeExistingDB() : InitializeNewDB();
+    if (!s.ok() || options_.trace_path.empty()) return s;
+
+    // Opened last because the trace file may be placed in the DB directory.
+    return OpTraceWriter::Open(options_.trace_path, &trace_);
 
   } catch (const fs::filesystem_error& ex) {
     return Status::FromPosixError(db_path_.string(), ex.code().value());
@@ -258,6 +262,9 @@ DBImpl::~DBImpl() {
 // first).
 Status DBImpl::Get(const ReadOptions& options, const Slice& key,
                    std::string* value_out) {
+  if (trace_ != nullptr) {
+    trace_->Record(TraceOp::kRead, key_utils::ExtractHead64(key));
+  }
   return GetWithPage(options, key, value_out, nullptr);
 }
 
@@ -282,6 +289,10 @@ Status DBImpl::GetWithPage(const ReadOptions& options, const Slice& key,
   }
 
   // 2. Check the on-disk page(s) by following the relevant overflow chain.
+  // The write out versions are used to avoid caching records that became
+  // stale while we read them.
+  const auto key_version = rec_cache_->GetWriteOutVersion(key);
+  auto page_version = rec_cache_->GetPageWriteOutVersion(key);
   bool next_link_exists = true;
   PhysicalPageId page_id;
   BufferFrame* bf;
@@ -330,18 +341,21 @@ Status DBImpl::GetWithPage(const ReadOptions& options, const Slice& key,
   // If found, add to record cache for future lookups.
   if (status.ok()) {
     rec_cache_->PutFromRead(key, Slice(*value_out),
-                            RecordCache::kDefaultPriority);
+                            RecordCache::kDefaultPriority, &key_version);
 
     // Optionally, also cache records on the same page.
     // TODO: records in other links of the same chain?
     if (options_.optimistic_caching) {
+      page_version =
+          rec_cache_->RecheckPageWriteOutVersion(key, page_version);
       Page page(local_page);
       auto it = page.GetIterator();
       it.Seek(page.GetLowerBoundary());
 
       while (it.Valid()) {
         rec_cache_->PutFromRead(it.key(), it.value(),
-                                RecordCache::kDefaultOptimisticPriority);
+                                RecordCache::kDefaultOptimisticPriority,
+                                &page_version);
         it.Next();
       }
     }
@@ -375,6 +389,13 @@ Status DBImpl::BulkLoad(
     return Status::InvalidArgument(
         "`options.sorted_load` must be true, indicating that the contents of "
         "`records` are sorted and distinct.");
+  if (trace_ != nullptr) {
+    for (const auto& record : records) {
+      trace_->Record(TraceOp::kBulkLoad,
+                     key_utils::ExtractHead64(record.first),
+                     record.second.size());
+    }
+  }
 
   // Determine number of needed pages.
   KeyDistHints dist;
@@ -436,6 +457,12 @@ Status DBImpl::FlushRecordCache(const bool disable_deferred_io) {
 
 Status DBImpl::WriteImpl(const WriteOptions& options, const Slice& key,
                          const Slice& value, format::WriteType write_type) {
+  if (trace_ != nullptr) {
+    // `DB::Put()` does not distinguish between inserts and updates.
+    trace_->Record(write_type == format::WriteType::kDelete ? TraceOp::kDelete
+                                                            : TraceOp::kInsert,
+                   key_utils::ExtractHead64(key), value.size());
+  }
   if (!options.bypass_wal) {
     Status log_result = wal_.LogWrite(options, key, value, write_type);
     if (!log_result.ok()) {
@@ -453,7 +480,7 @@ Status DBImpl::WriteImpl(const WriteOptions& options, const Slice& key,
   return write_result;
 }
 
-void DBImpl::WriteBatch(const WriteOutBatch& records) {
+Status DBImpl::WriteBatch(const WriteOutBatch& records) {
   // The approach below tries to keep an overflow chain fixed for as long as the
   // entries of `records` belong to it, while going through `records`
   // sequentially.
@@ -466,7 +493,7 @@ void DBImpl::WriteBatch(const WriteOutBatch& records) {
   //
   // However, no specific sort order is strictly required for correctness.
 
-  if (records.size() == 0) return;
+  if (records.size() == 0) return Status::OK();
 
   PhysicalPageId page_id;
   OverflowChain chain = nullptr;
@@ -555,6 +582,7 @@ void DBImpl::WriteBatch(const WriteOutBatch& records) {
   for (auto& bf : *chain) {
     buf_mgr_->UnfixPage(*bf, /* is_dirty = */ true);
   }
+  return Status::OK();
 }
 
 std::pair<key_utils::KeyHead, key_utils::KeyHead> DBImpl::GetPageBoundsFor(
@@ -18,6 +18,7 @@
 #include "model/model.h"
 #include "overflow_chain.h"
 #include "record_cache/record_cache.h"
+#include "util/op_trace.h"
 #include "util/thread_pool.h"
 #include "wal/manager.h"
 
@@ -65,7 +66,7 @@ class DBImpl : public DB {
                    const Slice& value, format::WriteType write_type);
 
   // Writes the records in the batch to persistent storage.
-  void WriteBatch(const WriteOutBatch& records);
+  Status WriteBatch(const WriteOutBatch& records);
 
   // Gets the lower (inclusive) and upper (exclusive) bounds for the page that
   // `key` should be placed on.
@@ -84,6 +85,9 @@ class DBImpl : public DB {
   std::shared_ptr<Model> model_;
   std::shared_ptr<ThreadPool> workers_;
 
+  // Set only if operation tracing is enabled (see `Options::trace_path`).
+  std::unique_ptr<OpTraceWriter> trace_;
+
   // Remaining database state protected by `mutex_`.
   std::mutex mutex_;
 
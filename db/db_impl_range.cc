@@ -6,6 +6,10 @@ namespace tl {
 
 Status DBImpl::GetRange(const ReadOptions& options, const Slice& start_key,
                         const size_t num_records, RecordBatch* results_out) {
+  if (trace_ != nullptr) {
+    trace_->Record(TraceOp::kScan, key_utils::ExtractHead64(start_key),
+                   /*value_size=*/0, num_records);
+  }
   results_out->clear();
   results_out->reserve(num_records);
 
@@ -10,6 +10,7 @@
 #include <cstdint>
 #include <cstdlib>
 #include <memory>
+#include <string>
 
 namespace tl {
 
@@ -110,6 +111,12 @@ struct Options {
 
   // Whether the record cache should use the LRU eviction policy.
   bool rec_cache_use_lru = false;
+
+  // If non-empty, the DB will record the operations issued against it to a
+  // binary trace file at this path. Keys are recorded using their 8-byte
+  // prefix. The trace can be re-issued using the `replay_trace` benchmark
+  // driver.
+  std::string trace_path;
 };
 
 struct ReadOptions {};
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <filesystem>
+#include <functional>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -14,11 +16,98 @@ namespace pg {
 using Key = tl::key_utils::KeyHead;
 using Record = std::pair<Key, Slice>;
 
+class PageGroupedDBImpl;
+
+// Holds a value returned by `PageGroupedDB::Get()` without copying it when
+// possible. If the record is in the record cache, the handle refers to the
+// cached value directly and keeps the cache entry latched (in shared mode)
+// until the handle is reset or destroyed. Otherwise the value is read from
+// disk into a buffer owned by the handle.
+//
+// A pinned value blocks writes to its key and the eviction of its cache entry,
+// so handles should be released quickly. A thread must release its pinned
+// handles before it calls any other `PageGroupedDB` method (the call may need
+// to evict the pinned entry). A handle can be reused for several reads.
+class PinnableValue {
+ public:
+  PinnableValue() = default;
+  ~PinnableValue() { Reset(); }
+
+  PinnableValue(const PinnableValue&) = delete;
+  PinnableValue& operator=(const PinnableValue&) = delete;
+
+  PinnableValue(PinnableValue&& other) noexcept { *this = std::move(other); }
+  PinnableValue& operator=(PinnableValue&& other) noexcept {
+    if (this == &other) return *this;
+    Reset();
+    buffer_ = std::move(other.buffer_);
+    value_ = other.uses_buffer_ ? Slice(buffer_) : other.value_;
+    uses_buffer_ = other.uses_buffer_;
+    release_ = other.release_;
+    release_arg_ = other.release_arg_;
+    other.value_ = Slice();
+    other.uses_buffer_ = false;
+    other.release_ = nullptr;
+    other.release_arg_ = nullptr;
+    return *this;
+  }
+
+  // The value. It stays valid until the handle is reset, reused, or destroyed.
+  const Slice& value() const { return value_; }
+
+  // Returns true iff the value refers to memory owned by the database (i.e.,
+  // it was not copied).
+  bool IsPinned() const { return release_ != nullptr; }
+
+  // Releases the value (and unpins it, if needed).
+  void Reset() {
+    if (release_ != nullptr) release_(release_arg_);
+    release_ = nullptr;
+    release_arg_ = nullptr;
+    value_ = Slice();
+    uses_buffer_ = false;
+  }
+
+ private:
+  friend class PageGroupedDBImpl;
+
+  // Refers to `value`, which stays valid until `release(release_arg)` is
+  // called.
+  void Pin(const Slice& value, void (*release)(void*), void* release_arg) {
+    Reset();
+    value_ = value;
+    release_ = release;
+    release_arg_ = release_arg;
+  }
+
+  // Returns a buffer that a copy of the value can be read into. Call
+  // `UseBuffer()` once it holds the value.
+  std::string* GetBuffer() {
+    Reset();
+    return &buffer_;
+  }
+  void UseBuffer() {
+    value_ = Slice(buffer_);
+    uses_buffer_ = true;
+  }
+
+  Slice value_;
+  std::string buffer_;
+  bool uses_buffer_ = false;
+  void (*release_)(void*) = nullptr;
+  void* release_arg_ = nullptr;
+};
+
 // The public page-grouped TreeLine database interface, representing
 // an embedded, persistent, and ordered key-value store.
 //
 // All methods return an OK status on success, and a non-OK status if an error
-// occurs. Concurrent access to the database is currently not supported.
+// occurs.
+//
+// `Put()`, `Get()`, `GetRange()`, and `FlattenRange()` can be called
+// concurrently from multiple threads without requiring external mutual
+// exclusion (except for `GetRange()` with experimental prefetching, see below).
+// `BulkLoad()` must complete before any other method is called.
 //
 // At most one `DB` instance should be used at any time in a single process.
 //
@@ -50,12 +139,18 @@ class PageGroupedDB {
   // The caller is responsible for verifying that `records` are distinct and
   // sorted by key. Returns Status::NotSupported if the database is not
   // initially empty.
+  //
+  // This method is not thread-safe; it must not run concurrently with any other
+  // method.
   virtual Status BulkLoad(const std::vector<Record>& records) = 0;
 
   // Set the database entry for `key` to `value`.
   //
   // It is not an error if `key` already exists in the database; this method
   // will overwrite the value associated with that key.
+  //
+  // Returns `Corruption` if the write needed to modify a page (for example, to
+  // make room in the record cache) that fails its checksum check.
   virtual Status Put(const WriteOptions& options, const Key key,
                      const Slice& value) = 0;
 
@@ -65,6 +160,11 @@ class PageGroupedDB {
   // will be returned where `Status::IsNotFound()` evaluates to true.
   virtual Status Get(const Key key, std::string* value_out) = 0;
 
+  // Like `Get()` above, but avoids copying the value if the record is cached
+  // (see `PinnableValue`). Any value previously held by `value_out` is
+  // released first.
+  virtual Status Get(const Key key, PinnableValue* value_out) = 0;
+
   // Retrieve an ascending range of at most `num_records` records, starting from
   // the smallest record whose key is greater than or equal to `start_key`.
   //
@@ -77,6 +177,40 @@ class PageGroupedDB {
                           std::vector<std::pair<Key, std::string>>* results_out,
                           bool use_experimental_prefetch = false) = 0;
 
+  using GetCallback = std::function<void(const Status&, std::string value)>;
+  using GetRangeCallback = std::function<void(
+      const Status&, std::vector<std::pair<Key, std::string>> results)>;
+  using PutCallback = std::function<void(const Status&)>;
+
+  // Asynchronous versions of `Get()`, `GetRange()`, and `Put()`. They run
+  // `callback` with the operation's result once it completes. Requests that
+  // complete without I/O (e.g., a `GetAsync()` for a record in the record
+  // cache) run `callback` on the calling thread before returning. Other
+  // requests are queued and the method returns immediately.
+  //
+  // The queued requests are served by a thread-per-outstanding-request pool
+  // of `PageGroupedDBOptions::num_async_threads` threads. There is no
+  // completion-based I/O path: a pool thread runs the request with the same
+  // blocking reads and writes as the synchronous methods and then runs
+  // `callback`. At most `num_async_threads` requests therefore have I/O in
+  // flight at once; keeping more reads in flight requires more threads.
+  // Callbacks should be short. They may issue other requests, but must not
+  // block waiting for another asynchronous request.
+  //
+  // The pool is opt-in. If `PageGroupedDBOptions::num_async_threads` is 0 (the
+  // default), these methods run `callback` with `Status::NotSupported()` on
+  // the calling thread.
+  //
+  // Concurrent asynchronous requests may complete in any order. A request that
+  // is issued after another request's callback ran observes that request's
+  // effects. Callers must wait for all their callbacks to run before closing
+  // the DB. `PutAsync()` copies `value`.
+  virtual void GetAsync(const Key key, GetCallback callback) = 0;
+  virtual void GetRangeAsync(const Key start_key, const size_t num_records,
+                             GetRangeCallback callback) = 0;
+  virtual void PutAsync(const WriteOptions& options, const Key key,
+                        const Slice& value, PutCallback callback) = 0;
+
   // Removes all overflow pages in the specified key range. The `end_key` is
   // exclusive.
   //
@@ -96,6 +230,14 @@ class PageGroupedDB {
   virtual Status FlattenRange(
       const Key start_key = 1,
       const Key end_key = std::numeric_limits<Key>::max()) = 0;
+
+  // Pauses or resumes the background scrubber (see `ScrubberOptions`), for
+  // example while the database is under heavy load. A paused scrubber finishes
+  // checking its current segment and then waits until it is resumed. This
+  // method has no effect if the scrubber is disabled.
+  //
+  // This method is thread-safe.
+  virtual void SetScrubberPaused(bool paused) = 0;
 };
 
 }  // namespace pg
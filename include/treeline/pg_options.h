@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstdint>
 #include <cstdlib>
+#include <string>
 
 namespace tl {
 namespace pg {
@@ -31,6 +33,75 @@ struct InsertForecastingOptions {
   size_t num_future_epochs = 1;
 };
 
+// Models the performance of the storage device simulated by the DB when
+// `PageGroupedDBOptions::use_simulated_device` is set to true. The defaults
+// roughly correspond to a datacenter NVMe SSD.
+struct SimulatedDeviceOptions {
+  // The fixed latency of each read (write) request, in microseconds.
+  uint64_t read_latency_us = 80;
+  uint64_t write_latency_us = 20;
+
+  // The device's read (write) bandwidth in MiB/s. Concurrent requests share
+  // the bandwidth. Set to 0 to model a device with unlimited bandwidth.
+  uint64_t read_bandwidth_mib = 2500;
+  uint64_t write_bandwidth_mib = 1500;
+
+  // The maximum number of requests that the device serves concurrently.
+  // Additional requests wait in a queue. Set to 0 to disable the limit.
+  size_t queue_depth = 64;
+};
+
+// Options for storing segments on two storage tiers: a small fast tier (the DB
+// directory) and a larger capacity tier.
+//
+// Segments written by reorganizations and all overflow pages are placed in the
+// fast tier. A background thread periodically moves cold segments (based on
+// the segment access counters, see `access_sample_interval`) to the capacity
+// tier.
+struct TieringOptions {
+  // The directory that holds the capacity tier's segment files. Set to an empty
+  // string to disable tiering. Tiering is only supported when `use_segments`
+  // is true.
+  std::string capacity_tier_path;
+
+  // How often the background thread looks for cold segments, in milliseconds.
+  // Set to 0 to disable the background thread.
+  uint64_t migration_interval_ms = 1000;
+
+  // A fast tier segment is considered cold if it had at most this many
+  // (estimated) accesses since the previous migration pass.
+  uint64_t cold_access_threshold = 0;
+
+  // The maximum number of segments moved to the capacity tier in each pass.
+  size_t max_migrations_per_pass = 64;
+
+  // The device model used for the capacity tier when `use_simulated_device`
+  // is set to true.
+  SimulatedDeviceOptions capacity_simulated_device = {
+      /*read_latency_us=*/200, /*write_latency_us=*/50,
+      /*read_bandwidth_mib=*/1000, /*write_bandwidth_mib=*/300,
+      /*queue_depth=*/32};
+};
+
+// Options for the background scrubber, which periodically reads every segment
+// (and its overflow pages) from storage and checks the segment and page
+// checksums and the segment's structure (page boundaries, overflow pointers,
+// and the segment's model). This detects latent media errors while the DB is
+// online. The results are reported in `PageGroupedDBStats`; run `pg_check` on
+// the DB for details about a problem that was found.
+//
+// Applications can pause the scrubber while the DB is under heavy load (see
+// `PageGroupedDB::SetScrubberPaused()`).
+struct ScrubberOptions {
+  // How long the scrubber waits between passes over the DB, in milliseconds.
+  // Set to 0 to disable the scrubber.
+  uint64_t interval_ms = 0;
+
+  // The maximum rate at which the scrubber reads pages. Set to 0 to scrub as
+  // fast as possible.
+  uint64_t max_pages_per_second = 1024;
+};
+
 // Options used by the page-grouped database implementation.
 struct PageGroupedDBOptions {
   // If set to false, no segments larger than 1 page will be created.
@@ -43,6 +114,30 @@ struct PageGroupedDBOptions {
   size_t records_per_page_goal = 44;
   double records_per_page_epsilon = 5;
 
+  // If set to true, pages written by bulk loads and reorganizations that cannot
+  // hold their records in the regular page format are stored in a compressed
+  // format instead (keys are delta encoded and values are dictionary encoded).
+  // Combine this with a `records_per_page_goal` that exceeds what fits in a
+  // regular page to store segments in fewer pages, which reduces the number of
+  // bytes read and written.
+  //
+  // Compressed pages are read-only until they are rewritten; writes to them go
+  // to their overflow page. Records that do not fit in a page (compressed or
+  // not) are also placed in an overflow page.
+  bool compress_pages = false;
+
+  // If set to N > 0, records that do not fit on their page are appended to a
+  // delta log shared by all the pages in the segment instead of going to a
+  // per-page overflow page. The log holds up to N delta pages; the segment is
+  // only rewritten (merging in the log) once the log is full. This makes
+  // insert-heavy segments absorb more writes between reorganizations. Reads
+  // keep an in-memory key range and filter for each delta page, so a point read
+  // usually reads at most one delta page. Set to 0 to use overflow pages.
+  //
+  // Segments that already have a delta log keep using it after this option is
+  // changed, until they are rewritten.
+  size_t delta_pages_per_segment = 0;
+
   // If set to true, will write out the segment sizes and models to a CSV file
   // for debug purposes.
   bool write_debug_info = true;
@@ -56,10 +151,55 @@ struct PageGroupedDBOptions {
   // experiment setup code not related to the evaluation.
   bool use_memory_based_io = false;
 
+  // If set to true, the DB will keep its pages in memory and delay each I/O
+  // request based on a model of a storage device (see `simulated_device`).
+  // This is meant for running repeatable experiments on how the DB would
+  // perform on slower or faster devices. The pages are loaded from the DB's
+  // files when it is opened and are written back when it is closed.
+  bool use_simulated_device = false;
+  SimulatedDeviceOptions simulated_device;
+
+  // If set to true, the DB will store its segments in anonymous memory that it
+  // owns instead of in files (no `sf-*` files are created). Point reads access
+  // pages in place instead of copying them. The DB's contents are lost when it
+  // is closed, so the DB always starts out empty. This is meant for ephemeral
+  // caches and for tests. It takes precedence over `use_simulated_device`.
+  bool use_in_memory_storage = false;
+
+  // The maximum size of each in-memory segment file (there is one file per
+  // segment size). Address space for this many bytes is reserved up front, but
+  // memory is only used as segments are written.
+  size_t in_memory_max_file_mib = 64 * 1024;
+
+  // If set to true, in-memory storage will be backed by transparent huge pages
+  // when they are available.
+  bool in_memory_use_huge_pages = false;
+
+  // Options for tiered storage (disabled by default).
+  TieringOptions tiering;
+
+  // Options for the background scrubber (disabled by default).
+  ScrubberOptions scrubber;
+
+  // If set to true, an existing DB will be opened in read-only mode (e.g., for
+  // analytics on a snapshot copy of the DB). The segment files are memory
+  // mapped and reads access their pages in place without acquiring locks. The
+  // record cache is not used and writes return `Status::NotSupported()`. The
+  // DB's files must not be modified while it is open.
+  bool read_only = false;
+
   // If set to 0, no background threads will be used. The background threads are
   // only used to issue I/O in parallel when possible.
   size_t num_bg_threads = 16;
 
+  // The number of threads in the pool that runs asynchronous requests that need
+  // I/O (see `PageGroupedDB::GetAsync()`). This is a thread-per-outstanding-
+  // request pool: each thread runs one request at a time and blocks on its
+  // I/O, so at most this many requests have I/O in flight; the others are
+  // queued. Set to 0 (the default) to start no threads; the asynchronous
+  // methods are then disabled and complete with `Status::NotSupported()`.
+  size_t num_async_threads = 0;
+
   // The number of neighboring segments to check (in each direction) when
   // performing a rewrite of a segment. If set to 0, only the segment that is
   // "full" will be rewritten.
@@ -83,10 +223,61 @@ struct PageGroupedDBOptions {
   // writing out a dirty entry.
   bool rec_cache_batch_writeout = true;
 
+  // If true (and `rec_cache_batch_writeout` is true), the record cache will
+  // write out all the dirty records in the evicted record's segment instead of
+  // its page. Writes that span multiple pages of a segment are then applied
+  // using one multi-page read and one multi-page write.
+  bool rec_cache_segment_writeout = false;
+
+  // If greater than 1 (and `rec_cache_batch_writeout` is true), the record
+  // cache will defer writing out an evicted dirty record when fewer than
+  // `deferred_io_batch_size` dirty records would be written to its page (or
+  // segment). The record stays cached so that more writes to the page can
+  // accumulate, trading cache space for fewer page reads and writes. Each
+  // record is deferred at most `deferred_io_max_deferrals` times. The deferral
+  // count is kept in two bits of the record's cache metadata, so `Open()`
+  // returns InvalidArgument if `deferred_io_max_deferrals` is larger than 3.
+  size_t deferred_io_batch_size = 1;
+  uint8_t deferred_io_max_deferrals = 1;
+
+  // The capacity of the page cache in pages. The page cache holds copies of
+  // recently read pages (including overflow pages), so that reads of other
+  // records on the same page and repeated short scans avoid I/O. Written pages
+  // are removed from the page cache. The page cache's memory is separate from
+  // the record cache's. Set to 0 to disable the page cache. The page cache is
+  // never used with `use_in_memory_storage` or `read_only`, since their pages
+  // are already accessed in memory.
+  size_t page_cache_pages = 0;
+
+  // If set to true, point reads that miss in the record cache and need a page
+  // that another thread is already reading wait for that thread's I/O and copy
+  // its result instead of reading the page again. This avoids redundant reads
+  // when many threads read the same hot page at once (e.g., right after the DB
+  // is opened). It has no effect with `use_in_memory_storage` or `read_only`.
+  bool coalesce_page_reads = false;
+
+  // If set to true, each page's checksum is verified when the page is read. A
+  // read that finds a corrupted (e.g., torn) page returns a `Corruption`
+  // status. A `Put()`, record cache write out, or reorganization that needs to
+  // modify a corrupted page also returns `Corruption` and leaves the page
+  // unwritten, since writing it back would hide the corruption (dirty records
+  // that cannot be written out stay in the record cache). Page checksums are
+  // always computed when pages are written, so this option can be changed
+  // when reopening a DB.
+  bool verify_page_checksums = true;
+
   // If true, the DB will attempt to flush the dirty writes in the cache in
   // parallel when it shuts down.
   bool parallelize_final_flush = false;
 
+  // If set to true, the DB will save the keys of the hottest records in the
+  // record cache (at most `max_persisted_hot_keys` keys) to `hot_keys` in the
+  // database directory when it shuts down. When the DB is reopened, a
+  // background thread reads these records back into the record cache (in key
+  // order, reading each page once).
+  bool persist_hot_keys = false;
+  size_t max_persisted_hot_keys = 64 * 1024;
+
   // Options for insert forecasting.
   InsertForecastingOptions forecasting;
 
@@ -97,6 +288,31 @@ struct PageGroupedDBOptions {
   // If true, the DB will avoid creating new overflow pages. If a page is full,
   // the DB will start a reorganization.
   bool disable_overflow_creation = false;
+
+  // The number of most recent reorganization (segment rewrite and page chain
+  // flatten) events kept in memory. Set to 0 to keep no events in memory.
+  size_t reorg_log_capacity = 1024;
+
+  // If set to true, every reorganization event will also be appended to
+  // `debug/reorg_log.csv` in the database directory.
+  bool write_reorg_log = false;
+
+  // If set to N > 0, the DB will record one out of every N segment accesses
+  // (per thread) in per-segment access counters (reads, writes, overflow hits,
+  // and record cache misses). Set to 0 to disable access tracking. Tiered
+  // storage needs the counters, so an interval of 16 is used if tiering is
+  // enabled and this is set to 0.
+  size_t access_sample_interval = 0;
+
+  // If set to true (and access tracking is enabled), the DB will write the
+  // per-segment access counters to `debug/access_heatmap.csv` in the database
+  // directory when it shuts down.
+  bool write_access_heatmap = false;
+
+  // If non-empty, the DB will record the operations issued against it (bulk
+  // loads, reads, writes, and scans) to a binary trace file at this path. The
+  // trace can be re-issued using the `replay_trace` benchmark driver.
+  std::string trace_path;
 };
 
 struct WriteOptions {
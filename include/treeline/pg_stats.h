@@ -31,11 +31,24 @@ class PageGroupedDBStats {
   uint64_t GetCacheMisses() const { return cache_misses_; }
   uint64_t GetCacheCleanEvictions() const { return cache_clean_evictions_; }
   uint64_t GetCacheDirtyEvictions() const { return cache_dirty_evictions_; }
+  uint64_t GetCacheWarmupRecords() const { return cache_warmup_records_; }
+  uint64_t GetCacheWarmupReadErrors() const {
+    return cache_warmup_read_errors_;
+  }
+  uint64_t GetHotKeysSaveErrors() const { return hot_keys_save_errors_; }
+  uint64_t GetCacheDeferredWriteOuts() const {
+    return cache_deferred_write_outs_;
+  }
 
   uint64_t GetOverflowsCreated() const { return overflows_created_; }
   uint64_t GetRewrites() const { return rewrites_; }
   uint64_t GetRewriteInputPages() const { return rewrite_input_pages_; }
   uint64_t GetRewriteOutputPages() const { return rewrite_output_pages_; }
+  uint64_t GetPagesCompressed() const { return pages_compressed_; }
+  uint64_t GetDeltaPagesCreated() const { return delta_pages_created_; }
+  uint64_t GetDeltaPageReads() const { return delta_page_reads_; }
+  uint64_t GetSegmentsMigrated() const { return segments_migrated_; }
+  uint64_t GetPagesMigrated() const { return pages_migrated_; }
 
   uint64_t GetSegments() const { return segments_; }
   uint64_t GetFreeListEntries() const { return free_list_entries_; }
@@ -45,12 +58,49 @@ class PageGroupedDBStats {
   uint64_t GetCacheBytes() const { return cache_bytes_; }
 
   uint64_t GetOverfetchedPages() const { return overfetched_pages_; }
+  uint64_t GetPageCacheHits() const { return page_cache_hits_; }
+  uint64_t GetPageCacheMisses() const { return page_cache_misses_; }
+  uint64_t GetCoalescedPageReads() const { return coalesced_page_reads_; }
+
+  uint64_t GetPagesVerified() const { return pages_verified_; }
+  uint64_t GetPageChecksumFailures() const { return page_checksum_failures_; }
+  uint64_t GetScrubbedSegments() const { return scrubbed_segments_; }
+  uint64_t GetScrubbedPages() const { return scrubbed_pages_; }
+  uint64_t GetScrubChecksumFailures() const {
+    return scrub_checksum_failures_;
+  }
+  uint64_t GetScrubInvariantViolations() const {
+    return scrub_invariant_violations_;
+  }
+
+  uint64_t GetSegmentLockWaits() const { return segment_lock_waits_; }
+  uint64_t GetPageLockWaits() const { return page_lock_waits_; }
+  uint64_t GetReorgReaderWaits() const { return reorg_reader_waits_; }
+  uint64_t GetWriteRetries() const { return write_retries_; }
 
   void BumpCacheHits() { ++cache_hits_; }
   void BumpCacheMisses() { ++cache_misses_; }
   void BumpCacheCleanEvictions() { ++cache_clean_evictions_; }
   void BumpCacheDirtyEvictions() { ++cache_dirty_evictions_; }
 
+  // Number of records read into the record cache when warming it up after the
+  // DB was reopened (see `PageGroupedDBOptions::persist_hot_keys`).
+  void BumpCacheWarmupRecords(uint64_t delta = 1) {
+    cache_warmup_records_ += delta;
+  }
+  // Number of pages that could not be read while warming up the cache (e.g.,
+  // because they failed their checksum). Their records are not warmed up.
+  void BumpCacheWarmupReadErrors() { ++cache_warmup_read_errors_; }
+  // Number of times the DB failed to save its hot keys when shutting down
+  // (see `PageGroupedDBOptions::persist_hot_keys`). The next open then does
+  // not warm up the cache.
+  void BumpHotKeysSaveErrors() { ++hot_keys_save_errors_; }
+
+  // Number of times a dirty record's write out was deferred because too few
+  // dirty records would be written to its page (see
+  // `PageGroupedDBOptions::deferred_io_batch_size`).
+  void BumpCacheDeferredWriteOuts() { ++cache_deferred_write_outs_; }
+
   void BumpOverflowsCreated() { ++overflows_created_; }
 
   // Number of times a reorganization was initiated.
@@ -62,8 +112,61 @@ class PageGroupedDBStats {
   // Number of pages written out during a reoganization.
   void BumpRewriteOutputPages(uint64_t delta = 1) { rewrite_output_pages_ += delta; }
 
+  // Number of pages written in the compressed format during bulk loads and
+  // reorganizations (see `PageGroupedDBOptions::compress_pages`).
+  void BumpPagesCompressed() { ++pages_compressed_; }
+
+  // Number of delta pages created, and the number of delta pages read by point
+  // reads (see `PageGroupedDBOptions::delta_pages_per_segment`).
+  void BumpDeltaPagesCreated() { ++delta_pages_created_; }
+  void BumpDeltaPageReads() { ++delta_page_reads_; }
+
+  // Number of segments (and their pages) moved to the capacity storage tier.
+  void BumpSegmentsMigrated() { ++segments_migrated_; }
+  void BumpPagesMigrated(uint64_t delta = 1) { pages_migrated_ += delta; }
+
   void BumpOverfetchedPages(uint64_t delta = 1) { overfetched_pages_ += delta; }
 
+  // Number of pages requested from the page cache that were served from
+  // memory (hits) or read from storage (misses). See
+  // `PageGroupedDBOptions::page_cache_pages`.
+  void BumpPageCacheHits(uint64_t delta = 1) { page_cache_hits_ += delta; }
+  void BumpPageCacheMisses(uint64_t delta = 1) { page_cache_misses_ += delta; }
+
+  // Number of page reads that were served by another thread's concurrent read
+  // of the same page. See `PageGroupedDBOptions::coalesce_page_reads`.
+  void BumpCoalescedPageReads() { ++coalesced_page_reads_; }
+
+  // Number of pages whose checksums were verified after being read, and the
+  // number of verifications that failed. See
+  // `PageGroupedDBOptions::verify_page_checksums`.
+  void BumpPagesVerified(uint64_t delta = 1) { pages_verified_ += delta; }
+  void BumpPageChecksumFailures() { ++page_checksum_failures_; }
+
+  // Number of segments and pages checked by the background scrubber, and the
+  // number of segments that failed a checksum or structural check. See
+  // `ScrubberOptions`.
+  void BumpScrubbedSegments() { ++scrubbed_segments_; }
+  void BumpScrubbedPages(uint64_t delta = 1) { scrubbed_pages_ += delta; }
+  void BumpScrubChecksumFailures() { ++scrub_checksum_failures_; }
+  void BumpScrubInvariantViolations() { ++scrub_invariant_violations_; }
+
+  // Number of times a thread backed off because a segment lock it requested
+  // was held in a conflicting mode.
+  void BumpSegmentLockWaits() { ++segment_lock_waits_; }
+
+  // Number of times a thread backed off because a page lock it requested was
+  // held in a conflicting mode.
+  void BumpPageLockWaits() { ++page_lock_waits_; }
+
+  // Number of times a reorganization backed off while waiting for concurrent
+  // readers to leave the segment(s) being reorganized.
+  void BumpReorgReaderWaits() { ++reorg_reader_waits_; }
+
+  // Number of times a write to a segment was retried because a concurrent
+  // reorganization intervened.
+  void BumpWriteRetries() { ++write_retries_; }
+
   void SetSegments(uint64_t segments) { segments_ = segments; }
   void SetFreeListEntries(uint64_t entries) { free_list_entries_ = entries; }
   void SetFreeListBytes(uint64_t bytes) { free_list_bytes_ = bytes; }
@@ -87,6 +190,10 @@ class PageGroupedDBStats {
   uint64_t cache_misses_;
   uint64_t cache_clean_evictions_;
   uint64_t cache_dirty_evictions_;
+  uint64_t cache_warmup_records_;
+  uint64_t cache_warmup_read_errors_;
+  uint64_t hot_keys_save_errors_;
+  uint64_t cache_deferred_write_outs_;
 
   // Reorganization related counters.
   // N.B. Rewrite/reorganization are used interchangeably.
@@ -94,6 +201,13 @@ class PageGroupedDBStats {
   uint64_t rewrites_;
   uint64_t rewrite_input_pages_;
   uint64_t rewrite_output_pages_;
+  uint64_t pages_compressed_;
+  uint64_t delta_pages_created_;
+  uint64_t delta_page_reads_;
+
+  // Tiered storage counters.
+  uint64_t segments_migrated_;
+  uint64_t pages_migrated_;
 
   // Size-related stats. These are meant to be set once.
   uint64_t segments_;
@@ -106,6 +220,23 @@ class PageGroupedDBStats {
 
   // Prefetching debug stats.
   uint64_t overfetched_pages_;
+  uint64_t page_cache_hits_;
+  uint64_t page_cache_misses_;
+  uint64_t coalesced_page_reads_;
+
+  // Integrity related counters.
+  uint64_t pages_verified_;
+  uint64_t page_checksum_failures_;
+  uint64_t scrubbed_segments_;
+  uint64_t scrubbed_pages_;
+  uint64_t scrub_checksum_failures_;
+  uint64_t scrub_invariant_violations_;
+
+  // Contention related counters.
+  uint64_t segment_lock_waits_;
+  uint64_t page_lock_waits_;
+  uint64_t reorg_reader_waits_;
+  uint64_t write_retries_;
 };
 
 }  // namespace pg
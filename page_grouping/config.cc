@@ -15,3 +15,7 @@ DEFINE_bool(use_memory_based_io, false,
             "should NOT be set when running actual performance benchmarks.");
 DEFINE_uint32(write_batch_size, 1000000,
               "The number of records to batch before initiating a write.");
+DEFINE_bool(perf_counters, false,
+            "If set, hardware performance counters will be measured on each "
+            "worker thread (per workload phase) and written to "
+            "`perf_counters.csv` in the output directory.");
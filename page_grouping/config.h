@@ -9,3 +9,4 @@ DECLARE_double(records_per_page_epsilon);
 DECLARE_uint32(bg_threads);
 DECLARE_bool(use_memory_based_io);
 DECLARE_uint32(write_batch_size);
+DECLARE_bool(perf_counters);
@@ -116,8 +116,8 @@ DBState DBState::Load(const fs::path& db_path) {
   for (size_t i = 0; i < SegmentBuilder::SegmentPageCounts().size(); ++i) {
     if (i > 0 && !uses_segments) break;
     const size_t pages_per_segment = SegmentBuilder::SegmentPageCounts()[i];
-    SegmentFile sf(db_path / ("sf-" + std::to_string(i)), pages_per_segment,
-                   /*use_memory_based_io=*/true);
+    PosixSegmentFile sf(db_path / ("sf-" + std::to_string(i)),
+                        pages_per_segment, /*use_memory_based_io=*/true);
 
     const size_t num_segments = sf.NumAllocatedSegments();
     const size_t bytes_per_segment = pages_per_segment * pg::Page::kSize;
@@ -140,10 +140,12 @@ DBState DBState::Load(const fs::path& db_path) {
       }
 
       // Check if any pages in the segment declare themselves as overflow pages.
-      // In a consistent DB, overflows only exist in sf-0.
+      // In a consistent DB, overflows only exist in sf-0. Delta pages are also
+      // marked as overflows, but no page points to them (they are attached to
+      // their segment when the DB is opened).
       sw.ForEachPage(
           [&declared_overflows, &id](const size_t idx, const pg::Page& page) {
-            if (!page.IsOverflow()) return;
+            if (!page.IsOverflow() || page.IsDelta()) return;
             const auto res = declared_overflows.insert(
                 SegmentId(id.GetFileId(), id.GetOffset() + idx));
             assert(res.second);
@@ -374,12 +376,14 @@ bool DBState::CheckPageRanges() const {
   for (size_t i = 0; i < SegmentBuilder::SegmentPageCounts().size(); ++i) {
     if (i > 0 && !uses_segments_) break;
     const size_t pages_per_segment = SegmentBuilder::SegmentPageCounts()[i];
-    segment_files.push_back(std::make_unique<SegmentFile>(
+    segment_files.push_back(std::make_unique<PosixSegmentFile>(
         db_path_ / ("sf-" + std::to_string(i)), pages_per_segment,
         /*use_memory_based_io=*/true));
   }
 
   size_t total_pages = 0;
+  // Number of pages whose contents do not match their checksum.
+  size_t pages_with_bad_checksums = 0;
   // Number of pages with invalid lower/upper boundaries.
   size_t invalid_key_bounds = 0;
   // Number of pages with boundaries that are outside the segment's boundaries.
@@ -404,11 +408,22 @@ bool DBState::CheckPageRanges() const {
 
     SegmentWrap sw(buf, seg.page_count);
     Key prev_upper;
-    const auto check_page = [&seg, &invalid_key_bounds,
-                             &pages_with_incorrect_keys,
+    const auto check_page = [&seg, &pages_with_bad_checksums,
+                             &invalid_key_bounds, &pages_with_incorrect_keys,
                              &invalid_bounds_for_segment, &prev_upper,
                              &pages_leaving_gaps](const size_t idx,
                                                   const pg::Page& page) {
+      // Check the page's checksum.
+      if (!page.CheckPageChecksum()) {
+        ++pages_with_bad_checksums;
+        if (FLAGS_verbose) {
+          std::cout << "ERROR: Page " << idx << " in segment " << seg.id
+                    << " does not match its checksum." << std::endl;
+        }
+        // Do not do further validation on this page.
+        return;
+      }
+
       // Check page bounds.
       const Key lower = key_utils::ExtractHead64(page.GetLowerBoundary());
       const Key upper = key_utils::ExtractHead64(page.GetUpperBoundary());
@@ -487,6 +502,8 @@ bool DBState::CheckPageRanges() const {
     }
   }
 
+  std::cout << ">>> Pages with bad checksums: " << pages_with_bad_checksums
+            << "/" << total_pages << std::endl;
   std::cout << ">>> Pages with invalid key bounds: " << invalid_key_bounds
             << "/" << total_pages << std::endl;
   std::cout << ">>> Pages with invalid bounds for the segment: "
@@ -496,8 +513,9 @@ bool DBState::CheckPageRanges() const {
   std::cout << ">>> Pages that leave gaps in the key space: "
             << pages_leaving_gaps << "/" << total_pages << std::endl;
 
-  return invalid_key_bounds + invalid_bounds_for_segment +
-             pages_with_incorrect_keys + pages_leaving_gaps ==
+  return pages_with_bad_checksums + invalid_key_bounds +
+             invalid_bounds_for_segment + pages_with_incorrect_keys +
+             pages_leaving_gaps ==
          0;
 }
 
@@ -0,0 +1,394 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "../../bufmgr/page_memory_allocator.h"
+#include "../../util/thread_pool.h"
+#include "../persist/page.h"
+#include "../persist/segment_file.h"
+#include "../persist/segment_wrap.h"
+#include "../segment_builder.h"
+#include "gflags/gflags.h"
+
+DEFINE_string(db_path, "", "Path to the database to analyze.");
+DEFINE_uint32(threads, 0,
+              "The number of threads to use to scan the segment files. If set "
+              "to 0, one thread per hardware thread will be used.");
+DEFINE_uint64(read_batch_pages, 256,
+              "The maximum number of pages to read from a segment file in a "
+              "single I/O request. Each scan task processes one batch.");
+DEFINE_bool(use_direct_io, false,
+            "If set, the segment files will be read using direct I/O (avoids "
+            "polluting the page cache when analyzing large databases).");
+DEFINE_uint64(records_per_page_goal, 44,
+              "The records per page goal used by the database (used to report "
+              "how closely the database matches its goal).");
+DEFINE_uint32(fill_buckets, 10,
+              "The number of buckets to use for the page fill factor "
+              "distribution.");
+
+DEFINE_string(counters_csv, "",
+              "Path to a `counters.csv` file written by a benchmark run. If "
+              "set, write amplification statistics will be reported.");
+DEFINE_string(write_counts_csv, "",
+              "Path to a `write_counts.csv` file written by a benchmark run. "
+              "Used to compute the total number of pages written.");
+DEFINE_uint64(user_writes, 0,
+              "The number of records written by the user during the "
+              "benchmark run (used to compute write amplification).");
+DEFINE_uint64(record_size_bytes, 16,
+              "The size of each user-written record, in bytes (used to "
+              "compute write amplification).");
+
+namespace {
+
+using namespace tl::pg;
+using tl::PageBuffer;
+using tl::PageMemoryAllocator;
+using tl::ThreadPool;
+namespace fs = std::filesystem;
+
+// Statistics about the pages in one segment file.
+struct FileSpace {
+  uint64_t file_bytes = 0;
+  uint64_t allocated_segments = 0;
+  uint64_t live_segments = 0;
+  uint64_t free_segments = 0;
+  // Overflow pages are single-page segments (they only exist in `sf-0`).
+  uint64_t overflow_pages = 0;
+  uint64_t records = 0;
+  // Bytes used by records (keys, values, and per-record metadata) in valid
+  // pages.
+  uint64_t used_bytes = 0;
+
+  void Merge(const FileSpace& other) {
+    allocated_segments += other.allocated_segments;
+    live_segments += other.live_segments;
+    free_segments += other.free_segments;
+    overflow_pages += other.overflow_pages;
+    records += other.records;
+    used_bytes += other.used_bytes;
+  }
+};
+
+// Statistics computed by one scan task. Tasks' results are merged together.
+struct SpaceStats {
+  explicit SpaceStats(size_t num_files, size_t fill_buckets)
+      : files(num_files),
+        main_fill(fill_buckets, 0),
+        overflow_fill(fill_buckets, 0) {}
+
+  std::vector<FileSpace> files;
+  // Page fill factor histograms (for pages in live segments and for overflow
+  // pages).
+  std::vector<uint64_t> main_fill;
+  std::vector<uint64_t> overflow_fill;
+  // Main pages (pages in live segments) that point to an overflow page.
+  uint64_t pages_with_overflow = 0;
+  uint64_t overflow_records = 0;
+
+  void Merge(const SpaceStats& other) {
+    for (size_t i = 0; i < files.size(); ++i) {
+      files[i].Merge(other.files[i]);
+    }
+    for (size_t i = 0; i < main_fill.size(); ++i) {
+      main_fill[i] += other.main_fill[i];
+      overflow_fill[i] += other.overflow_fill[i];
+    }
+    pages_with_overflow += other.pages_with_overflow;
+    overflow_records += other.overflow_records;
+  }
+};
+
+size_t FillBucket(const Page& page) {
+  const double used =
+      static_cast<double>(Page::UsableSize() - page.GetFreeSpace());
+  const double fill = used / Page::UsableSize();
+  return std::min(static_cast<size_t>(fill * FLAGS_fill_buckets),
+                  static_cast<size_t>(FLAGS_fill_buckets - 1));
+}
+
+// Scans the segments `[seg_begin, seg_end)` in the given segment file.
+SpaceStats ScanSegments(const SegmentFile& sf, const size_t file_id,
+                        const size_t num_files, const size_t seg_begin,
+                        const size_t seg_end) {
+  SpaceStats stats(num_files, FLAGS_fill_buckets);
+  FileSpace& file = stats.files[file_id];
+  const size_t pages_per_segment = sf.PagesPerSegment();
+  const size_t num_pages = (seg_end - seg_begin) * pages_per_segment;
+
+  PageBuffer buf = PageMemoryAllocator::Allocate(num_pages);
+  sf.ReadPages(seg_begin * pages_per_segment * Page::kSize, buf.get(),
+               num_pages);
+
+  for (size_t seg_idx = seg_begin; seg_idx < seg_end; ++seg_idx) {
+    ++file.allocated_segments;
+    void* const seg_buf =
+        buf.get() + (seg_idx - seg_begin) * pages_per_segment * Page::kSize;
+    SegmentWrap sw(seg_buf, pages_per_segment);
+    const Page first_page(seg_buf);
+
+    // Uses the same criteria as `Manager::Reopen()`.
+    if (!sw.CheckChecksum() || !first_page.IsValid()) {
+      ++file.free_segments;
+      continue;
+    }
+    if (first_page.IsOverflow()) {
+      ++file.overflow_pages;
+      file.records += first_page.GetNumRecords();
+      file.used_bytes += Page::UsableSize() - first_page.GetFreeSpace();
+      stats.overflow_records += first_page.GetNumRecords();
+      ++stats.overflow_fill[FillBucket(first_page)];
+      continue;
+    }
+
+    ++file.live_segments;
+    sw.ForEachPage([&](const size_t, const Page& page) {
+      file.records += page.GetNumRecords();
+      file.used_bytes += Page::UsableSize() - page.GetFreeSpace();
+      ++stats.main_fill[FillBucket(page)];
+      if (page.HasOverflow()) {
+        ++stats.pages_with_overflow;
+      }
+    });
+  }
+  return stats;
+}
+
+// Reads a `name,value` CSV file (e.g., `counters.csv`).
+std::unordered_map<std::string, uint64_t> ReadCounters(const fs::path& path) {
+  std::unordered_map<std::string, uint64_t> counters;
+  std::ifstream in(path);
+  std::string line;
+  // Skip the header.
+  std::getline(in, line);
+  while (std::getline(in, line)) {
+    const size_t comma = line.find(',');
+    if (comma == std::string::npos) continue;
+    counters[line.substr(0, comma)] = std::stoull(line.substr(comma + 1));
+  }
+  return counters;
+}
+
+void PrintHistogram(std::ostream& out, const std::vector<uint64_t>& hist) {
+  uint64_t total = 0;
+  for (const auto count : hist) total += count;
+  const double bucket_width = 100.0 / hist.size();
+  const auto flags = out.flags();
+  const auto precision = out.precision();
+  for (size_t i = 0; i < hist.size(); ++i) {
+    out << "  [" << std::setw(5) << std::fixed << std::setprecision(1)
+        << (i * bucket_width) << "%, " << std::setw(5)
+        << ((i + 1) * bucket_width) << "%" << (i + 1 == hist.size() ? "]" : ")")
+        << ": " << hist[i];
+    if (total > 0) {
+      out << " (" << std::setprecision(2) << (100.0 * hist[i] / total) << "%)";
+    }
+    out << std::endl;
+  }
+  out.flags(flags);
+  out.precision(precision);
+}
+
+void PrintWriteAmplification(std::ostream& out) {
+  const auto counters = ReadCounters(FLAGS_counters_csv);
+  const auto get = [&counters](const std::string& name) -> uint64_t {
+    const auto it = counters.find(name);
+    return it == counters.end() ? 0 : it->second;
+  };
+  const uint64_t rewrites = get("rewrites");
+  const uint64_t rewrite_in = get("rewrite_input_pages");
+  const uint64_t rewrite_out = get("rewrite_output_pages");
+
+  out << std::endl << ">>> Write amplification" << std::endl;
+  out << "Rewrites: " << rewrites << std::endl;
+  out << "Overflows created: " << get("overflows_created") << std::endl;
+  out << "Rewrite input pages: " << rewrite_in << std::endl;
+  out << "Rewrite output pages: " << rewrite_out << std::endl;
+  if (rewrites > 0) {
+    out << "Average output pages per rewrite: "
+        << static_cast<double>(rewrite_out) / rewrites << std::endl;
+  }
+  if (rewrite_in > 0) {
+    out << "Rewrite output/input page ratio: "
+        << static_cast<double>(rewrite_out) / rewrite_in << std::endl;
+  }
+
+  if (FLAGS_write_counts_csv.empty()) return;
+  // The `write_counts.csv` file maps the number of contiguous pages written to
+  // the number of writes of that size.
+  const auto write_counts = ReadCounters(FLAGS_write_counts_csv);
+  uint64_t pages_written = 0;
+  for (const auto& [num_pages, count] : write_counts) {
+    pages_written += std::stoull(num_pages) * count;
+  }
+  out << "Total pages written: " << pages_written << std::endl;
+  if (pages_written > 0) {
+    out << "Fraction of page writes due to rewrites: "
+        << static_cast<double>(rewrite_out) / pages_written << std::endl;
+  }
+  if (FLAGS_user_writes > 0) {
+    const double user_bytes =
+        static_cast<double>(FLAGS_user_writes) * FLAGS_record_size_bytes;
+    out << "Cumulative write amplification (bytes written / user bytes): "
+        << (pages_written * Page::kSize) / user_bytes << std::endl;
+  }
+}
+
+void RunAnalysis() {
+  const fs::path db_path(FLAGS_db_path);
+  const bool uses_segments = fs::exists(db_path / "sf-1");
+  const size_t num_files =
+      uses_segments ? SegmentBuilder::SegmentPageCounts().size() : 1;
+
+  std::vector<std::unique_ptr<SegmentFile>> segment_files;
+  for (size_t i = 0; i < num_files; ++i) {
+    segment_files.push_back(std::make_unique<PosixSegmentFile>(
+        db_path / ("sf-" + std::to_string(i)),
+        SegmentBuilder::SegmentPageCounts()[i],
+        /*use_memory_based_io=*/!FLAGS_use_direct_io));
+  }
+
+  const size_t num_threads =
+      FLAGS_threads > 0 ? FLAGS_threads
+                        : std::max(1U, std::thread::hardware_concurrency());
+  std::cout << ">>> Scanning " << num_files << " segment file(s) using "
+            << num_threads << " thread(s)..." << std::endl;
+
+  // Split each file into batches of (at most) `read_batch_pages` pages. Each
+  // batch is scanned by one task.
+  std::vector<std::future<SpaceStats>> tasks;
+  {
+    ThreadPool pool(num_threads);
+    for (size_t i = 0; i < num_files; ++i) {
+      const SegmentFile& sf = *segment_files[i];
+      const size_t segments_per_batch =
+          std::max(static_cast<size_t>(1),
+                   FLAGS_read_batch_pages / sf.PagesPerSegment());
+      const size_t num_segments = sf.NumAllocatedSegments();
+      for (size_t begin = 0; begin < num_segments;
+           begin += segments_per_batch) {
+        const size_t end = std::min(begin + segments_per_batch, num_segments);
+        tasks.push_back(pool.Submit(ScanSegments, std::cref(sf), i, num_files,
+                                    begin, end));
+      }
+    }
+  }
+
+  SpaceStats stats(num_files, FLAGS_fill_buckets);
+  for (auto& task : tasks) {
+    stats.Merge(task.get());
+  }
+  for (size_t i = 0; i < num_files; ++i) {
+    stats.files[i].file_bytes =
+        fs::file_size(db_path / ("sf-" + std::to_string(i)));
+  }
+
+  // Per-file utilization.
+  std::cout << std::endl << ">>> Segment file utilization" << std::endl;
+  uint64_t total_file_bytes = 0, total_used_bytes = 0, total_records = 0;
+  uint64_t main_pages = 0;
+  for (size_t i = 0; i < num_files; ++i) {
+    const FileSpace& file = stats.files[i];
+    const size_t pages_per_segment = SegmentBuilder::SegmentPageCounts()[i];
+    const uint64_t live_pages =
+        file.live_segments * pages_per_segment + file.overflow_pages;
+    main_pages += file.live_segments * pages_per_segment;
+    total_file_bytes += file.file_bytes;
+    total_used_bytes += file.used_bytes;
+    total_records += file.records;
+    std::cout << "sf-" << i << " (" << pages_per_segment
+              << " page segments): " << file.file_bytes << " bytes, "
+              << file.allocated_segments << " allocated segments, "
+              << file.live_segments << " live, " << file.overflow_pages
+              << " overflow pages, " << file.free_segments << " free"
+              << std::endl;
+    if (file.file_bytes > 0) {
+      std::cout << "  Live pages / file size: "
+                << static_cast<double>(live_pages * Page::kSize) /
+                       file.file_bytes
+                << std::endl;
+      std::cout << "  Record bytes / file size: "
+                << static_cast<double>(file.used_bytes) / file.file_bytes
+                << std::endl;
+    }
+    if (file.live_segments > 0) {
+      std::cout << "  Average records per segment: "
+                << static_cast<double>(file.records) / file.live_segments
+                << " (goal: " << FLAGS_records_per_page_goal * pages_per_segment
+                << ")" << std::endl;
+    }
+  }
+  if (total_file_bytes > 0) {
+    std::cout << "Overall record bytes / file size: "
+              << static_cast<double>(total_used_bytes) / total_file_bytes
+              << std::endl;
+  }
+
+  // Free segments.
+  std::cout << std::endl << ">>> Free segments summary" << std::endl;
+  for (size_t i = 0; i < num_files; ++i) {
+    std::cout << "Length " << SegmentBuilder::SegmentPageCounts()[i] << ": "
+              << stats.files[i].free_segments << std::endl;
+  }
+
+  // Fill factor and overflows.
+  const uint64_t overflow_pages = stats.files[0].overflow_pages;
+  std::cout << std::endl
+            << ">>> Page fill factor distribution (" << main_pages
+            << " segment pages)" << std::endl;
+  PrintHistogram(std::cout, stats.main_fill);
+  std::cout << std::endl
+            << ">>> Overflow page fill factor distribution (" << overflow_pages
+            << " overflow pages)" << std::endl;
+  PrintHistogram(std::cout, stats.overflow_fill);
+
+  std::cout << std::endl << ">>> Overflows" << std::endl;
+  std::cout << "Overflow pages: " << overflow_pages << std::endl;
+  std::cout << "Segment pages with an overflow: " << stats.pages_with_overflow
+            << std::endl;
+  if (main_pages > 0) {
+    std::cout << "Overflow ratio (overflow pages / segment pages): "
+              << static_cast<double>(overflow_pages) / main_pages << std::endl;
+    std::cout << "Average records per segment page (incl. overflows): "
+              << static_cast<double>(total_records) / main_pages
+              << " (goal: " << FLAGS_records_per_page_goal << ")" << std::endl;
+  }
+  if (total_records > 0) {
+    std::cout << "Records in overflow pages: " << stats.overflow_records << "/"
+              << total_records << std::endl;
+  }
+
+  if (!FLAGS_counters_csv.empty()) {
+    PrintWriteAmplification(std::cout);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  gflags::SetUsageMessage(
+      "Report space utilization and write amplification statistics for a page "
+      "grouped DB.");
+  gflags::ParseCommandLineFlags(&argc, &argv, /*remove_flags=*/true);
+
+  if (FLAGS_db_path.empty()) {
+    std::cerr << "ERROR: Must provide a path to an existing DB." << std::endl;
+    return 1;
+  }
+  if (FLAGS_fill_buckets == 0) {
+    std::cerr << "ERROR: --fill_buckets must be positive." << std::endl;
+    return 1;
+  }
+
+  RunAnalysis();
+  return 0;
+}
@@ -0,0 +1,101 @@
+#include "delta_index.h"
+
+#include <algorithm>
+
+#include "util/key.h"
+
+namespace {
+
+// The 64-bit finalizer from MurmurHash3.
+uint64_t Mix(uint64_t key) {
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdULL;
+  key ^= key >> 33;
+  key *= 0xc4ceb9fe1a85ec53ULL;
+  key ^= key >> 33;
+  return key;
+}
+
+}  // namespace
+
+namespace tl {
+namespace pg {
+
+void DeltaFilter::Add(const Key key) {
+  // Probes are derived from one hash (double hashing).
+  const uint64_t hash = Mix(key);
+  const uint64_t step = (hash >> 32) | 1;
+  for (size_t i = 0; i < kNumProbes; ++i) {
+    const size_t bit = (hash + i * step) % kNumBits;
+    bits_[bit / 64] |= 1ULL << (bit % 64);
+  }
+}
+
+bool DeltaFilter::MayContain(const Key key) const {
+  const uint64_t hash = Mix(key);
+  const uint64_t step = (hash >> 32) | 1;
+  for (size_t i = 0; i < kNumProbes; ++i) {
+    const size_t bit = (hash + i * step) % kNumBits;
+    if ((bits_[bit / 64] & (1ULL << (bit % 64))) == 0) return false;
+  }
+  return true;
+}
+
+DeltaIndex::PageInfo DeltaIndex::PageInfo::FromPage(const SegmentId id,
+                                                    const Page& page) {
+  PageInfo info;
+  info.id = id;
+  for (auto it = page.GetIterator(); it.Valid(); it.Next()) {
+    info.Add(key_utils::ExtractHead64(it.key()));
+  }
+  return info;
+}
+
+void DeltaIndex::PageInfo::Add(const Key key) {
+  if (num_records == 0) {
+    min_key = key;
+    max_key = key;
+  } else {
+    min_key = std::min(min_key, key);
+    max_key = std::max(max_key, key);
+  }
+  ++num_records;
+  filter.Add(key);
+}
+
+bool DeltaIndex::PageInfo::MayContain(const Key key) const {
+  return MayOverlap(key, key) && filter.MayContain(key);
+}
+
+std::shared_ptr<DeltaIndex::Log> DeltaIndex::Find(
+    const SegmentId segment_id) const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  const auto it = logs_.find(segment_id);
+  if (it == logs_.end()) return nullptr;
+  return it->second;
+}
+
+std::shared_ptr<DeltaIndex::Log> DeltaIndex::GetOrCreate(
+    const SegmentId segment_id) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto& log = logs_[segment_id];
+  if (log == nullptr) {
+    log = std::make_shared<Log>();
+    num_logs_.store(logs_.size(), std::memory_order_release);
+  }
+  return log;
+}
+
+std::shared_ptr<DeltaIndex::Log> DeltaIndex::Remove(
+    const SegmentId segment_id) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  const auto it = logs_.find(segment_id);
+  if (it == logs_.end()) return nullptr;
+  std::shared_ptr<Log> log = std::move(it->second);
+  logs_.erase(it);
+  num_logs_.store(logs_.size(), std::memory_order_release);
+  return log;
+}
+
+}  // namespace pg
+}  // namespace tl
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "key.h"
+#include "persist/page.h"
+#include "persist/segment_id.h"
+
+namespace tl {
+namespace pg {
+
+// An in-memory Bloom filter over the keys stored in one delta page. It is used
+// to skip delta pages that cannot hold a key without reading them.
+class DeltaFilter {
+ public:
+  void Add(Key key);
+  bool MayContain(Key key) const;
+
+ private:
+  static constexpr size_t kNumBits = 1024;
+  static constexpr size_t kNumProbes = 3;
+  std::array<uint64_t, kNumBits / 64> bits_ = {};
+};
+
+// Tracks the delta pages of each segment (see
+// `PageGroupedDBOptions::delta_pages_per_segment`).
+//
+// Records that do not fit on their page are appended to their segment's delta
+// log, a short list of single pages (stored in the first segment file, like
+// overflow pages) that hold records for any of the segment's pages. Newer delta
+// pages hold newer records. The log is merged into the segment by a segment
+// rewrite once it is full.
+//
+// This class only keeps the logs' in-memory summaries (fences and filters); the
+// delta pages themselves are read and written by `Manager`. This class is
+// thread-safe.
+class DeltaIndex {
+ public:
+  // The in-memory summary of one delta page.
+  struct PageInfo {
+    // Summarizes the records in `page`, which is stored at `id`.
+    static PageInfo FromPage(SegmentId id, const Page& page);
+
+    // Updates the summary after `key` is added to the page.
+    void Add(Key key);
+
+    // Returns false if the page cannot hold `key`.
+    bool MayContain(Key key) const;
+
+    // Returns false if the page cannot hold a key in `[lower, upper]`.
+    bool MayOverlap(Key lower, Key upper) const {
+      return num_records > 0 && min_key <= upper && lower <= max_key;
+    }
+
+    SegmentId id;
+    size_t num_records = 0;
+    Key min_key = 0, max_key = 0;
+    DeltaFilter filter;
+  };
+
+  // A segment's delta log. `mutex` must be held in shared mode while the delta
+  // pages are read and in exclusive mode while they are modified.
+  struct Log {
+    std::shared_mutex mutex;
+    // Oldest first.
+    std::vector<PageInfo> pages;
+  };
+
+  DeltaIndex() : num_logs_(0) {}
+
+  DeltaIndex(const DeltaIndex&) = delete;
+  DeltaIndex& operator=(const DeltaIndex&) = delete;
+
+  // Returns true if no segment has a delta log. Callers that hold a lock on
+  // one of a segment's pages can use this to skip the lookup in `Find()`.
+  bool Empty() const { return num_logs_.load(std::memory_order_acquire) == 0; }
+
+  // Returns the delta log of the segment `segment_id`, or `nullptr` if it does
+  // not have one.
+  std::shared_ptr<Log> Find(SegmentId segment_id) const;
+
+  // Returns the delta log of the segment `segment_id`, creating an empty log if
+  // needed.
+  std::shared_ptr<Log> GetOrCreate(SegmentId segment_id);
+
+  // Removes and returns the delta log of the segment `segment_id` (or
+  // `nullptr` if it does not have one). Must only be called while no other
+  // thread can access the segment (e.g., during a segment rewrite).
+  std::shared_ptr<Log> Remove(SegmentId segment_id);
+
+ private:
+  mutable std::mutex mutex_;
+  std::unordered_map<SegmentId, std::shared_ptr<Log>> logs_;
+  std::atomic<size_t> num_logs_;
+};
+
+}  // namespace pg
+}  // namespace tl
@@ -10,7 +10,8 @@ namespace pg {
 FreeList::FreeList()
     : bytes_allocated_(0),
       list_(TrackingAllocator<SegmentList>(bytes_allocated_)) {
-  list_.resize(SegmentBuilder::SegmentPageCounts().size());
+  list_.resize(SegmentBuilder::SegmentPageCounts().size() *
+               SegmentId::kNumTiers);
 }
 
 void FreeList::Add(SegmentId id) {
@@ -18,17 +19,18 @@ void FreeList::Add(SegmentId id) {
   AddImpl(id);
 }
 
-std::optional<SegmentId> FreeList::Get(const size_t page_count) {
+std::optional<SegmentId> FreeList::Get(const size_t page_count,
+                                       const size_t tier) {
   std::unique_lock<std::mutex> lock(mutex_);
   const auto it = SegmentBuilder::PageCountToSegment().find(page_count);
   assert(it != SegmentBuilder::PageCountToSegment().end());
-  const size_t file_id = it->second;
-  if (list_[file_id].empty()) {
+  SegmentList& list = list_[ListIndex(it->second, tier)];
+  if (list.empty()) {
     // No free segments. The caller should allocate a new one.
     return std::optional<SegmentId>();
   }
-  const SegmentId free = list_[file_id].front();
-  list_[file_id].pop();
+  const SegmentId free = list.front();
+  list.pop();
   return free;
 }
 
@@ -39,7 +41,14 @@ void FreeList::AddBatch(const std::vector<SegmentId>& ids) {
   }
 }
 
-void FreeList::AddImpl(SegmentId id) { list_[id.GetFileId()].push(id); }
+void FreeList::AddImpl(SegmentId id) {
+  list_[ListIndex(id.GetFileId(), id.GetTier())].push(id);
+}
+
+size_t FreeList::ListIndex(const size_t file_id, const size_t tier) {
+  assert(tier < SegmentId::kNumTiers);
+  return tier * SegmentBuilder::SegmentPageCounts().size() + file_id;
+}
 
 uint64_t FreeList::GetSizeFootprint() const {
   std::unique_lock<std::mutex> lock(mutex_);
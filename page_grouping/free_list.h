@@ -20,13 +20,17 @@ class FreeList {
   FreeList();
   void Add(SegmentId id);
   void AddBatch(const std::vector<SegmentId>& ids);
-  std::optional<SegmentId> Get(size_t page_count);
+  // Returns a free segment with `page_count` pages in the given storage tier,
+  // if one exists.
+  std::optional<SegmentId> Get(size_t page_count, size_t tier = 0);
 
   uint64_t GetSizeFootprint() const;
   uint64_t GetNumEntries() const;
 
  private:
   void AddImpl(SegmentId id);
+  // Free segments are kept in separate lists for each segment size and tier.
+  static size_t ListIndex(size_t file_id, size_t tier);
 
   mutable std::mutex mutex_;
   using SegmentList =
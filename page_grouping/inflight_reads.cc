@@ -0,0 +1,84 @@
+#include "inflight_reads.h"
+
+#include <cstring>
+
+#include "persist/page.h"
+
+namespace {
+
+constexpr size_t kNumShards = 64;
+
+}  // namespace
+
+namespace tl {
+namespace pg {
+
+InflightReads::InflightReads() : shards_(new Shard[kNumShards]) {}
+
+InflightReads::Shard& InflightReads::ShardFor(const uint64_t page_id) const {
+  return shards_[page_id % kNumShards];
+}
+
+InflightReads::Role InflightReads::Begin(const uint64_t page_id,
+                                         Inflight* const self, void* out) {
+  Shard& shard = ShardFor(page_id);
+  std::unique_lock<std::mutex> shard_lock(shard.mutex);
+
+  // Probe every slot, starting from the page's home slot. Removals leave holes
+  // in the probe sequence, so an empty slot does not end the search (the
+  // shards are small enough for this to be cheap).
+  const size_t home = (page_id / kNumShards) % kSlotsPerShard;
+  Slot* free_slot = nullptr;
+  Inflight* other = nullptr;
+  for (size_t i = 0; i < kSlotsPerShard; ++i) {
+    Slot& slot = shard.slots[(home + i) % kSlotsPerShard];
+    if (slot.read == nullptr) {
+      if (free_slot == nullptr) free_slot = &slot;
+    } else if (slot.page_id == page_id) {
+      other = slot.read;
+      break;
+    }
+  }
+
+  if (other == nullptr) {
+    if (free_slot == nullptr) return Role::kUncoordinated;
+    free_slot->page_id = page_id;
+    free_slot->read = self;
+    return Role::kReader;
+  }
+
+  // Join the read that is in flight. Registering under the shard lock ensures
+  // the reading thread waits for us before it returns.
+  std::unique_lock<std::mutex> lock(other->mutex);
+  shard_lock.unlock();
+  ++other->num_waiting;
+  other->cv.wait(lock, [other]() { return other->done; });
+  const bool copied = other->data != nullptr;
+  if (copied) memcpy(out, other->data, Page::kSize);
+  if (--other->num_waiting == 0) other->cv.notify_all();
+  // The other read failed (it threw an exception), so we retry the read.
+  return copied ? Role::kCopied : Role::kUncoordinated;
+}
+
+void InflightReads::Finish(const uint64_t page_id, Inflight* const self,
+                           const void* data) {
+  // New readers of the page now issue their own I/O.
+  {
+    Shard& shard = ShardFor(page_id);
+    std::unique_lock<std::mutex> shard_lock(shard.mutex);
+    for (Slot& slot : shard.slots) {
+      if (slot.read == self) {
+        slot.read = nullptr;
+        break;
+      }
+    }
+  }
+  std::unique_lock<std::mutex> lock(self->mutex);
+  self->data = data;
+  self->done = true;
+  self->cv.notify_all();
+  self->cv.wait(lock, [self]() { return self->num_waiting == 0; });
+}
+
+}  // namespace pg
+}  // namespace tl
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+namespace tl {
+namespace pg {
+
+// Coalesces concurrent reads of the same page (see
+// `PageGroupedDBOptions::coalesce_page_reads`). The first thread that reads a
+// page issues the I/O into its own buffer. Threads that read the same page
+// while that I/O is in flight wait for it to finish and copy the page from the
+// first thread's buffer instead of issuing their own I/O.
+//
+// Pages are identified by a 64-bit ID (e.g., the `SegmentId` value of the
+// page). The table is split into independently locked shards, each with a
+// fixed number of slots, so reads do not allocate memory. If all of a shard's
+// slots are in use, the read is issued without coalescing. This class is
+// thread-safe.
+class InflightReads {
+ public:
+  InflightReads();
+
+  InflightReads(const InflightReads&) = delete;
+  InflightReads& operator=(const InflightReads&) = delete;
+
+  // Reads the page `page_id` into `out`. If no other thread is reading the
+  // page, `read(out)` is called to read it. Otherwise this waits for the other
+  // thread's read and copies its result. Returns true iff the page was copied
+  // from another thread's read.
+  //
+  // Callers must ensure that the page is not modified while they read it
+  // (e.g., by holding the page's lock in shared mode).
+  template <class ReadFn>
+  bool Read(uint64_t page_id, void* out, const ReadFn& read) {
+    Inflight self;
+    switch (Begin(page_id, &self, out)) {
+      case Role::kCopied:
+        return true;
+      case Role::kUncoordinated:
+        read(out);
+        return false;
+      case Role::kReader:
+        break;
+    }
+    try {
+      read(out);
+    } catch (...) {
+      Finish(page_id, &self, /*data=*/nullptr);
+      throw;
+    }
+    Finish(page_id, &self, out);
+    return false;
+  }
+
+ private:
+  // Lives on the stack of the thread that issues the I/O. That thread waits
+  // for all the threads that joined its read to copy the page before it
+  // returns.
+  struct Inflight {
+    std::mutex mutex;
+    std::condition_variable cv;
+    const void* data = nullptr;
+    bool done = false;
+    size_t num_waiting = 0;
+  };
+  // An open addressing table. A slot is empty if its `read` is null.
+  static constexpr size_t kSlotsPerShard = 8;
+  struct Slot {
+    uint64_t page_id = 0;
+    Inflight* read = nullptr;
+  };
+  struct Shard {
+    std::mutex mutex;
+    std::array<Slot, kSlotsPerShard> slots;
+  };
+
+  enum class Role {
+    // The page was copied from another thread's read.
+    kCopied,
+    // The caller must read the page without publishing it (its shard is full,
+    // or the read it joined failed).
+    kUncoordinated,
+    // The caller must read the page and then call `Finish()`.
+    kReader,
+  };
+
+  Shard& ShardFor(uint64_t page_id) const;
+  // Registers `self` as the read of `page_id`, or joins the read that is
+  // already in flight (copying its result into `out`).
+  Role Begin(uint64_t page_id, Inflight* self, void* out);
+  // Publishes the result of the read `self` (`data` is null if it failed) and
+  // waits until the threads that joined it are done with `data`.
+  void Finish(uint64_t page_id, Inflight* self, const void* data);
+
+  std::unique_ptr<Shard[]> shards_;
+};
+
+}  // namespace pg
+}  // namespace tl
@@ -3,6 +3,7 @@
 #include <cassert>
 
 #include "rand_exp_backoff.h"
+#include "treeline/pg_stats.h"
 
 namespace {
 
@@ -111,6 +112,7 @@ void LockManager::UpgradeSegmentLockToReorgExclusive(const SegmentId& seg_id) {
   if (!can_return) {
     RandExpBackoff backoff(kBackoffSaturate);
     while (!can_return) {
+      PageGroupedDBStats::Local().BumpReorgReaderWaits();
       backoff.Wait();
       const bool found = segment_locks_.find_fn(
           id, [&can_return](const SegmentLockState& lock_state) {
@@ -160,6 +162,7 @@ void LockManager::AcquirePageLock(const SegmentId& seg_id,
   while (true) {
     const bool granted = TryAcquirePageLock(seg_id, page_idx, requested_mode);
     if (granted) return;
+    PageGroupedDBStats::Local().BumpPageLockWaits();
     backoff.Wait();
   }
 }
@@ -1,17 +1,25 @@
 #include "manager.h"
 
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <limits>
 #include <optional>
+#include <shared_mutex>
 #include <sstream>
+#include <stdexcept>
 
 #include "bufmgr/page_memory_allocator.h"
 #include "key.h"
+#include "persist/cached_segment_file.h"
+#include "persist/mapped_segment_file.h"
+#include "persist/memory_segment_file.h"
 #include "persist/merge_iterator.h"
 #include "persist/page.h"
 #include "persist/segment_file.h"
+#include "persist/simulated_segment_file.h"
 #include "persist/segment_wrap.h"
 #include "segment_builder.h"
 #include "treeline/pg_db.h"
@@ -28,6 +36,9 @@ using PageMode = LockManager::PageMode;
 
 thread_local Workspace Manager::w_;
 const std::string Manager::kSegmentFilePrefix = "sf-";
+const std::string Manager::kDebugDirName = "debug";
+const std::string Manager::kReorgLogCsvFileName = "reorg_log.csv";
+const std::string Manager::kAccessHeatmapCsvFileName = "access_heatmap.csv";
 
 Manager::Manager(fs::path db_path,
                  std::vector<std::pair<Key, SegmentInfo>> boundaries,
@@ -38,12 +49,49 @@ Manager::Manager(fs::path db_path,
       lock_manager_(std::make_shared<LockManager>()),
       index_(std::make_unique<SegmentIndex>(lock_manager_)),
       segment_files_(std::move(segment_files)),
-      next_sequence_number_(next_sequence_number),
+      next_sequence_number_(
+          std::make_unique<std::atomic<uint32_t>>(next_sequence_number)),
       free_(std::move(free)),
+      deltas_(std::make_unique<DeltaIndex>()),
       options_(std::move(options)) {
   if (!boundaries.empty()) {
     index_->BulkLoadFromEmpty(boundaries.begin(), boundaries.end());
   }
+  if (options_.page_cache_pages > 0 && !options_.read_only &&
+      !options_.use_in_memory_storage) {
+    // All the segment files share one page cache.
+    const auto page_cache =
+        std::make_shared<PageCache>(options_.page_cache_pages);
+    for (size_t i = 0; i < segment_files_.size(); ++i) {
+      segment_files_[i] = std::make_unique<CachedSegmentFile>(
+          std::move(segment_files_[i]), i, page_cache);
+    }
+  }
+  if (options_.coalesce_page_reads && !options_.read_only &&
+      !options_.use_in_memory_storage) {
+    inflight_reads_ = std::make_unique<InflightReads>();
+  }
+  if (options_.reorg_log_capacity > 0 || options_.write_reorg_log) {
+    std::optional<fs::path> csv_path;
+    if (options_.write_reorg_log) {
+      const auto debug_path = db_path_ / kDebugDirName;
+      fs::create_directories(debug_path);
+      csv_path = debug_path / kReorgLogCsvFileName;
+    }
+    reorg_log_ = std::make_unique<ReorgLog>(options_.reorg_log_capacity,
+                                            std::move(csv_path));
+  }
+  if (options_.access_sample_interval > 0) {
+    access_tracker_ = std::make_unique<SegmentAccessTracker>(
+        options_.access_sample_interval);
+  } else if (HasCapacityTier() && !options_.read_only) {
+    // Tiering uses the access counts to estimate segment temperatures.
+    access_tracker_ = std::make_unique<SegmentAccessTracker>(
+        /*sample_interval=*/16);
+  }
+  if (HasCapacityTier()) {
+    migration_ = std::make_unique<MigrationState>();
+  }
   if (options_.num_bg_threads > 0) {
     bg_threads_ = std::make_unique<ThreadPool>(options_.num_bg_threads, []() {
       // Make sure all locally recorded stats are exposed.
@@ -64,32 +112,103 @@ Manager Manager::LoadIntoNew(const fs::path& db,
   }
 }
 
+std::vector<std::unique_ptr<SegmentFile>> Manager::OpenSegmentFiles(
+    const fs::path& db_path, const size_t num_files,
+    const PageGroupedDBOptions& options) {
+  const size_t num_sizes = SegmentBuilder::SegmentPageCounts().size();
+  assert(num_files <= num_sizes);
+  // The capacity tier is only used when the DB stores segments.
+  const bool use_capacity_tier =
+      !options.tiering.capacity_tier_path.empty() && num_files == num_sizes;
+  const fs::path capacity_path = options.tiering.capacity_tier_path;
+  if (use_capacity_tier && !options.read_only) {
+    fs::create_directories(capacity_path);
+  }
+
+  // All the files in a tier share one simulated device.
+  std::shared_ptr<SimulatedDevice> device, capacity_device;
+  if (options.use_simulated_device && !options.use_in_memory_storage &&
+      !options.read_only) {
+    device = std::make_shared<SimulatedDevice>(options.simulated_device);
+    if (use_capacity_tier) {
+      capacity_device = std::make_shared<SimulatedDevice>(
+          options.tiering.capacity_simulated_device);
+    }
+  }
+
+  std::vector<std::unique_ptr<SegmentFile>> segment_files;
+  const size_t num_tiers = use_capacity_tier ? SegmentId::kNumTiers : 1;
+  for (size_t tier = 0; tier < num_tiers; ++tier) {
+    const fs::path& dir = tier == 0 ? db_path : capacity_path;
+    for (size_t i = 0; i < num_files; ++i) {
+      const fs::path path = dir / (kSegmentFilePrefix + std::to_string(i));
+      const size_t pages_per_segment = SegmentBuilder::SegmentPageCounts()[i];
+      if (options.read_only) {
+        segment_files.push_back(
+            std::make_unique<MappedSegmentFile>(path, pages_per_segment));
+      } else if (options.use_in_memory_storage) {
+        segment_files.push_back(std::make_unique<MemorySegmentFile>(
+            pages_per_segment, options.in_memory_max_file_mib * 1024 * 1024,
+            options.in_memory_use_huge_pages));
+      } else if (device != nullptr) {
+        segment_files.push_back(std::make_unique<SimulatedSegmentFile>(
+            path, pages_per_segment, tier == 0 ? device : capacity_device));
+      } else {
+        segment_files.push_back(std::make_unique<PosixSegmentFile>(
+            path, pages_per_segment, options.use_memory_based_io));
+      }
+    }
+  }
+  return segment_files;
+}
+
 Manager Manager::Reopen(const fs::path& db,
                         const PageGroupedDBOptions& options) {
+  std::optional<Manager> mgr;
+  const Status status = Reopen(db, options, &mgr);
+  if (!status.ok()) {
+    throw std::runtime_error("Failed to reopen the DB: " + status.ToString());
+  }
+  return std::move(*mgr);
+}
+
+Status Manager::Reopen(const fs::path& db, const PageGroupedDBOptions& options,
+                       std::optional<Manager>* mgr_out) {
   // Figure out if there are segments in this DB.
   const bool uses_segments = fs::exists(db / (kSegmentFilePrefix + "1"));
   PageBuffer buf = PageMemoryAllocator::Allocate(
       /*num_pages=*/SegmentBuilder::SegmentPageCounts().back());
   Page first_page(buf.get());
 
-  std::vector<std::unique_ptr<SegmentFile>> segment_files;
+  std::vector<std::unique_ptr<SegmentFile>> segment_files = OpenSegmentFiles(
+      db, uses_segments ? SegmentBuilder::SegmentPageCounts().size() : 1,
+      options);
   std::vector<std::pair<Key, SegmentInfo>> segment_boundaries;
+  // The sequence number of each segment in `segment_boundaries`.
+  std::vector<uint32_t> sequence_numbers;
   std::unique_ptr<FreeList> free = std::make_unique<FreeList>();
   uint32_t max_sequence = 0;
+  struct DeltaPage {
+    Key base_key;
+    uint32_t sequence_number;
+    DeltaIndex::PageInfo info;
+  };
+  std::vector<DeltaPage> delta_pages;
 
-  for (size_t i = 0; i < SegmentBuilder::SegmentPageCounts().size(); ++i) {
-    if (i > 0 && !uses_segments) break;
-    const size_t pages_per_segment = SegmentBuilder::SegmentPageCounts()[i];
-    segment_files.push_back(std::make_unique<SegmentFile>(
-        db / (kSegmentFilePrefix + std::to_string(i)), pages_per_segment,
-        options.use_memory_based_io));
-    std::unique_ptr<SegmentFile>& sf = segment_files.back();
+  const size_t num_sizes = SegmentBuilder::SegmentPageCounts().size();
+  for (size_t i = 0; i < segment_files.size(); ++i) {
+    // The capacity tier's files (if any) follow the fast tier's files.
+    const size_t file_id = i % num_sizes;
+    const size_t tier = i / num_sizes;
+    const size_t pages_per_segment =
+        SegmentBuilder::SegmentPageCounts()[file_id];
+    std::unique_ptr<SegmentFile>& sf = segment_files[i];
 
     const size_t num_segments = sf->NumAllocatedSegments();
     const size_t bytes_per_segment = pages_per_segment * Page::kSize;
     for (size_t seg_idx = 0; seg_idx < num_segments; ++seg_idx) {
       // Offset in `id` is the page offset.
-      SegmentId id(i, seg_idx * pages_per_segment);
+      SegmentId id(file_id, seg_idx * pages_per_segment, tier);
       sf->ReadPages(seg_idx * bytes_per_segment, buf.get(), pages_per_segment);
 
       SegmentWrap sw(buf.get(), pages_per_segment);
@@ -98,6 +217,15 @@ Manager Manager::Reopen(const fs::path& db,
         free->Add(id);
         continue;
       }
+      if (first_page.IsDelta()) {
+        // Delta pages are attached to their segments below.
+        delta_pages.push_back(
+            {key_utils::ExtractHead64(first_page.GetLowerBoundary()),
+             first_page.GetSequenceNumber(),
+             DeltaIndex::PageInfo::FromPage(id, first_page)});
+        max_sequence = std::max(max_sequence, first_page.GetSequenceNumber());
+        continue;
+      }
       if (first_page.IsOverflow()) {
         continue;
       }
@@ -108,11 +236,18 @@ Manager Manager::Reopen(const fs::path& db,
         segment_boundaries.emplace_back(
             base_key, SegmentInfo(id, std::optional<plr::Line64>()));
       } else {
-        segment_boundaries.emplace_back(base_key,
-                                        SegmentInfo(id, first_page.GetModel()));
+        const plr::Line64 model = first_page.GetModel();
+        if (!SegmentInfo::CanStoreExactly(model)) {
+          // The index would map some keys to the wrong pages.
+          return Status::NotSupported(
+              "A segment's model cannot be stored in the index. The DB was "
+              "written by an incompatible version.");
+        }
+        segment_boundaries.emplace_back(base_key, SegmentInfo(id, model));
       }
 
       // Extract the sequence number.
+      sequence_numbers.push_back(sw.GetSequenceNumber());
       max_sequence = std::max(max_sequence, sw.GetSequenceNumber());
 
       // Keep track of whether or not the segment has an overflow.
@@ -120,15 +255,81 @@ Manager Manager::Reopen(const fs::path& db,
     }
   }
 
-  std::sort(segment_boundaries.begin(), segment_boundaries.end(),
-            [](const std::pair<Key, SegmentInfo>& left,
-               const std::pair<Key, SegmentInfo>& right) {
-              return left.first < right.first;
+  std::vector<size_t> order(segment_boundaries.size());
+  for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+  std::sort(order.begin(), order.end(), [&](size_t left, size_t right) {
+    return segment_boundaries[left].first < segment_boundaries[right].first;
+  });
+
+  // A crash during a tier migration can leave two valid copies of a segment
+  // (one per tier). We keep the copy with the larger sequence number and
+  // reclaim the other one.
+  std::vector<std::pair<Key, SegmentInfo>> sorted_boundaries;
+  sorted_boundaries.reserve(order.size());
+  // The sequence number of each segment in `sorted_boundaries`.
+  std::vector<uint32_t> kept_sequences;
+  kept_sequences.reserve(order.size());
+  const auto invalidate = [&](const SegmentId& stale) {
+    if (!options.read_only) {
+      // Invalidate the stale copy so that it is not considered again.
+      memset(buf.get(), 0, Page::kSize);
+      segment_files[stale.GetTier() * num_sizes + stale.GetFileId()]
+          ->WritePages(stale.GetOffset() * Page::kSize, buf.get(), 1);
+    }
+    free->Add(stale);
+  };
+  for (const size_t idx : order) {
+    const auto& boundary = segment_boundaries[idx];
+    if (sorted_boundaries.empty() ||
+        sorted_boundaries.back().first != boundary.first) {
+      sorted_boundaries.push_back(boundary);
+      kept_sequences.push_back(sequence_numbers[idx]);
+      continue;
+    }
+    SegmentId stale = boundary.second.id();
+    if (sequence_numbers[idx] > kept_sequences.back()) {
+      stale = sorted_boundaries.back().second.id();
+      sorted_boundaries.back() = boundary;
+      kept_sequences.back() = sequence_numbers[idx];
+    }
+    invalidate(stale);
+  }
+  segment_boundaries = std::move(sorted_boundaries);
+
+  // A delta page belongs to the segment with the same base key, but only if it
+  // was written after the segment. Rewrites free the delta pages of the
+  // segments they replace, so older delta pages are stale.
+  std::sort(delta_pages.begin(), delta_pages.end(),
+            [](const DeltaPage& left, const DeltaPage& right) {
+              return left.sequence_number < right.sequence_number;
             });
+  std::unordered_map<SegmentId, std::vector<DeltaIndex::PageInfo>> delta_logs;
+  for (auto& delta : delta_pages) {
+    const auto it = std::lower_bound(
+        segment_boundaries.begin(), segment_boundaries.end(), delta.base_key,
+        [](const auto& boundary, const Key key) {
+          return boundary.first < key;
+        });
+    if (it == segment_boundaries.end() || it->first != delta.base_key ||
+        delta.sequence_number <=
+            kept_sequences[it - segment_boundaries.begin()]) {
+      invalidate(delta.info.id);
+      continue;
+    }
+    // Segments with a delta log are treated like segments with overflows
+    // (e.g., by `FlattenRange()`).
+    it->second.SetOverflow(true);
+    delta_logs[it->second.id()].push_back(std::move(delta.info));
+  }
 
-  return Manager(db, std::move(segment_boundaries), std::move(segment_files),
-                 options, /*next_segment_index=*/max_sequence + 1,
-                 std::move(free));
+  Manager mgr(db, std::move(segment_boundaries), std::move(segment_files),
+              options, /*next_segment_index=*/max_sequence + 1,
+              std::move(free));
+  for (auto& [seg_id, pages] : delta_logs) {
+    mgr.deltas_->GetOrCreate(seg_id)->pages = std::move(pages);
+  }
+  mgr_out->emplace(std::move(mgr));
+  return Status::OK();
 }
 
 void Manager::SetTracker(std::shared_ptr<InsertTracker> tracker) {
@@ -136,48 +337,128 @@ void Manager::SetTracker(std::shared_ptr<InsertTracker> tracker) {
 }
 
 Status Manager::Get(const Key& key, std::string* value_out) {
-  return GetWithPages(key, value_out).first;
+  return GetImpl(key, value_out, /*return_pages=*/false).first;
 }
 
 std::pair<Status, std::vector<pg::Page>> Manager::GetWithPages(
     const Key& key, std::string* value_out) {
+  return GetImpl(key, value_out, /*return_pages=*/true);
+}
+
+std::pair<Status, std::vector<pg::Page>> Manager::GetImpl(
+    const Key& key, std::string* value_out, const bool return_pages) {
+  // Read-only DBs are never modified, so they do not need any locks and their
+  // pages can always be accessed in place. Otherwise the returned pages must
+  // remain valid after the locks are released, so they can only be accessed in
+  // place when they are not returned.
+  const bool read_only = options_.read_only;
+  const bool in_place = read_only || !return_pages;
   void* main_page_buf = w_.buffer().get();
   void* overflow_page_buf = w_.buffer().get() + pg::Page::kSize;
 
   // 1. Find the segment that should hold the key.
-  const auto seg = index_->SegmentForKeyWithLock(key, SegmentMode::kPageRead);
+  const auto seg =
+      read_only ? index_->SegmentForKeyUnlatched(key)
+                : index_->SegmentForKeyWithLock(key, SegmentMode::kPageRead);
 
   // 2. Figure out the page offset, lock the page, and then read it in.
   const size_t page_idx = seg.sinfo.PageForKey(seg.lower, key);
-  lock_manager_->AcquirePageLock(seg.sinfo.id(), page_idx, PageMode::kShared);
-  ReadPage(seg.sinfo.id(), page_idx, main_page_buf);
+  const auto release_locks = [&]() {
+    if (read_only) return;
+    lock_manager_->ReleasePageLock(seg.sinfo.id(), page_idx, PageMode::kShared);
+    lock_manager_->ReleaseSegmentLock(seg.sinfo.id(), SegmentMode::kPageRead);
+  };
+  if (!read_only) {
+    lock_manager_->AcquirePageLock(seg.sinfo.id(), page_idx,
+                                   PageMode::kShared);
+  }
+  main_page_buf =
+      PageForRead(seg.sinfo.id(), page_idx, main_page_buf, in_place);
+  SampleSegmentAccess(seg.lower, SegmentAccessType::kRead);
+  Status status = VerifyPages(main_page_buf, /*num_pages=*/1);
+  if (!status.ok()) {
+    release_locks();
+    return {status, {}};
+  }
 
-  // 3. Search for the record on the page.
+  // 3. Search for the record on the page. Compressed pages are read-only, so
+  // their overflow page (and delta log) holds newer records and must be checked
+  // first.
   pg::Page main_page(main_page_buf);
   key_utils::IntKeyAsSlice key_slice(key);
-  auto status = main_page.Get(key_slice.as<Slice>(), value_out);
-  if (status.ok()) {
-    lock_manager_->ReleasePageLock(seg.sinfo.id(), page_idx, PageMode::kShared);
-    lock_manager_->ReleaseSegmentLock(seg.sinfo.id(), SegmentMode::kPageRead);
-    return {status, {main_page}};
+  const bool overflow_first = main_page.IsCompressed();
+  if (!overflow_first) {
+    status = main_page.Get(key_slice.as<Slice>(), value_out);
+    if (status.ok()) {
+      release_locks();
+      return {status, {main_page}};
+    }
   }
 
-  // 4. Check the overflow page if it exists.
+  // 4. Check the segment's delta log (newest page first) if it has one. Its
+  // records are newer than the records in the overflow page.
+  const std::shared_ptr<DeltaIndex::Log> log =
+      deltas_->Empty() ? nullptr : deltas_->Find(seg.sinfo.id());
+  std::shared_lock<std::shared_mutex> log_lock;
+  bool has_deltas = false;
+  if (log != nullptr) {
+    log_lock = std::shared_lock<std::shared_mutex>(log->mutex);
+    has_deltas = !log->pages.empty();
+    for (auto it = log->pages.rbegin(); it != log->pages.rend(); ++it) {
+      if (!it->MayContain(key)) continue;
+      void* const delta_page_buf =
+          PageForRead(it->id, /*page_idx=*/0, overflow_page_buf, in_place);
+      SampleSegmentAccess(seg.lower, SegmentAccessType::kOverflowHit);
+      PageGroupedDBStats::Local().BumpDeltaPageReads();
+      status = VerifyPages(delta_page_buf, /*num_pages=*/1);
+      if (!status.ok()) {
+        release_locks();
+        return {status, {}};
+      }
+      status = pg::Page(delta_page_buf).Get(key_slice.as<Slice>(), value_out);
+      if (status.ok()) {
+        release_locks();
+        if (overflow_first) return {status, {}};
+        return {status, {main_page}};
+      }
+    }
+  }
+
+  // 5. Check the overflow page if it exists.
   // TODO: We always assume at most 1 overflow page.
   if (!main_page.HasOverflow()) {
-    lock_manager_->ReleasePageLock(seg.sinfo.id(), page_idx, PageMode::kShared);
-    lock_manager_->ReleaseSegmentLock(seg.sinfo.id(), SegmentMode::kPageRead);
-    return {Status::NotFound("Record does not exist."), {main_page}};
+    if (overflow_first) {
+      status = main_page.Get(key_slice.as<Slice>(), value_out);
+    } else {
+      status = Status::NotFound("Record does not exist.");
+    }
+    release_locks();
+    if (has_deltas && overflow_first) return {status, {}};
+    return {status, {main_page}};
   }
   const SegmentId overflow_id = main_page.GetOverflow();
   // All overflow pages are single pages.
   assert(overflow_id.GetFileId() == 0);
-  ReadPage(overflow_id, /*page_idx=*/0, overflow_page_buf);
+  overflow_page_buf =
+      PageForRead(overflow_id, /*page_idx=*/0, overflow_page_buf, in_place);
+  SampleSegmentAccess(seg.lower, SegmentAccessType::kOverflowHit);
+  status = VerifyPages(overflow_page_buf, /*num_pages=*/1);
+  if (!status.ok()) {
+    release_locks();
+    return {status, {}};
+  }
   pg::Page overflow_page(overflow_page_buf);
   status = overflow_page.Get(key_slice.as<Slice>(), value_out);
+  if (!status.ok() && overflow_first) {
+    status = main_page.Get(key_slice.as<Slice>(), value_out);
+  }
 
-  lock_manager_->ReleasePageLock(seg.sinfo.id(), page_idx, PageMode::kShared);
-  lock_manager_->ReleaseSegmentLock(seg.sinfo.id(), SegmentMode::kPageRead);
+  release_locks();
+  if (has_deltas) {
+    // The records in the log may replace records in these pages.
+    if (overflow_first) return {status, {}};
+    return {status, {main_page}};
+  }
   return {status, {main_page, overflow_page}};
 }
 
@@ -206,11 +487,16 @@ Status Manager::PutBatchImpl(const std::vector<std::pair<Key, Slice>>& records,
                          });
     const size_t range_size = cutoff_it - left_it;
     // `WriteToSegment()` will release the segment lock.
-    const size_t num_written =
-        WriteToSegment(segment, records, left_idx, left_idx + range_size);
+    size_t num_written = 0;
+    const Status status = WriteToSegment(segment, records, left_idx,
+                                         left_idx + range_size, &num_written);
+    if (!status.ok()) return status;
     // If a reorg intervenes and no records are written, `num_written` will
     // be 0 and the logic in this loop will retry the write.
     left_idx += num_written;
+    if (num_written < range_size) {
+      PageGroupedDBStats::Local().BumpWriteRetries();
+    }
 
     if (num_written == 0 && num_attempts >= kMaxAttempts) {
       // This is a defensive check. If the number of attempts exceeds
@@ -246,7 +532,7 @@ Status Manager::PutBatchParallel(
   // if `PutBatchImpl()` requires a reorg. This is because the segment rewrite
   // logic uses background threads to issue I/O in parallel, which shares the
   // same thread pool.
-  std::vector<std::future<void>> write_futures;
+  std::vector<std::future<Status>> write_futures;
   size_t left_idx = 0;
   while (left_idx < records.size()) {
     const auto [_, upper] = GetPageBoundsFor(records[left_idx].first);
@@ -259,24 +545,24 @@ Status Manager::PutBatchParallel(
     const size_t range_size = cutoff_it - left_it;
     write_futures.push_back(bg_threads_->Submit(
         [this, &records, start = left_idx, end = left_idx + range_size]() {
-          PutBatchImpl(records, start, end);
+          return PutBatchImpl(records, start, end);
         }));
     left_idx += range_size;
   }
 
-  // Wait for the writes to complete.
+  // Wait for the writes to complete. We report the first failure.
+  Status status;
   for (auto& f : write_futures) {
-    f.get();
+    const Status write_status = f.get();
+    if (status.ok()) status = write_status;
   }
-
-  // `PutBatchImpl()` always returns this.
-  return Status::OK();
+  return status;
 }
 
-size_t Manager::WriteToSegment(
+Status Manager::WriteToSegment(
     const SegmentIndex::Entry& segment,
     const std::vector<std::pair<Key, Slice>>& records, const size_t start_idx,
-    const size_t end_idx) {
+    const size_t end_idx, size_t* const num_written) {
   // Simplifying assumptions:
   // - If the number of writes is past a certain threshold
   //   (`record_per_page_goal` x `pages_in_segment` x 2), we don't attempt to
@@ -286,6 +572,9 @@ size_t Manager::WriteToSegment(
   // - As soon as we try to insert into a full overflow page, we trigger a
   //   segment reorg.
 
+  SampleSegmentAccess(segment.lower, SegmentAccessType::kWrite,
+                      end_idx - start_idx);
+
   const size_t reorg_threshold =
       options_.records_per_page_goal * segment.sinfo.page_count() * 2ULL;
   if (end_idx - start_idx > reorg_threshold) {
@@ -295,14 +584,25 @@ size_t Manager::WriteToSegment(
     Status status;
     if (options_.use_segments) {
       status = RewriteSegments(segment.lower, records.begin() + start_idx,
-                               records.begin() + end_idx);
+                               records.begin() + end_idx,
+                               ReorgTrigger::kBatchThreshold);
     } else {
       status = FlattenChain(segment.lower, records.begin() + start_idx,
-                            records.begin() + end_idx);
+                            records.begin() + end_idx,
+                            ReorgTrigger::kBatchThreshold);
     }
+    if (status.IsCorruption()) return status;
     // If the rewrite succeeded then all of the records will have been written
     // into the new segments.
-    return status.ok() ? (end_idx - start_idx) : 0;
+    *num_written = status.ok() ? (end_idx - start_idx) : 0;
+    return Status::OK();
+  }
+
+  if (options_.rec_cache_segment_writeout &&
+      segment.sinfo.PageForKey(segment.lower, records[start_idx].first) !=
+          segment.sinfo.PageForKey(segment.lower, records[end_idx - 1].first)) {
+    return WriteToSegmentPages(segment, records, start_idx, end_idx,
+                               num_written);
   }
 
   void* orig_page_buf = w_.buffer().get();
@@ -319,8 +619,33 @@ size_t Manager::WriteToSegment(
   pg::Page* curr_page = &orig_page;
   bool* curr_page_dirty = &orig_page_dirty;
 
+  // The index of the first record that maps to the current page.
+  size_t curr_page_start_idx = start_idx;
+  // Records that did not fit on the current page, if the segment uses a delta
+  // log. They are appended to the log before the page lock is released.
+  std::vector<std::pair<Key, Slice>> delta_records;
+  std::optional<bool> use_delta_log;
+  const auto uses_delta_log = [&]() {
+    if (!use_delta_log.has_value()) {
+      use_delta_log = options_.delta_pages_per_segment > 0 ||
+                      (!deltas_->Empty() &&
+                       deltas_->Find(segment.sinfo.id()) != nullptr);
+    }
+    return *use_delta_log;
+  };
+
+  // Sets `appended` to false if the delta records could not be appended to
+  // the delta log (the current page's records then need to be merged in by a
+  // rewrite).
   auto write_dirty_pages = [&, segment_base = segment.lower,
-                            sinfo = segment.sinfo]() {
+                            sinfo = segment.sinfo](bool* appended) {
+    *appended = true;
+    if (!delta_records.empty()) {
+      const Status status =
+          AppendToDeltaLog(segment, delta_records, appended);
+      if (!status.ok()) return status;
+      delta_records.clear();
+    }
     // Write out overflow first to avoid dangling overflow pointers.
     if (overflow_page_dirty) {
       WritePage(overflow_page_id, 0, overflow_page_buf);
@@ -328,39 +653,56 @@ size_t Manager::WriteToSegment(
     if (curr_page_dirty) {
       WritePage(sinfo.id(), curr_page_idx, orig_page_buf);
     }
+    return Status::OK();
+  };
+  // Releases the locks held by this method and returns `status`. Used when a
+  // page fails its checksum check.
+  const auto unlock_and_fail = [&](const Status& status) {
+    lock_manager_->ReleasePageLock(segment.sinfo.id(), curr_page_idx,
+                                   PageMode::kExclusive);
+    lock_manager_->ReleaseSegmentLock(segment.sinfo.id(),
+                                      SegmentMode::kPageWrite);
+    return status;
   };
-  auto write_record_to_chain = [&](Key key, const Slice& value) {
+  // Sets `succeeded` to false if the record does not fit in the page chain.
+  auto write_record_to_chain = [&](Key key, const Slice& value,
+                                   bool* succeeded) {
+    *succeeded = true;
     key_utils::IntKeyAsSlice key_slice(key);
     auto status = curr_page->Put(key_slice.as<Slice>(), value);
     if (status.ok()) {
       *curr_page_dirty = true;
-      return true;
+      return Status::OK();
     }
 
     // `curr_page` is full. Create/load an overflow page if possible.
     if (curr_page == &overflow_page || options_.disable_overflow_creation) {
       // Cannot allocate another overflow (reached max length, or overflow
       // creation was disabled).
-      return false;
+      *succeeded = false;
+      return Status::OK();
+    }
+
+    // Records that go to the delta log are appended in one batch per page.
+    if (uses_delta_log()) {
+      delta_records.emplace_back(key, value);
+      return Status::OK();
     }
 
+    SampleSegmentAccess(segment.lower, SegmentAccessType::kOverflowHit);
+
     // Load the overflow page.
     if (curr_page->HasOverflow()) {
       overflow_page_id = curr_page->GetOverflow();
       ReadPage(overflow_page_id, 0, overflow_page_buf);
+      status = VerifyPages(overflow_page_buf, /*num_pages=*/1);
+      if (!status.ok()) return status;
       curr_page = &overflow_page;
       curr_page_dirty = &overflow_page_dirty;
 
     } else {
       // Allocate a new page.
-      const auto maybe_free_page = free_->Get(/*page_count=*/1);
-      if (maybe_free_page.has_value()) {
-        overflow_page_id = *maybe_free_page;
-      } else {
-        // Allocate a new free page.
-        const size_t byte_offset = segment_files_[0]->AllocateSegment();
-        overflow_page_id = SegmentId(0, byte_offset / pg::Page::kSize);
-      }
+      overflow_page_id = AllocateOverflowPage();
 
       memset(overflow_page_buf, 0, pg::Page::kSize);
       overflow_page = Page(overflow_page_buf, orig_page);
@@ -381,31 +723,55 @@ size_t Manager::WriteToSegment(
     status = curr_page->Put(key_slice.as<Slice>(), value);
     if (status.ok()) {
       *curr_page_dirty = true;
-      return true;
     } else {
       // Overflow is full too.
-      return false;
+      *succeeded = false;
     }
+    return Status::OK();
+  };
+  // Merges the records in [reorg_start_idx, end_idx) into the segment using a
+  // reorganization. The locks must already be released.
+  const auto reorg_from = [&](const size_t reorg_start_idx) {
+    size_t reorg_written = 0;
+    const Status status = ReorgFullSegment(segment, records, reorg_start_idx,
+                                           end_idx, &reorg_written);
+    *num_written = (reorg_start_idx - start_idx) + reorg_written;
+    return status;
   };
 
+  Status status;
+  bool appended = true;
   curr_page_idx =
       segment.sinfo.PageForKey(segment.lower, records[start_idx].first);
   lock_manager_->AcquirePageLock(segment.sinfo.id(), curr_page_idx,
                                  PageMode::kExclusive);
   ReadPage(segment.sinfo.id(), curr_page_idx, orig_page_buf);
+  status = VerifyPages(orig_page_buf, /*num_pages=*/1);
+  if (!status.ok()) return unlock_and_fail(status);
 
   for (size_t i = start_idx; i < end_idx; ++i) {
     const size_t page_idx =
         segment.sinfo.PageForKey(segment.lower, records[i].first);
     if (page_idx != curr_page_idx) {
-      write_dirty_pages();
+      status = write_dirty_pages(&appended);
+      if (!status.ok()) return unlock_and_fail(status);
       lock_manager_->ReleasePageLock(segment.sinfo.id(), curr_page_idx,
                                      PageMode::kExclusive);
+      if (!appended) {
+        // The delta log is full. We need to rewrite the segment in order to
+        // merge in the writes (starting with the previous page's).
+        lock_manager_->ReleaseSegmentLock(segment.sinfo.id(),
+                                          SegmentMode::kPageWrite);
+        return reorg_from(curr_page_start_idx);
+      }
       // Update the current page.
+      curr_page_start_idx = i;
       curr_page_idx = page_idx;
       lock_manager_->AcquirePageLock(segment.sinfo.id(), curr_page_idx,
                                      PageMode::kExclusive);
       ReadPage(segment.sinfo.id(), curr_page_idx, orig_page_buf);
+      status = VerifyPages(orig_page_buf, /*num_pages=*/1);
+      if (!status.ok()) return unlock_and_fail(status);
       overflow_page_id = SegmentId();
       orig_page_dirty = false;
       overflow_page_dirty = false;
@@ -413,69 +779,473 @@ size_t Manager::WriteToSegment(
       curr_page_dirty = &orig_page_dirty;
     }
 
-    const bool succeeded =
-        write_record_to_chain(records[i].first, records[i].second);
+    bool succeeded = true;
+    status =
+        write_record_to_chain(records[i].first, records[i].second, &succeeded);
+    if (!status.ok()) return unlock_and_fail(status);
     if (!succeeded) {
-      write_dirty_pages();
+      status = write_dirty_pages(&appended);
+      if (!status.ok()) return unlock_and_fail(status);
+      const size_t reorg_start_idx = appended ? i : curr_page_start_idx;
       lock_manager_->ReleasePageLock(segment.sinfo.id(), curr_page_idx,
                                      PageMode::kExclusive);
       lock_manager_->ReleaseSegmentLock(segment.sinfo.id(),
                                         SegmentMode::kPageWrite);
       // The segment is full. We need to rewrite it in order to merge in the
       // writes.
-      Status status;
-      if (options_.use_segments) {
-        status = RewriteSegments(segment.lower, records.begin() + i,
-                                 records.begin() + end_idx);
-      } else {
-        status = FlattenChain(segment.lower, records.begin() + i,
-                              records.begin() + end_idx);
-      }
-
-      // If the rewrite succeeded then all the records will have been written
-      // into the new segments. Otherwise only the records we processed up to
-      // index `i` (but excluding `i`) will have been written.
-      return status.ok() ? (end_idx - start_idx) : (i - start_idx);
+      return reorg_from(reorg_start_idx);
     }
   }
 
-  write_dirty_pages();
+  status = write_dirty_pages(&appended);
+  if (!status.ok()) return unlock_and_fail(status);
   lock_manager_->ReleasePageLock(segment.sinfo.id(), curr_page_idx,
                                  PageMode::kExclusive);
   lock_manager_->ReleaseSegmentLock(segment.sinfo.id(),
                                     SegmentMode::kPageWrite);
+  if (!appended) {
+    // The delta log is full (see above).
+    return reorg_from(curr_page_start_idx);
+  }
 
   // All the records were successfully written.
-  return end_idx - start_idx;
+  *num_written = end_idx - start_idx;
+  return Status::OK();
+}
+
+Status Manager::WriteToSegmentPages(
+    const SegmentIndex::Entry& segment,
+    const std::vector<std::pair<Key, Slice>>& records, const size_t start_idx,
+    const size_t end_idx, size_t* num_written) {
+  const SegmentId seg_id = segment.sinfo.id();
+  const size_t first_page_idx =
+      segment.sinfo.PageForKey(segment.lower, records[start_idx].first);
+  const size_t last_page_idx =
+      segment.sinfo.PageForKey(segment.lower, records[end_idx - 1].first);
+  const size_t num_pages = last_page_idx - first_page_idx + 1;
+  assert(num_pages > 1);
+
+  // Page locks are always acquired in ascending order, so holding several of
+  // them cannot cause a deadlock.
+  for (size_t page_idx = first_page_idx; page_idx <= last_page_idx;
+       ++page_idx) {
+    lock_manager_->AcquirePageLock(seg_id, page_idx, PageMode::kExclusive);
+  }
+  char* const pages_buf = w_.buffer().get();
+  SegmentFileFor(seg_id)->ReadPages(
+      (seg_id.GetOffset() + first_page_idx) * Page::kSize, pages_buf,
+      num_pages);
+  w_.BumpReadCount(num_pages);
+  const auto page_at = [&](const size_t page_idx) {
+    return Page(pages_buf + (page_idx - first_page_idx) * Page::kSize);
+  };
+
+  // The overflow page of each page in the range, loaded when needed.
+  struct Overflow {
+    SegmentId id;
+    PageBuffer buf;
+    bool dirty = false;
+    // Set if the page was allocated by this write (it is not on disk yet).
+    bool allocated = false;
+  };
+  std::vector<Overflow> overflows(num_pages);
+
+  // Releases the locks held by this method and returns `status`. Used when a
+  // page fails its checksum check; nothing has been written at that point.
+  const auto unlock_and_fail = [&](const Status& status) {
+    for (const auto& overflow : overflows) {
+      if (overflow.allocated) free_->Add(overflow.id);
+    }
+    for (size_t page_idx = first_page_idx; page_idx <= last_page_idx;
+         ++page_idx) {
+      lock_manager_->ReleasePageLock(seg_id, page_idx, PageMode::kExclusive);
+    }
+    lock_manager_->ReleaseSegmentLock(seg_id, SegmentMode::kPageWrite);
+    return status;
+  };
+  Status status = VerifyPages(pages_buf, num_pages);
+  if (!status.ok()) return unlock_and_fail(status);
+  size_t min_dirty_idx = last_page_idx + 1;
+  size_t max_dirty_idx = 0;
+  const auto mark_dirty = [&](const size_t page_idx) {
+    min_dirty_idx = std::min(min_dirty_idx, page_idx);
+    max_dirty_idx = std::max(max_dirty_idx, page_idx);
+  };
+
+  // Records that did not fit on their page, if the segment uses a delta log.
+  // They are appended to the log in one batch before the page locks are
+  // released.
+  std::vector<std::pair<Key, Slice>> delta_records;
+  const bool use_delta_log =
+      options_.delta_pages_per_segment > 0 ||
+      (!deltas_->Empty() && deltas_->Find(seg_id) != nullptr);
+
+  // Sets `succeeded` to false if the record does not fit in its page chain.
+  const auto write_record = [&](const size_t page_idx,
+                                const std::pair<Key, Slice>& record,
+                                bool* succeeded) {
+    *succeeded = true;
+    key_utils::IntKeyAsSlice key_slice(record.first);
+    const Slice key = key_slice.as<Slice>();
+    const Slice& value = record.second;
+    Page main_page = page_at(page_idx);
+    if (main_page.Put(key, value).ok()) {
+      mark_dirty(page_idx);
+      return Status::OK();
+    }
+
+    if (use_delta_log && !options_.disable_overflow_creation) {
+      delta_records.push_back(record);
+      return Status::OK();
+    }
+
+    // The main page is full. Create/load its overflow page if possible.
+    Overflow& overflow = overflows[page_idx - first_page_idx];
+    if (overflow.buf == nullptr) {
+      if (options_.disable_overflow_creation) {
+        *succeeded = false;
+        return Status::OK();
+      }
+      SampleSegmentAccess(segment.lower, SegmentAccessType::kOverflowHit);
+      overflow.buf = PageMemoryAllocator::Allocate(/*num_pages=*/1);
+      if (main_page.HasOverflow()) {
+        overflow.id = main_page.GetOverflow();
+        ReadPage(overflow.id, 0, overflow.buf.get());
+        const Status status = VerifyPages(overflow.buf.get(), 1);
+        if (!status.ok()) return status;
+      } else {
+        overflow.id = AllocateOverflowPage();
+        overflow.allocated = true;
+        memset(overflow.buf.get(), 0, Page::kSize);
+        Page overflow_page(overflow.buf.get(), main_page);
+        overflow_page.MakeOverflow();
+        overflow_page.SetOverflow(SegmentId());
+        overflow.dirty = true;
+        index_->SetSegmentOverflow(segment.lower, true);
+        PageGroupedDBStats::Local().BumpOverflowsCreated();
+
+        main_page.SetOverflow(overflow.id);
+        mark_dirty(page_idx);
+      }
+    }
+    Page overflow_page(overflow.buf.get());
+    if (!overflow_page.Put(key, value).ok()) {
+      // The overflow is full too.
+      *succeeded = false;
+      return Status::OK();
+    }
+    overflow.dirty = true;
+    return Status::OK();
+  };
+
+  // Sets `appended` to false if the delta records could not be appended to
+  // the delta log (the records then need to be merged in by a rewrite).
+  const auto write_dirty_pages_and_unlock = [&](bool* appended) {
+    *appended = true;
+    if (!delta_records.empty()) {
+      const Status status =
+          AppendToDeltaLog(segment, delta_records, appended);
+      if (!status.ok()) return unlock_and_fail(status);
+    }
+    // Write out the overflows first to avoid dangling overflow pointers.
+    for (const auto& overflow : overflows) {
+      if (overflow.dirty) WritePage(overflow.id, 0, overflow.buf.get());
+    }
+    if (min_dirty_idx <= max_dirty_idx) {
+      const size_t pages_to_write = max_dirty_idx - min_dirty_idx + 1;
+      char* const dirty_pages =
+          pages_buf + (min_dirty_idx - first_page_idx) * Page::kSize;
+      SegmentWrap(dirty_pages, pages_to_write).ComputeAndSetPageChecksums();
+      SegmentFileFor(seg_id)->WritePages(
+          (seg_id.GetOffset() + min_dirty_idx) * Page::kSize, dirty_pages,
+          pages_to_write);
+      w_.BumpWriteCount(pages_to_write);
+    }
+    for (size_t page_idx = first_page_idx; page_idx <= last_page_idx;
+         ++page_idx) {
+      lock_manager_->ReleasePageLock(seg_id, page_idx, PageMode::kExclusive);
+    }
+    lock_manager_->ReleaseSegmentLock(seg_id, SegmentMode::kPageWrite);
+    return Status::OK();
+  };
+  // Merges the records in [reorg_start_idx, end_idx) into the segment using a
+  // reorganization. The locks must already be released.
+  const auto reorg_from = [&](const size_t reorg_start_idx) {
+    size_t reorg_written = 0;
+    const Status status = ReorgFullSegment(segment, records, reorg_start_idx,
+                                           end_idx, &reorg_written);
+    *num_written = (reorg_start_idx - start_idx) + reorg_written;
+    return status;
+  };
+
+  bool appended = true;
+  for (size_t i = start_idx; i < end_idx; ++i) {
+    const size_t page_idx =
+        segment.sinfo.PageForKey(segment.lower, records[i].first);
+    bool succeeded = true;
+    status = write_record(page_idx, records[i], &succeeded);
+    if (!status.ok()) return unlock_and_fail(status);
+    if (!succeeded) {
+      status = write_dirty_pages_and_unlock(&appended);
+      if (!status.ok()) return status;
+      // The segment is full. We need to rewrite it in order to merge in the
+      // writes.
+      return reorg_from(appended ? i : start_idx);
+    }
+  }
+
+  status = write_dirty_pages_and_unlock(&appended);
+  if (!status.ok()) return status;
+  if (!appended) {
+    // The delta log is full. All the records are merged in by a rewrite.
+    return reorg_from(start_idx);
+  }
+  *num_written = end_idx - start_idx;
+  return Status::OK();
+}
+
+SegmentId Manager::AllocateOverflowPage() {
+  const auto maybe_free_page = free_->Get(/*page_count=*/1);
+  if (maybe_free_page.has_value()) {
+    return *maybe_free_page;
+  }
+  // Allocate a new free page.
+  const size_t byte_offset = segment_files_[0]->AllocateSegment();
+  return SegmentId(0, byte_offset / pg::Page::kSize);
+}
+
+Status Manager::AppendToDeltaLog(
+    const SegmentIndex::Entry& segment,
+    const std::vector<std::pair<Key, Slice>>& records, bool* appended) {
+  *appended = false;
+  const size_t max_pages = options_.delta_pages_per_segment;
+
+  // All the pages are modified in memory first, so that nothing is written if
+  // the records do not fit.
+  std::vector<PageBuffer> bufs;
+  std::vector<DeltaIndex::PageInfo> infos;
+  std::shared_ptr<DeltaIndex::Log> log = deltas_->Find(segment.sinfo.id());
+  if (log == nullptr) {
+    // Check that the records fit before creating the log, so that a failed
+    // append does not leave an empty log behind.
+    if (max_pages == 0 ||
+        !FillDeltaPages(segment, records, max_pages, &bufs, &infos)) {
+      return Status::OK();
+    }
+    log = deltas_->GetOrCreate(segment.sinfo.id());
+  }
+  std::unique_lock<std::shared_mutex> lock(log->mutex);
+  SampleSegmentAccess(segment.lower, SegmentAccessType::kOverflowHit);
+
+  // Records are added to the newest page in the log until it is full. The
+  // pages built above can only be used if no other thread added pages to the
+  // log in the meantime.
+  const bool has_tail = !log->pages.empty();
+  const size_t max_new_pages =
+      max_pages > log->pages.size() ? max_pages - log->pages.size() : 0;
+  if (has_tail) {
+    bufs.clear();
+    infos.clear();
+    bufs.push_back(PageMemoryAllocator::Allocate(/*num_pages=*/1));
+    ReadPage(log->pages.back().id, 0, bufs.back().get());
+    const Status status = VerifyPages(bufs.back().get(), /*num_pages=*/1);
+    if (!status.ok()) return status;
+    infos.push_back(log->pages.back());
+    if (!FillDeltaPages(segment, records, max_new_pages, &bufs, &infos)) {
+      return Status::OK();
+    }
+  } else if (bufs.empty() && !FillDeltaPages(segment, records, max_new_pages,
+                                             &bufs, &infos)) {
+    return Status::OK();
+  }
+
+  // Write out the pages, then make them visible to readers.
+  for (size_t i = 0; i < bufs.size(); ++i) {
+    if (i > 0 || !has_tail) {
+      infos[i].id = AllocateOverflowPage();
+      // Newer delta pages have larger sequence numbers (see `Reopen()`).
+      pg::Page(bufs[i].get()).SetSequenceNumber((*next_sequence_number_)++);
+      PageGroupedDBStats::Local().BumpDeltaPagesCreated();
+    }
+    WritePage(infos[i].id, 0, bufs[i].get());
+  }
+  if (has_tail) {
+    log->pages.back() = std::move(infos.front());
+  }
+  for (size_t i = has_tail ? 1 : 0; i < infos.size(); ++i) {
+    log->pages.push_back(std::move(infos[i]));
+  }
+  if (!has_tail) {
+    // Segments with a delta log are treated like segments with overflows
+    // (e.g., by `FlattenRange()`).
+    index_->SetSegmentOverflow(segment.lower, true);
+  }
+  *appended = true;
+  return Status::OK();
+}
+
+bool Manager::FillDeltaPages(
+    const SegmentIndex::Entry& segment,
+    const std::vector<std::pair<Key, Slice>>& records,
+    const size_t max_new_pages, std::vector<PageBuffer>* bufs,
+    std::vector<DeltaIndex::PageInfo>* infos) const {
+  // Delta pages hold records for the whole segment.
+  const key_utils::IntKeyAsSlice lower(segment.lower);
+  const key_utils::IntKeyAsSlice upper(segment.upper - 1);
+  size_t new_pages = 0;
+  for (const auto& [key, value] : records) {
+    const key_utils::IntKeyAsSlice key_slice(key);
+    if (!bufs->empty() &&
+        pg::Page(bufs->back().get()).Put(key_slice.as<Slice>(), value).ok()) {
+      infos->back().Add(key);
+      continue;
+    }
+    if (new_pages >= max_new_pages) {
+      // The log is full.
+      return false;
+    }
+    bufs->push_back(PageMemoryAllocator::Allocate(/*num_pages=*/1));
+    ++new_pages;
+    memset(bufs->back().get(), 0, pg::Page::kSize);
+    pg::Page page(bufs->back().get(), lower.as<Slice>(), upper.as<Slice>());
+    page.MakeDelta();
+    page.SetOverflow(SegmentId());
+    if (!page.Put(key_slice.as<Slice>(), value).ok()) {
+      // The record does not fit in an empty page.
+      return false;
+    }
+    infos->emplace_back();
+    infos->back().Add(key);
+  }
+  return true;
+}
+
+Status Manager::ReadDeltaPages(const SegmentId& seg_id,
+                               DeltaPages* out) const {
+  out->pages.clear();
+  if (deltas_->Empty()) return Status::OK();
+  const std::shared_ptr<DeltaIndex::Log> log = deltas_->Find(seg_id);
+  if (log == nullptr) return Status::OK();
+
+  std::shared_lock<std::shared_mutex> lock(log->mutex);
+  const size_t num_pages = log->pages.size();
+  if (out->capacity < num_pages) {
+    out->buf = PageMemoryAllocator::Allocate(num_pages);
+    out->capacity = num_pages;
+  }
+  for (size_t i = 0; i < num_pages; ++i) {
+    ReadPage(log->pages[i].id, 0, out->buf.get() + i * pg::Page::kSize);
+  }
+  out->pages = log->pages;
+  const Status status = VerifyPages(out->buf.get(), num_pages);
+  if (!status.ok()) out->pages.clear();
+  return status;
+}
+
+bool Manager::DeltaPages::AddIterators(
+    const Page& page, std::vector<Page::Iterator>* page_its) const {
+  if (pages.empty()) return false;
+  const Slice lower_slice = page.GetLowerBoundary();
+  const Key lower = key_utils::ExtractHead64(lower_slice);
+  const Key upper = key_utils::ExtractHead64(page.GetUpperBoundary());
+  bool added = false;
+  for (size_t i = 0; i < pages.size(); ++i) {
+    if (!pages[i].MayOverlap(lower, upper)) continue;
+    auto it = Page(buf.get() + i * Page::kSize).GetIterator();
+    it.Seek(lower_slice);
+    page_its->push_back(std::move(it));
+    added = true;
+  }
+  return added;
+}
+
+void Manager::DeltaPages::AppendRecords(std::vector<Record>* out) const {
+  std::vector<Page::Iterator> page_its;
+  page_its.reserve(pages.size());
+  for (size_t i = 0; i < pages.size(); ++i) {
+    page_its.push_back(Page(buf.get() + i * Page::kSize).GetIterator());
+  }
+  for (PageMergeIterator pmi(std::move(page_its)); pmi.Valid(); pmi.Next()) {
+    out->emplace_back(key_utils::ExtractHead64(pmi.key()), pmi.value());
+  }
+}
+
+Status Manager::ReorgFullSegment(
+    const SegmentIndex::Entry& segment,
+    const std::vector<std::pair<Key, Slice>>& records, const size_t start_idx,
+    const size_t end_idx, size_t* num_written) {
+  Status status;
+  if (options_.use_segments) {
+    status = RewriteSegments(segment.lower, records.begin() + start_idx,
+                             records.begin() + end_idx,
+                             ReorgTrigger::kOverflowFull);
+  } else {
+    status = FlattenChain(segment.lower, records.begin() + start_idx,
+                          records.begin() + end_idx,
+                          ReorgTrigger::kOverflowFull);
+  }
+  // A corrupt page aborts the rewrite; the caller must retry the records.
+  if (status.IsCorruption()) return status;
+  // If the rewrite succeeded then all the records will have been written into
+  // the new segments. Otherwise none of them were written.
+  *num_written = status.ok() ? (end_idx - start_idx) : 0;
+  return Status::OK();
 }
 
 void Manager::ReadPage(const SegmentId& seg_id, size_t page_idx,
                        void* buffer) const {
   assert(seg_id.IsValid());
-  const std::unique_ptr<SegmentFile>& sf = segment_files_[seg_id.GetFileId()];
+  const std::unique_ptr<SegmentFile>& sf = SegmentFileFor(seg_id);
   sf->ReadPages((seg_id.GetOffset() + page_idx) * pg::Page::kSize, buffer,
                 /*num_pages=*/1);
   w_.BumpReadCount(1);
 }
 
+void* Manager::PageForRead(const SegmentId& seg_id, size_t page_idx,
+                           void* buffer, bool in_place) const {
+  if (in_place) {
+    const std::unique_ptr<SegmentFile>& sf = SegmentFileFor(seg_id);
+    char* const address =
+        sf->PageAddress((seg_id.GetOffset() + page_idx) * pg::Page::kSize);
+    if (address != nullptr) {
+      w_.BumpReadCount(1);
+      return address;
+    }
+  }
+  if (inflight_reads_ != nullptr) {
+    const SegmentId page_id(seg_id.GetFileId(), seg_id.GetOffset() + page_idx,
+                            seg_id.GetTier());
+    const bool coalesced =
+        inflight_reads_->Read(page_id.value(), buffer, [&](void* out) {
+          ReadPage(seg_id, page_idx, out);
+        });
+    if (coalesced) PageGroupedDBStats::Local().BumpCoalescedPageReads();
+    return buffer;
+  }
+  ReadPage(seg_id, page_idx, buffer);
+  return buffer;
+}
+
 void Manager::WritePage(const SegmentId& seg_id, size_t page_idx,
                         void* buffer) const {
   assert(seg_id.IsValid());
-  const std::unique_ptr<SegmentFile>& sf = segment_files_[seg_id.GetFileId()];
+  pg::Page(buffer).ComputeAndSetPageChecksum();
+  const std::unique_ptr<SegmentFile>& sf = SegmentFileFor(seg_id);
   sf->WritePages((seg_id.GetOffset() + page_idx) * pg::Page::kSize, buffer,
                  /*num_pages=*/1);
   w_.BumpWriteCount(1);
 }
 
-void Manager::ReadSegment(const SegmentId& seg_id) const {
+Status Manager::ReadSegment(const SegmentId& seg_id) const {
   assert(seg_id.IsValid());
-  const std::unique_ptr<SegmentFile>& sf = segment_files_[seg_id.GetFileId()];
+  const std::unique_ptr<SegmentFile>& sf = SegmentFileFor(seg_id);
   sf->ReadPages(seg_id.GetOffset() * pg::Page::kSize, w_.buffer().get(),
                 sf->PagesPerSegment());
   w_.BumpReadCount(sf->PagesPerSegment());
+  return VerifyPages(w_.buffer().get(), sf->PagesPerSegment());
 }
 
-void Manager::ReadOverflows(
+Status Manager::ReadOverflows(
     const std::vector<std::pair<SegmentId, void*>>& overflows_to_read) const {
   if (bg_threads_ != nullptr) {
     std::vector<std::future<void>> futures;
@@ -493,6 +1263,21 @@ void Manager::ReadOverflows(
       ReadPage(otr.first, 0, otr.second);
     }
   }
+  for (const auto& otr : overflows_to_read) {
+    const Status status = VerifyPages(otr.second, /*num_pages=*/1);
+    if (!status.ok()) return status;
+  }
+  return Status::OK();
+}
+
+Status Manager::VerifyPages(const void* pages, const size_t num_pages) const {
+  if (!options_.verify_page_checksums) return Status::OK();
+  PageGroupedDBStats::Local().BumpPagesVerified(num_pages);
+  // The pages are not modified by the check.
+  const SegmentWrap sw(const_cast<void*>(pages), num_pages);
+  if (sw.CheckPageChecksums()) return Status::OK();
+  PageGroupedDBStats::Local().BumpPageChecksumFailures();
+  return Status::Corruption("Page checksum mismatch.");
 }
 
 std::pair<Key, Key> Manager::GetPageBoundsFor(const Key key) const {
@@ -535,5 +1320,77 @@ void Manager::PostStats() const {
   PageGroupedDBStats::Local().SetSegments(index_->GetNumEntries());
 }
 
+std::vector<ReorgEvent> Manager::GetReorgEvents() const {
+  if (reorg_log_ == nullptr) return {};
+  return reorg_log_->GetEvents();
+}
+
+void Manager::RecordCacheMiss(const Key key) {
+  if (access_tracker_ == nullptr || !access_tracker_->ShouldSample()) return;
+  const auto [segment_base, _] = index_->GetSegmentBoundsFor(key);
+  access_tracker_->Add(segment_base, SegmentAccessType::kCacheMiss, 1);
+}
+
+void Manager::MoveSegmentAccesses(
+    const std::vector<SegmentIndex::Entry>& old_segments,
+    const std::vector<std::pair<Key, SegmentInfo>>& new_segments) {
+  if (access_tracker_ == nullptr || new_segments.empty()) return;
+  for (const auto& old_seg : old_segments) {
+    // The last new segment whose base key is at most the old base key.
+    auto it = std::upper_bound(
+        new_segments.begin(), new_segments.end(), old_seg.lower,
+        [](const Key key, const auto& seg) { return key < seg.first; });
+    if (it != new_segments.begin()) --it;
+    access_tracker_->Move(old_seg.lower, it->first);
+  }
+}
+
+std::vector<SegmentAccessStats> Manager::GetAccessHeatmap() const {
+  std::vector<SegmentAccessStats> heatmap;
+  if (access_tracker_ == nullptr) return heatmap;
+
+  // The counters are keyed by the base key of the segment that was accessed.
+  // Reorgs move the counters of the segments they replace, but an access that
+  // raced with a reorg may have recorded a counter for a replaced segment. We
+  // attribute each counter to the segment that currently contains its base
+  // key (and move stale counters there). The snapshot is sorted, so counters
+  // that map to the same segment are adjacent.
+  const auto snapshot = access_tracker_->Snapshot();
+  for (const auto& [base, counts] : snapshot) {
+    const auto seg = index_->SegmentForKey(base);
+    if (seg.lower != base) access_tracker_->Move(base, seg.lower);
+    if (!heatmap.empty() && heatmap.back().lower == seg.lower) {
+      heatmap.back().counts += counts;
+      continue;
+    }
+    heatmap.push_back(SegmentAccessStats{seg.lower, seg.upper,
+                                         seg.sinfo.page_count(), counts});
+  }
+  for (auto& seg : heatmap) {
+    seg.counts *= access_tracker_->sample_interval();
+  }
+  return heatmap;
+}
+
+std::vector<SegmentAccessStats> Manager::GetHottestSegments(
+    const size_t k) const {
+  std::vector<SegmentAccessStats> segments = GetAccessHeatmap();
+  const size_t num_hottest = std::min(k, segments.size());
+  std::partial_sort(segments.begin(), segments.begin() + num_hottest,
+                    segments.end(), [](const auto& left, const auto& right) {
+                      return left.counts.Total() > right.counts.Total();
+                    });
+  segments.resize(num_hottest);
+  return segments;
+}
+
+void Manager::WriteAccessHeatmap() const {
+  if (access_tracker_ == nullptr) return;
+  const auto debug_path = db_path_ / kDebugDirName;
+  fs::create_directories(debug_path);
+  std::ofstream out(debug_path / kAccessHeatmapCsvFileName);
+  PrintAccessHeatmapAsCsv(out, GetAccessHeatmap());
+}
+
 }  // namespace pg
 }  // namespace tl
@@ -1,13 +1,21 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <filesystem>
+#include <functional>
 #include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "delta_index.h"
 #include "free_list.h"
+#include "inflight_reads.h"
 #include "key.h"
 #include "treeline/pg_options.h"
 #include "treeline/slice.h"
@@ -15,6 +23,9 @@
 #include "lock_manager.h"
 #include "persist/page.h"
 #include "persist/segment_file.h"
+#include "reorg_log.h"
+#include "segment_access_tracker.h"
+#include "segment_builder.h"
 #include "segment_index.h"
 #include "segment_info.h"
 #include "util/insert_tracker.h"
@@ -36,6 +47,16 @@ class Manager {
                              const std::vector<std::pair<Key, Slice>>& records,
                              const PageGroupedDBOptions& options);
 
+  // Reopens the DB at `db`. Returns `Status::NotSupported` (and leaves
+  // `mgr_out` empty) if a segment's model cannot be stored in the index (see
+  // `SegmentInfo::CanStoreExactly()`), e.g., because the DB was written by an
+  // older build.
+  static Status Reopen(const std::filesystem::path& db,
+                       const PageGroupedDBOptions& options,
+                       std::optional<Manager>* mgr_out);
+
+  // Same as above, but throws `std::runtime_error` if the DB cannot be
+  // reopened.
   static Manager Reopen(const std::filesystem::path& db,
                         const PageGroupedDBOptions& options);
 
@@ -44,7 +65,12 @@ class Manager {
   Status Get(const Key& key, std::string* value_out);
 
   // Similar to `Get()`, but also returns the page(s) read from disk (e.g., for
-  // access to other records for caching purposes).
+  // access to other records for caching purposes). The main page is returned
+  // first. If it is compressed, records in its overflow page take precedence
+  // over records with the same key (see `Page::PutCompressed()`). Delta pages
+  // are never returned, and if the segment has a delta log, only an
+  // uncompressed main page is returned (the other pages may hold records that
+  // were replaced by records in the log).
   //
   // Callers should not store the returned `Page`s because their backing memory
   // is only valid until the next call to a `Manager` method.
@@ -52,6 +78,9 @@ class Manager {
                                                         std::string* value_out);
 
   // Pre-condition: The batch is sorted in ascending order by key.
+  //
+  // Returns `Corruption` if a page that the batch needs to modify fails its
+  // checksum check. Records that map to other pages may still be written.
   Status PutBatch(const std::vector<std::pair<Key, Slice>>& records);
 
   // Does the same thing as `PutBatch()` but attempts to parallelize the write.
@@ -72,8 +101,17 @@ class Manager {
       const Key& start_key, const size_t amount,
       std::vector<std::pair<Key, std::string>>* values_out);
 
+  // Scans the mapped segment files without acquiring any locks. Only used
+  // when the DB is open in read-only mode.
+  Status ScanReadOnly(
+      const Key& start_key, const size_t amount,
+      std::vector<std::pair<Key, std::string>>* values_out) const;
+
   Status Scan(const Key& start_key, const size_t amount,
               std::vector<std::pair<Key, std::string>>* values_out) {
+    if (options_.read_only) {
+      return ScanReadOnly(start_key, amount, values_out);
+    }
     return ScanWithEstimates(start_key, amount, values_out);
   }
 
@@ -81,6 +119,12 @@ class Manager {
   // The lower bound is inclusive and the upper bound is exclusive.
   std::pair<Key, Key> GetPageBoundsFor(const Key key) const;
 
+  // Returns the boundaries of the segment on which `key` should be stored.
+  // The lower bound is inclusive and the upper bound is exclusive.
+  std::pair<Key, Key> GetSegmentBoundsFor(const Key key) const {
+    return index_->GetSegmentBoundsFor(key);
+  }
+
   // See `PageGroupedDB::FlattenRange()` for details.
   Status FlattenRange(const Key start_key = 0,
                       const Key end_key = std::numeric_limits<Key>::max());
@@ -92,6 +136,59 @@ class Manager {
   }
   void PostStats() const;
 
+  // Returns the most recent reorganization events (oldest first). See
+  // `PageGroupedDBOptions::reorg_log_capacity`.
+  std::vector<ReorgEvent> GetReorgEvents() const;
+
+  // Used to report that a read of `key` missed the record cache.
+  void RecordCacheMiss(const Key key);
+
+  // Returns the estimated number of accesses made to each segment since the
+  // DB was opened (sorted by key). Segments that were not sampled are omitted.
+  // See `PageGroupedDBOptions::access_sample_interval`.
+  std::vector<SegmentAccessStats> GetAccessHeatmap() const;
+
+  // Returns the number of segment base keys that have access counters (0 if
+  // access tracking is disabled). Reorganizations move the counters of the
+  // segments they replace, so this is at most the number of segments (plus a
+  // few keys of recently replaced segments).
+  size_t GetNumTrackedSegments() const {
+    return access_tracker_ == nullptr ? 0 : access_tracker_->size();
+  }
+
+  // Returns (up to) the `k` most frequently accessed segments, most accessed
+  // first.
+  std::vector<SegmentAccessStats> GetHottestSegments(size_t k) const;
+
+  // Writes the access heatmap to `debug/access_heatmap.csv` in the database
+  // directory. This method does nothing if access tracking is disabled.
+  void WriteAccessHeatmap() const;
+
+  // Moves (up to `TieringOptions::max_migrations_per_pass`) cold segments from
+  // the fast storage tier to the capacity tier. A segment is cold if it had at
+  // most `TieringOptions::cold_access_threshold` (estimated) accesses since
+  // the previous call to this method; segments created after the previous call
+  // are never moved. Returns the number of segments that were moved.
+  //
+  // This method does nothing if tiering is disabled. It is thread-safe, but
+  // only one migration pass runs at a time.
+  size_t MigrateColdSegments();
+
+  // Reads every segment (and its overflow pages) from storage and checks the
+  // segment and page checksums and the segment's structure (see
+  // `ScrubberOptions`). The results are recorded in `PageGroupedDBStats`.
+  // `throttle` is called with the number of pages read after each segment is
+  // checked; the pass stops early if it returns false. Returns the number of
+  // segments that failed a check.
+  //
+  // This method is thread-safe and can run concurrently with other requests.
+  size_t ScrubSegments(const std::function<bool(size_t)>& throttle);
+
+  // Returns true iff the DB stores segments on two storage tiers.
+  bool HasCapacityTier() const {
+    return segment_files_.size() > SegmentBuilder::SegmentPageCounts().size();
+  }
+
   Manager(const Manager&) = delete;
   Manager& operator=(const Manager&) = delete;
 
@@ -110,6 +207,12 @@ class Manager {
           PageGroupedDBOptions options, uint32_t next_sequence_number,
           std::unique_ptr<FreeList> free);
 
+  // Opens the first `num_files` segment files in `db_path` (creating them if
+  // needed). The files use the storage backend selected in `options`.
+  static std::vector<std::unique_ptr<SegmentFile>> OpenSegmentFiles(
+      const std::filesystem::path& db_path, size_t num_files,
+      const PageGroupedDBOptions& options);
+
   static Manager BulkLoadIntoSegments(
       const std::filesystem::path& db_path,
       const std::vector<std::pair<Key, Slice>>& records,
@@ -122,6 +225,12 @@ class Manager {
       const PageGroupedDBOptions& options);
   void BulkLoadIntoPagesImpl(const std::vector<Record>& records);
 
+  // Implements `Get()` and `GetWithPages()`. Pages are only returned if
+  // `return_pages` is true.
+  std::pair<Status, std::vector<pg::Page>> GetImpl(const Key& key,
+                                                   std::string* value_out,
+                                                   bool return_pages);
+
   Status PutBatchImpl(const std::vector<std::pair<Key, Slice>>& records,
                       size_t start_idx, size_t end_idx);
 
@@ -129,13 +238,78 @@ class Manager {
   // must already hold a `kPageWrite` lock on the segment. This method will
   // release the segment lock when it is done making the write(s).
   //
-  // This method returns the number of records actually written. This number may
-  // be less than the number of records passed to the method; this indicates
-  // that a reorganization intervened during the write. If this happens, the
-  // caller should retry the write.
-  size_t WriteToSegment(const SegmentIndex::Entry& segment,
+  // This method sets `num_written` to the number of records actually written.
+  // This number may be less than the number of records passed to the method;
+  // this indicates that a reorganization intervened during the write. If this
+  // happens, the caller should retry the write.
+  //
+  // Returns `Corruption` (with the segment lock released) if a page that the
+  // write needs to modify fails its checksum check. Some of the records may
+  // have been written in this case.
+  Status WriteToSegment(const SegmentIndex::Entry& segment,
                         const std::vector<std::pair<Key, Slice>>& records,
-                        size_t start_idx, size_t end_idx);
+                        size_t start_idx, size_t end_idx, size_t* num_written);
+
+  // Same as `WriteToSegment()`, but the records must map to more than one page
+  // in the segment. All the affected pages are read using one multi-page read
+  // and are written back using one multi-page write (overflow pages are still
+  // accessed individually). Used when `rec_cache_segment_writeout` is set.
+  Status WriteToSegmentPages(const SegmentIndex::Entry& segment,
+                             const std::vector<std::pair<Key, Slice>>& records,
+                             size_t start_idx, size_t end_idx,
+                             size_t* num_written);
+
+  // Returns the ID of a free page that can be used as an overflow page.
+  SegmentId AllocateOverflowPage();
+
+  // Appends `records` (sorted by key), which did not fit on their page, to
+  // `segment`'s delta log. The caller must hold a `kPageWrite` lock on the
+  // segment and exclusive locks on the records' pages. Sets `appended` to
+  // false, without writing any of the records, if the log does not have enough
+  // room (the segment then needs to be rewritten). Returns `Corruption` if the
+  // log's newest page fails its checksum check.
+  Status AppendToDeltaLog(const SegmentIndex::Entry& segment,
+                          const std::vector<std::pair<Key, Slice>>& records,
+                          bool* appended);
+
+  // Adds `records` (sorted by key) to the in-memory delta pages in `bufs`,
+  // whose metadata is in `infos`. Records are added to the last page until it
+  // is full; then (up to `max_new_pages`) new pages are started. Returns false
+  // if the records do not fit.
+  bool FillDeltaPages(const SegmentIndex::Entry& segment,
+                      const std::vector<std::pair<Key, Slice>>& records,
+                      size_t max_new_pages, std::vector<PageBuffer>* bufs,
+                      std::vector<DeltaIndex::PageInfo>* infos) const;
+
+  // A copy of a segment's delta pages, used to merge them into scans.
+  struct DeltaPages {
+    PageBuffer buf;
+    size_t capacity = 0;
+    // Oldest first. The pages are stored in `buf` in the same order.
+    std::vector<DeltaIndex::PageInfo> pages;
+
+    // Adds iterators over the delta pages that may hold records that belong to
+    // `page` to `page_its` (oldest first, so that newer records take
+    // precedence in a `PageMergeIterator`). Returns true if any were added;
+    // the merged records must then be bounded by `page`'s upper boundary.
+    bool AddIterators(const Page& page,
+                      std::vector<Page::Iterator>* page_its) const;
+
+    // Appends the records in the delta pages to `out` in key order, keeping
+    // only the newest record for each key. The values point into `buf`.
+    void AppendRecords(std::vector<Record>* out) const;
+  };
+  // Reads the delta pages of the segment `seg_id` (if any) into `out`. Scans
+  // read a segment's delta pages once, before scanning its pages.
+  Status ReadDeltaPages(const SegmentId& seg_id, DeltaPages* out) const;
+
+  // Starts a reorganization that merges the records in [start_idx, end_idx)
+  // into `segment` after a write found the segment full. Sets `num_written` to
+  // the number of records written (see `WriteToSegment()`).
+  Status ReorgFullSegment(const SegmentIndex::Entry& segment,
+                          const std::vector<std::pair<Key, Slice>>& records,
+                          size_t start_idx, size_t end_idx,
+                          size_t* num_written);
 
   // Rewrite the segment specified by `segment_base` (merge in the overflows)
   // while also adding in additional records.
@@ -143,41 +317,105 @@ class Manager {
   // If `consider_adjacent` is true, this method will also rewrite all logically
   // neighboring segments that also have overflows.
   //
-  // This method may return a non-OK status which indicates that the additional
-  // records passed in do not belong to the specified segment and that the
-  // rewrite was aborted. This happens when a concurrent reorg intervenes.
+  // This method may return `InvalidArgument`, which indicates that the
+  // additional records passed in do not belong to the specified segment and
+  // that the rewrite was aborted. This happens when a concurrent reorg
+  // intervenes. It returns `Corruption` if one of the segments' pages fails its
+  // checksum check; the rewrite is then aborted and the segments are left
+  // unchanged.
   Status RewriteSegments(Key segment_base,
                          std::vector<Record>::const_iterator addtl_rec_begin,
-                         std::vector<Record>::const_iterator addtl_rec_end);
+                         std::vector<Record>::const_iterator addtl_rec_end,
+                         ReorgTrigger trigger);
   // NOTE: `segments_to_rewrite` must consist of contiguous segments and the
   // caller must already hold the appropriate locks.
+  //
+  // `event` should have its trigger, start time, and lock wait time set by the
+  // caller. This method fills in the remaining fields and records the event.
   Status RewriteSegmentsImpl(
       std::vector<SegmentIndex::Entry> segments_to_rewrite,
       std::vector<Record>::const_iterator addtl_rec_begin,
-      std::vector<Record>::const_iterator addtl_rec_end);
+      std::vector<Record>::const_iterator addtl_rec_end, ReorgEvent event);
 
   // Flatten the given page chain and merge in the additional records (which
   // must fall in the key space assigned to the given page chain).
   //
-  // This method may return a non-OK status which indicates that the additional
-  // records passed in do not belong to the specified segment and that the
-  // flatten was aborted. This happens when a concurrent reorg intervenes.
+  // This method may return `InvalidArgument`, which indicates that the
+  // additional records passed in do not belong to the specified segment and
+  // that the flatten was aborted. This happens when a concurrent reorg
+  // intervenes. It returns `Corruption` (leaving the chain unchanged) if one of
+  // the chain's pages fails its checksum check.
   Status FlattenChain(Key base,
                       std::vector<Record>::const_iterator addtl_rec_begin,
-                      std::vector<Record>::const_iterator addtl_rec_end);
+                      std::vector<Record>::const_iterator addtl_rec_end,
+                      ReorgTrigger trigger);
+
+  // Records an access to the segment with base key `segment_base` if access
+  // tracking is enabled and this access is sampled.
+  void SampleSegmentAccess(const Key segment_base, const SegmentAccessType type,
+                           const uint64_t amount = 1) {
+    if (access_tracker_ == nullptr || !access_tracker_->ShouldSample()) return;
+    access_tracker_->Add(segment_base, type, amount);
+  }
+
+  // Moves the access counters of `old_segments` to the segments in
+  // `new_segments` (sorted by key) that now contain their base keys. Called
+  // when a reorganization replaces `old_segments` in the index.
+  void MoveSegmentAccesses(
+      const std::vector<SegmentIndex::Entry>& old_segments,
+      const std::vector<std::pair<Key, SegmentInfo>>& new_segments);
+
+  // Moves `segment` to the capacity tier. The segment's overflow pages (if
+  // any) stay in the fast tier. Returns `Status::InvalidArgument()` if an
+  // intervening reorganization replaced the segment, and `Corruption` if one
+  // of the segment's pages fails its checksum check.
+  Status MigrateSegment(const SegmentIndex::Entry& segment);
+
+  // Returns the file that stores the segment with the given ID. The capacity
+  // tier's files follow the fast tier's files in `segment_files_`.
+  const std::unique_ptr<SegmentFile>& SegmentFileFor(
+      const SegmentId& id) const {
+    const size_t num_sizes = SegmentBuilder::SegmentPageCounts().size();
+    return segment_files_[id.GetTier() * num_sizes + id.GetFileId()];
+  }
 
   // Helpers for convenience.
   void ReadPage(const SegmentId& seg_id, size_t page_idx, void* buffer) const;
+  // Returns the address of the page's contents. If `in_place` is true and the
+  // page can be accessed in place, its address in the segment file is
+  // returned (the page must stay locked while it is used). Otherwise the page
+  // is read into `buffer`, sharing the I/O with concurrent readers of the page
+  // if `PageGroupedDBOptions::coalesce_page_reads` is set (the page must not be
+  // modified during the read).
+  void* PageForRead(const SegmentId& seg_id, size_t page_idx, void* buffer,
+                    bool in_place) const;
   void WritePage(const SegmentId& seg_id, size_t page_idx, void* buffer) const;
-  // Reads the given segment into this thread's workspace buffer.
-  void ReadSegment(const SegmentId& seg_id) const;
-  void ReadOverflows(
+  // Reads the given segment into this thread's workspace buffer. Returns
+  // `Corruption` if one of its pages fails its checksum check.
+  Status ReadSegment(const SegmentId& seg_id) const;
+
+  // Returns `Corruption` if one of the `num_pages` pages starting at `pages`
+  // fails its checksum check. Always succeeds if
+  // `PageGroupedDBOptions::verify_page_checksums` is false.
+  Status VerifyPages(const void* pages, size_t num_pages) const;
+  // Checks one segment for `ScrubSegments()`. Returns `Corruption` if the
+  // segment fails a check.
+  Status ScrubSegment(const SegmentIndex::Entry& segment,
+                      size_t* pages_read) const;
+  // Returns `Corruption` if one of the overflow pages fails its checksum check.
+  Status ReadOverflows(
       const std::vector<std::pair<SegmentId, void*>>& overflows_to_read) const;
 
   std::pair<Key, SegmentInfo> LoadIntoNewSegment(uint32_t sequence_number,
                                                  const Segment& segment,
                                                  Key upper_bound);
 
+  // Writes the records in `[rec_begin, rec_end)`, which did not fit in the
+  // newly loaded `main_page`, to a new overflow page for `main_page`.
+  void LoadIntoOverflowPage(pg::Page main_page,
+                            std::vector<Record>::const_iterator rec_begin,
+                            std::vector<Record>::const_iterator rec_end);
+
   // Loads the records in `[rec_begin, rec_end)` into pages based on the page
   // fill goal.
   std::vector<std::pair<Key, SegmentInfo>> LoadIntoNewPages(
@@ -185,14 +423,41 @@ class Manager {
       std::vector<Record>::const_iterator rec_begin,
       std::vector<Record>::const_iterator rec_end);
 
+  // Invalidates and frees segments (and their overflow pages) that an aborted
+  // reorganization wrote but did not add to the index.
+  void DiscardNewSegments(
+      const std::vector<std::pair<Key, SegmentInfo>>& new_segments);
+
   std::filesystem::path db_path_;
   std::shared_ptr<LockManager> lock_manager_;
   std::unique_ptr<SegmentIndex> index_;
   std::vector<std::unique_ptr<SegmentFile>> segment_files_;
-  uint32_t next_sequence_number_;
+  // Incremented by concurrent reorganizations. Stored behind a pointer to keep
+  // `Manager` movable.
+  std::unique_ptr<std::atomic<uint32_t>> next_sequence_number_;
   std::unique_ptr<FreeList> free_;
   std::unique_ptr<ThreadPool> bg_threads_;
   std::shared_ptr<InsertTracker> tracker_;
+  // Set to `nullptr` if reorganization events should not be logged.
+  std::unique_ptr<ReorgLog> reorg_log_;
+  // Set to `nullptr` if segment accesses should not be tracked.
+  std::unique_ptr<SegmentAccessTracker> access_tracker_;
+  // The delta logs of the segments that have one. See
+  // `PageGroupedDBOptions::delta_pages_per_segment`.
+  std::unique_ptr<DeltaIndex> deltas_;
+  // Set to `nullptr` if concurrent page reads should not be coalesced.
+  std::unique_ptr<InflightReads> inflight_reads_;
+
+  // Used to estimate segment temperatures for tiered storage. Stored behind a
+  // pointer to keep `Manager` movable.
+  struct MigrationState {
+    std::mutex mutex;
+    // The base key and estimated accesses of each fast tier segment (keyed by
+    // the segment's ID value) as of the previous migration pass. The base key
+    // detects segment IDs that were reused in the meantime.
+    std::unordered_map<size_t, std::pair<Key, uint64_t>> prev_accesses;
+  };
+  std::unique_ptr<MigrationState> migration_;
 
   // Options passed in when the `Manager` was created.
   PageGroupedDBOptions options_;
@@ -203,6 +468,9 @@ class Manager {
   static thread_local Workspace w_;
 
   static const std::string kSegmentFilePrefix;
+  static const std::string kDebugDirName;
+  static const std::string kReorgLogCsvFileName;
+  static const std::string kAccessHeatmapCsvFileName;
 };
 
 }  // namespace pg
@@ -1,6 +1,7 @@
 #include <filesystem>
 #include <fstream>
 #include <iterator>
+#include <tuple>
 #include <vector>
 
 #include "key.h"
@@ -8,6 +9,7 @@
 #include "persist/segment_wrap.h"
 #include "treeline/pg_db.h"
 #include "treeline/pg_options.h"
+#include "treeline/pg_stats.h"
 #include "util/key.h"
 
 namespace fs = std::filesystem;
@@ -18,26 +20,47 @@ using namespace tl;
 using namespace tl::pg;
 
 const std::string kSegmentSummaryCsvFileName = "segment_summary.csv";
-const std::string kDebugDirName = "debug";
 
-Status LoadIntoPage(const PageBuffer& buf, size_t page_idx, Key lower,
-                    Key upper, std::vector<Record>::const_iterator rec_begin,
-                    std::vector<Record>::const_iterator rec_end) {
+// Loads the records in `[rec_begin, rec_end)` into page `page_idx` of `buf`.
+// If `compress` is true and the records do not fit in a regular page, the page
+// is compressed. Returns an iterator to the first record that did not fit in
+// the page (`rec_end` if all the records fit).
+std::vector<Record>::const_iterator LoadIntoPage(
+    const PageBuffer& buf, size_t page_idx, Key lower, Key upper,
+    std::vector<Record>::const_iterator rec_begin,
+    std::vector<Record>::const_iterator rec_end, const bool compress) {
   // All upper bound values in the page grouping code are exclusive. But the on
   // disk page expects an inclusive upper bound. So we subtract 1 from `upper`.
   key_utils::IntKeyAsSlice lower_key(lower), upper_key(upper - 1);
   pg::Page page(buf.get() + pg::Page::kSize * page_idx, lower_key.as<Slice>(),
                 upper_key.as<Slice>());
-  for (auto it = rec_begin; it != rec_end; ++it) {
+  auto it = rec_begin;
+  for (; it != rec_end; ++it) {
     key_utils::IntKeyAsSlice key(it->first);
-    const auto res = page.Put(key.as<Slice>(), it->second);
-    if (!res.ok()) {
-      std::cerr << "Page full. Current size: " << page.GetNumRecords()
-                << std::endl;
-      return res;
+    if (!page.Put(key.as<Slice>(), it->second).ok()) break;
+  }
+  if (it == rec_end || !compress) return it;
+
+  // Compress as many of the records as possible. Dropping records never makes
+  // the encoding larger, so we binary search for the longest prefix that fits.
+  // The page keeps the records of the last successful `PutCompressed()`.
+  const size_t num_uncompressed = it - rec_begin;
+  size_t fits = num_uncompressed;
+  size_t does_not_fit = rec_end - rec_begin + 1;
+  while (does_not_fit - fits > 1) {
+    const size_t mid = fits + (does_not_fit - fits) / 2;
+    if (page.PutCompressed(rec_begin, rec_begin + mid).ok()) {
+      fits = mid;
+    } else {
+      does_not_fit = mid;
     }
   }
-  return Status::OK();
+  if (fits == num_uncompressed) {
+    // Compression does not help; the page still holds the regular records.
+    return it;
+  }
+  PageGroupedDBStats::Local().BumpPagesCompressed();
+  return rec_begin + fits;
 }
 
 // Unused, but kept in case it is useful for debugging later on.
@@ -110,16 +133,13 @@ Manager Manager::BulkLoadIntoSegments(
   assert(options.use_segments);
 
   // Open the segment files before constructing the `Manager`.
-  std::vector<std::unique_ptr<SegmentFile>> segment_files;
-  for (size_t i = 0; i < SegmentBuilder::SegmentPageCounts().size(); ++i) {
-    segment_files.push_back(std::make_unique<SegmentFile>(
-        db_path / (kSegmentFilePrefix + std::to_string(i)),
-        /*pages_per_segment=*/SegmentBuilder::SegmentPageCounts()[i],
-        options.use_memory_based_io));
-  }
+  std::vector<std::unique_ptr<SegmentFile>> segment_files = OpenSegmentFiles(
+      db_path, SegmentBuilder::SegmentPageCounts().size(), options);
 
+  // The loaded segments use sequence number 0, so later writes (e.g., delta
+  // pages) start at 1.
   Manager m(db_path, {}, std::move(segment_files), options,
-            /*next_sequence_number=*/0, std::make_unique<FreeList>());
+            /*next_sequence_number=*/1, std::make_unique<FreeList>());
   m.BulkLoadIntoSegmentsImpl(records);
   return m;
 }
@@ -161,13 +181,12 @@ Manager Manager::BulkLoadIntoPages(
     const fs::path& db, const std::vector<std::pair<Key, Slice>>& records,
     const PageGroupedDBOptions& options) {
   // One single file containing 4 KiB pages.
-  std::vector<std::unique_ptr<SegmentFile>> segment_files;
-  segment_files.push_back(std::make_unique<SegmentFile>(
-      db / (kSegmentFilePrefix + "0"),
-      /*pages_per_segment=*/1, options.use_memory_based_io));
+  std::vector<std::unique_ptr<SegmentFile>> segment_files =
+      OpenSegmentFiles(db, /*num_files=*/1, options);
 
+  // The loaded pages use sequence number 0 (see above).
   Manager m(db, {}, std::move(segment_files), options,
-            /*next_sequence_number=*/0, std::make_unique<FreeList>());
+            /*next_sequence_number=*/1, std::make_unique<FreeList>());
   m.BulkLoadIntoPagesImpl(records);
   return m;
 }
@@ -188,6 +207,20 @@ std::pair<Key, SegmentInfo> Manager::LoadIntoNewSegment(
   const Key base_key = seg.records[0].first;
   const PageBuffer& buf = w_.buffer();
   memset(buf.get(), 0, pg::Page::kSize * seg.page_count);
+
+  // The records that did not fit in their page (page index, first record, and
+  // end).
+  std::vector<std::tuple<size_t, std::vector<Record>::const_iterator,
+                         std::vector<Record>::const_iterator>>
+      spilled;
+  const auto load_page = [&](const size_t page_idx, const Key lower,
+                             const Key upper,
+                             const std::vector<Record>::const_iterator begin,
+                             const std::vector<Record>::const_iterator end) {
+    const auto loaded_end = LoadIntoPage(buf, page_idx, lower, upper, begin,
+                                         end, options_.compress_pages);
+    if (loaded_end != end) spilled.emplace_back(page_idx, loaded_end, end);
+  };
   if (seg.page_count > 1) {
     const auto lower_boundaries = ComputePageLowerBoundaries(seg);
     auto page_start = seg.records.begin();
@@ -200,18 +233,13 @@ std::pair<Key, SegmentInfo> Manager::LoadIntoNewSegment(
                              return rec.first < page_upper;
                            });
       // All upper bounds in the page grouping code are exclusive.
-      const auto result =
-          LoadIntoPage(buf, page_idx, lower_boundaries[page_idx], page_upper,
-                       page_start, cutoff_it);
-      assert(result.ok());
+      load_page(page_idx, lower_boundaries[page_idx], page_upper, page_start,
+                cutoff_it);
       page_start = cutoff_it;
     }
     // Flush remaining to a page.
-    const auto result =
-        LoadIntoPage(buf, seg.page_count - 1,
-                     /*lower=*/lower_boundaries.back(),
-                     /*upper=*/upper_bound, page_start, seg.records.end());
-    assert(result.ok());
+    load_page(seg.page_count - 1, /*lower=*/lower_boundaries.back(),
+              /*upper=*/upper_bound, page_start, seg.records.end());
 
     // Write model into the first page (for deserialization).
     pg::Page first_page(buf.get());
@@ -220,10 +248,8 @@ std::pair<Key, SegmentInfo> Manager::LoadIntoNewSegment(
   } else {
     // Simple case - put all the records into one page.
     assert(seg.page_count == 1);
-    const auto result =
-        LoadIntoPage(buf, 0, /*lower=*/seg.base_key, upper_bound,
-                     seg.records.begin(), seg.records.end());
-    assert(result.ok());
+    load_page(0, /*lower=*/seg.base_key, upper_bound, seg.records.begin(),
+              seg.records.end());
   }
 
   // 2. Set the checksum and sequence number.
@@ -232,7 +258,13 @@ std::pair<Key, SegmentInfo> Manager::LoadIntoNewSegment(
   sw.ComputeAndSetChecksum();
   sw.ClearAllOverflows();
 
-  // 3. Write the segment to disk.
+  // 3. Place the records that did not fit in their page in overflow pages.
+  for (const auto& [page_idx, begin, end] : spilled) {
+    LoadIntoOverflowPage(pg::Page(buf.get() + page_idx * pg::Page::kSize),
+                         begin, end);
+  }
+
+  // 4. Write the segment to disk.
   const size_t segment_idx =
       SegmentBuilder::PageCountToSegment().find(seg.page_count)->second;
   std::unique_ptr<SegmentFile>& sf = segment_files_[segment_idx];
@@ -248,12 +280,35 @@ std::pair<Key, SegmentInfo> Manager::LoadIntoNewSegment(
                        /*page_offset=*/byte_offset / pg::Page::kSize);
   }
 
+  SegmentWrap(buf.get(), seg.page_count).ComputeAndSetPageChecksums();
   sf->WritePages(seg_id.GetOffset() * Page::kSize, buf.get(), seg.page_count);
   w_.BumpWriteCount(seg.page_count);
-  return std::make_pair(
-      base_key, SegmentInfo(seg_id, seg.model.has_value()
-                                        ? seg.model->line()
-                                        : std::optional<plr::Line64>()));
+  SegmentInfo sinfo(seg_id, seg.model.has_value()
+                                ? seg.model->line()
+                                : std::optional<plr::Line64>());
+  sinfo.SetOverflow(!spilled.empty());
+  return std::make_pair(base_key, sinfo);
+}
+
+void Manager::LoadIntoOverflowPage(
+    pg::Page main_page, const std::vector<Record>::const_iterator rec_begin,
+    const std::vector<Record>::const_iterator rec_end) {
+  PageBuffer buf = PageMemoryAllocator::Allocate(/*num_pages=*/1);
+  memset(buf.get(), 0, pg::Page::kSize);
+  pg::Page overflow_page(buf.get(), main_page);
+  overflow_page.MakeOverflow();
+  overflow_page.SetOverflow(SegmentId());
+  for (auto it = rec_begin; it != rec_end; ++it) {
+    key_utils::IntKeyAsSlice key(it->first);
+    if (!overflow_page.Put(key.as<Slice>(), it->second).ok()) {
+      throw std::runtime_error(
+          "Records do not fit in a page and its overflow page.");
+    }
+  }
+  const SegmentId overflow_id = AllocateOverflowPage();
+  WritePage(overflow_id, /*page_idx=*/0, buf.get());
+  main_page.SetOverflow(overflow_id);
+  PageGroupedDBStats::Local().BumpOverflowsCreated();
 }
 
 std::vector<std::pair<Key, SegmentInfo>> Manager::LoadIntoNewPages(
@@ -275,12 +330,15 @@ std::vector<std::pair<Key, SegmentInfo>> Manager::LoadIntoNewPages(
     const Key lower = page_start_idx == 0 ? lower_bound : page_begin->first;
     const Key upper =
         page_end_idx == num_records ? upper_bound : page_end->first;
-    auto result = LoadIntoPage(buf, 0, lower, upper, page_begin, page_end);
-    assert(result.ok());
+    const auto loaded_end = LoadIntoPage(buf, 0, lower, upper, page_begin,
+                                         page_end, options_.compress_pages);
 
     SegmentWrap sw(buf.get(), 1);
     sw.SetSequenceNumber(sequence_number);
     sw.ClearAllOverflows();
+    if (loaded_end != page_end) {
+      LoadIntoOverflowPage(pg::Page(buf.get()), loaded_end, page_end);
+    }
 
     // Write page to disk.
     SegmentId seg_id;
@@ -292,13 +350,15 @@ std::vector<std::pair<Key, SegmentInfo>> Manager::LoadIntoNewPages(
       seg_id = SegmentId(/*file_id=*/0,
                          /*page_offset=*/byte_offset / pg::Page::kSize);
     }
+    pg::Page(buf.get()).ComputeAndSetPageChecksum();
     sf->WritePages(seg_id.GetOffset() * Page::kSize, buf.get(),
                    /*num_pages=*/1);
     w_.BumpWriteCount(1);
 
     // Record the page boundary.
-    segment_boundaries.emplace_back(
-        lower, SegmentInfo(seg_id, std::optional<plr::Line64>()));
+    SegmentInfo sinfo(seg_id, std::optional<plr::Line64>());
+    sinfo.SetOverflow(loaded_end != page_end);
+    segment_boundaries.emplace_back(lower, sinfo);
 
     page_start_idx = page_end_idx;
     page_end_idx = page_start_idx + options_.records_per_page_goal;
@@ -308,12 +368,15 @@ std::vector<std::pair<Key, SegmentInfo>> Manager::LoadIntoNewPages(
     memset(buf.get(), 0, pg::Page::kSize);
     const auto page_begin = rec_begin + page_start_idx;
     const Key lower = page_start_idx == 0 ? lower_bound : page_begin->first;
-    auto result = LoadIntoPage(buf, 0, lower, upper_bound, page_begin, rec_end);
-    assert(result.ok());
+    const auto loaded_end = LoadIntoPage(buf, 0, lower, upper_bound, page_begin,
+                                         rec_end, options_.compress_pages);
 
     SegmentWrap sw(buf.get(), 1);
     sw.SetSequenceNumber(0);
     sw.ClearAllOverflows();
+    if (loaded_end != rec_end) {
+      LoadIntoOverflowPage(pg::Page(buf.get()), loaded_end, rec_end);
+    }
 
     // Write page to disk.
     SegmentId seg_id;
@@ -325,16 +388,45 @@ std::vector<std::pair<Key, SegmentInfo>> Manager::LoadIntoNewPages(
       seg_id = SegmentId(/*file_id=*/0,
                          /*page_offset=*/byte_offset / pg::Page::kSize);
     }
+    pg::Page(buf.get()).ComputeAndSetPageChecksum();
     sf->WritePages(seg_id.GetOffset() * Page::kSize, buf.get(),
                    /*num_pages=*/1);
     w_.BumpWriteCount(1);
 
-    segment_boundaries.emplace_back(
-        lower, SegmentInfo(seg_id, std::optional<plr::Line64>()));
+    SegmentInfo sinfo(seg_id, std::optional<plr::Line64>());
+    sinfo.SetOverflow(loaded_end != rec_end);
+    segment_boundaries.emplace_back(lower, sinfo);
   }
 
   return segment_boundaries;
 }
 
+void Manager::DiscardNewSegments(
+    const std::vector<std::pair<Key, SegmentInfo>>& new_segments) {
+  void* const buf = w_.buffer().get();
+  std::vector<SegmentId> to_free;
+  for (const auto& [base, sinfo] : new_segments) {
+    const SegmentId seg_id = sinfo.id();
+    if (sinfo.HasOverflow()) {
+      // The new segment's pages are valid, so they do not need to be verified.
+      const size_t page_count = sinfo.page_count();
+      SegmentFileFor(seg_id)->ReadPages(seg_id.GetOffset() * pg::Page::kSize,
+                                        buf, page_count);
+      w_.BumpReadCount(page_count);
+      SegmentWrap(buf, page_count).ForEachPage([&](size_t, pg::Page page) {
+        if (page.HasOverflow()) to_free.push_back(page.GetOverflow());
+      });
+    }
+    to_free.push_back(seg_id);
+  }
+
+  // Invalidate the pages so that they are not picked up by `Reopen()`.
+  memset(buf, 0, pg::Page::kSize);
+  for (const auto& id : to_free) {
+    WritePage(id, 0, buf);
+  }
+  free_->AddBatch(to_free);
+}
+
 }  // namespace pg
 }  // namespace tl
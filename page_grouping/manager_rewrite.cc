@@ -1,4 +1,6 @@
+#include <chrono>
 #include <deque>
+#include <stdexcept>
 #include <utility>
 #include <vector>
 
@@ -146,6 +148,30 @@ bool ValidRangeForSegment(const Key lower, const Key upper,
   return lower <= first_key && last_key < upper;
 }
 
+// Merges the sorted record ranges `[newer_begin, newer_end)` and `older`. If
+// both hold a record with the same key, only the newer record is kept.
+std::vector<Record> MergeNewerRecords(
+    std::vector<Record>::const_iterator newer_begin,
+    const std::vector<Record>::const_iterator newer_end,
+    const std::vector<Record>& older) {
+  std::vector<Record> merged;
+  merged.reserve((newer_end - newer_begin) + older.size());
+  auto older_it = older.begin();
+  while (newer_begin != newer_end && older_it != older.end()) {
+    if (newer_begin->first <= older_it->first) {
+      if (newer_begin->first == older_it->first) ++older_it;
+      merged.push_back(*newer_begin);
+      ++newer_begin;
+    } else {
+      merged.push_back(*older_it);
+      ++older_it;
+    }
+  }
+  merged.insert(merged.end(), newer_begin, newer_end);
+  merged.insert(merged.end(), older_it, older.end());
+  return merged;
+}
+
 }  // namespace
 
 namespace tl {
@@ -153,8 +179,12 @@ namespace pg {
 
 Status Manager::RewriteSegments(
     Key segment_base, std::vector<Record>::const_iterator addtl_rec_begin,
-    std::vector<Record>::const_iterator addtl_rec_end) {
+    std::vector<Record>::const_iterator addtl_rec_end,
+    const ReorgTrigger trigger) {
   std::vector<SegmentIndex::Entry> segments_to_rewrite;
+  ReorgEvent event;
+  event.trigger = trigger;
+  event.start = std::chrono::steady_clock::now();
 
   if (options_.rewrite_search_radius > 0) {
     segments_to_rewrite = index_->FindAndLockRewriteRegion(
@@ -163,6 +193,7 @@ Status Manager::RewriteSegments(
     segments_to_rewrite.emplace_back(
         index_->SegmentForKeyWithLock(segment_base, SegmentMode::kReorg));
   }
+  event.lock_wait = std::chrono::steady_clock::now() - event.start;
 
   // Verify that the segments can still be rewritten after we have acquired the
   // segment locks.
@@ -182,20 +213,30 @@ Status Manager::RewriteSegments(
   }
 
   return RewriteSegmentsImpl(std::move(segments_to_rewrite), addtl_rec_begin,
-                             addtl_rec_end);
+                             addtl_rec_end, event);
 }
 
 Status Manager::RewriteSegmentsImpl(
     std::vector<SegmentIndex::Entry> segments_to_rewrite,
     std::vector<Record>::const_iterator addtl_rec_begin,
-    std::vector<Record>::const_iterator addtl_rec_end) {
+    std::vector<Record>::const_iterator addtl_rec_end, ReorgEvent event) {
   std::vector<std::pair<Key, SegmentInfo>> rewritten_segments;
   std::vector<SegmentId> overflows_to_clear;
   // Track rewrite statistics.
   PageGroupedDBStats::Local().BumpRewrites();
   for (const auto& seg : segments_to_rewrite) {
     PageGroupedDBStats::Local().BumpRewriteInputPages(seg.sinfo.page_count());
+    event.pages_read += seg.sinfo.page_count();
   }
+  // Aborts the rewrite when a page fails its checksum check. The old segments
+  // are left unchanged; the new segments written so far are discarded.
+  const auto abort_rewrite = [&](const Status& status) {
+    DiscardNewSegments(rewritten_segments);
+    for (const auto& seg : segments_to_rewrite) {
+      lock_manager_->ReleaseSegmentLock(seg.sinfo.id(), SegmentMode::kReorg);
+    }
+    return status;
+  };
 
   // 2. Load and merge the segments.
   //
@@ -218,8 +259,34 @@ Status Manager::RewriteSegmentsImpl(
   // no more memory available in our sliding window, we will just write
   // currently-being-built built segment onto disk instead.
 
+  // The records in the segments' delta logs are newer than the records in
+  // their pages, so they are merged in with the additional records (which are
+  // newer still). The delta pages are freed along with the overflow pages.
+  std::vector<DeltaPages> segment_deltas(segments_to_rewrite.size());
+  std::vector<Record> delta_records, merged_records;
+  for (size_t i = 0; i < segments_to_rewrite.size(); ++i) {
+    DeltaPages& deltas = segment_deltas[i];
+    const Status status =
+        ReadDeltaPages(segments_to_rewrite[i].sinfo.id(), &deltas);
+    if (!status.ok()) return abort_rewrite(status);
+    deltas.AppendRecords(&delta_records);
+    for (const auto& page : deltas.pages) {
+      overflows_to_clear.push_back(page.id);
+    }
+    PageGroupedDBStats::Local().BumpRewriteInputPages(deltas.pages.size());
+    event.pages_read += deltas.pages.size();
+  }
+  if (!delta_records.empty()) {
+    merged_records =
+        MergeNewerRecords(addtl_rec_begin, addtl_rec_end, delta_records);
+  }
+  const auto rec_begin = delta_records.empty() ? addtl_rec_begin
+                                               : merged_records.cbegin();
+  const auto rec_end =
+      delta_records.empty() ? addtl_rec_end : merged_records.cend();
+
   // Used for recovery.
-  const uint32_t sequence_number = next_sequence_number_++;
+  const uint32_t sequence_number = (*next_sequence_number_)++;
 
   CircularPageBuffer page_buf(SegmentBuilder::SegmentPageCounts().back() * 4);
 
@@ -265,7 +332,9 @@ Status Manager::RewriteSegmentsImpl(
     // (i.e., pages that do not cover any keys in the key space).
     future_goal =
         std::max(static_cast<size_t>(2 * future_epsilon), future_goal);
+    event.forecasted_inserts = forecasted_inserts;
   }
+  event.records_per_page_goal = future_goal;
 
   //
   // End insert forecasting
@@ -286,7 +355,7 @@ Status Manager::RewriteSegmentsImpl(
   // (because their records have not yet been written to new segments).
   std::deque<PageChain> pages_to_process, pages_processed;
 
-  PagePlusRecordMerger pm(addtl_rec_begin, addtl_rec_end);
+  PagePlusRecordMerger pm(rec_begin, rec_end);
 
   // TODO: Before starting the rewrite, we should log (and force to stable
   // storage) the following:
@@ -379,7 +448,8 @@ Status Manager::RewriteSegmentsImpl(
     }
 
     // Load the segment and check for overflows.
-    ReadSegment(seg_to_rewrite.sinfo.id());
+    Status status = ReadSegment(seg_to_rewrite.sinfo.id());
+    if (!status.ok()) return abort_rewrite(status);
     SegmentWrap sw(w_.buffer().get(), seg_to_rewrite.sinfo.page_count());
     const size_t num_overflows = sw.NumOverflows();
     if (segment_pages + num_overflows > page_buf.NumFreePages()) {
@@ -413,8 +483,10 @@ Status Manager::RewriteSegmentsImpl(
     });
 
     // Load all overflows into memory.
-    ReadOverflows(overflows_to_load);
+    status = ReadOverflows(overflows_to_load);
+    if (!status.ok()) return abort_rewrite(status);
     PageGroupedDBStats::Local().BumpRewriteInputPages(overflows_to_load.size());
+    event.pages_read += overflows_to_load.size();
 
     // Add chains into the deque.
     pages_to_process.insert(pages_to_process.end(), chains_in_segment.begin(),
@@ -454,9 +526,11 @@ Status Manager::RewriteSegmentsImpl(
 
   // The new segments have now been rewritten. Upgrade to exclusive mode before
   // exposing the new segments.
+  const auto upgrade_start = std::chrono::steady_clock::now();
   for (const auto& seg : segments_to_rewrite) {
     lock_manager_->UpgradeSegmentLockToReorgExclusive(seg.sinfo.id());
   }
+  event.lock_wait += std::chrono::steady_clock::now() - upgrade_start;
 
   // 3. For crash consistency, we need to invalidate at least one of the old
   // segments before exposing the newly rewritten segments. Ideally we would
@@ -501,6 +575,10 @@ Status Manager::RewriteSegmentsImpl(
           raw_index.insert(new_segment);
         }
       });
+  MoveSegmentAccesses(segments_to_rewrite, rewritten_segments);
+  for (const auto& seg : segments_to_rewrite) {
+    deltas_->Remove(seg.sinfo.id());
+  }
   for (const auto& seg : segments_to_rewrite) {
     lock_manager_->ReleaseSegmentLock(seg.sinfo.id(),
                                       SegmentMode::kReorgExclusive);
@@ -546,13 +624,33 @@ Status Manager::RewriteSegmentsImpl(
   PageGroupedDBStats::Local().BumpRewriteOutputPages(rewritten_segments.size() +
                                                      overflows_to_clear.size());
 
+  if (reorg_log_ != nullptr) {
+    event.lower = segments_to_rewrite.front().lower;
+    event.upper = segments_to_rewrite.back().upper;
+    event.segments_in = segments_to_rewrite.size();
+    event.segments_out = rewritten_segments.size();
+    for (const auto& new_seg : rewritten_segments) {
+      event.pages_written += new_seg.second.page_count();
+    }
+    event.pages_written +=
+        segments_to_rewrite.size() + overflows_to_clear.size();
+    event.records_merged = addtl_rec_end - addtl_rec_begin;
+    event.duration = std::chrono::steady_clock::now() - event.start;
+    reorg_log_->Record(event);
+  }
+
   return Status::OK();
 }
 
 Status Manager::FlattenChain(
     const Key base, const std::vector<Record>::const_iterator addtl_rec_begin,
-    const std::vector<Record>::const_iterator addtl_rec_end) {
+    const std::vector<Record>::const_iterator addtl_rec_end,
+    const ReorgTrigger trigger) {
+  ReorgEvent event;
+  event.trigger = trigger;
+  event.start = std::chrono::steady_clock::now();
   const auto seg = index_->SegmentForKeyWithLock(base, SegmentMode::kReorg);
+  event.lock_wait = std::chrono::steady_clock::now() - event.start;
   if (base != seg.lower ||
       !ValidRangeForSegment(seg.lower, seg.upper, addtl_rec_begin,
                             addtl_rec_end)) {
@@ -570,12 +668,21 @@ Status Manager::FlattenChain(
   // NOTE: No need for page lock(s) if you hold the segment lock in `kReorg`
   // mode.
   PageBuffer buf = PageMemoryAllocator::Allocate(/*num_pages=*/2);
+  // A page that fails its checksum check aborts the flatten.
+  const auto abort_flatten = [&](const Status& status) {
+    lock_manager_->ReleaseSegmentLock(seg.sinfo.id(), SegmentMode::kReorg);
+    return status;
+  };
   ReadPage(main_page_id, 0, buf.get());
+  Status status = VerifyPages(buf.get(), /*num_pages=*/1);
+  if (!status.ok()) return abort_flatten(status);
   pg::Page main(buf.get());
   const SegmentId overflow_page_id = main.GetOverflow();
   if (overflow_page_id.IsValid()) {
     // Read the overflow too.
     ReadPage(overflow_page_id, 0, buf.get() + pg::Page::kSize);
+    status = VerifyPages(buf.get() + pg::Page::kSize, /*num_pages=*/1);
+    if (!status.ok()) return abort_flatten(status);
   }
   const PageChain pc =
       main.HasOverflow()
@@ -583,15 +690,32 @@ Status Manager::FlattenChain(
           : PageChain::SingleOnly(buf.get());
   PageMergeIterator pmi = pc.GetIterator();
 
+  // The records in the page's delta log (if any) are newer than the records in
+  // the chain, but older than the additional records.
+  DeltaPages deltas;
+  status = ReadDeltaPages(main_page_id, &deltas);
+  if (!status.ok()) return abort_flatten(status);
+  std::vector<Record> delta_records, merged_records;
+  deltas.AppendRecords(&delta_records);
+  if (!delta_records.empty()) {
+    merged_records =
+        MergeNewerRecords(addtl_rec_begin, addtl_rec_end, delta_records);
+  }
+  const auto rec_begin = delta_records.empty() ? addtl_rec_begin
+                                               : merged_records.cbegin();
+  const auto rec_end =
+      delta_records.empty() ? addtl_rec_end : merged_records.cend();
+
   PageGroupedDBStats::Local().BumpRewrites();
-  PageGroupedDBStats::Local().BumpRewriteInputPages(main.HasOverflow() ? 2 : 1);
+  PageGroupedDBStats::Local().BumpRewriteInputPages(
+      (main.HasOverflow() ? 2 : 1) + deltas.pages.size());
 
   // Merge the records in the chain with those in memory. If two records have
   // the same key, we prefer the in-memory one (it is a more recent write).
   std::vector<Record> records;
-  records.reserve(pmi.RecordsLeft() + (addtl_rec_end - addtl_rec_begin));
-  auto rec_it = addtl_rec_begin;
-  while (pmi.Valid() && rec_it != addtl_rec_end) {
+  records.reserve(pmi.RecordsLeft() + (rec_end - rec_begin));
+  auto rec_it = rec_begin;
+  while (pmi.Valid() && rec_it != rec_end) {
     const Key pmi_key = key_utils::ExtractHead64(pmi.key());
     if (pmi_key == rec_it->first) {
       records.push_back(*rec_it);
@@ -611,12 +735,12 @@ Status Manager::FlattenChain(
     records.emplace_back(pmi_key, pmi.value());
     pmi.Next();
   }
-  while (rec_it != addtl_rec_end) {
+  while (rec_it != rec_end) {
     records.push_back(*rec_it);
     ++rec_it;
   }
 
-  const uint32_t sequence_number = next_sequence_number_++;
+  const uint32_t sequence_number = (*next_sequence_number_)++;
 
   // TODO: Log that we're running a page chain rewrite (include the sequence
   // number and the segment ID).
@@ -626,7 +750,9 @@ Status Manager::FlattenChain(
   // The flattened chain has been written to new pages. Now we upgrade the
   // segment lock to `kReorgExclusive` to wait for any concurrent readers to
   // finish reading the old chain.
+  const auto upgrade_start = std::chrono::steady_clock::now();
   lock_manager_->UpgradeSegmentLockToReorgExclusive(seg.sinfo.id());
+  event.lock_wait += std::chrono::steady_clock::now() - upgrade_start;
 
   // For crash consistency, we need to invalidate at least one of the old pages
   // before exposing the newly rewritten pages. Ideally we would submit
@@ -662,6 +788,8 @@ Status Manager::FlattenChain(
     raw_index.erase(base);
     raw_index.insert(new_pages.begin(), new_pages.end());
   });
+  MoveSegmentAccesses({seg}, new_pages);
+  deltas_->Remove(main_page_id);
   lock_manager_->ReleaseSegmentLock(seg.sinfo.id(),
                                     SegmentMode::kReorgExclusive);
 
@@ -675,6 +803,10 @@ Status Manager::FlattenChain(
     }
     free_->Add(overflow_page_id);
   }
+  for (const auto& delta_page : deltas.pages) {
+    WritePage(delta_page.id, 0, zero);
+    free_->Add(delta_page.id);
+  }
 
   // Keep track of the number of affected pages.
   // Newly written pages.
@@ -682,7 +814,21 @@ Status Manager::FlattenChain(
 
   // Invalidated old pages.
   PageGroupedDBStats::Local().BumpRewriteOutputPages(
-      overflow_page_id.IsValid() ? 2 : 1);
+      (overflow_page_id.IsValid() ? 2 : 1) + deltas.pages.size());
+
+  if (reorg_log_ != nullptr) {
+    event.lower = base;
+    event.upper = upper;
+    event.segments_in = 1;
+    event.segments_out = new_pages.size();
+    event.pages_read =
+        (overflow_page_id.IsValid() ? 2 : 1) + deltas.pages.size();
+    event.pages_written = new_pages.size() + event.pages_read;
+    event.records_merged = addtl_rec_end - addtl_rec_begin;
+    event.records_per_page_goal = options_.records_per_page_goal;
+    event.duration = std::chrono::steady_clock::now() - event.start;
+    reorg_log_->Record(event);
+  }
 
   return Status::OK();
 }
@@ -693,6 +839,9 @@ Status Manager::FlattenRange(const Key start_key, const Key end_key) {
   Key curr_start = start_key;
   std::vector<SegmentIndex::Entry> to_rewrite;
   while (curr_start < end_key) {
+    ReorgEvent event;
+    event.trigger = ReorgTrigger::kFlatten;
+    event.start = std::chrono::steady_clock::now();
     while (true) {
       const auto res =
           index_->FindAndLockNextOverflowRegion(curr_start, end_key);
@@ -706,9 +855,12 @@ Status Manager::FlattenRange(const Key start_key, const Key end_key) {
       // Done.
       return Status::OK();
     }
+    event.lock_wait = std::chrono::steady_clock::now() - event.start;
     const Key next_start = to_rewrite.back().upper;
-    RewriteSegmentsImpl(std::move(to_rewrite), kEmptyRecords.begin(),
-                        kEmptyRecords.end());
+    const Status status =
+        RewriteSegmentsImpl(std::move(to_rewrite), kEmptyRecords.begin(),
+                            kEmptyRecords.end(), event);
+    if (!status.ok()) return status;
     curr_start = next_start;
     to_rewrite.clear();
   }
@@ -1,3 +1,4 @@
+#include <optional>
 #include <vector>
 
 #include "manager.h"
@@ -35,6 +36,7 @@ Status Manager::ScanWithEstimates(
   // 1. Find the segment that should hold the start key.
   const auto start_seg =
       index_->SegmentForKeyWithLock(start_key, SegmentMode::kPageRead);
+  SampleSegmentAccess(start_seg.lower, SegmentAccessType::kRead);
 
   // 2. Estimate how much of the segment to read based on the position of the
   // key.
@@ -81,8 +83,7 @@ Status Manager::ScanWithEstimates(
     lock_manager_->AcquirePageLock(start_seg.sinfo.id(), page_idx,
                                    PageMode::kShared);
   }
-  const std::unique_ptr<SegmentFile>& sf =
-      segment_files_[start_seg.sinfo.id().GetFileId()];
+  const std::unique_ptr<SegmentFile>& sf = SegmentFileFor(start_seg.sinfo.id());
   const size_t segment_byte_offset =
       start_seg.sinfo.id().GetOffset() * Page::kSize;
   sf->ReadPages(segment_byte_offset + start_page_idx * Page::kSize,
@@ -97,14 +98,35 @@ Status Manager::ScanWithEstimates(
 
   // Scan the first page.
   Page first_page(w_.buffer().get());
-  std::vector<Page::Iterator> page_its = {first_page.GetIterator()};
-  if (first_page.HasOverflow()) {
-    ReadPage(first_page.GetOverflow(), 0, overflow_buf);
-    page_its.push_back(overflow_page.GetIterator());
+  // A segment's delta pages (if any) are read once, before its pages are
+  // scanned.
+  DeltaPages deltas;
+  Status status = ReadDeltaPages(start_seg.sinfo.id(), &deltas);
+  if (status.ok()) {
+    status = VerifyPages(first_page.data().data(), /*num_pages=*/1);
+  }
+  std::vector<Page::Iterator> page_its;
+  Slice first_page_upper;
+  bool first_page_has_deltas = false;
+  if (status.ok()) {
+    page_its.push_back(first_page.GetIterator());
+    if (first_page.HasOverflow()) {
+      ReadPage(first_page.GetOverflow(), 0, overflow_buf);
+      status = VerifyPages(overflow_buf, /*num_pages=*/1);
+      page_its.push_back(overflow_page.GetIterator());
+    }
+    first_page_has_deltas = deltas.AddIterators(first_page, &page_its);
+    first_page_upper = first_page.GetUpperBoundary();
+  }
+  if (!status.ok()) {
+    // Stop the scan. The remaining page locks are released below.
+    page_its.clear();
+    records_left = 0;
   }
   key_utils::IntKeyAsSlice start_key_slice_helper(start_key);
   Slice start_key_slice = start_key_slice_helper.as<Slice>();
-  PageMergeIterator pmi(std::move(page_its), &start_key_slice);
+  PageMergeIterator pmi(std::move(page_its), &start_key_slice,
+                        first_page_has_deltas ? &first_page_upper : nullptr);
   for (; records_left > 0 && pmi.Valid(); --records_left, pmi.Next()) {
     values_out->emplace_back(key_utils::ExtractHead64(pmi.key()),
                              pmi.value().ToString());
@@ -113,15 +135,28 @@ Status Manager::ScanWithEstimates(
                                  PageMode::kShared);
 
   // Common code used to scan a whole page.
-  const auto scan_page = [this, &records_left, &overflow_page, overflow_buf,
-                          values_out](const Page& page) {
+  const auto scan_page = [this, &records_left, &status, &overflow_page,
+                          &deltas, overflow_buf, values_out](const Page& page) {
+    Status page_status = VerifyPages(page.data().data(), /*num_pages=*/1);
+    if (page_status.ok() && page.HasOverflow()) {
+      ReadPage(page.GetOverflow(), 0, overflow_buf);
+      page_status = VerifyPages(overflow_buf, /*num_pages=*/1);
+    }
+    if (!page_status.ok()) {
+      status = page_status;
+      records_left = 0;
+      return;
+    }
+
     std::vector<Page::Iterator> page_its = {page.GetIterator()};
     if (page.HasOverflow()) {
-      ReadPage(page.GetOverflow(), 0, overflow_buf);
       page_its.push_back(overflow_page.GetIterator());
     }
+    const bool has_deltas = deltas.AddIterators(page, &page_its);
+    const Slice upper = page.GetUpperBoundary();
 
-    PageMergeIterator pmi(std::move(page_its));
+    PageMergeIterator pmi(std::move(page_its), /*start_key=*/nullptr,
+                          has_deltas ? &upper : nullptr);
     for (; records_left > 0 && pmi.Valid(); --records_left, pmi.Next()) {
       values_out->emplace_back(key_utils::ExtractHead64(pmi.key()),
                                pmi.value().ToString());
@@ -167,7 +202,7 @@ Status Manager::ScanWithEstimates(
     // No need to scan the next segment.
     lock_manager_->ReleaseSegmentLock(start_seg.sinfo.id(),
                                       SegmentMode::kPageRead);
-    return Status::OK();
+    return status;
   }
 
   // 4. Now keep scanning forward as far as needed.
@@ -177,6 +212,7 @@ Status Manager::ScanWithEstimates(
                                         SegmentMode::kPageRead);
   while (records_left > 0 && curr_seg.has_value()) {
     lock_manager_->ReleaseSegmentLock(prev_seg_id, SegmentMode::kPageRead);
+    SampleSegmentAccess(curr_seg->lower, SegmentAccessType::kRead);
 
     const size_t seg_page_count = curr_seg->sinfo.page_count();
     const size_t seg_byte_offset =
@@ -193,9 +229,11 @@ Status Manager::ScanWithEstimates(
                                      PageMode::kShared);
     }
     const std::unique_ptr<SegmentFile>& sf =
-        segment_files_[curr_seg->sinfo.id().GetFileId()];
+        SegmentFileFor(curr_seg->sinfo.id());
     sf->ReadPages(seg_byte_offset, w_.buffer().get(), pages_to_read);
     w_.BumpReadCount(pages_to_read);
+    status = ReadDeltaPages(curr_seg->sinfo.id(), &deltas);
+    if (!status.ok()) records_left = 0;
 
     size_t page_idx = 0;
     while (records_left > 0 && page_idx < pages_to_read) {
@@ -237,7 +275,7 @@ Status Manager::ScanWithEstimates(
   }
 
   lock_manager_->ReleaseSegmentLock(prev_seg_id, SegmentMode::kPageRead);
-  return Status::OK();
+  return status;
 }
 
 Status Manager::ScanWhole(
@@ -262,8 +300,7 @@ Status Manager::ScanWhole(
       index_->SegmentForKeyWithLock(start_key, SegmentMode::kPageRead);
 
   // 2. Read the first segment.
-  const std::unique_ptr<SegmentFile>& sf =
-      segment_files_[start_seg.sinfo.id().GetFileId()];
+  const std::unique_ptr<SegmentFile>& sf = SegmentFileFor(start_seg.sinfo.id());
   const size_t first_segment_size = start_seg.sinfo.page_count();
   const size_t segment_byte_offset =
       start_seg.sinfo.id().GetOffset() * Page::kSize;
@@ -287,14 +324,35 @@ Status Manager::ScanWhole(
 
   // 3. Scan the first matching page in the segment.
   Page first_page(w_.buffer().get() + start_segment_page_idx * Page::kSize);
-  std::vector<Page::Iterator> page_its = {first_page.GetIterator()};
-  if (first_page.HasOverflow()) {
-    ReadPage(first_page.GetOverflow(), 0, overflow_buf);
-    page_its.push_back(overflow_page.GetIterator());
+  // A segment's delta pages (if any) are read once, before its pages are
+  // scanned.
+  DeltaPages deltas;
+  Status status = ReadDeltaPages(start_seg.sinfo.id(), &deltas);
+  if (status.ok()) {
+    status = VerifyPages(first_page.data().data(), /*num_pages=*/1);
+  }
+  std::vector<Page::Iterator> page_its;
+  Slice first_page_upper;
+  bool first_page_has_deltas = false;
+  if (status.ok()) {
+    page_its.push_back(first_page.GetIterator());
+    if (first_page.HasOverflow()) {
+      ReadPage(first_page.GetOverflow(), 0, overflow_buf);
+      status = VerifyPages(overflow_buf, /*num_pages=*/1);
+      page_its.push_back(overflow_page.GetIterator());
+    }
+    first_page_has_deltas = deltas.AddIterators(first_page, &page_its);
+    first_page_upper = first_page.GetUpperBoundary();
+  }
+  if (!status.ok()) {
+    // Stop the scan. The remaining page locks are released below.
+    page_its.clear();
+    records_left = 0;
   }
   key_utils::IntKeyAsSlice start_key_slice_helper(start_key);
   Slice start_key_slice = start_key_slice_helper.as<Slice>();
-  PageMergeIterator pmi(std::move(page_its), &start_key_slice);
+  PageMergeIterator pmi(std::move(page_its), &start_key_slice,
+                        first_page_has_deltas ? &first_page_upper : nullptr);
   for (; pmi.Valid() && records_left > 0; pmi.Next(), --records_left) {
     values_out->emplace_back(key_utils::ExtractHead64(pmi.key()),
                              pmi.value().ToString());
@@ -303,15 +361,28 @@ Status Manager::ScanWhole(
                                  PageMode::kShared);
 
   // Common code used to scan a whole page.
-  const auto scan_page = [this, &records_left, &overflow_page, overflow_buf,
-                          values_out](const Page& page) {
+  const auto scan_page = [this, &records_left, &status, &overflow_page,
+                          &deltas, overflow_buf, values_out](const Page& page) {
+    Status page_status = VerifyPages(page.data().data(), /*num_pages=*/1);
+    if (page_status.ok() && page.HasOverflow()) {
+      ReadPage(page.GetOverflow(), 0, overflow_buf);
+      page_status = VerifyPages(overflow_buf, /*num_pages=*/1);
+    }
+    if (!page_status.ok()) {
+      status = page_status;
+      records_left = 0;
+      return;
+    }
+
     std::vector<Page::Iterator> page_its = {page.GetIterator()};
     if (page.HasOverflow()) {
-      ReadPage(page.GetOverflow(), 0, overflow_buf);
       page_its.push_back(overflow_page.GetIterator());
     }
+    const bool has_deltas = deltas.AddIterators(page, &page_its);
+    const Slice upper = page.GetUpperBoundary();
 
-    PageMergeIterator pmi(std::move(page_its));
+    PageMergeIterator pmi(std::move(page_its), /*start_key=*/nullptr,
+                          has_deltas ? &upper : nullptr);
     for (; records_left > 0 && pmi.Valid(); --records_left, pmi.Next()) {
       values_out->emplace_back(key_utils::ExtractHead64(pmi.key()),
                                pmi.value().ToString());
@@ -339,7 +410,7 @@ Status Manager::ScanWhole(
   if (records_left == 0) {
     lock_manager_->ReleaseSegmentLock(start_seg.sinfo.id(),
                                       SegmentMode::kPageRead);
-    return Status::OK();
+    return status;
   }
 
   // 5. Scan forward until we read enough records or run out of segments to
@@ -360,9 +431,11 @@ Status Manager::ScanWhole(
                                      PageMode::kShared);
     }
     const std::unique_ptr<SegmentFile>& sf =
-        segment_files_[curr_seg->sinfo.id().GetFileId()];
+        SegmentFileFor(curr_seg->sinfo.id());
     sf->ReadPages(seg_byte_offset, w_.buffer().get(), seg_page_count);
     w_.BumpReadCount(seg_page_count);
+    status = ReadDeltaPages(curr_seg->sinfo.id(), &deltas);
+    if (!status.ok()) records_left = 0;
 
     size_t page_idx = 0;
     while (records_left > 0 && page_idx < seg_page_count) {
@@ -387,6 +460,75 @@ Status Manager::ScanWhole(
   }
 
   lock_manager_->ReleaseSegmentLock(prev_seg_id, SegmentMode::kPageRead);
+  return status;
+}
+
+Status Manager::ScanReadOnly(
+    const Key& start_key, const size_t amount,
+    std::vector<std::pair<Key, std::string>>* values_out) const {
+  // The DB is never modified while it is open in read-only mode, so this scan
+  // does not acquire any locks. Pages are read in place from the mapped segment
+  // files. While a segment is scanned, the next segment is prefetched.
+  assert(options_.read_only);
+  values_out->clear();
+  values_out->reserve(amount);
+  if (amount == 0) return Status::OK();
+  size_t records_left = amount;
+
+  const auto page_for = [this](const SegmentId& id, const size_t page_idx) {
+    const std::unique_ptr<SegmentFile>& sf = SegmentFileFor(id);
+    return Page(sf->PageAddress((id.GetOffset() + page_idx) * Page::kSize));
+  };
+  const auto prefetch = [this](const SegmentIndex::Entry& seg) {
+    const std::unique_ptr<SegmentFile>& sf = SegmentFileFor(seg.sinfo.id());
+    sf->Prefetch(seg.sinfo.id().GetOffset() * Page::kSize,
+                 seg.sinfo.page_count());
+  };
+
+  key_utils::IntKeyAsSlice start_key_slice_helper(start_key);
+  Slice start_key_slice = start_key_slice_helper.as<Slice>();
+
+  std::optional<SegmentIndex::Entry> curr_seg =
+      index_->SegmentForKeyUnlatched(start_key);
+  size_t page_idx = curr_seg->sinfo.PageForKey(curr_seg->lower, start_key);
+  bool first_page = true;
+  DeltaPages deltas;
+  while (records_left > 0 && curr_seg.has_value()) {
+    const std::optional<SegmentIndex::Entry> next_seg =
+        index_->NextSegmentForKeyUnlatched(curr_seg->lower);
+    if (next_seg.has_value()) prefetch(*next_seg);
+    const Status delta_status = ReadDeltaPages(curr_seg->sinfo.id(), &deltas);
+    if (!delta_status.ok()) return delta_status;
+
+    const size_t seg_page_count = curr_seg->sinfo.page_count();
+    for (; records_left > 0 && page_idx < seg_page_count; ++page_idx) {
+      const Page page = page_for(curr_seg->sinfo.id(), page_idx);
+      w_.BumpReadCount(1);
+      Status status = VerifyPages(page.data().data(), /*num_pages=*/1);
+      if (!status.ok()) return status;
+      std::vector<Page::Iterator> page_its = {page.GetIterator()};
+      if (page.HasOverflow()) {
+        const Page overflow_page = page_for(page.GetOverflow(), 0);
+        w_.BumpReadCount(1);
+        status = VerifyPages(overflow_page.data().data(), /*num_pages=*/1);
+        if (!status.ok()) return status;
+        page_its.push_back(overflow_page.GetIterator());
+      }
+      const bool has_deltas = deltas.AddIterators(page, &page_its);
+      const Slice upper = page.GetUpperBoundary();
+      PageMergeIterator pmi(std::move(page_its),
+                            first_page ? &start_key_slice : nullptr,
+                            has_deltas ? &upper : nullptr);
+      first_page = false;
+      for (; records_left > 0 && pmi.Valid(); --records_left, pmi.Next()) {
+        values_out->emplace_back(key_utils::ExtractHead64(pmi.key()),
+                                 pmi.value().ToString());
+      }
+    }
+
+    curr_seg = next_seg;
+    page_idx = 0;
+  }
   return Status::OK();
 }
 
@@ -91,8 +91,10 @@ Status Manager::ScanWithExperimentalPrefetching(
     }
   }
 
-  // Used to handle prefetching.
+  // Used to handle prefetching. `ready_segments` holds the segment that each
+  // entry in `ready_pages` was read from.
   std::vector<std::future<std::pair<char*, size_t>>> ready_pages;
+  std::vector<SegmentId> ready_segments;
   PrefetchBuffer prefetch_buf(w_.prefetch_buffer().get(),
                               Workspace::kPrefetchBufferPages);
 
@@ -101,7 +103,7 @@ Status Manager::ScanWithExperimentalPrefetching(
       bg_threads_->Submit([this, start_seg, start_page_idx, start_pages_to_read,
                            buf = prefetch_buf.Allocate(start_pages_to_read)]() {
         const std::unique_ptr<SegmentFile>& sf =
-            segment_files_[start_seg.sinfo.id().GetFileId()];
+            SegmentFileFor(start_seg.sinfo.id());
         const size_t segment_byte_offset =
             start_seg.sinfo.id().GetOffset() * Page::kSize;
         sf->ReadPages(segment_byte_offset + start_page_idx * Page::kSize, buf,
@@ -109,6 +111,7 @@ Status Manager::ScanWithExperimentalPrefetching(
         w_.BumpReadCount(start_pages_to_read);
         return std::make_pair(buf, start_pages_to_read);
       }));
+  ready_segments.push_back(start_seg.sinfo.id());
   pages_prefetched += start_pages_to_read;
 
   // 4. Fetch additional segments until we exhaust our estimate.
@@ -138,11 +141,12 @@ Status Manager::ScanWithExperimentalPrefetching(
         [this, curr_seg = *curr_seg, seg_byte_offset, pages_to_read,
          buf = prefetch_buf.Allocate(pages_to_read)]() {
           const std::unique_ptr<SegmentFile>& sf =
-              segment_files_[curr_seg.sinfo.id().GetFileId()];
+              SegmentFileFor(curr_seg.sinfo.id());
           sf->ReadPages(seg_byte_offset, buf, pages_to_read);
           w_.BumpReadCount(pages_to_read);
           return std::make_pair(buf, pages_to_read);
         }));
+    ready_segments.push_back(curr_seg->sinfo.id());
     pages_prefetched += seg_page_count;
 
     // Go to the next segment. To avoid an unnecessary lock acquisiton, we check
@@ -164,18 +168,38 @@ Status Manager::ScanWithExperimentalPrefetching(
   void* overflow_buf = w_.buffer().get();
   Page overflow_page(overflow_buf);
 
+  // Verifies a page (and its overflow, which is read into `overflow_buf`). The
+  // scan stops if either page fails its checksum check.
+  Status status;
+  const auto verify_page = [this, &records_left, &status,
+                            overflow_buf](const Page& page) {
+    status = VerifyPages(page.data().data(), /*num_pages=*/1);
+    if (status.ok() && page.HasOverflow()) {
+      ReadPage(page.GetOverflow(), 0, overflow_buf);
+      status = VerifyPages(overflow_buf, /*num_pages=*/1);
+    }
+    if (!status.ok()) records_left = 0;
+    return status.ok();
+  };
+
+  // The delta pages (if any) of the segment that is being scanned.
+  DeltaPages deltas;
+
   // Code used to scan the first page (requires a lower bound seek).
-  const auto scan_first_page = [this, &records_left, &overflow_page,
-                                overflow_buf, start_key,
+  const auto scan_first_page = [&records_left, &overflow_page, &verify_page,
+                                &deltas, start_key,
                                 values_out](const Page& first_page) {
+    if (!verify_page(first_page)) return;
     std::vector<Page::Iterator> page_its = {first_page.GetIterator()};
     if (first_page.HasOverflow()) {
-      ReadPage(first_page.GetOverflow(), 0, overflow_buf);
       page_its.push_back(overflow_page.GetIterator());
     }
+    const bool has_deltas = deltas.AddIterators(first_page, &page_its);
+    const Slice upper = first_page.GetUpperBoundary();
     key_utils::IntKeyAsSlice start_key_slice_helper(start_key);
     Slice start_key_slice = start_key_slice_helper.as<Slice>();
-    PageMergeIterator pmi(std::move(page_its), &start_key_slice);
+    PageMergeIterator pmi(std::move(page_its), &start_key_slice,
+                          has_deltas ? &upper : nullptr);
     for (; pmi.Valid() && records_left > 0; pmi.Next(), --records_left) {
       values_out->emplace_back(key_utils::ExtractHead64(pmi.key()),
                                pmi.value().ToString());
@@ -183,15 +207,18 @@ Status Manager::ScanWithExperimentalPrefetching(
   };
 
   // Common code used to scan a whole page.
-  const auto scan_page = [this, &records_left, &overflow_page, overflow_buf,
-                          values_out](const Page& page) {
+  const auto scan_page = [&records_left, &overflow_page, &verify_page,
+                          &deltas, values_out](const Page& page) {
+    if (!verify_page(page)) return;
     std::vector<Page::Iterator> page_its = {page.GetIterator()};
     if (page.HasOverflow()) {
-      ReadPage(page.GetOverflow(), 0, overflow_buf);
       page_its.push_back(overflow_page.GetIterator());
     }
+    const bool has_deltas = deltas.AddIterators(page, &page_its);
+    const Slice upper = page.GetUpperBoundary();
 
-    PageMergeIterator pmi(std::move(page_its));
+    PageMergeIterator pmi(std::move(page_its), /*start_key=*/nullptr,
+                          has_deltas ? &upper : nullptr);
     if (pmi.Valid()) {
       assert(pmi.RecordsLeft() > 0);
     }
@@ -204,11 +231,16 @@ Status Manager::ScanWithExperimentalPrefetching(
 
   bool is_first_page = true;
   size_t fetched_pages_used = 0;
-  for (auto& f : ready_pages) {
+  for (size_t seg_idx = 0; seg_idx < ready_pages.size(); ++seg_idx) {
     if (records_left == 0) break;
 
     // Wait for the I/O to complete.
-    const auto [buf, num_pages] = f.get();
+    const auto [buf, num_pages] = ready_pages[seg_idx].get();
+    status = ReadDeltaPages(ready_segments[seg_idx], &deltas);
+    if (!status.ok()) {
+      records_left = 0;
+      break;
+    }
 
     for (size_t i = 0; i < num_pages && records_left > 0; ++i) {
       Page page(buf + Page::kSize * i);
@@ -240,7 +272,7 @@ Status Manager::ScanWithExperimentalPrefetching(
   PageGroupedDBStats::Local().BumpOverfetchedPages(est_pages_to_fetch -
                                                    fetched_pages_used);
 
-  return Status::OK();
+  return status;
 }
 
 }  // namespace pg
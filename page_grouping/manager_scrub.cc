@@ -0,0 +1,187 @@
+#include <shared_mutex>
+#include <sstream>
+
+#include "manager.h"
+#include "persist/segment_wrap.h"
+#include "treeline/pg_stats.h"
+#include "util/key.h"
+
+namespace {
+
+using tl::pg::Key;
+
+// Returns true iff all the records in `page` have keys in `[lower, upper]`.
+bool KeysWithinBounds(const tl::pg::Page& page, const Key lower,
+                      const Key upper) {
+  for (auto it = page.GetIterator(); it.Valid(); it.Next()) {
+    const Key key = tl::key_utils::ExtractHead64(it.key());
+    if (key < lower || key > upper) return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+namespace tl {
+namespace pg {
+
+using SegmentMode = LockManager::SegmentMode;
+using PageMode = LockManager::PageMode;
+
+size_t Manager::ScrubSegments(const std::function<bool(size_t)>& throttle) {
+  size_t num_failed = 0;
+  for (const auto& segment : index_->GetAllSegments()) {
+    size_t pages_read = 0;
+    if (!ScrubSegment(segment, &pages_read).ok()) ++num_failed;
+    if (!throttle(pages_read)) break;
+  }
+  return num_failed;
+}
+
+Status Manager::ScrubSegment(const SegmentIndex::Entry& segment,
+                             size_t* pages_read) const {
+  *pages_read = 0;
+  const bool read_only = options_.read_only;
+  const SegmentId seg_id = segment.sinfo.id();
+  const size_t page_count = segment.sinfo.page_count();
+
+  // Pages are locked in the same way as in a scan, so the scrubber never sees
+  // a partially written page.
+  if (!read_only) {
+    const auto seg =
+        index_->SegmentForKeyWithLock(segment.lower, SegmentMode::kPageRead);
+    if (seg.lower != segment.lower || seg.sinfo.id() != seg_id) {
+      // A reorganization replaced the segment. Its replacement will be checked
+      // during the next pass.
+      lock_manager_->ReleaseSegmentLock(seg.sinfo.id(),
+                                        SegmentMode::kPageRead);
+      return Status::OK();
+    }
+    for (size_t page_idx = 0; page_idx < page_count; ++page_idx) {
+      lock_manager_->AcquirePageLock(seg_id, page_idx, PageMode::kShared);
+    }
+  }
+
+  // The workspace buffer has one extra page at the end for use as the overflow.
+  char* const buf = w_.buffer().get();
+  char* const overflow_buf =
+      buf + SegmentBuilder::SegmentPageCounts().back() * Page::kSize;
+
+  const auto checksum_failure = [&seg_id](const std::string& problem) {
+    PageGroupedDBStats::Local().BumpScrubChecksumFailures();
+    std::stringstream msg;
+    msg << "Segment " << seg_id << ": " << problem;
+    return Status::Corruption(msg.str());
+  };
+  const auto invariant_violation = [&seg_id](const std::string& problem) {
+    PageGroupedDBStats::Local().BumpScrubInvariantViolations();
+    std::stringstream msg;
+    msg << "Segment " << seg_id << ": " << problem;
+    return Status::Corruption(msg.str());
+  };
+
+  // Bypass the page cache (if any) to check the pages that are in storage.
+  const auto read_pages = [this, pages_read](const SegmentId& id, void* data,
+                                             const size_t num_pages) {
+    SegmentFileFor(id)->ReadPagesFromStorage(id.GetOffset() * Page::kSize,
+                                             data, num_pages);
+    *pages_read += num_pages;
+  };
+
+  const auto check_segment = [&]() {
+    read_pages(seg_id, buf, page_count);
+    const SegmentWrap sw(buf, page_count);
+    if (!sw.CheckChecksum()) {
+      return checksum_failure("Segment checksum mismatch.");
+    }
+    if (!sw.CheckPageChecksums()) {
+      return checksum_failure("Page checksum mismatch.");
+    }
+
+    Key prev_upper = 0;
+    for (size_t page_idx = 0; page_idx < page_count; ++page_idx) {
+      const Page page(buf + page_idx * Page::kSize);
+      if (!page.IsValid() || page.IsOverflow()) {
+        return invariant_violation("Invalid page.");
+      }
+
+      // Page boundaries are inclusive and must cover the segment's key space
+      // without gaps. The segment's model must map each page's lower boundary
+      // to that page.
+      const Key lower = key_utils::ExtractHead64(page.GetLowerBoundary());
+      const Key upper = key_utils::ExtractHead64(page.GetUpperBoundary());
+      if (lower > upper || lower < segment.lower || upper >= segment.upper) {
+        return invariant_violation("Invalid page boundaries.");
+      }
+      if (page_idx > 0 && prev_upper + 1 != lower) {
+        return invariant_violation("Page boundaries leave a gap.");
+      }
+      if (segment.sinfo.PageForKey(segment.lower, lower) != page_idx) {
+        return invariant_violation("Model does not match the pages.");
+      }
+      if (!KeysWithinBounds(page, lower, upper)) {
+        return invariant_violation("Key outside of the page boundaries.");
+      }
+      prev_upper = upper;
+
+      if (!page.HasOverflow()) continue;
+      // Overflow pages are always stored in single-page segments.
+      const SegmentId overflow_id = page.GetOverflow();
+      if (overflow_id.GetFileId() != 0) {
+        return invariant_violation("Invalid overflow pointer.");
+      }
+      read_pages(overflow_id, overflow_buf, /*num_pages=*/1);
+      const Page overflow_page(overflow_buf);
+      if (!overflow_page.CheckPageChecksum()) {
+        return checksum_failure("Overflow page checksum mismatch.");
+      }
+      if (!overflow_page.IsValid() || !overflow_page.IsOverflow() ||
+          overflow_page.HasOverflow() ||
+          overflow_page.GetLowerBoundary() != page.GetLowerBoundary() ||
+          overflow_page.GetUpperBoundary() != page.GetUpperBoundary()) {
+        return invariant_violation("Invalid overflow page.");
+      }
+      if (!KeysWithinBounds(overflow_page, lower, upper)) {
+        return invariant_violation("Key outside of the page boundaries.");
+      }
+    }
+
+    // Delta pages hold records for any of the segment's pages. They cannot
+    // change while we hold all the page locks.
+    if (deltas_->Empty()) return Status::OK();
+    const std::shared_ptr<DeltaIndex::Log> log = deltas_->Find(seg_id);
+    if (log == nullptr) return Status::OK();
+    std::shared_lock<std::shared_mutex> lock(log->mutex);
+    for (const auto& info : log->pages) {
+      if (info.id.GetFileId() != 0) {
+        return invariant_violation("Invalid delta page pointer.");
+      }
+      read_pages(info.id, overflow_buf, /*num_pages=*/1);
+      const Page delta_page(overflow_buf);
+      if (!delta_page.CheckPageChecksum()) {
+        return checksum_failure("Delta page checksum mismatch.");
+      }
+      if (!delta_page.IsValid() || !delta_page.IsDelta()) {
+        return invariant_violation("Invalid delta page.");
+      }
+      if (!KeysWithinBounds(delta_page, segment.lower, segment.upper - 1)) {
+        return invariant_violation("Key outside of the segment boundaries.");
+      }
+    }
+    return Status::OK();
+  };
+  const Status status = check_segment();
+  PageGroupedDBStats::Local().BumpScrubbedSegments();
+  PageGroupedDBStats::Local().BumpScrubbedPages(*pages_read);
+
+  if (!read_only) {
+    for (size_t page_idx = 0; page_idx < page_count; ++page_idx) {
+      lock_manager_->ReleasePageLock(seg_id, page_idx, PageMode::kShared);
+    }
+    lock_manager_->ReleaseSegmentLock(seg_id, SegmentMode::kPageRead);
+  }
+  return status;
+}
+
+}  // namespace pg
+}  // namespace tl
@@ -0,0 +1,157 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <unordered_map>
+
+#include "bufmgr/page_memory_allocator.h"
+#include "manager.h"
+#include "persist/segment_wrap.h"
+#include "treeline/pg_stats.h"
+
+namespace tl {
+namespace pg {
+
+using SegmentMode = LockManager::SegmentMode;
+
+size_t Manager::MigrateColdSegments() {
+  if (migration_ == nullptr || options_.read_only) return 0;
+  std::unique_lock<std::mutex> lock(migration_->mutex);
+
+  std::unordered_map<Key, uint64_t> accesses;
+  for (const auto& seg : GetAccessHeatmap()) {
+    accesses[seg.lower] = seg.counts.Total();
+  }
+
+  // A segment is only considered for migration once it has been observed for
+  // a full migration interval.
+  std::vector<std::pair<uint64_t, SegmentIndex::Entry>> candidates;
+  std::unordered_map<size_t, std::pair<Key, uint64_t>> curr_accesses;
+  for (const auto& seg : index_->GetAllSegments()) {
+    const SegmentId id = seg.sinfo.id();
+    if (id.GetTier() != 0) continue;
+    const auto acc_it = accesses.find(seg.lower);
+    const uint64_t total = acc_it == accesses.end() ? 0 : acc_it->second;
+    curr_accesses[id.value()] = {seg.lower, total};
+
+    const auto prev_it = migration_->prev_accesses.find(id.value());
+    if (prev_it == migration_->prev_accesses.end() ||
+        prev_it->second.first != seg.lower) {
+      continue;
+    }
+    // Counters are attributed to the segment that currently contains their
+    // base key, so a segment's total can shrink after a reorg.
+    const uint64_t delta = total - std::min(total, prev_it->second.second);
+    if (delta <= options_.tiering.cold_access_threshold) {
+      candidates.emplace_back(delta, seg);
+    }
+  }
+  migration_->prev_accesses = std::move(curr_accesses);
+
+  // Move the coldest segments first.
+  std::stable_sort(
+      candidates.begin(), candidates.end(),
+      [](const auto& left, const auto& right) {
+        return left.first < right.first;
+      });
+  size_t num_migrated = 0;
+  for (const auto& [_, seg] : candidates) {
+    if (num_migrated >= options_.tiering.max_migrations_per_pass) break;
+    if (MigrateSegment(seg).ok()) {
+      migration_->prev_accesses.erase(seg.sinfo.id().value());
+      ++num_migrated;
+    }
+  }
+  return num_migrated;
+}
+
+Status Manager::MigrateSegment(const SegmentIndex::Entry& segment) {
+  ReorgEvent event;
+  event.trigger = ReorgTrigger::kTierMigration;
+  event.start = std::chrono::steady_clock::now();
+  const auto seg =
+      index_->SegmentForKeyWithLock(segment.lower, SegmentMode::kReorg);
+  event.lock_wait = std::chrono::steady_clock::now() - event.start;
+  if (seg.lower != segment.lower || seg.sinfo.id() != segment.sinfo.id()) {
+    lock_manager_->ReleaseSegmentLock(seg.sinfo.id(), SegmentMode::kReorg);
+    return Status::InvalidArgument(
+        "MigrateSegment(): Intervening rewrite replaced the segment.");
+  }
+  // A segment's delta pages are tied to its ID and sequence number, so a
+  // segment with a delta log stays in place until a rewrite merges the log.
+  if (!deltas_->Empty() && deltas_->Find(seg.sinfo.id()) != nullptr) {
+    lock_manager_->ReleaseSegmentLock(seg.sinfo.id(), SegmentMode::kReorg);
+    return Status::InvalidArgument(
+        "MigrateSegment(): The segment has a delta log.");
+  }
+
+  // 1. Copy the segment into the capacity tier. The copy gets a new sequence
+  // number so that recovery prefers it over the original if we crash before
+  // the original is invalidated.
+  // NOTE: No need for page locks since we hold the segment lock in `kReorg`
+  // mode.
+  const SegmentId old_id = seg.sinfo.id();
+  const size_t page_count = seg.sinfo.page_count();
+  const Status status = ReadSegment(old_id);
+  if (!status.ok()) {
+    lock_manager_->ReleaseSegmentLock(old_id, SegmentMode::kReorg);
+    return status;
+  }
+  SegmentWrap sw(w_.buffer().get(), page_count);
+  sw.SetSequenceNumber((*next_sequence_number_)++);
+  sw.ComputeAndSetChecksum();
+  sw.ComputeAndSetPageChecksums();
+
+  SegmentId new_id;
+  const auto maybe_seg_id = free_->Get(page_count, /*tier=*/1);
+  if (maybe_seg_id.has_value()) {
+    new_id = *maybe_seg_id;
+  } else {
+    const SegmentId capacity_file(old_id.GetFileId(), 0, /*tier=*/1);
+    const size_t byte_offset = SegmentFileFor(capacity_file)->AllocateSegment();
+    new_id = SegmentId(old_id.GetFileId(), byte_offset / Page::kSize,
+                       /*tier=*/1);
+  }
+  SegmentFileFor(new_id)->WritePages(new_id.GetOffset() * Page::kSize,
+                                     w_.buffer().get(), page_count);
+  w_.BumpWriteCount(page_count);
+
+  // 2. Wait for concurrent readers of the original to finish before
+  // invalidating it.
+  const auto upgrade_start = std::chrono::steady_clock::now();
+  lock_manager_->UpgradeSegmentLockToReorgExclusive(old_id);
+  event.lock_wait += std::chrono::steady_clock::now() - upgrade_start;
+
+  PageBuffer zero = PageMemoryAllocator::Allocate(/*num_pages=*/1);
+  memset(zero.get(), 0, Page::kSize);
+  WritePage(old_id, 0, zero.get());
+
+  // 3. Expose the copy. Its overflow pages (if any) stay in the fast tier.
+  SegmentInfo new_info(new_id, seg.sinfo.model());
+  new_info.SetOverflow(seg.sinfo.HasOverflow());
+  index_->RunExclusive([&seg, &new_info](auto& raw_index) {
+    raw_index.erase(seg.lower);
+    raw_index.insert(std::make_pair(seg.lower, new_info));
+  });
+  lock_manager_->ReleaseSegmentLock(old_id, SegmentMode::kReorgExclusive);
+  free_->Add(old_id);
+
+  PageGroupedDBStats::Local().BumpSegmentsMigrated();
+  PageGroupedDBStats::Local().BumpPagesMigrated(page_count);
+
+  if (reorg_log_ != nullptr) {
+    event.lower = seg.lower;
+    event.upper = seg.upper;
+    event.segments_in = 1;
+    event.segments_out = 1;
+    event.pages_read = page_count;
+    event.pages_written = page_count + 1;
+    event.records_per_page_goal = options_.records_per_page_goal;
+    event.duration = std::chrono::steady_clock::now() - event.start;
+    reorg_log_->Record(event);
+  }
+
+  return Status::OK();
+}
+
+}  // namespace pg
+}  // namespace tl
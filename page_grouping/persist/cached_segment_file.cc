@@ -0,0 +1,164 @@
+#include "cached_segment_file.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "treeline/pg_stats.h"
+
+namespace {
+
+// The cache is split into (up to) this many shards to reduce lock contention.
+constexpr size_t kMaxShards = 16;
+
+// Invalidations only discard concurrent reads of pages in the same version
+// stripe. Neighboring pages map to different stripes.
+constexpr size_t kVersionStripes = 1024;
+
+// Page IDs hold the page's offset (in pages) in the lower bits and the file's
+// index in the upper bits.
+constexpr size_t kFileIndexShift = 48;
+
+}  // namespace
+
+namespace tl {
+namespace pg {
+
+PageCache::PageCache(const size_t capacity_pages)
+    : num_shards_(std::clamp<size_t>(capacity_pages, 1, kMaxShards)),
+      frames_(PageMemoryAllocator::Allocate(capacity_pages)),
+      shards_(std::make_unique<Shard[]>(num_shards_)),
+      versions_(std::make_unique<std::atomic<uint64_t>[]>(kVersionStripes)) {
+  // Frames are assigned to shards round-robin.
+  for (size_t frame_idx = 0; frame_idx < capacity_pages; ++frame_idx) {
+    shards_[frame_idx % num_shards_].free_frames.push_back(frame_idx);
+  }
+}
+
+bool PageCache::Lookup(const uint64_t page_id, void* out) {
+  Shard& shard = ShardFor(page_id);
+  std::unique_lock<std::mutex> lock(shard.mutex);
+  const auto it = shard.pages.find(page_id);
+  if (it == shard.pages.end()) return false;
+  shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+  memcpy(out, Frame(it->second->second), Page::kSize);
+  return true;
+}
+
+uint64_t PageCache::GetVersion(const uint64_t page_id) const {
+  return VersionFor(page_id).load(std::memory_order_acquire);
+}
+
+void PageCache::Insert(const uint64_t page_id, const void* data,
+                       const uint64_t version) {
+  Shard& shard = ShardFor(page_id);
+  std::unique_lock<std::mutex> lock(shard.mutex);
+  if (VersionFor(page_id).load(std::memory_order_relaxed) != version) return;
+
+  const auto it = shard.pages.find(page_id);
+  if (it != shard.pages.end()) {
+    // Another reader cached the same page (the contents are the same).
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+    return;
+  }
+
+  size_t frame_idx;
+  if (!shard.free_frames.empty()) {
+    frame_idx = shard.free_frames.back();
+    shard.free_frames.pop_back();
+  } else if (!shard.lru.empty()) {
+    // Evict the least recently used page.
+    const auto& [evicted_id, evicted_frame] = shard.lru.back();
+    shard.pages.erase(evicted_id);
+    frame_idx = evicted_frame;
+    shard.lru.pop_back();
+  } else {
+    // This shard has no frames.
+    return;
+  }
+
+  memcpy(Frame(frame_idx), data, Page::kSize);
+  shard.lru.emplace_front(page_id, frame_idx);
+  shard.pages.emplace(page_id, shard.lru.begin());
+}
+
+void PageCache::Invalidate(const uint64_t page_id) {
+  Shard& shard = ShardFor(page_id);
+  std::unique_lock<std::mutex> lock(shard.mutex);
+  VersionFor(page_id).fetch_add(1, std::memory_order_release);
+  const auto it = shard.pages.find(page_id);
+  if (it == shard.pages.end()) return;
+  shard.free_frames.push_back(it->second->second);
+  shard.lru.erase(it->second);
+  shard.pages.erase(it);
+}
+
+PageCache::Shard& PageCache::ShardFor(const uint64_t page_id) const {
+  // Neighboring pages map to different shards.
+  return shards_[page_id % num_shards_];
+}
+
+std::atomic<uint64_t>& PageCache::VersionFor(const uint64_t page_id) const {
+  return versions_[page_id % kVersionStripes];
+}
+
+char* PageCache::Frame(const size_t frame_idx) const {
+  return frames_.get() + frame_idx * Page::kSize;
+}
+
+CachedSegmentFile::CachedSegmentFile(std::unique_ptr<SegmentFile> file,
+                                     const size_t file_index,
+                                     std::shared_ptr<PageCache> cache)
+    : file_(std::move(file)),
+      file_index_(file_index),
+      cache_(std::move(cache)) {}
+
+Status CachedSegmentFile::ReadPages(const size_t offset, void* data,
+                                    const size_t num_pages) const {
+  char* const out = reinterpret_cast<char*>(data);
+  const uint64_t first_page_id = PageIdFor(offset);
+
+  size_t hits = 0;
+  while (hits < num_pages &&
+         cache_->Lookup(first_page_id + hits, out + hits * Page::kSize)) {
+    ++hits;
+  }
+  if (hits > 0) PageGroupedDBStats::Local().BumpPageCacheHits(hits);
+  if (hits == num_pages) return Status::OK();
+
+  // Only the pages after the cached prefix are read from the file.
+  const size_t num_fetched = num_pages - hits;
+  PageGroupedDBStats::Local().BumpPageCacheMisses(num_fetched);
+
+  // Versions must be taken before the read so that a concurrent write cannot
+  // leave a stale page in the cache.
+  std::vector<uint64_t> versions;
+  versions.reserve(num_fetched);
+  for (size_t i = hits; i < num_pages; ++i) {
+    versions.push_back(cache_->GetVersion(first_page_id + i));
+  }
+  const Status s = file_->ReadPages(offset + hits * Page::kSize,
+                                    out + hits * Page::kSize, num_fetched);
+  if (!s.ok()) return s;
+  for (size_t i = hits; i < num_pages; ++i) {
+    cache_->Insert(first_page_id + i, out + i * Page::kSize,
+                   versions[i - hits]);
+  }
+  return s;
+}
+
+Status CachedSegmentFile::WritePages(const size_t offset, const void* data,
+                                     const size_t num_pages) const {
+  const Status s = file_->WritePages(offset, data, num_pages);
+  const uint64_t first_page_id = PageIdFor(offset);
+  for (size_t i = 0; i < num_pages; ++i) {
+    cache_->Invalidate(first_page_id + i);
+  }
+  return s;
+}
+
+uint64_t CachedSegmentFile::PageIdFor(const size_t offset) const {
+  return (file_index_ << kFileIndexShift) | (offset / Page::kSize);
+}
+
+}  // namespace pg
+}  // namespace tl
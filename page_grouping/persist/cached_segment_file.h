@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "bufmgr/page_memory_allocator.h"
+#include "segment_file.h"
+
+namespace tl {
+namespace pg {
+
+// Caches recently read page images in memory (see
+// `PageGroupedDBOptions::page_cache_pages`). Pages are identified by a 64-bit
+// ID (see `CachedSegmentFile`) and are evicted in LRU order. The cache is
+// split into independently locked shards. This class is thread-safe.
+class PageCache {
+ public:
+  explicit PageCache(size_t capacity_pages);
+
+  PageCache(const PageCache&) = delete;
+  PageCache& operator=(const PageCache&) = delete;
+
+  // Copies the cached page `page_id` into `out` and returns true. Returns false
+  // if the page is not cached.
+  bool Lookup(uint64_t page_id, void* out);
+
+  // Returns a version that changes whenever `page_id` (or one of the few other
+  // pages that share its version stripe) is invalidated. Readers should take
+  // the version before reading a page from the underlying file, and pass it to
+  // `Insert()`.
+  uint64_t GetVersion(uint64_t page_id) const;
+
+  // Caches a copy of `data` as the contents of `page_id`, unless the page was
+  // invalidated after `version` was taken (the data may then be stale).
+  void Insert(uint64_t page_id, const void* data, uint64_t version);
+
+  // Removes `page_id` from the cache, if present. Must be called after the
+  // page is modified in the underlying file.
+  void Invalidate(uint64_t page_id);
+
+ private:
+  // Most recently used first. Each element is a page ID and frame index.
+  using LruList = std::list<std::pair<uint64_t, size_t>>;
+  struct Shard {
+    std::mutex mutex;
+    LruList lru;
+    std::unordered_map<uint64_t, LruList::iterator> pages;
+    std::vector<size_t> free_frames;
+  };
+
+  Shard& ShardFor(uint64_t page_id) const;
+  // The invalidation counter of `page_id`'s version stripe. It is only
+  // incremented while holding the mutex of `page_id`'s shard.
+  std::atomic<uint64_t>& VersionFor(uint64_t page_id) const;
+  char* Frame(size_t frame_idx) const;
+
+  const size_t num_shards_;
+  PageBuffer frames_;
+  std::unique_ptr<Shard[]> shards_;
+  std::unique_ptr<std::atomic<uint64_t>[]> versions_;
+};
+
+// A `SegmentFile` that serves reads from a `PageCache` when possible and adds
+// the pages it reads to the cache. Writes go to the wrapped file and
+// invalidate the written pages. Pages are identified by `file_index` and their
+// offset in the file, so reused segment IDs never see stale pages.
+//
+// A multi-page read copies its leading cached pages from the cache and reads
+// the remaining pages from the wrapped file (using one request). This class is
+// thread-safe.
+class CachedSegmentFile : public SegmentFile {
+ public:
+  CachedSegmentFile(std::unique_ptr<SegmentFile> file, size_t file_index,
+                    std::shared_ptr<PageCache> cache);
+
+  size_t NumAllocatedSegments() const override {
+    return file_->NumAllocatedSegments();
+  }
+  size_t PagesPerSegment() const override { return file_->PagesPerSegment(); }
+
+  Status ReadPages(size_t offset, void* data, size_t num_pages) const override;
+  Status ReadPagesFromStorage(size_t offset, void* data,
+                              size_t num_pages) const override {
+    return file_->ReadPagesFromStorage(offset, data, num_pages);
+  }
+  Status WritePages(size_t offset, const void* data,
+                    size_t num_pages) const override;
+  void Sync() const override { file_->Sync(); }
+
+  size_t AllocateSegment() override { return file_->AllocateSegment(); }
+
+  char* PageAddress(size_t offset) const override {
+    return file_->PageAddress(offset);
+  }
+  void Prefetch(size_t offset, size_t num_pages) const override {
+    file_->Prefetch(offset, num_pages);
+  }
+
+ private:
+  uint64_t PageIdFor(size_t offset) const;
+
+  const std::unique_ptr<SegmentFile> file_;
+  const uint64_t file_index_;
+  const std::shared_ptr<PageCache> cache_;
+};
+
+}  // namespace pg
+}  // namespace tl
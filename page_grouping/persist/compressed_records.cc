@@ -0,0 +1,166 @@
+#include "compressed_records.h"
+
+#include <cstring>
+#include <limits>
+#include <string_view>
+#include <unordered_map>
+
+namespace {
+
+// Bit-packed entries are read using one unaligned 8-byte load, so entries
+// cannot be wider than this many bits. Each bit array is followed by enough
+// padding to keep the loads in bounds.
+constexpr unsigned kMaxBits = 57;
+constexpr size_t kBitArrayPadding = sizeof(uint64_t) - 1;
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__,
+              "The compressed page format assumes a little endian machine.");
+
+unsigned BitsNeeded(const uint64_t max_value) {
+  return max_value == 0 ? 0 : 64 - __builtin_clzll(max_value);
+}
+
+size_t BitArrayBytes(const size_t num_entries, const unsigned bits) {
+  if (bits == 0) return 0;
+  return (num_entries * bits + 7) / 8 + kBitArrayPadding;
+}
+
+uint64_t ReadBits(const uint8_t* bit_array, const size_t index,
+                  const unsigned bits) {
+  if (bits == 0) return 0;
+  const size_t bit_offset = index * bits;
+  uint64_t word;
+  memcpy(&word, bit_array + bit_offset / 8, sizeof(word));
+  return (word >> (bit_offset % 8)) & ((1ULL << bits) - 1);
+}
+
+// REQUIRES: The bit array is zeroed out.
+void WriteBits(uint8_t* bit_array, const size_t index, const unsigned bits,
+               const uint64_t value) {
+  if (bits == 0) return;
+  const size_t bit_offset = index * bits;
+  uint64_t word;
+  memcpy(&word, bit_array + bit_offset / 8, sizeof(word));
+  word |= value << (bit_offset % 8);
+  memcpy(bit_array + bit_offset / 8, &word, sizeof(word));
+}
+
+}  // namespace
+
+namespace tl {
+namespace pg {
+
+size_t CompressedRecords::Encode(
+    const std::vector<Record>::const_iterator begin,
+    const std::vector<Record>::const_iterator end, uint8_t* out,
+    const size_t capacity) {
+  const size_t num_records = end - begin;
+  if (num_records == 0 ||
+      num_records > std::numeric_limits<uint16_t>::max()) {
+    return 0;
+  }
+  const uint64_t base_key = begin->first;
+  const unsigned key_bits = BitsNeeded((end - 1)->first - base_key);
+  if (key_bits > kMaxBits) return 0;
+
+  // Assign IDs to the distinct values.
+  std::unordered_map<std::string_view, uint16_t> value_to_id;
+  std::vector<uint16_t> value_ids;
+  std::vector<Slice> values;
+  value_ids.reserve(num_records);
+  size_t values_size = 0;
+  for (auto it = begin; it != end; ++it) {
+    const auto [id_it, inserted] = value_to_id.emplace(
+        std::string_view(it->second.data(), it->second.size()),
+        values.size());
+    if (inserted) {
+      values.push_back(it->second);
+      values_size += it->second.size();
+    }
+    value_ids.push_back(id_it->second);
+  }
+  const unsigned value_bits = BitsNeeded(values.size() - 1);
+
+  const size_t key_offsets_size = BitArrayBytes(num_records, key_bits);
+  const size_t value_ids_size = BitArrayBytes(num_records, value_bits);
+  const size_t value_ends_size = values.size() * sizeof(uint16_t);
+  const size_t encoded_size = sizeof(Header) + key_offsets_size +
+                              value_ids_size + value_ends_size + values_size;
+  if (encoded_size > capacity ||
+      encoded_size > std::numeric_limits<uint16_t>::max()) {
+    return 0;
+  }
+
+  memset(out, 0, encoded_size);
+  Header header;
+  header.base_key = base_key;
+  header.num_records = num_records;
+  header.num_values = values.size();
+  header.encoded_size = encoded_size;
+  header.key_bits = key_bits;
+  header.value_bits = value_bits;
+  memcpy(out, &header, sizeof(header));
+
+  uint8_t* const key_offsets = out + sizeof(Header);
+  uint8_t* const ids = key_offsets + key_offsets_size;
+  uint8_t* const value_ends = ids + value_ids_size;
+  uint8_t* const value_bytes = value_ends + value_ends_size;
+  for (size_t i = 0; i < num_records; ++i) {
+    WriteBits(key_offsets, i, key_bits, (begin + i)->first - base_key);
+    WriteBits(ids, i, value_bits, value_ids[i]);
+  }
+  uint16_t value_end = 0;
+  for (size_t i = 0; i < values.size(); ++i) {
+    memcpy(value_bytes + value_end, values[i].data(), values[i].size());
+    value_end += values[i].size();
+    memcpy(value_ends + i * sizeof(uint16_t), &value_end, sizeof(uint16_t));
+  }
+  return encoded_size;
+}
+
+CompressedRecords::CompressedRecords(const uint8_t* data)
+    : header_(reinterpret_cast<const Header*>(data)) {
+  key_offsets_ = data + sizeof(Header);
+  value_ids_ =
+      key_offsets_ + BitArrayBytes(header_->num_records, header_->key_bits);
+  value_ends_ =
+      value_ids_ + BitArrayBytes(header_->num_records, header_->value_bits);
+  values_ = value_ends_ + header_->num_values * sizeof(uint16_t);
+}
+
+size_t CompressedRecords::NumRecords() const { return header_->num_records; }
+
+size_t CompressedRecords::EncodedSize() const { return header_->encoded_size; }
+
+uint64_t CompressedRecords::KeyAt(const size_t index) const {
+  return header_->base_key + ReadBits(key_offsets_, index, header_->key_bits);
+}
+
+Slice CompressedRecords::ValueAt(const size_t index) const {
+  const size_t value_id = ReadBits(value_ids_, index, header_->value_bits);
+  uint16_t start = 0, end;
+  if (value_id > 0) {
+    memcpy(&start, value_ends_ + (value_id - 1) * sizeof(uint16_t),
+           sizeof(uint16_t));
+  }
+  memcpy(&end, value_ends_ + value_id * sizeof(uint16_t), sizeof(uint16_t));
+  return Slice(reinterpret_cast<const char*>(values_) + start, end - start);
+}
+
+size_t CompressedRecords::LowerBound(const uint64_t key) const {
+  if (key <= header_->base_key) return 0;
+  const uint64_t offset = key - header_->base_key;
+  size_t lower = 0, upper = header_->num_records;
+  while (lower < upper) {
+    const size_t mid = lower + (upper - lower) / 2;
+    if (ReadBits(key_offsets_, mid, header_->key_bits) < offset) {
+      lower = mid + 1;
+    } else {
+      upper = mid;
+    }
+  }
+  return lower;
+}
+
+}  // namespace pg
+}  // namespace tl
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "treeline/slice.h"
+
+namespace tl {
+namespace pg {
+
+// Encodes and decodes the records stored in a compressed `Page` (see
+// `PageGroupedDBOptions::compress_pages`).
+//
+// Keys are 64-bit integers (stored in pages as 8-byte big endian strings) and
+// use frame-of-reference encoding: the smallest key is stored once, followed by
+// the bit-packed difference between each key and the smallest key. Values are
+// dictionary encoded: each distinct value is stored once and each record stores
+// the bit-packed index of its value. Both encodings keep individual records
+// addressable (keys can be binary searched and values are returned in place),
+// so a point read does not need to decode the whole page.
+//
+// Encoded layout:
+//   Header
+//   Key offsets  (`key_bits` per record)
+//   Value IDs    (`value_bits` per record)
+//   Value ends   (2 bytes per distinct value)
+//   Values       (distinct values only)
+class CompressedRecords {
+ public:
+  using Record = std::pair<uint64_t, Slice>;
+
+  // Encodes the records in `[begin, end)`, which must be sorted by key, into
+  // `out` (which has room for `capacity` bytes). Returns the number of bytes
+  // used, or 0 if the records do not fit.
+  static size_t Encode(std::vector<Record>::const_iterator begin,
+                       std::vector<Record>::const_iterator end, uint8_t* out,
+                       size_t capacity);
+
+  // Reads the records encoded in `data`. The buffer must remain valid for the
+  // lifetime of this object.
+  explicit CompressedRecords(const uint8_t* data);
+
+  size_t NumRecords() const;
+  size_t EncodedSize() const;
+
+  uint64_t KeyAt(size_t index) const;
+  Slice ValueAt(size_t index) const;
+
+  // Returns the index of the first record with a key that is greater than or
+  // equal to `key` (or `NumRecords()` if there is no such record).
+  size_t LowerBound(uint64_t key) const;
+
+ private:
+  struct Header {
+    uint64_t base_key;
+    uint16_t num_records;
+    uint16_t num_values;
+    uint16_t encoded_size;
+    uint8_t key_bits;
+    uint8_t value_bits;
+  } __attribute__((packed));
+
+  const Header* header_;
+  const uint8_t* key_offsets_;
+  const uint8_t* value_ids_;
+  const uint8_t* value_ends_;
+  const uint8_t* values_;
+};
+
+}  // namespace pg
+}  // namespace tl
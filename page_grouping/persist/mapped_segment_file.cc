@@ -0,0 +1,91 @@
+#include "mapped_segment_file.h"
+
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace tl {
+namespace pg {
+
+MappedSegmentFile::MappedSegmentFile(const std::filesystem::path& name,
+                                     const size_t pages_per_segment)
+    : pages_per_segment_(pages_per_segment),
+      fd_(-1),
+      base_(nullptr),
+      file_size_(0),
+      num_allocated_bytes_(0) {
+  assert(pages_per_segment > 0);
+  CHECK_ERROR(fd_ = open(name.c_str(), O_RDONLY));
+
+  struct stat file_status;
+  CHECK_ERROR(fstat(fd_, &file_status));
+  assert(file_status.st_size >= 0);
+  file_size_ = file_status.st_size;
+  if (file_size_ == 0) return;
+
+  void* const mapping =
+      mmap(nullptr, file_size_, PROT_READ, MAP_SHARED, fd_, /*offset=*/0);
+  if (mapping == MAP_FAILED) CHECK_ERROR(-1);
+  base_ = reinterpret_cast<char*>(mapping);
+  // Most accesses are point lookups, so kernel read ahead would mostly bring
+  // in pages that are not needed. Scans issue explicit `Prefetch()` hints.
+  madvise(base_, file_size_, MADV_RANDOM);
+
+  // Like `PosixSegmentFile`, find the end of the last valid segment. The
+  // segments before it are either valid or "free".
+  const size_t bytes_per_segment = pages_per_segment_ * Page::kSize;
+  size_t num_segments = file_size_ / bytes_per_segment;
+  while (num_segments > 0) {
+    const Page page(base_ + (num_segments - 1) * bytes_per_segment);
+    if (page.IsValid()) break;
+    --num_segments;
+  }
+  num_allocated_bytes_ = num_segments * bytes_per_segment;
+}
+
+MappedSegmentFile::~MappedSegmentFile() {
+  if (base_ != nullptr) munmap(base_, file_size_);
+  if (fd_ >= 0) close(fd_);
+}
+
+size_t MappedSegmentFile::NumAllocatedSegments() const {
+  return num_allocated_bytes_ / (pages_per_segment_ * Page::kSize);
+}
+
+Status MappedSegmentFile::ReadPages(const size_t offset, void* data,
+                                    const size_t num_pages) const {
+  if (offset >= num_allocated_bytes_) {
+    return Status::InvalidArgument("Tried to read from unallocated page.");
+  }
+  memcpy(data, base_ + offset, num_pages * Page::kSize);
+  return Status::OK();
+}
+
+Status MappedSegmentFile::WritePages(const size_t offset, const void* data,
+                                     const size_t num_pages) const {
+  return Status::NotSupported("Cannot write to a read-only segment file.");
+}
+
+size_t MappedSegmentFile::AllocateSegment() {
+  throw std::runtime_error("Cannot allocate segments in a read-only file.");
+}
+
+char* MappedSegmentFile::PageAddress(const size_t offset) const {
+  assert(offset < num_allocated_bytes_);
+  return base_ + offset;
+}
+
+void MappedSegmentFile::Prefetch(const size_t offset,
+                                 const size_t num_pages) const {
+  if (offset >= num_allocated_bytes_) return;
+  const size_t num_bytes =
+      std::min(num_pages * Page::kSize, num_allocated_bytes_ - offset);
+  // `madvise()` requires a page-aligned address. Pages are 4 KiB, which is the
+  // usual OS page size.
+  madvise(base_ + offset, num_bytes, MADV_WILLNEED);
+}
+
+}  // namespace pg
+}  // namespace tl
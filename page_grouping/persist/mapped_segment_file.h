@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+
+#include "segment_file.h"
+
+namespace tl {
+namespace pg {
+
+// A read-only `SegmentFile` that memory maps an existing segment file. Pages
+// can be accessed in place (see `PageAddress()`), so reads do not need to go
+// through a system call or be copied into a separate buffer.
+//
+// Writes and segment allocations are not supported. The file must not be
+// modified while it is mapped. This class is thread-safe.
+class MappedSegmentFile : public SegmentFile {
+ public:
+  MappedSegmentFile(const std::filesystem::path& name,
+                    size_t pages_per_segment);
+  ~MappedSegmentFile() override;
+
+  MappedSegmentFile(const MappedSegmentFile&) = delete;
+  MappedSegmentFile& operator=(const MappedSegmentFile&) = delete;
+
+  size_t NumAllocatedSegments() const override;
+  size_t PagesPerSegment() const override { return pages_per_segment_; }
+
+  Status ReadPages(size_t offset, void* data, size_t num_pages) const override;
+  // Always returns `Status::NotSupported()`.
+  Status WritePages(size_t offset, const void* data,
+                    size_t num_pages) const override;
+  void Sync() const override {}
+
+  // Throws `std::runtime_error` (the file is read only).
+  size_t AllocateSegment() override;
+
+  char* PageAddress(size_t offset) const override;
+  void Prefetch(size_t offset, size_t num_pages) const override;
+
+ private:
+  const size_t pages_per_segment_;
+  int fd_;
+  char* base_;
+  size_t file_size_;
+  size_t num_allocated_bytes_;
+};
+
+}  // namespace pg
+}  // namespace tl
@@ -0,0 +1,98 @@
+#include "memory_segment_file.h"
+
+#include <sys/mman.h>
+
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+// Transparent huge pages are only used for suitably aligned 2 MiB regions.
+constexpr size_t kHugePageSize = 2ULL * 1024 * 1024;
+
+}  // namespace
+
+namespace tl {
+namespace pg {
+
+MemorySegmentFile::MemorySegmentFile(const size_t pages_per_segment,
+                                     const size_t max_bytes,
+                                     const bool use_huge_pages)
+    : pages_per_segment_(pages_per_segment),
+      mapping_(nullptr),
+      mapping_bytes_(0),
+      base_(nullptr),
+      capacity_(0),
+      next_page_allocation_offset_(0) {
+  assert(pages_per_segment > 0);
+  const size_t bytes_per_segment = pages_per_segment_ * Page::kSize;
+  capacity_ = (max_bytes / bytes_per_segment) * bytes_per_segment;
+  assert(capacity_ > 0);
+
+  // Over-reserve when using huge pages so that the pages can start on a huge
+  // page boundary.
+  mapping_bytes_ = capacity_ + (use_huge_pages ? kHugePageSize : 0);
+  mapping_ = mmap(nullptr, mapping_bytes_, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (mapping_ == MAP_FAILED) {
+    mapping_ = nullptr;
+    CHECK_ERROR(-1);
+  }
+  base_ = reinterpret_cast<char*>(mapping_);
+  if (use_huge_pages) {
+    const uintptr_t addr = reinterpret_cast<uintptr_t>(base_);
+    base_ += (kHugePageSize - (addr % kHugePageSize)) % kHugePageSize;
+    // This is only a hint, so failures (e.g., when transparent huge pages are
+    // disabled) are ignored.
+    madvise(base_, capacity_, MADV_HUGEPAGE);
+  }
+}
+
+MemorySegmentFile::~MemorySegmentFile() {
+  if (mapping_ == nullptr) return;
+  munmap(mapping_, mapping_bytes_);
+}
+
+size_t MemorySegmentFile::NumAllocatedSegments() const {
+  return next_page_allocation_offset_ / (pages_per_segment_ * Page::kSize);
+}
+
+Status MemorySegmentFile::ReadPages(const size_t offset, void* data,
+                                    const size_t num_pages) const {
+  if (offset >= next_page_allocation_offset_) {
+    return Status::InvalidArgument("Tried to read from unallocated page.");
+  }
+  memcpy(data, base_ + offset, num_pages * Page::kSize);
+  return Status::OK();
+}
+
+Status MemorySegmentFile::WritePages(const size_t offset, const void* data,
+                                     const size_t num_pages) const {
+  if (offset >= next_page_allocation_offset_) {
+    return Status::InvalidArgument("Tried to write to unallocated page.");
+  }
+  memcpy(base_ + offset, data, num_pages * Page::kSize);
+  return Status::OK();
+}
+
+size_t MemorySegmentFile::AllocateSegment() {
+  std::unique_lock<std::mutex> lock(allocation_mutex_);
+  const size_t allocated_offset = next_page_allocation_offset_;
+  const size_t bytes_per_segment = pages_per_segment_ * Page::kSize;
+  if (allocated_offset + bytes_per_segment > capacity_) {
+    throw std::runtime_error(
+        "Exceeded the capacity of an in-memory segment file.");
+  }
+  // The memory is freshly mapped, so newly allocated segments are zeroed out
+  // (like newly allocated file space).
+  next_page_allocation_offset_ += bytes_per_segment;
+  return allocated_offset;
+}
+
+char* MemorySegmentFile::PageAddress(const size_t offset) const {
+  assert(offset < next_page_allocation_offset_);
+  return base_ + offset;
+}
+
+}  // namespace pg
+}  // namespace tl
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+
+#include "segment_file.h"
+
+namespace tl {
+namespace pg {
+
+// A `SegmentFile` whose segments live in anonymous memory owned by this class
+// (no file is created and no system calls are made to read or write pages).
+// The file's contents are lost when it is destroyed.
+//
+// Address space for `max_bytes` is reserved up front so that pages never move.
+// Memory is only committed as pages are first written. This class is
+// thread-safe.
+class MemorySegmentFile : public SegmentFile {
+ public:
+  // If `use_huge_pages` is true, the kernel is asked to back the memory with
+  // transparent huge pages (the request is ignored if they are unavailable).
+  MemorySegmentFile(size_t pages_per_segment, size_t max_bytes,
+                    bool use_huge_pages);
+  ~MemorySegmentFile() override;
+
+  MemorySegmentFile(const MemorySegmentFile&) = delete;
+  MemorySegmentFile& operator=(const MemorySegmentFile&) = delete;
+
+  size_t NumAllocatedSegments() const override;
+  size_t PagesPerSegment() const override { return pages_per_segment_; }
+
+  Status ReadPages(size_t offset, void* data, size_t num_pages) const override;
+  Status WritePages(size_t offset, const void* data,
+                    size_t num_pages) const override;
+  // The pages are only kept in memory, so this is a no-op.
+  void Sync() const override {}
+
+  size_t AllocateSegment() override;
+
+  char* PageAddress(size_t offset) const override;
+
+ private:
+  const size_t pages_per_segment_;
+  // The reserved region, as returned by `mmap()`.
+  void* mapping_;
+  size_t mapping_bytes_;
+  // The (possibly aligned) start of the pages and the usable capacity.
+  char* base_;
+  size_t capacity_;
+
+  std::mutex allocation_mutex_;
+  std::atomic<size_t> next_page_allocation_offset_;
+};
+
+}  // namespace pg
+}  // namespace tl
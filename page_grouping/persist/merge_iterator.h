@@ -1,7 +1,9 @@
 #pragma once
 
 #include <functional>
+#include <optional>
 #include <queue>
+#include <string>
 #include <vector>
 
 #include "treeline/slice.h"
@@ -10,15 +12,25 @@
 namespace tl {
 namespace pg {
 
+// Merges the records in a list of pages (e.g., a page and its overflow) into
+// one sorted stream. If several pages hold a record with the same key, only
+// the record in the page that is last in the list is returned (overflow pages
+// hold newer records than the compressed pages they belong to).
+//
+// If `end_key` is set, the iterator stops before the first record with a key
+// larger than `end_key` (e.g., to merge in a segment's delta pages, which hold
+// records for the segment's other pages too).
 class PageMergeIterator {
  public:
   // Represents an empty iterator.
   PageMergeIterator() : merged_iterators_(&PageMergeIterator::Compare) {}
 
   explicit PageMergeIterator(std::vector<Page::Iterator> iterators,
-                             const Slice* start_key = nullptr)
+                             const Slice* start_key = nullptr,
+                             const Slice* end_key = nullptr)
       : page_iterators_(std::move(iterators)),
         merged_iterators_(&PageMergeIterator::Compare) {
+    if (end_key != nullptr) end_key_ = end_key->ToString();
     for (auto& it : page_iterators_) {
       if (start_key != nullptr) it.Seek(*start_key);
       if (!it.Valid()) continue;
@@ -31,6 +43,7 @@ class PageMergeIterator {
 
   PageMergeIterator(const PageMergeIterator& other)
       : page_iterators_(other.page_iterators_),
+        end_key_(other.end_key_),
         merged_iterators_(&PageMergeIterator::Compare) {
     InitHeap();
   }
@@ -38,12 +51,14 @@ class PageMergeIterator {
   PageMergeIterator& operator=(const PageMergeIterator& other) {
     if (this == &other) return *this;
     page_iterators_ = other.page_iterators_;
+    end_key_ = other.end_key_;
     InitHeap();
     return *this;
   }
 
   PageMergeIterator(PageMergeIterator&& other)
       : page_iterators_(other.page_iterators_),
+        end_key_(other.end_key_),
         merged_iterators_(&PageMergeIterator::Compare) {
     InitHeap();
   }
@@ -51,11 +66,16 @@ class PageMergeIterator {
   PageMergeIterator& operator=(PageMergeIterator&& other) {
     if (this == &other) return *this;
     page_iterators_ = other.page_iterators_;
+    end_key_ = other.end_key_;
     InitHeap();
     return *this;
   }
 
-  bool Valid() const { return !merged_iterators_.empty(); }
+  bool Valid() const {
+    if (merged_iterators_.empty()) return false;
+    return !end_key_.has_value() ||
+           merged_iterators_.top()->key().compare(Slice(*end_key_)) <= 0;
+  }
 
   // REQUIRES: `Valid()` is true.
   void Next() {
@@ -63,6 +83,15 @@ class PageMergeIterator {
     Page::Iterator* const it = merged_iterators_.top();
     merged_iterators_.pop();
 
+    // Skip over any older records with the same key.
+    while (!merged_iterators_.empty() &&
+           merged_iterators_.top()->key().compare(it->key()) == 0) {
+      Page::Iterator* const shadowed = merged_iterators_.top();
+      merged_iterators_.pop();
+      shadowed->Next();
+      if (shadowed->Valid()) merged_iterators_.push(shadowed);
+    }
+
     assert(it->Valid());
     it->Next();
     if (!it->Valid()) return;
@@ -85,6 +114,8 @@ class PageMergeIterator {
     return it->value();
   }
 
+  // Records that are shadowed by a record with the same key are included in
+  // this count.
   size_t RecordsLeft() const {
     size_t records_left = 0;
     for (auto& it : page_iterators_) {
@@ -99,11 +130,14 @@ class PageMergeIterator {
   // However, `std::priority_queue` returns the *largest* items first, whereas
   // we want to return the smallest items first. So we return true here if
   // `left` is strictly larger than `right` to ensure the smallest records are
-  // returned first.
+  // returned first. Among records with the same key, the record from the page
+  // that is later in `page_iterators_` is returned first.
   static bool Compare(const Page::Iterator* left, const Page::Iterator* right) {
     assert(left->Valid() && right->Valid());
     // Evaluates to true iff `left.key()` is greater than `right.key()`.
-    return left->key().compare(right->key()) > 0;
+    const int cmp = left->key().compare(right->key());
+    if (cmp != 0) return cmp > 0;
+    return left < right;
   }
 
   // Used by the copy/move constructors/assignment operators.
@@ -118,6 +152,7 @@ class PageMergeIterator {
   }
 
   std::vector<Page::Iterator> page_iterators_;
+  std::optional<std::string> end_key_;
   std::priority_queue<Page::Iterator*, std::vector<Page::Iterator*>,
                       decltype(&PageMergeIterator::Compare)>
       merged_iterators_;
@@ -436,6 +436,75 @@ void PackedMap<MapSizeBytes>::UnmakeOverflow() {
   header_.flags &= ~kOverflowFlag;
 }
 
+template <uint16_t MapSizeBytes>
+const bool PackedMap<MapSizeBytes>::IsDelta() const {
+  return header_.flags & kDeltaFlag;
+}
+
+template <uint16_t MapSizeBytes>
+void PackedMap<MapSizeBytes>::MakeDelta() {
+  header_.flags |= kOverflowFlag | kDeltaFlag;
+}
+
+template <uint16_t MapSizeBytes>
+const bool PackedMap<MapSizeBytes>::IsCompressed() const {
+  return header_.flags & kCompressedFlag;
+}
+
+template <uint16_t MapSizeBytes>
+void PackedMap<MapSizeBytes>::MakeCompressed(const uint16_t num_records) {
+  // The fences are always stored at the end of the map (see `SetFences()`), so
+  // dropping the records only requires resetting the heap.
+  const unsigned fence_bytes =
+      header_.lower_fence.length + header_.upper_fence.length;
+  header_.data_offset = MapSizeBytes - fence_bytes;
+  header_.space_used = fence_bytes;
+  header_.count = num_records;
+  header_.flags |= kCompressedFlag;
+}
+
+template <uint16_t MapSizeBytes>
+uint8_t* PackedMap<MapSizeBytes>::GetBody() {
+  return Ptr() + kTotalMetadataBytes;
+}
+
+template <uint16_t MapSizeBytes>
+const uint8_t* PackedMap<MapSizeBytes>::GetBody() const {
+  return Ptr() + kTotalMetadataBytes;
+}
+
+template <uint16_t MapSizeBytes>
+unsigned PackedMap<MapSizeBytes>::GetBodySize() const {
+  return MapSizeBytes - kTotalMetadataBytes - header_.lower_fence.length -
+         header_.upper_fence.length;
+}
+
+template <uint16_t MapSizeBytes>
+const bool PackedMap<MapSizeBytes>::IsChecksummed() const {
+  return header_.flags & kChecksumFlag;
+}
+
+template <uint16_t MapSizeBytes>
+void PackedMap<MapSizeBytes>::MakeChecksummed() {
+  header_.flags |= kChecksumFlag;
+}
+
+template <uint16_t MapSizeBytes>
+uint32_t PackedMap<MapSizeBytes>::GetChecksum() const {
+  uint32_t checksum = 0;
+  for (size_t i = 0; i < kChecksumBytes; ++i) {
+    checksum |= static_cast<uint32_t>(header_.checksum[i]) << (8 * i);
+  }
+  return checksum;
+}
+
+template <uint16_t MapSizeBytes>
+void PackedMap<MapSizeBytes>::SetChecksum(const uint32_t checksum) {
+  for (size_t i = 0; i < kChecksumBytes; ++i) {
+    header_.checksum[i] = static_cast<uint8_t>(checksum >> (8 * i));
+  }
+}
+
 template <uint16_t MapSizeBytes>
 void PackedMap<MapSizeBytes>::SearchHint(const uint32_t key_head,
                                          unsigned& lower_out,
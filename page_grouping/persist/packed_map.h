@@ -103,6 +103,10 @@ class PackedMap {
   // Returns the number of records currently stored in this map.
   uint16_t GetNumRecords() const;
 
+  // Returns the number of bytes that would be available for new records (slots,
+  // keys, and payloads) if this map were compacted.
+  unsigned GetFreeSpace() const { return FreeSpaceAfterCompaction(); }
+
   // Retrieves the common prefix among all keys stored in this map.
   void GetKeyPrefix(const uint8_t** key_prefix_out,
                     unsigned* key_prefix_length_out) const;
@@ -148,6 +152,43 @@ class PackedMap {
   void MakeOverflow();
   void UnmakeOverflow();
 
+  // Check whether this is a delta page & make it one. Delta pages are also
+  // overflow pages.
+  const bool IsDelta() const;
+  void MakeDelta();
+
+  // Compressed maps keep their fences and scratch space, but their records are
+  // stored in a format that is managed by the caller (see `Page`). The encoded
+  // records are stored in the map's "body", which holds all the bytes that are
+  // not used by the header and fences.
+  const bool IsCompressed() const;
+
+  // Removes all records from this map and marks it as compressed. The caller
+  // should then write the `num_records` encoded records into the body.
+  void MakeCompressed(uint16_t num_records);
+
+  uint8_t* GetBody();
+  const uint8_t* GetBody() const;
+  unsigned GetBodySize() const;
+
+  // Check whether this map stores a checksum & mark it as one that does. Maps
+  // written before checksums were added do not.
+  const bool IsChecksummed() const;
+  void MakeChecksummed();
+
+  // Retrieve/update the checksum stored in this map's header. The map does not
+  // compute or check the checksum itself. Only the lowest `kChecksumBytes`
+  // bytes of `checksum` are stored.
+  uint32_t GetChecksum() const;
+  void SetChecksum(uint32_t checksum);
+
+  // The size of the stored checksum, and its offset from the start of the map
+  // (the header is stored first).
+  static constexpr size_t kChecksumBytes = 3;
+  static constexpr size_t ChecksumOffset() {
+    return offsetof(Header, checksum);
+  }
+
  private:
   static constexpr unsigned kHintCount = 16;
   static constexpr unsigned kScratchSize = 24;
@@ -155,6 +196,9 @@ class PackedMap {
 
   static constexpr uint8_t kValidFlag = 1;
   static constexpr uint8_t kOverflowFlag = 2;
+  static constexpr uint8_t kCompressedFlag = 4;
+  static constexpr uint8_t kDeltaFlag = 8;
+  static constexpr uint8_t kChecksumFlag = 16;
 
   struct Header {
     struct FenceKeySlot {
@@ -176,7 +220,14 @@ class PackedMap {
     uint8_t scratch[kScratchSize];
 
     uint8_t flags = kValidFlag & ~kOverflowFlag;
+
+    // Used by `Page` to detect corrupted pages; only valid if `kChecksumFlag`
+    // is set. It uses the bytes that would otherwise be padding, which keeps
+    // the on-disk format compatible with maps written before it was added.
+    uint8_t checksum[kChecksumBytes] = {0, 0, 0};
   };
+  static_assert(sizeof(Header) == 108,
+                "Changing the header's size changes the on-disk format.");
   struct Slot {
     uint16_t offset;
     uint16_t key_length;
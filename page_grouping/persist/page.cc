@@ -1,9 +1,13 @@
 #include "page.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <limits>
 
+#include "compressed_records.h"
 #include "packed_map.h"
+#include "util/crc32c.h"
 
 namespace {
 
@@ -29,6 +33,47 @@ inline const PackedMap* AsMapPtr(const void* data) {
   return reinterpret_cast<const PackedMap*>(data);
 }
 
+inline tl::pg::CompressedRecords AsCompressed(const void* data) {
+  return tl::pg::CompressedRecords(AsMapPtr(data)->GetBody());
+}
+
+// The checksum covers the whole page, except for the checksum itself. It is
+// truncated to the size that the page stores.
+uint32_t ComputePageChecksum(const void* data) {
+  const uint8_t* const bytes = reinterpret_cast<const uint8_t*>(data);
+  constexpr size_t kChecksumEnd =
+      PackedMap::ChecksumOffset() + PackedMap::kChecksumBytes;
+  constexpr uint32_t kChecksumMask =
+      (1U << (8 * PackedMap::kChecksumBytes)) - 1;
+  const uint32_t checksum =
+      tl::crc32c::Value(bytes, PackedMap::ChecksumOffset());
+  return tl::crc32c::Extend(checksum, bytes + kChecksumEnd,
+                            tl::pg::Page::kSize - kChecksumEnd) &
+         kChecksumMask;
+}
+
+// Compressed pages only store 8-byte keys. Shorter keys are padded with 0s.
+uint64_t DecodeKey(const tl::Slice& key) {
+  uint64_t swapped = 0;
+  memcpy(&swapped, key.data(), std::min(key.size(), sizeof(swapped)));
+  return __builtin_bswap64(swapped);
+}
+
+// Returns the index of the first record in `records` with a key that is
+// greater than or equal to `key`.
+size_t CompressedLowerBound(const tl::pg::CompressedRecords& records,
+                            const tl::Slice& key) {
+  uint64_t int_key = DecodeKey(key);
+  if (key.size() > sizeof(uint64_t)) {
+    // `key` is ordered after the 8-byte key that is its prefix.
+    if (int_key == std::numeric_limits<uint64_t>::max()) {
+      return records.NumRecords();
+    }
+    ++int_key;
+  }
+  return records.LowerBound(int_key);
+}
+
 }  // namespace
 
 namespace tl {
@@ -104,6 +149,9 @@ Status Page::Put(const Slice& key, const Slice& value) {
 
 Status Page::Put(const WriteOptions& options, const Slice& key,
                  const Slice& value) {
+  if (AsMapPtr(data_)->IsCompressed()) {
+    return Status::InvalidArgument("Page is full.");
+  }
   if (options.sorted_load) {
     if (!AsMapPtr(data_)->Append(reinterpret_cast<const uint8_t*>(key.data()),
                                  key.size(),
@@ -122,6 +170,9 @@ Status Page::Put(const WriteOptions& options, const Slice& key,
 }
 
 Status Page::UpdateOrRemove(const Slice& key, const Slice& value) {
+  if (AsMapPtr(data_)->IsCompressed()) {
+    return Status::NotSupported("Compressed pages are read-only.");
+  }
   if (!AsMapPtr(data_)->UpdateOrRemove(
           reinterpret_cast<const uint8_t*>(key.data()), key.size(),
           reinterpret_cast<const uint8_t*>(value.data()), value.size())) {
@@ -132,6 +183,20 @@ Status Page::UpdateOrRemove(const Slice& key, const Slice& value) {
 }
 
 Status Page::Get(const Slice& key, std::string* value_out) {
+  if (AsMapPtr(data_)->IsCompressed()) {
+    const CompressedRecords records = AsCompressed(data_);
+    if (key.size() != sizeof(uint64_t)) {
+      return Status::NotFound("Key not found in page.");
+    }
+    const uint64_t int_key = DecodeKey(key);
+    const size_t index = records.LowerBound(int_key);
+    if (index >= records.NumRecords() || records.KeyAt(index) != int_key) {
+      return Status::NotFound("Key not found in page.");
+    }
+    const Slice value = records.ValueAt(index);
+    value_out->assign(value.data(), value.size());
+    return Status::OK();
+  }
   const uint8_t* payload = nullptr;
   unsigned payload_length = 0;
   if (!AsMapPtr(data_)->Get(reinterpret_cast<const uint8_t*>(key.data()),
@@ -145,6 +210,9 @@ Status Page::Get(const Slice& key, std::string* value_out) {
 }
 
 Status Page::Delete(const Slice& key) {
+  if (AsMapPtr(data_)->IsCompressed()) {
+    return Status::NotSupported("Compressed pages are read-only.");
+  }
   if (!AsMapPtr(data_)->Remove(reinterpret_cast<const uint8_t*>(key.data()),
                                key.size())) {
     return Status::NotFound("Key not found in page.");
@@ -152,6 +220,37 @@ Status Page::Delete(const Slice& key) {
   return Status::OK();
 }
 
+Status Page::PutCompressed(
+    const std::vector<std::pair<uint64_t, Slice>>::const_iterator begin,
+    const std::vector<std::pair<uint64_t, Slice>>::const_iterator end) {
+  ::PackedMap* const map = AsMapPtr(data_);
+  // The records are encoded into a separate buffer so that the page is left
+  // unchanged if they do not fit.
+  uint8_t encoded[MapSize];
+  const size_t encoded_size =
+      CompressedRecords::Encode(begin, end, encoded, map->GetBodySize());
+  if (encoded_size == 0) {
+    return Status::InvalidArgument("Page is full.");
+  }
+  map->MakeCompressed(end - begin);
+  memcpy(map->GetBody(), encoded, encoded_size);
+  return Status::OK();
+}
+
+bool Page::IsCompressed() const { return AsMapPtr(data_)->IsCompressed(); }
+
+void Page::ComputeAndSetPageChecksum() {
+  if (!IsValid()) return;
+  // The flag is covered by the checksum, so it must be set first.
+  AsMapPtr(data_)->MakeChecksummed();
+  AsMapPtr(data_)->SetChecksum(ComputePageChecksum(data_));
+}
+
+bool Page::CheckPageChecksum() const {
+  if (!IsValid() || !AsMapPtr(data_)->IsChecksummed()) return true;
+  return AsMapPtr(data_)->GetChecksum() == ComputePageChecksum(data_);
+}
+
 bool Page::HasOverflow() const { return GetOverflow().IsValid(); }
 
 // Page scratch space: 24 bytes. The scratch space is used differently depending
@@ -173,6 +272,10 @@ bool Page::HasOverflow() const { return GetOverflow().IsValid(); }
 //
 // Multi-page Segments (Other Pages)
 // - Overflow page ID  (8 B)
+//
+// Delta Pages
+// - Overflow page ID  (8 B, unused)
+// - Sequence number   (4 B)
 
 
 SegmentId Page::GetOverflow() const {
@@ -227,19 +330,34 @@ uint16_t Page::GetNumRecords() const {
   return AsMapPtr(data_)->GetNumRecords();
 }
 
+size_t Page::GetFreeSpace() const {
+  const ::PackedMap* const map = AsMapPtr(data_);
+  if (map->IsCompressed()) {
+    return map->GetBodySize() - AsCompressed(data_).EncodedSize();
+  }
+  return map->GetFreeSpace();
+}
+
 const bool Page::IsOverflow() const { return AsMapPtr(data_)->IsOverflow(); }
 
 void Page::MakeOverflow() { return AsMapPtr(data_)->MakeOverflow(); }
 
 void Page::UnmakeOverflow() { return AsMapPtr(data_)->UnmakeOverflow(); }
 
+const bool Page::IsDelta() const { return AsMapPtr(data_)->IsDelta(); }
+
+void Page::MakeDelta() { return AsMapPtr(data_)->MakeDelta(); }
+
 Page::Iterator Page::GetIterator() const { return Iterator(*this); }
 
 Page::Iterator::Iterator(const Page& page)
     : data_(page.data_),
       current_slot_(0),
+      compressed_(page.IsCompressed()),
       prefix_length_(0),
       key_buffer_valid_(false) {
+  // Compressed pages store whole keys.
+  if (compressed_) return;
   const Slice prefix = page.GetKeyPrefix();
   key_buffer_.append(prefix.data(), prefix.size());
   prefix_length_ = prefix.size();
@@ -247,6 +365,11 @@ Page::Iterator::Iterator(const Page& page)
 }
 
 void Page::Iterator::Seek(const Slice& key) {
+  if (compressed_) {
+    current_slot_ = CompressedLowerBound(AsCompressed(data_), key);
+    key_buffer_valid_ = false;
+    return;
+  }
   current_slot_ = AsMapPtr(data_)->LowerBoundSlot(
       reinterpret_cast<const uint8_t*>(key.data()), key.size());
   key_buffer_valid_ = false;
@@ -278,6 +401,13 @@ size_t Page::Iterator::RecordsLeft() const {
 }
 
 Slice Page::Iterator::key() const {
+  if (!key_buffer_valid_ && compressed_) {
+    const uint64_t swapped =
+        __builtin_bswap64(AsCompressed(data_).KeyAt(current_slot_));
+    key_buffer_.assign(reinterpret_cast<const char*>(&swapped),
+                       sizeof(swapped));
+    key_buffer_valid_ = true;
+  }
   if (!key_buffer_valid_) {
     key_buffer_.resize(prefix_length_);
     const uint8_t* suffix = nullptr;
@@ -293,6 +423,7 @@ Slice Page::Iterator::key() const {
 
 Slice Page::Iterator::value() const {
   assert(Valid());
+  if (compressed_) return AsCompressed(data_).ValueAt(current_slot_);
   const uint8_t* value = nullptr;
   unsigned length = 0;
   const bool found =
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "segment_id.h"
 #include "../plr/data.h"
@@ -78,6 +81,23 @@ class Page {
   Status Get(const Slice& key, std::string* value_out);
   Status Delete(const Slice& key);
 
+  // Stores the records in `[begin, end)`, which must be sorted by key, in this
+  // page using the compressed format (see `CompressedRecords`). Any records
+  // already in the page are removed. Keys are 64-bit integers that are stored
+  // as 8-byte big endian strings (see `key_utils::IntKeyAsSlice`). If the
+  // records do not fit, this method returns `InvalidArgument` and leaves the
+  // page unchanged.
+  //
+  // Compressed pages are read-only: `Put()` fails as if the page were full, so
+  // new writes go to the page's overflow page. A record in the overflow page
+  // takes precedence over a record with the same key in a compressed page.
+  Status PutCompressed(
+      std::vector<std::pair<uint64_t, Slice>>::const_iterator begin,
+      std::vector<std::pair<uint64_t, Slice>>::const_iterator end);
+
+  // Check whether this page stores its records in the compressed format.
+  bool IsCompressed() const;
+
   // Check whether this is a valid Page (as opposed to a Page-sized
   // block of 0s).
   const bool IsValid() const;
@@ -85,11 +105,22 @@ class Page {
   // Returns the number of records stored in this page.
   uint16_t GetNumRecords() const;
 
+  // Returns the number of usable bytes in this page that are not yet used to
+  // store records (see `UsableSize()`).
+  size_t GetFreeSpace() const;
+
   // Check whether this is an overflow page & make/unmake it one.
   const bool IsOverflow() const;
   void MakeOverflow();
   void UnmakeOverflow();
 
+  // Check whether this is a delta page & make it one (see
+  // `PageGroupedDBOptions::delta_pages_per_segment`). Delta pages are also
+  // overflow pages. A delta page's fences cover its whole segment and its
+  // sequence number orders it relative to the segment (see `Manager`).
+  const bool IsDelta() const;
+  void MakeDelta();
+
   // Retrieve the stored `overflow` page id for this page.
   SegmentId GetOverflow() const;
 
@@ -107,6 +138,7 @@ class Page {
   // Retrieve/update the segment's sequence number.
   // VALID FOR: First (only) page in a single-page segment.
   // VALID FOR: Second page in a segment (multi-page segments).
+  // VALID FOR: Delta pages.
   uint32_t GetSequenceNumber() const;
   void SetSequenceNumber(uint32_t sequence);
 
@@ -115,6 +147,17 @@ class Page {
   uint32_t GetChecksum() const;
   void SetChecksum(uint32_t checksum);
 
+  // Computes a checksum (CRC32C, truncated to 24 bits) over this page's
+  // contents and stores it in the page. This should be called right before
+  // the page is written to storage. Invalid pages (e.g., all zeros) are left
+  // unchanged.
+  void ComputeAndSetPageChecksum();
+
+  // Returns false if this page's contents do not match its stored checksum
+  // (e.g., because the page was torn or corrupted). Invalid pages and pages
+  // written before checksums were added always pass this check.
+  bool CheckPageChecksum() const;
+
   class Iterator;
   friend class Iterator;
 
@@ -184,6 +227,8 @@ class Page::Iterator {
   // Points to the this iterator's page's underlying memory buffer.
   const void* data_;
   size_t current_slot_;
+  // If true, `current_slot_` is the index of a record in a compressed page.
+  bool compressed_;
 
   // Keys in the page are stored using a prefix (shared by all keys) and a
   // suffix (specific to each record). To reconstruct the record's actual key,
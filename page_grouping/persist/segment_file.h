@@ -5,6 +5,7 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <atomic>
 #include <cassert>
 #include <filesystem>
 #include <iostream>
@@ -27,22 +28,62 @@
 namespace tl {
 namespace pg {
 
-// Adapted from `db/file.h`. This class is thread-safe.
+// Stores fixed-size segments of pages. Offsets are specified in bytes.
+// Implementations must be thread-safe.
 class SegmentFile {
+ public:
+  virtual ~SegmentFile() = default;
+
+  // The number of allocated segments in this file. Some segments may be
+  // invalid; these represent "free" segments that can be reused.
+  virtual size_t NumAllocatedSegments() const = 0;
+
+  virtual size_t PagesPerSegment() const = 0;
+
+  virtual Status ReadPages(size_t offset, void* data,
+                           size_t num_pages) const = 0;
+  // Reads pages from the underlying storage, bypassing any in-memory cache of
+  // page images (used to check the stored pages).
+  virtual Status ReadPagesFromStorage(size_t offset, void* data,
+                                      size_t num_pages) const {
+    return ReadPages(offset, data, num_pages);
+  }
+  virtual Status WritePages(size_t offset, const void* data,
+                            size_t num_pages) const = 0;
+  virtual void Sync() const = 0;
+
+  // Reserves space for an additional segment in the file.
+  //
+  // Returns the offset of the newly allocated page.
+  virtual size_t AllocateSegment() = 0;
+
+  // Returns the address of the page at `offset` if this file's pages can be
+  // accessed in place, or `nullptr` otherwise. A returned address is valid
+  // for the lifetime of this file.
+  virtual char* PageAddress(size_t offset) const { return nullptr; }
+
+  // Hints that the given pages will be read soon. Implementations may ignore
+  // the hint.
+  virtual void Prefetch(size_t offset, size_t num_pages) const {}
+};
+
+// A `SegmentFile` stored in a file on disk. Adapted from `db/file.h`. This
+// class is thread-safe.
+class PosixSegmentFile : public SegmentFile {
   // The number of pages by which to grow a file when needed.
   const size_t kGrowthPages = 256;
   const size_t kGrowthBytes = kGrowthPages * Page::kSize;
 
  public:
   // Represents an invalid file.
-  SegmentFile()
+  PosixSegmentFile()
       : fd_(-1),
         pages_per_segment_(0),
         file_size_(0),
         next_page_allocation_offset_(0) {}
 
-  SegmentFile(const std::filesystem::path& name, size_t pages_per_segment,
-              bool use_memory_based_io = false)
+  PosixSegmentFile(const std::filesystem::path& name, size_t pages_per_segment,
+                   bool use_memory_based_io = false)
       : fd_(-1),
         pages_per_segment_(pages_per_segment),
         file_size_(0),
@@ -96,7 +137,7 @@ class SegmentFile {
     }
   }
 
-  ~SegmentFile() {
+  ~PosixSegmentFile() override {
     if (fd_ < 0) {
       // A negative file descriptor signifies an invalid file.
       return;
@@ -104,20 +145,18 @@ class SegmentFile {
     close(fd_);
   }
 
-  SegmentFile(const SegmentFile&) = delete;
-  SegmentFile(const SegmentFile&&) = delete;
-  SegmentFile& operator=(const SegmentFile&) = delete;
-  SegmentFile& operator=(const SegmentFile&&) = delete;
+  PosixSegmentFile(const PosixSegmentFile&) = delete;
+  PosixSegmentFile(const PosixSegmentFile&&) = delete;
+  PosixSegmentFile& operator=(const PosixSegmentFile&) = delete;
+  PosixSegmentFile& operator=(const PosixSegmentFile&&) = delete;
 
-  // The number of allocated segments in this file. Some segments may be
-  // invalid; these represent "free" segments that can be reused.
-  size_t NumAllocatedSegments() const {
+  size_t NumAllocatedSegments() const override {
     return next_page_allocation_offset_ / (pages_per_segment_ * Page::kSize);
   }
 
-  size_t PagesPerSegment() const { return pages_per_segment_; }
+  size_t PagesPerSegment() const override { return pages_per_segment_; }
 
-  Status ReadPages(size_t offset, void* data, size_t num_pages) const {
+  Status ReadPages(size_t offset, void* data, size_t num_pages) const override {
     if (offset >= next_page_allocation_offset_) {
       return Status::InvalidArgument("Tried to read from unallocated page.");
     }
@@ -125,7 +164,8 @@ class SegmentFile {
     return Status::OK();
   }
 
-  Status WritePages(size_t offset, const void* data, size_t num_pages) const {
+  Status WritePages(size_t offset, const void* data,
+                    size_t num_pages) const override {
     if (offset >= next_page_allocation_offset_) {
       return Status::InvalidArgument("Tried to write to unallocated page.");
     }
@@ -133,13 +173,11 @@ class SegmentFile {
     return Status::OK();
   }
 
-  void Sync() const { CHECK_ERROR(fsync(fd_)); }
+  void Sync() const override { CHECK_ERROR(fsync(fd_)); }
 
-  // Reserves space for an additional segment in the file. This might involve
-  // growing the file if needed, otherwise it just updates the bookkeeping.
-  //
-  // Returns the offset of the newly allocated page.
-  size_t AllocateSegment() {
+  // This might involve growing the file if needed, otherwise it just updates
+  // the bookkeeping.
+  size_t AllocateSegment() override {
     std::unique_lock<std::mutex> lock(allocation_mutex_);
     size_t allocated_offset = next_page_allocation_offset_;
     ExpandToIfNeeded(allocated_offset);
@@ -4,10 +4,14 @@ namespace tl {
 namespace pg {
 
 // Most significant 4 bits reserved for the file (only 3 are actually used for
-// the file ID; the most significant bit is reserved).
+// the file ID; the most significant bit is reserved). The next bit stores the
+// storage tier, so IDs in the fast tier (tier 0) are unchanged.
 size_t SegmentId::offset_bits_ = 60;
+size_t SegmentId::tier_bit_ = 59;
 size_t SegmentId::file_mask_ = 15ULL << SegmentId::offset_bits_;
-size_t SegmentId::offset_mask_ = ~(SegmentId::file_mask_);
+size_t SegmentId::tier_mask_ = 1ULL << SegmentId::tier_bit_;
+size_t SegmentId::offset_mask_ =
+    ~(SegmentId::file_mask_ | SegmentId::tier_mask_);
 
 }  // namespace pg
 }  // namespace tl
@@ -15,6 +19,7 @@ size_t SegmentId::offset_mask_ = ~(SegmentId::file_mask_);
 namespace std {
 
 ostream& operator<<(ostream& os, const tl::pg::SegmentId& id) {
+  if (id.GetTier() != 0) os << "t" << id.GetTier() << ":";
   os << id.GetFileId() << "-" << id.GetOffset();
   return os;
 }
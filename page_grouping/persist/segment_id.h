@@ -13,16 +13,23 @@ namespace pg {
 // be found. This class is adapted from `tl::PhysicalPageId`.
 class SegmentId {
  public:
+  // The number of storage tiers that segments can be placed in.
+  static constexpr size_t kNumTiers = 2;
+
   SegmentId() : value_(kInvalidValue) {}
 
   // Used in deserialization.
   explicit SegmentId(size_t value) : value_(value) {}
 
-  SegmentId(const size_t file_id, const size_t offset) {
+  // `tier` identifies the storage tier that holds the file (0 is the fast tier
+  // and 1 is the capacity tier).
+  SegmentId(const size_t file_id, const size_t offset, const size_t tier = 0) {
     CheckFileId(file_id);
     CheckOffset(offset);
-    const size_t temp_value =
-        (offset & offset_mask_) | ((file_id << offset_bits_) & file_mask_);
+    CheckTier(tier);
+    const size_t temp_value = (offset & offset_mask_) |
+                              ((tier << tier_bit_) & tier_mask_) |
+                              ((file_id << offset_bits_) & file_mask_);
     CheckValid(temp_value);
     value_ = temp_value;
   }
@@ -46,6 +53,8 @@ class SegmentId {
 
   size_t GetOffset() const { return value_ & offset_mask_; }
 
+  size_t GetTier() const { return (value_ & tier_mask_) >> tier_bit_; }
+
   bool IsValid() const { return value_ != kInvalidValue; }
 
   size_t value() const { return value_; }
@@ -75,6 +84,12 @@ class SegmentId {
     }
   }
 
+  static void CheckTier(const size_t tier) {
+    if ((tier & ~(tier_mask_ >> tier_bit_)) != 0) {
+      throw std::runtime_error("Failed to create PageId: tier overflow.");
+    }
+  }
+
   static void CheckOffset(const size_t offset) {
     if ((offset & ~offset_mask_) != 0) {
       throw std::runtime_error("Failed to create PageId: offset overflow.");
@@ -84,11 +99,13 @@ class SegmentId {
   // The number of bits of `value_` allocated to each component of a
   // `SegmentId`.
   static size_t offset_bits_;
+  static size_t tier_bit_;
   static size_t file_mask_;
+  static size_t tier_mask_;
   static size_t offset_mask_;
 
-  // The lowest-order `offset_bits_` store the page offset, while the rest store
-  // the file_id.
+  // The lowest-order `offset_bits_` store the page offset and the tier (in the
+  // most significant of these bits), while the rest store the file_id.
   size_t value_;
 
   friend struct std::hash<tl::pg::SegmentId>;
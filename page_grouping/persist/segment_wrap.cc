@@ -45,6 +45,19 @@ void SegmentWrap::ComputeAndSetChecksum() {
   PageAtIndex(1).SetChecksum(checksum);
 }
 
+void SegmentWrap::ComputeAndSetPageChecksums() {
+  for (size_t i = 0; i < pages_in_segment_; ++i) {
+    PageAtIndex(i).ComputeAndSetPageChecksum();
+  }
+}
+
+bool SegmentWrap::CheckPageChecksums() const {
+  for (size_t i = 0; i < pages_in_segment_; ++i) {
+    if (!PageAtIndex(i).CheckPageChecksum()) return false;
+  }
+  return true;
+}
+
 Page SegmentWrap::PageAtIndex(size_t index) const {
   return Page(reinterpret_cast<uint8_t*>(data_) + index * Page::kSize);
 }
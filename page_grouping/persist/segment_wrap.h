@@ -20,6 +20,14 @@ class SegmentWrap {
   bool CheckChecksum() const;
   void ComputeAndSetChecksum();
 
+  // Computes and stores the checksum of each page in the segment (see
+  // `Page::ComputeAndSetPageChecksum()`). This should be done after all other
+  // changes to the pages, right before they are written to storage.
+  void ComputeAndSetPageChecksums();
+
+  // Returns true iff all pages in the segment pass their checksum check.
+  bool CheckPageChecksums() const;
+
   // Sets all overflow values to "invalid" (indicating no overflow).
   void ClearAllOverflows();
 
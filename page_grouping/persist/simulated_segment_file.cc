@@ -0,0 +1,198 @@
+#include "simulated_segment_file.h"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Sleeping is imprecise for short delays (a thread may oversleep by tens of
+// microseconds), so we spin for the last part of each wait.
+constexpr auto kSpinThreshold = std::chrono::microseconds(100);
+
+void WaitUntil(const Clock::time_point deadline) {
+  const auto now = Clock::now();
+  if (deadline - now > kSpinThreshold) {
+    std::this_thread::sleep_until(deadline - kSpinThreshold);
+  }
+  while (Clock::now() < deadline) {
+    std::this_thread::yield();
+  }
+}
+
+double NanosPerByte(const uint64_t bandwidth_mib) {
+  if (bandwidth_mib == 0) return 0.0;
+  return 1e9 / (static_cast<double>(bandwidth_mib) * 1024.0 * 1024.0);
+}
+
+}  // namespace
+
+namespace tl {
+namespace pg {
+
+SimulatedDevice::SimulatedDevice(const SimulatedDeviceOptions& options)
+    : options_(options),
+      read_ns_per_byte_(NanosPerByte(options.read_bandwidth_mib)),
+      write_ns_per_byte_(NanosPerByte(options.write_bandwidth_mib)),
+      requests_in_service_(0),
+      transfers_done_(Clock::now()) {}
+
+void SimulatedDevice::Read(const size_t num_bytes) {
+  Serve(num_bytes, std::chrono::microseconds(options_.read_latency_us),
+        read_ns_per_byte_);
+}
+
+void SimulatedDevice::Write(const size_t num_bytes) {
+  Serve(num_bytes, std::chrono::microseconds(options_.write_latency_us),
+        write_ns_per_byte_);
+}
+
+void SimulatedDevice::Serve(const size_t num_bytes,
+                            const std::chrono::nanoseconds latency,
+                            const double ns_per_byte) {
+  const std::chrono::nanoseconds transfer_time(
+      static_cast<int64_t>(static_cast<double>(num_bytes) * ns_per_byte));
+  Clock::time_point done;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (options_.queue_depth > 0) {
+      queue_cv_.wait(lock, [this]() {
+        return requests_in_service_ < options_.queue_depth;
+      });
+    }
+    ++requests_in_service_;
+
+    // The transfer is queued behind the transfers already assigned to the
+    // device. The request completes once both its latency and its transfer
+    // have elapsed.
+    const auto now = Clock::now();
+    transfers_done_ = std::max(transfers_done_, now) + transfer_time;
+    done = std::max(now + latency + transfer_time, transfers_done_);
+  }
+
+  WaitUntil(done);
+
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    --requests_in_service_;
+  }
+  queue_cv_.notify_one();
+}
+
+SimulatedSegmentFile::SimulatedSegmentFile(
+    const std::filesystem::path& name, const size_t pages_per_segment,
+    std::shared_ptr<SimulatedDevice> device)
+    : pages_per_segment_(pages_per_segment),
+      bytes_per_chunk_(kSegmentsPerChunk * pages_per_segment * Page::kSize),
+      device_(std::move(device)),
+      backing_file_(name, pages_per_segment, /*use_memory_based_io=*/true),
+      next_page_allocation_offset_(0) {
+  assert(pages_per_segment > 0);
+  // Load the existing segments into memory.
+  const size_t num_segments = backing_file_.NumAllocatedSegments();
+  const size_t bytes_per_segment = pages_per_segment_ * Page::kSize;
+  for (size_t seg_idx = 0; seg_idx < num_segments;
+       seg_idx += kSegmentsPerChunk) {
+    chunks_.push_back(
+        PageMemoryAllocator::Allocate(kSegmentsPerChunk * pages_per_segment_));
+    const size_t segments_to_read =
+        std::min(kSegmentsPerChunk, num_segments - seg_idx);
+    backing_file_.ReadPages(seg_idx * bytes_per_segment,
+                            chunks_.back().get(),
+                            segments_to_read * pages_per_segment_);
+  }
+  next_page_allocation_offset_ = num_segments * bytes_per_segment;
+}
+
+SimulatedSegmentFile::~SimulatedSegmentFile() {
+  // Write the segments back to the on-disk file.
+  const size_t num_segments = NumAllocatedSegments();
+  while (backing_file_.NumAllocatedSegments() < num_segments) {
+    backing_file_.AllocateSegment();
+  }
+  const size_t bytes_per_segment = pages_per_segment_ * Page::kSize;
+  for (size_t chunk_idx = 0; chunk_idx < chunks_.size(); ++chunk_idx) {
+    const size_t seg_idx = chunk_idx * kSegmentsPerChunk;
+    if (seg_idx >= num_segments) break;
+    const size_t segments_to_write =
+        std::min(kSegmentsPerChunk, num_segments - seg_idx);
+    backing_file_.WritePages(seg_idx * bytes_per_segment,
+                             chunks_[chunk_idx].get(),
+                             segments_to_write * pages_per_segment_);
+  }
+  backing_file_.Sync();
+}
+
+size_t SimulatedSegmentFile::NumAllocatedSegments() const {
+  return next_page_allocation_offset_ / (pages_per_segment_ * Page::kSize);
+}
+
+template <typename Fn>
+void SimulatedSegmentFile::ForEachChunk(size_t offset, size_t num_bytes,
+                                        Fn&& fn) const {
+  std::shared_lock<std::shared_mutex> lock(chunks_mutex_);
+  size_t bytes_done = 0;
+  while (bytes_done < num_bytes) {
+    const size_t chunk_idx = offset / bytes_per_chunk_;
+    const size_t chunk_offset = offset % bytes_per_chunk_;
+    const size_t len =
+        std::min(num_bytes - bytes_done, bytes_per_chunk_ - chunk_offset);
+    assert(chunk_idx < chunks_.size());
+    fn(chunks_[chunk_idx].get() + chunk_offset, bytes_done, len);
+    bytes_done += len;
+    offset += len;
+  }
+}
+
+Status SimulatedSegmentFile::ReadPages(const size_t offset, void* data,
+                                       const size_t num_pages) const {
+  if (offset >= next_page_allocation_offset_) {
+    return Status::InvalidArgument("Tried to read from unallocated page.");
+  }
+  const size_t num_bytes = num_pages * Page::kSize;
+  device_->Read(num_bytes);
+  char* const out = reinterpret_cast<char*>(data);
+  ForEachChunk(offset, num_bytes,
+               [out](const char* chunk, size_t bytes_done, size_t len) {
+                 memcpy(out + bytes_done, chunk, len);
+               });
+  return Status::OK();
+}
+
+Status SimulatedSegmentFile::WritePages(const size_t offset, const void* data,
+                                        const size_t num_pages) const {
+  if (offset >= next_page_allocation_offset_) {
+    return Status::InvalidArgument("Tried to write to unallocated page.");
+  }
+  const size_t num_bytes = num_pages * Page::kSize;
+  const char* const in = reinterpret_cast<const char*>(data);
+  ForEachChunk(offset, num_bytes,
+               [in](char* chunk, size_t bytes_done, size_t len) {
+                 memcpy(chunk, in + bytes_done, len);
+               });
+  device_->Write(num_bytes);
+  return Status::OK();
+}
+
+size_t SimulatedSegmentFile::AllocateSegment() {
+  std::unique_lock<std::mutex> lock(allocation_mutex_);
+  const size_t allocated_offset = next_page_allocation_offset_;
+  const size_t bytes_per_segment = pages_per_segment_ * Page::kSize;
+  {
+    std::unique_lock<std::shared_mutex> chunks_lock(chunks_mutex_);
+    if (allocated_offset + bytes_per_segment >
+        chunks_.size() * bytes_per_chunk_) {
+      // Newly allocated chunks are zeroed out, like newly allocated file
+      // space.
+      chunks_.push_back(PageMemoryAllocator::Allocate(kSegmentsPerChunk *
+                                                      pages_per_segment_));
+    }
+  }
+  next_page_allocation_offset_ += bytes_per_segment;
+  return allocated_offset;
+}
+
+}  // namespace pg
+}  // namespace tl
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
+#include "bufmgr/page_memory_allocator.h"
+#include "segment_file.h"
+#include "treeline/pg_options.h"
+
+namespace tl {
+namespace pg {
+
+// Models the time a storage device takes to serve I/O requests (see
+// `SimulatedDeviceOptions`). Each request is delayed by a fixed latency plus
+// its transfer time. Transfers share the device's bandwidth, and at most
+// `queue_depth` requests are in service at once (the rest wait in a queue).
+//
+// A single device is shared by all the segment files in a database. This class
+// is thread-safe.
+class SimulatedDevice {
+ public:
+  explicit SimulatedDevice(const SimulatedDeviceOptions& options);
+
+  // Blocks the calling thread until the device would have finished serving a
+  // read (write) request of `num_bytes`.
+  void Read(size_t num_bytes);
+  void Write(size_t num_bytes);
+
+ private:
+  using Clock = std::chrono::steady_clock;
+  void Serve(size_t num_bytes, std::chrono::nanoseconds latency,
+             double ns_per_byte);
+
+  const SimulatedDeviceOptions options_;
+  const double read_ns_per_byte_;
+  const double write_ns_per_byte_;
+
+  std::mutex mutex_;
+  std::condition_variable queue_cv_;
+  // Protected by `mutex_`.
+  size_t requests_in_service_;
+  // The time at which the device finishes the transfers it has already been
+  // assigned. Protected by `mutex_`.
+  Clock::time_point transfers_done_;
+};
+
+// A `SegmentFile` that keeps its pages in memory and delays each request
+// according to a `SimulatedDevice`. This makes performance experiments
+// independent of the machine's storage device.
+//
+// The pages are loaded from the segment file on disk when this file is opened,
+// and they are written back when it is closed (I/O to the on-disk file is not
+// simulated). This class is thread-safe.
+class SimulatedSegmentFile : public SegmentFile {
+ public:
+  SimulatedSegmentFile(const std::filesystem::path& name,
+                       size_t pages_per_segment,
+                       std::shared_ptr<SimulatedDevice> device);
+  ~SimulatedSegmentFile() override;
+
+  SimulatedSegmentFile(const SimulatedSegmentFile&) = delete;
+  SimulatedSegmentFile& operator=(const SimulatedSegmentFile&) = delete;
+
+  size_t NumAllocatedSegments() const override;
+  size_t PagesPerSegment() const override { return pages_per_segment_; }
+
+  Status ReadPages(size_t offset, void* data, size_t num_pages) const override;
+  Status WritePages(size_t offset, const void* data,
+                    size_t num_pages) const override;
+  // The pages are kept in memory, so this is a no-op.
+  void Sync() const override {}
+
+  size_t AllocateSegment() override;
+
+ private:
+  // The number of segments stored in each memory chunk.
+  static constexpr size_t kSegmentsPerChunk = 256;
+
+  // Copies `num_bytes` between `data` and the pages starting at `offset`.
+  template <typename Fn>
+  void ForEachChunk(size_t offset, size_t num_bytes, Fn&& fn) const;
+
+  const size_t pages_per_segment_;
+  const size_t bytes_per_chunk_;
+  const std::shared_ptr<SimulatedDevice> device_;
+  // The on-disk segment file that holds the pages when this file is closed.
+  PosixSegmentFile backing_file_;
+
+  mutable std::shared_mutex chunks_mutex_;
+  // Protected by `chunks_mutex_` (the chunks themselves are never moved).
+  std::vector<PageBuffer> chunks_;
+
+  std::mutex allocation_mutex_;
+  std::atomic<size_t> next_page_allocation_offset_;
+};
+
+}  // namespace pg
+}  // namespace tl
@@ -150,5 +150,11 @@ int main(int argc, char* argv[]) {
     }
   }
 
+  // Hardware performance counters.
+  if (session.db().GetPerfCounters().HasResults()) {
+    std::ofstream out(output_dir / "perf_counters.csv");
+    session.db().GetPerfCounters().PrintAsCsv(out);
+  }
+
   return 0;
 }
@@ -2,6 +2,9 @@
 
 #include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <cstring>
+#include <fstream>
 #include <functional>
 
 #include "treeline/pg_stats.h"
@@ -9,6 +12,70 @@
 
 namespace fs = std::filesystem;
 
+namespace {
+
+using namespace tl;
+using namespace tl::pg;
+
+// Stores the keys saved by `PageGroupedDBImpl::SaveHotKeys()`, in ascending
+// order. The file starts with a magic string followed by a 4 byte format
+// version.
+const std::string kHotKeysFileName = "hot_keys";
+const char kHotKeysMagic[] = "TLHOTKY";
+constexpr uint32_t kHotKeysVersion = 1;
+constexpr size_t kHotKeysHeaderSize =
+    sizeof(kHotKeysMagic) + sizeof(kHotKeysVersion);
+
+// Releases the cache entry pinned by a `PinnableValue`.
+void UnpinCacheEntry(void* entry) {
+  static_cast<RecordCacheEntry*>(entry)->Unlock();
+}
+
+Status WriteHotKeys(const fs::path& path, const std::vector<Key>& keys) {
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write(kHotKeysMagic, sizeof(kHotKeysMagic));
+  out.write(reinterpret_cast<const char*>(&kHotKeysVersion),
+            sizeof(kHotKeysVersion));
+  out.write(reinterpret_cast<const char*>(keys.data()),
+            keys.size() * sizeof(Key));
+  if (!out) {
+    return Status::IOError("Failed to write the hot keys:", path.string());
+  }
+  return Status::OK();
+}
+
+Status ReadHotKeys(const fs::path& path, std::vector<Key>* keys_out) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    return Status::NotFound("No saved hot keys:", path.string());
+  }
+  char header[kHotKeysHeaderSize];
+  in.read(header, kHotKeysHeaderSize);
+  uint32_t version = 0;
+  if (in) {
+    std::memcpy(&version, header + sizeof(kHotKeysMagic), sizeof(version));
+  }
+  if (!in ||
+      std::memcmp(header, kHotKeysMagic, sizeof(kHotKeysMagic)) != 0 ||
+      version != kHotKeysVersion) {
+    return Status::Corruption("Invalid hot keys file:", path.string());
+  }
+  const size_t file_size = fs::file_size(path);
+  if ((file_size - kHotKeysHeaderSize) % sizeof(Key) != 0) {
+    return Status::Corruption("Truncated hot keys file:", path.string());
+  }
+  keys_out->resize((file_size - kHotKeysHeaderSize) / sizeof(Key));
+  in.read(reinterpret_cast<char*>(keys_out->data()),
+          keys_out->size() * sizeof(Key));
+  if (!in) {
+    keys_out->clear();
+    return Status::IOError("Failed to read the hot keys:", path.string());
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
 namespace tl {
 namespace pg {
 
@@ -19,24 +86,65 @@ static thread_local size_t thread_id_ = ([]() {
 Status PageGroupedDB::Open(const PageGroupedDBOptions& options,
                            const std::filesystem::path& db_path,
                            PageGroupedDB** db_out) {
+  if (options.deferred_io_max_deferrals > RecordCacheEntry::kMaxDeferrals) {
+    return Status::InvalidArgument(
+        "deferred_io_max_deferrals must be at most 3:",
+        std::to_string(options.deferred_io_max_deferrals));
+  }
+
   // TODO: This open logic could be improved, but it is good enough for our
   // current use cases.
-  if (std::filesystem::exists(db_path) &&
-      std::filesystem::is_directory(db_path) &&
-      !std::filesystem::is_empty(db_path)) {
+  // In-memory databases do not persist their contents, so they always start
+  // out empty.
+  const bool db_exists = !options.use_in_memory_storage &&
+                         std::filesystem::exists(db_path) &&
+                         std::filesystem::is_directory(db_path) &&
+                         !std::filesystem::is_empty(db_path);
+
+  // The trace file is opened after checking for an existing database because
+  // it may be placed in the database directory.
+  std::unique_ptr<OpTraceWriter> trace;
+  if (!options.trace_path.empty()) {
+    const Status s = OpTraceWriter::Open(options.trace_path, &trace);
+    if (!s.ok()) return s;
+  }
+
+  if (options.read_only) {
+    if (!db_exists) {
+      return Status::InvalidArgument(
+          "Only existing DBs can be opened in read-only mode:",
+          db_path.string());
+    }
+    // Read-only DBs do not use the record cache or track inserts.
+    PageGroupedDBOptions read_only_options(options);
+    read_only_options.bypass_cache = true;
+    read_only_options.record_cache_capacity = 0;
+    read_only_options.rec_cache_use_lru = false;
+    read_only_options.forecasting.use_insert_forecasting = false;
+    std::optional<Manager> mgr;
+    const Status s = Manager::Reopen(db_path, read_only_options, &mgr);
+    if (!s.ok()) return s;
+    *db_out = new PageGroupedDBImpl(db_path, read_only_options, std::move(mgr),
+                                    std::move(trace));
+  } else if (db_exists) {
     // Reopening an existing database.
-    Manager mgr = Manager::Reopen(db_path, options);
-    *db_out = new PageGroupedDBImpl(db_path, options, std::move(mgr));
+    std::optional<Manager> mgr;
+    const Status s = Manager::Reopen(db_path, options, &mgr);
+    if (!s.ok()) return s;
+    *db_out = new PageGroupedDBImpl(db_path, options, std::move(mgr),
+                                    std::move(trace));
   } else {
     // Opening a new database.
-    *db_out = new PageGroupedDBImpl(db_path, options, std::optional<Manager>());
+    *db_out = new PageGroupedDBImpl(db_path, options, std::optional<Manager>(),
+                                    std::move(trace));
   }
   return Status::OK();
 }
 
 PageGroupedDBImpl::PageGroupedDBImpl(fs::path db_path,
                                      PageGroupedDBOptions options,
-                                     std::optional<Manager> mgr)
+                                     std::optional<Manager> mgr,
+                                     std::unique_ptr<OpTraceWriter> trace)
     : db_path_(std::move(db_path)),
       options_(std::move(options)),
       mgr_(std::move(mgr)),
@@ -46,23 +154,50 @@ PageGroupedDBImpl::PageGroupedDBImpl(fs::path db_path,
              options_.rec_cache_batch_writeout
                  ? std::bind(&PageGroupedDBImpl::GetPageBoundsFor, this,
                              std::placeholders::_1)
-                 : RecordCache::KeyBoundsFn()),
+                 : RecordCache::KeyBoundsFn(),
+             options_.deferred_io_batch_size,
+             options_.deferred_io_max_deferrals),
       tracker_(options_.forecasting.use_insert_forecasting
                    ? std::make_shared<InsertTracker>(
                          options_.forecasting.num_inserts_per_epoch,
                          options_.forecasting.num_partitions,
                          options_.forecasting.sample_size,
                          options_.forecasting.random_seed)
-                   : nullptr) {
-  if (mgr_.has_value()) mgr_->SetTracker(tracker_);
+                   : nullptr),
+      trace_(std::move(trace)),
+      stop_migration_(false),
+      stop_scrubber_(false),
+      scrubber_paused_(false),
+      stop_warmup_(false) {
+  if (options_.num_async_threads > 0) {
+    async_threads_ = std::make_unique<ThreadPool>(
+        options_.num_async_threads,
+        []() { PageGroupedDBStats::Local().PostToGlobal(); });
+  }
+  if (mgr_.has_value()) {
+    mgr_->SetTracker(tracker_);
+    StartMigrationThread();
+    StartScrubberThread();
+    StartCacheWarmup();
+  }
 }
 
 PageGroupedDBImpl::~PageGroupedDBImpl() {
+  // Run any queued asynchronous requests before shutting down.
+  async_threads_.reset();
+  if (warmup_thread_.joinable()) {
+    stop_warmup_ = true;
+    warmup_thread_.join();
+  }
+  StopMigrationThread();
+  StopScrubberThread();
   if (!mgr_.has_value()) return;
 
   // Record statistics before shutting down.
   mgr_->PostStats();
+  if (options_.write_access_heatmap) mgr_->WriteAccessHeatmap();
   PageGroupedDBStats::Local().SetCacheBytes(cache_.GetSizeFootprintEstimate());
+  SaveHotKeys();
 
   if (!options_.parallelize_final_flush || options_.bypass_cache) return;
 
@@ -83,6 +218,9 @@ PageGroupedDBImpl::~PageGroupedDBImpl() {
 }
 
 Status PageGroupedDBImpl::BulkLoad(const std::vector<Record>& records) {
+  if (options_.read_only) {
+    return Status::NotSupported("Cannot bulk load a read-only DB.");
+  }
   if (mgr_.has_value()) {
     return Status::NotSupported("Cannot bulk load a non-empty DB.");
   }
@@ -113,14 +251,217 @@ Status PageGroupedDBImpl::BulkLoad(const std::vector<Record>& records) {
     prev_key = curr_key;
   }
 
+  // Only bulk loads that pass validation are traced.
+  if (trace_ != nullptr) {
+    for (const auto& record : records) {
+      trace_->Record(TraceOp::kBulkLoad, record.first, record.second.size());
+    }
+  }
+
   // Run the bulk load.
   mgr_ = Manager::LoadIntoNew(db_path_, records, options_);
   mgr_->SetTracker(tracker_);
+  StartMigrationThread();
+  StartScrubberThread();
   return Status::OK();
 }
 
+void PageGroupedDBImpl::StartMigrationThread() {
+  assert(mgr_.has_value());
+  if (!mgr_->HasCapacityTier() || options_.read_only ||
+      options_.tiering.migration_interval_ms == 0) {
+    return;
+  }
+  migration_thread_ =
+      std::thread(&PageGroupedDBImpl::MigrationThreadMain, this);
+}
+
+void PageGroupedDBImpl::StopMigrationThread() {
+  if (!migration_thread_.joinable()) return;
+  {
+    std::unique_lock<std::mutex> lock(migration_mutex_);
+    stop_migration_ = true;
+  }
+  migration_cv_.notify_all();
+  migration_thread_.join();
+}
+
+void PageGroupedDBImpl::StartScrubberThread() {
+  assert(mgr_.has_value());
+  if (options_.scrubber.interval_ms == 0) return;
+  scrubber_thread_ = std::thread(&PageGroupedDBImpl::ScrubberThreadMain, this);
+}
+
+void PageGroupedDBImpl::StopScrubberThread() {
+  if (!scrubber_thread_.joinable()) return;
+  {
+    std::unique_lock<std::mutex> lock(scrubber_mutex_);
+    stop_scrubber_ = true;
+  }
+  scrubber_cv_.notify_all();
+  scrubber_thread_.join();
+}
+
+void PageGroupedDBImpl::SetScrubberPaused(const bool paused) {
+  {
+    std::unique_lock<std::mutex> lock(scrubber_mutex_);
+    scrubber_paused_ = paused;
+  }
+  scrubber_cv_.notify_all();
+}
+
+void PageGroupedDBImpl::SaveHotKeys() {
+  if (!options_.persist_hot_keys || options_.bypass_cache ||
+      options_.use_in_memory_storage) {
+    return;
+  }
+  // This method runs during shutdown, so no other threads are using the cache.
+  const auto key_slices = cache_.GetHotKeys(options_.max_persisted_hot_keys);
+  std::vector<Key> keys;
+  keys.reserve(key_slices.size());
+  for (const auto& key : key_slices) {
+    keys.push_back(key_utils::ExtractHead64(key));
+  }
+  std::sort(keys.begin(), keys.end());
+  if (!WriteHotKeys(db_path_ / kHotKeysFileName, keys).ok()) {
+    // The DB still shuts down; the next open just starts with a cold cache.
+    PageGroupedDBStats::Local().BumpHotKeysSaveErrors();
+  }
+}
+
+void PageGroupedDBImpl::StartCacheWarmup() {
+  assert(mgr_.has_value());
+  if (!options_.persist_hot_keys || options_.bypass_cache) return;
+  std::vector<Key> keys;
+  if (!ReadHotKeys(db_path_ / kHotKeysFileName, &keys).ok() || keys.empty()) {
+    return;
+  }
+  warmup_thread_ = std::thread(&PageGroupedDBImpl::WarmUpCache, this,
+                               std::move(keys));
+}
+
+void PageGroupedDBImpl::WarmUpCache(const std::vector<Key>& keys) {
+  cache_.GetMasstreePointer()->thread_init(thread_id_);
+  std::string value_out;
+  uint64_t num_warmed = 0;
+  size_t i = 0;
+  while (i < keys.size() && !stop_warmup_) {
+    // The keys are sorted, so all the keys on the same page are adjacent. We
+    // read each page once and cache all of its requested records. The write
+    // out versions avoid caching records that became stale during the read.
+    const key_utils::IntKeyAsSlice first_key(keys[i]);
+    const auto key_version = cache_.GetWriteOutVersion(first_key.as<Slice>());
+    auto page_version = cache_.GetPageWriteOutVersion(first_key.as<Slice>());
+    auto [status, pages] = mgr_->GetWithPages(keys[i], &value_out);
+    if (!status.ok() && !status.IsNotFound()) {
+      // The page could not be read (e.g., it failed its checksum). Skip the
+      // keys on the page; they are cached when they are next read.
+      PageGroupedDBStats::Local().BumpCacheWarmupReadErrors();
+      const Key page_upper = mgr_->GetPageBoundsFor(keys[i]).second;
+      while (i < keys.size() && keys[i] < page_upper) ++i;
+      continue;
+    }
+    if (status.ok()) {
+      cache_.PutFromRead(first_key.as<Slice>(), Slice(value_out),
+                         RecordCache::kDefaultPriority, &key_version);
+      ++num_warmed;
+    }
+    ++i;
+    // Pages are not returned if the segment's delta log may hold newer
+    // records, so the remaining keys are read separately.
+    if (pages.empty()) continue;
+    page_version =
+        cache_.RecheckPageWriteOutVersion(first_key.as<Slice>(), page_version);
+
+    // The main page is first; its (inclusive) upper fence is the largest key
+    // it can hold.
+    const Key page_upper =
+        key_utils::ExtractHead64(pages.front().GetUpperBoundary());
+    for (; i < keys.size() && keys[i] <= page_upper; ++i) {
+      const key_utils::IntKeyAsSlice key_slice(keys[i]);
+      // The overflow page (if any) is last and holds the newest records.
+      for (auto page = pages.rbegin(); page != pages.rend(); ++page) {
+        if (!page->Get(key_slice.as<Slice>(), &value_out).ok()) continue;
+        cache_.PutFromRead(key_slice.as<Slice>(), Slice(value_out),
+                           RecordCache::kDefaultPriority, &page_version);
+        ++num_warmed;
+        break;
+      }
+    }
+  }
+  PageGroupedDBStats::Local().BumpCacheWarmupRecords(num_warmed);
+  PageGroupedDBStats::Local().PostToGlobal();
+}
+
+void PageGroupedDBImpl::MigrationThreadMain() {
+  const std::chrono::milliseconds interval(
+      options_.tiering.migration_interval_ms);
+  std::unique_lock<std::mutex> lock(migration_mutex_);
+  while (!migration_cv_.wait_for(lock, interval,
+                                 [this]() { return stop_migration_; })) {
+    lock.unlock();
+    mgr_->MigrateColdSegments();
+    // Make sure the migration stats are exposed. The local counters are reset
+    // so that they are not posted twice.
+    PageGroupedDBStats::Local().PostToGlobal();
+    PageGroupedDBStats::Local().Reset();
+    lock.lock();
+  }
+}
+
+void PageGroupedDBImpl::ScrubberThreadMain() {
+  using Clock = std::chrono::steady_clock;
+  const std::chrono::milliseconds interval(options_.scrubber.interval_ms);
+  const uint64_t max_pages_per_second = options_.scrubber.max_pages_per_second;
+
+  // Waits while the scrubber is paused. Returns false if the thread should
+  // stop. REQUIRES: `scrubber_mutex_` is held by `lock`.
+  Clock::time_point rate_start;
+  uint64_t rate_pages = 0;
+  const auto wait_while_paused = [&](std::unique_lock<std::mutex>& lock) {
+    if (scrubber_paused_) {
+      scrubber_cv_.wait(
+          lock, [this]() { return stop_scrubber_ || !scrubber_paused_; });
+      // Time spent paused does not count towards the read rate.
+      rate_start = Clock::now();
+      rate_pages = 0;
+    }
+    return !stop_scrubber_;
+  };
+
+  std::unique_lock<std::mutex> lock(scrubber_mutex_);
+  while (!scrubber_cv_.wait_for(lock, interval,
+                                [this]() { return stop_scrubber_; })) {
+    if (!wait_while_paused(lock)) break;
+    lock.unlock();
+    rate_start = Clock::now();
+    rate_pages = 0;
+    mgr_->ScrubSegments([&](const size_t pages_read) {
+      std::unique_lock<std::mutex> throttle_lock(scrubber_mutex_);
+      rate_pages += pages_read;
+      if (max_pages_per_second > 0) {
+        // Wait until the pages read so far fit within the rate limit.
+        const auto resume_at =
+            rate_start + std::chrono::microseconds(rate_pages * 1000000 /
+                                                   max_pages_per_second);
+        scrubber_cv_.wait_until(throttle_lock, resume_at,
+                                [this]() { return stop_scrubber_; });
+      }
+      return wait_while_paused(throttle_lock);
+    });
+    // Make sure the scrubber stats are exposed. The local counters are reset
+    // so that they are not posted twice.
+    PageGroupedDBStats::Local().PostToGlobal();
+    PageGroupedDBStats::Local().Reset();
+    lock.lock();
+  }
+}
+
 Status PageGroupedDBImpl::Put(const WriteOptions& options, const Key key,
                               const Slice& value) {
+  if (options_.read_only) {
+    return Status::NotSupported("Cannot write to a read-only DB.");
+  }
   if (!mgr_.has_value()) {
     return Status::NotSupported(
         "DB must be bulk loaded before any writes are allowed.");
@@ -129,6 +470,10 @@ Status PageGroupedDBImpl::Put(const WriteOptions& options, const Key key,
   if (key == Manager::kMinReservedKey || key == Manager::kMaxReservedKey) {
     return Status::InvalidArgument("Cannot Put() a reserved key.");
   }
+  if (trace_ != nullptr) {
+    trace_->Record(options.is_update ? TraceOp::kUpdate : TraceOp::kInsert, key,
+                   value.size());
+  }
   Status s;
   if (!options_.bypass_cache) {
     key_utils::IntKeyAsSlice key_slice(key);
@@ -146,6 +491,46 @@ Status PageGroupedDBImpl::Put(const WriteOptions& options, const Key key,
 }
 
 Status PageGroupedDBImpl::Get(const Key key, std::string* value_out) {
+  if (trace_ != nullptr) trace_->Record(TraceOp::kRead, key);
+  const key_utils::IntKeyAsSlice key_slice_helper(key);
+  const Slice key_slice = key_slice_helper.as<Slice>();
+  Status status;
+  if (GetWithoutIO(key, key_slice, value_out, &status)) return status;
+  return GetFromDisk(key, key_slice, value_out);
+}
+
+bool PageGroupedDBImpl::GetWithoutIO(const Key key, const Slice& key_slice,
+                                     std::string* value_out,
+                                     Status* status_out) {
+  if (!mgr_.has_value()) {
+    *status_out = Status::NotFound("DB is empty.");
+    return true;
+  }
+  cache_.GetMasstreePointer()->thread_init(thread_id_);
+  if (key == Manager::kMinReservedKey || key == Manager::kMaxReservedKey) {
+    *status_out = Status::NotFound("Reserved keys cannot be used.");
+    return true;
+  }
+  if (options_.bypass_cache) return false;
+
+  uint64_t cache_index;
+  const Status cache_status =
+      cache_.GetCacheIndex(key_slice, /*exclusive=*/false, &cache_index);
+  if (!cache_status.ok()) return false;
+  auto entry = &RecordCache::cache_entries[cache_index];
+  if (entry->IsDelete()) {
+    *status_out = Status::NotFound("Key not found.");
+  } else {
+    value_out->assign(entry->GetValue().data(), entry->GetValue().size());
+    *status_out = cache_status;
+  }
+  entry->Unlock();
+  return true;
+}
+
+Status PageGroupedDBImpl::Get(const Key key, PinnableValue* value_out) {
+  value_out->Reset();
+  if (trace_ != nullptr) trace_->Record(TraceOp::kRead, key);
   if (!mgr_.has_value()) return Status::NotFound("DB is empty.");
   cache_.GetMasstreePointer()->thread_init(thread_id_);
   if (key == Manager::kMinReservedKey || key == Manager::kMaxReservedKey) {
@@ -155,7 +540,8 @@ Status PageGroupedDBImpl::Get(const Key key, std::string* value_out) {
   const key_utils::IntKeyAsSlice key_slice_helper(key);
   const Slice key_slice = key_slice_helper.as<Slice>();
 
-  // 1. Search the record cache.
+  // 1. Search the record cache. A cached value is returned in place; the
+  // handle keeps the entry latched until it is released.
   if (!options_.bypass_cache) {
     uint64_t cache_index;
     const Status cache_status =
@@ -166,34 +552,137 @@ Status PageGroupedDBImpl::Get(const Key key, std::string* value_out) {
         entry->Unlock();
         return Status::NotFound("Key not found.");
       }
-      value_out->assign(entry->GetValue().data(), entry->GetValue().size());
-      entry->Unlock();
+      value_out->Pin(entry->GetValue(), &UnpinCacheEntry, entry);
       return cache_status;
     }
   }
 
-  // 2. Go to disk. Cache the record if found.
+  // 2. Go to disk. The value is read into the handle's buffer.
+  const Status status = GetFromDisk(key, key_slice, value_out->GetBuffer());
+  if (status.ok()) value_out->UseBuffer();
+  return status;
+}
+
+Status PageGroupedDBImpl::GetFromDisk(const Key key, const Slice& key_slice,
+                                      std::string* value_out) {
+  // Cache the record if found. The write out versions are used to avoid
+  // caching records that became stale while we read them.
+  if (!options_.bypass_cache) mgr_->RecordCacheMiss(key);
+  const auto key_version = cache_.GetWriteOutVersion(key_slice);
+  if (options_.bypass_cache || !options_.optimistic_caching) {
+    // The other records on the page are not needed, which lets the manager
+    // avoid copying the page when it can be accessed in place.
+    const Status status = mgr_->Get(key, value_out);
+    if (!status.ok() || options_.bypass_cache) return status;
+    cache_.PutFromRead(key_slice, Slice(*value_out),
+                       RecordCache::kDefaultPriority, &key_version);
+    return status;
+  }
+
+  auto page_version = cache_.GetPageWriteOutVersion(key_slice);
   auto [status, pages] = mgr_->GetWithPages(key, value_out);
-  if (!status.ok() || options_.bypass_cache) return status;
+  if (!status.ok()) return status;
 
   cache_.PutFromRead(key_slice, Slice(*value_out),
-                     RecordCache::kDefaultPriority);
-  if (options_.optimistic_caching) {
-    for (const auto& page : pages) {
-      for (auto it = page.GetIterator(); it.Valid(); it.Next()) {
-        cache_.PutFromRead(it.key(), it.value(),
-                           RecordCache::kDefaultOptimisticPriority);
-      }
+                     RecordCache::kDefaultPriority, &key_version);
+  page_version = cache_.RecheckPageWriteOutVersion(key_slice, page_version);
+  // Records that are already cached are not replaced, so the overflow page
+  // (which holds the newest records) is cached first.
+  for (auto page = pages.rbegin(); page != pages.rend(); ++page) {
+    for (auto it = page->GetIterator(); it.Valid(); it.Next()) {
+      cache_.PutFromRead(it.key(), it.value(),
+                         RecordCache::kDefaultOptimisticPriority,
+                         &page_version);
     }
   }
 
   return status;
 }
 
+void PageGroupedDBImpl::GetAsync(const Key key, GetCallback callback) {
+  if (async_threads_ == nullptr) {
+    callback(AsyncDisabledStatus(), std::string());
+    return;
+  }
+  if (trace_ != nullptr) trace_->Record(TraceOp::kRead, key);
+  // Cache hits are completed inline. The value is copied (rather than pinned)
+  // because the callback may issue other requests.
+  std::string value;
+  Status status;
+  {
+    const key_utils::IntKeyAsSlice key_slice_helper(key);
+    if (GetWithoutIO(key, key_slice_helper.as<Slice>(), &value, &status)) {
+      callback(status, std::move(value));
+      return;
+    }
+  }
+  RunAsync([this, key, callback = std::move(callback)]() {
+    cache_.GetMasstreePointer()->thread_init(thread_id_);
+    const key_utils::IntKeyAsSlice key_slice_helper(key);
+    std::string value;
+    const Status status =
+        GetFromDisk(key, key_slice_helper.as<Slice>(), &value);
+    callback(status, std::move(value));
+  });
+}
+
+void PageGroupedDBImpl::GetRangeAsync(const Key start_key,
+                                      const size_t num_records,
+                                      GetRangeCallback callback) {
+  if (async_threads_ == nullptr) {
+    callback(AsyncDisabledStatus(), {});
+    return;
+  }
+  if (!mgr_.has_value()) {
+    if (trace_ != nullptr) {
+      trace_->Record(TraceOp::kScan, start_key, /*value_size=*/0,
+                     num_records);
+    }
+    callback(Status::OK(), {});
+    return;
+  }
+  RunAsync([this, start_key, num_records, callback = std::move(callback)]() {
+    std::vector<std::pair<Key, std::string>> results;
+    const Status status = GetRange(start_key, num_records, &results);
+    callback(status, std::move(results));
+  });
+}
+
+void PageGroupedDBImpl::PutAsync(const WriteOptions& options, const Key key,
+                                 const Slice& value, PutCallback callback) {
+  if (async_threads_ == nullptr) {
+    callback(AsyncDisabledStatus());
+    return;
+  }
+  if (options_.read_only || !mgr_.has_value()) {
+    // These requests fail without I/O.
+    callback(Put(options, key, value));
+    return;
+  }
+  RunAsync([this, options, key, value = value.ToString(),
+            callback = std::move(callback)]() {
+    callback(Put(options, key, Slice(value)));
+  });
+}
+
+void PageGroupedDBImpl::RunAsync(std::function<void()> request) {
+  assert(async_threads_ != nullptr);
+  async_threads_->SubmitNoWait(std::move(request));
+}
+
+Status PageGroupedDBImpl::AsyncDisabledStatus() {
+  return Status::NotSupported(
+      "Asynchronous requests need PageGroupedDBOptions::num_async_threads > "
+      "0.");
+}
+
 Status PageGroupedDBImpl::GetRange(
     const Key start_key, const size_t num_records,
     std::vector<std::pair<Key, std::string>>* results_out,
     bool use_experimental_prefetch) {
+  if (trace_ != nullptr) {
+    trace_->Record(TraceOp::kScan, start_key, /*value_size=*/0, num_records);
+  }
   if (!mgr_.has_value()) {
     results_out->clear();
     return Status::OK();
@@ -209,10 +698,16 @@ Status PageGroupedDBImpl::GetRange(
   const Slice key_slice = key_slice_helper.as<Slice>();
 
   std::vector<std::pair<Key, std::string>> results;
-  if (use_experimental_prefetch) {
-    mgr_->ScanWithExperimentalPrefetching(start_key, num_records, &results);
+  Status status;
+  if (use_experimental_prefetch && !options_.read_only) {
+    status =
+        mgr_->ScanWithExperimentalPrefetching(start_key, num_records, &results);
   } else {
-    mgr_->Scan(start_key, num_records, &results);
+    status = mgr_->Scan(start_key, num_records, &results);
+  }
+  if (!status.ok()) {
+    results_out->clear();
+    return status;
   }
 
   std::vector<uint64_t> indices;
@@ -272,7 +767,7 @@ Status PageGroupedDBImpl::GetRange(
   return Status::OK();
 }
 
-void PageGroupedDBImpl::WriteBatch(const WriteOutBatch& records) {
+Status PageGroupedDBImpl::WriteBatch(const WriteOutBatch& records) {
   assert(mgr_.has_value());
   std::vector<std::pair<Key, Slice>> reformatted;
   reformatted.resize(records.size());
@@ -287,14 +782,20 @@ void PageGroupedDBImpl::WriteBatch(const WriteOutBatch& records) {
             [](const auto& left, const auto& right) {
               return left.first < right.first;
             });
-  mgr_->PutBatch(reformatted);
+  return mgr_->PutBatch(reformatted);
 }
 
 std::pair<Key, Key> PageGroupedDBImpl::GetPageBoundsFor(Key key) {
+  if (options_.rec_cache_segment_writeout) {
+    return mgr_->GetSegmentBoundsFor(key);
+  }
   return mgr_->GetPageBoundsFor(key);
 }
 
 Status PageGroupedDBImpl::FlattenRange(const Key start_key, const Key end_key) {
+  if (options_.read_only) {
+    return Status::NotSupported("Cannot flatten a read-only DB.");
+  }
   if (!options_.use_segments) {
     return Status::NotSupported(
         "FlattenRange() only implemented for segments.");
@@ -1,8 +1,13 @@
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
 #include <filesystem>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <vector>
 
@@ -13,6 +18,8 @@
 #include "treeline/pg_options.h"
 #include "treeline/slice.h"
 #include "util/insert_tracker.h"
+#include "util/op_trace.h"
+#include "util/thread_pool.h"
 
 namespace tl {
 namespace pg {
@@ -20,7 +27,8 @@ namespace pg {
 class PageGroupedDBImpl : public PageGroupedDB {
  public:
   PageGroupedDBImpl(std::filesystem::path db_path, PageGroupedDBOptions options,
-                    std::optional<Manager> mgr);
+                    std::optional<Manager> mgr,
+                    std::unique_ptr<OpTraceWriter> trace = nullptr);
   ~PageGroupedDBImpl() override;
 
   PageGroupedDBImpl(const PageGroupedDBImpl&) = delete;
@@ -30,18 +38,61 @@ class PageGroupedDBImpl : public PageGroupedDB {
   Status Put(const WriteOptions& options, const Key key,
              const Slice& value) override;
   Status Get(const Key key, std::string* value_out) override;
+  Status Get(const Key key, PinnableValue* value_out) override;
   Status GetRange(const Key start_key, const size_t num_records,
                   std::vector<std::pair<Key, std::string>>* results_out,
                   bool use_experimental_prefetch = false) override;
 
+  void GetAsync(const Key key, GetCallback callback) override;
+  void GetRangeAsync(const Key start_key, const size_t num_records,
+                     GetRangeCallback callback) override;
+  void PutAsync(const WriteOptions& options, const Key key, const Slice& value,
+                PutCallback callback) override;
+
   Status FlattenRange(
       const Key start_key = 1,
       const Key end_key = std::numeric_limits<Key>::max()) override;
 
+  void SetScrubberPaused(bool paused) override;
+
  private:
-  void WriteBatch(const WriteOutBatch& records);
+  Status WriteBatch(const WriteOutBatch& records);
+  // Returns true (and sets `*status_out`) if a `Get()` for `key` completes
+  // without I/O, for example because the record is in the record cache.
+  bool GetWithoutIO(Key key, const Slice& key_slice, std::string* value_out,
+                    Status* status_out);
+  // Reads the record with `key` from disk (a record cache miss) and caches it.
+  Status GetFromDisk(Key key, const Slice& key_slice, std::string* value_out);
+  // Queues `request` to run on an asynchronous request thread. There must be
+  // at least one such thread.
+  void RunAsync(std::function<void()> request);
+  // The status that asynchronous requests complete with when
+  // `PageGroupedDBOptions::num_async_threads` is 0.
+  static Status AsyncDisabledStatus();
   std::pair<Key, Key> GetPageBoundsFor(Key key);
 
+  // Periodically moves cold segments to the capacity tier (see
+  // `TieringOptions`). The thread is only started when tiering is enabled.
+  void StartMigrationThread();
+  void StopMigrationThread();
+  void MigrationThreadMain();
+
+  // Periodically checks the DB's segments for corruption (see
+  // `ScrubberOptions`). The thread is only started when the scrubber is
+  // enabled.
+  void StartScrubberThread();
+  void StopScrubberThread();
+  void ScrubberThreadMain();
+
+  // Saves the keys of the hottest cached records so that the record cache can
+  // be warmed up when the DB is reopened (see
+  // `PageGroupedDBOptions::persist_hot_keys`).
+  void SaveHotKeys();
+  // Starts a background thread that reads the records saved by
+  // `SaveHotKeys()` into the record cache.
+  void StartCacheWarmup();
+  void WarmUpCache(const std::vector<Key>& keys);
+
   std::filesystem::path db_path_;
   PageGroupedDBOptions options_;
 
@@ -51,6 +102,30 @@ class PageGroupedDBImpl : public PageGroupedDB {
   RecordCache cache_;
 
   std::shared_ptr<InsertTracker> tracker_;
+
+  // Set only if operation tracing is enabled (see
+  // `PageGroupedDBOptions::trace_path`).
+  std::unique_ptr<OpTraceWriter> trace_;
+
+  std::thread migration_thread_;
+  std::mutex migration_mutex_;
+  std::condition_variable migration_cv_;
+  // Protected by `migration_mutex_`.
+  bool stop_migration_;
+
+  std::thread scrubber_thread_;
+  std::mutex scrubber_mutex_;
+  std::condition_variable scrubber_cv_;
+  // Protected by `scrubber_mutex_`.
+  bool stop_scrubber_;
+  bool scrubber_paused_;
+
+  std::thread warmup_thread_;
+  std::atomic<bool> stop_warmup_;
+
+  // Runs asynchronous requests that need I/O. Set to `nullptr` (disabling the
+  // asynchronous methods) if `PageGroupedDBOptions::num_async_threads` is 0.
+  std::unique_ptr<ThreadPool> async_threads_;
 };
 
 }  // namespace pg
@@ -9,6 +9,7 @@
 #include <utility>
 #include <vector>
 
+#include "bench/common/perf_counters.h"
 #include "config.h"
 #include "treeline/pg_options.h"
 #include "treeline/slice.h"
@@ -24,12 +25,17 @@ class PageGroupingInterface {
  public:
   // Called once by each worker thread **before** the database is initialized.
   // Note that this method will be called concurrently by each worker thread.
-  void InitializeWorker(const std::thread::id& worker_id) {}
+  void InitializeWorker(const std::thread::id& worker_id) {
+    if (FLAGS_perf_counters) {
+      perf_counters_.BeginPhase("run");
+    }
+  }
 
   // Called once by each worker thread after it is done running. This method is
   // called concurrently by each worker thread and may run concurrently with
   // `DeleteDatabase()`.
   void ShutdownWorker(const std::thread::id& worker_id) {
+    perf_counters_.EndPhase();
     if (!pg_mgr_.has_value()) return;
 
     std::unique_lock<std::mutex> lock(mutex_);
@@ -85,6 +91,12 @@ class PageGroupingInterface {
       throw std::runtime_error(
           "DB already exists! Bulk load is not supported.");
     }
+    std::optional<bench::PerfCounterCollector::ScopedPhase> perf_phase;
+    if (FLAGS_perf_counters) {
+      perf_phase.emplace(&perf_counters_, "load");
+    }
+    bench::PerfCounterCollector::CountOps(load.size());
+
     std::vector<std::pair<ycsbr::Request::Key, Slice>> records;
     records.reserve(load.size());
     for (const auto& rec : load) {
@@ -106,6 +118,7 @@ class PageGroupingInterface {
 
   // Insert the specified key value pair. Return true if the insert succeeded.
   bool Insert(ycsbr::Request::Key key, const char* value, size_t value_size) {
+    bench::PerfCounterCollector::CountOps(1);
     write_batch_.emplace_back(key, Slice(value, value_size));
     if (write_batch_.size() >= FLAGS_write_batch_size) {
       SubmitWrites();
@@ -115,6 +128,7 @@ class PageGroupingInterface {
 
   // Read the value at the specified key. Return true if the read succeeded.
   bool Read(ycsbr::Request::Key key, std::string* value_out) {
+    bench::PerfCounterCollector::CountOps(1);
     return pg_mgr_->Get(key, value_out).ok();
   }
 
@@ -123,6 +137,7 @@ class PageGroupingInterface {
   bool Scan(
       ycsbr::Request::Key key, size_t amount,
       std::vector<std::pair<ycsbr::Request::Key, std::string>>* scan_out) {
+    bench::PerfCounterCollector::CountOps(1);
     return pg_mgr_->Scan(key, amount, scan_out).ok();
   }
 
@@ -130,6 +145,11 @@ class PageGroupingInterface {
 
   const std::vector<size_t>& GetWriteCounts() const { return write_counts_; }
 
+  // Only populated when `--perf_counters` is set.
+  const bench::PerfCounterCollector& GetPerfCounters() const {
+    return perf_counters_;
+  }
+
  private:
   PageGroupedDBOptions GetOptions() {
     PageGroupedDBOptions options;
@@ -158,6 +178,8 @@ class PageGroupingInterface {
   // Combined read/write counts from all worker threads.
   std::mutex mutex_;
   std::vector<size_t> read_counts_, write_counts_;
+
+  bench::PerfCounterCollector perf_counters_;
 };
 
 }  // namespace pg
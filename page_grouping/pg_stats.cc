@@ -14,11 +14,21 @@ void PageGroupedDBStats::PostToGlobal() const {
   global_.cache_misses_ += cache_misses_;
   global_.cache_clean_evictions_ += cache_clean_evictions_;
   global_.cache_dirty_evictions_ += cache_dirty_evictions_;
+  global_.cache_warmup_records_ += cache_warmup_records_;
+  global_.cache_warmup_read_errors_ += cache_warmup_read_errors_;
+  global_.hot_keys_save_errors_ += hot_keys_save_errors_;
+  global_.cache_deferred_write_outs_ += cache_deferred_write_outs_;
 
   global_.overflows_created_ += overflows_created_;
   global_.rewrites_ += rewrites_;
   global_.rewrite_input_pages_ += rewrite_input_pages_;
   global_.rewrite_output_pages_ += rewrite_output_pages_;
+  global_.pages_compressed_ += pages_compressed_;
+  global_.delta_pages_created_ += delta_pages_created_;
+  global_.delta_page_reads_ += delta_page_reads_;
+
+  global_.segments_migrated_ += segments_migrated_;
+  global_.pages_migrated_ += pages_migrated_;
 
   global_.segments_ = segments_;
   global_.free_list_entries_ += free_list_entries_;
@@ -28,6 +38,21 @@ void PageGroupedDBStats::PostToGlobal() const {
   global_.cache_bytes_ += cache_bytes_;
 
   global_.overfetched_pages_ += overfetched_pages_;
+  global_.page_cache_hits_ += page_cache_hits_;
+  global_.page_cache_misses_ += page_cache_misses_;
+  global_.coalesced_page_reads_ += coalesced_page_reads_;
+
+  global_.pages_verified_ += pages_verified_;
+  global_.page_checksum_failures_ += page_checksum_failures_;
+  global_.scrubbed_segments_ += scrubbed_segments_;
+  global_.scrubbed_pages_ += scrubbed_pages_;
+  global_.scrub_checksum_failures_ += scrub_checksum_failures_;
+  global_.scrub_invariant_violations_ += scrub_invariant_violations_;
+
+  global_.segment_lock_waits_ += segment_lock_waits_;
+  global_.page_lock_waits_ += page_lock_waits_;
+  global_.reorg_reader_waits_ += reorg_reader_waits_;
+  global_.write_retries_ += write_retries_;
 }
 
 void PageGroupedDBStats::Reset() {
@@ -35,11 +60,21 @@ void PageGroupedDBStats::Reset() {
   cache_misses_ = 0;
   cache_clean_evictions_ = 0;
   cache_dirty_evictions_ = 0;
+  cache_warmup_records_ = 0;
+  cache_warmup_read_errors_ = 0;
+  hot_keys_save_errors_ = 0;
+  cache_deferred_write_outs_ = 0;
 
   overflows_created_ = 0;
   rewrites_ = 0;
   rewrite_input_pages_ = 0;
   rewrite_output_pages_ = 0;
+  pages_compressed_ = 0;
+  delta_pages_created_ = 0;
+  delta_page_reads_ = 0;
+
+  segments_migrated_ = 0;
+  pages_migrated_ = 0;
 
   segments_ = 0;
   free_list_entries_ = 0;
@@ -49,6 +84,21 @@ void PageGroupedDBStats::Reset() {
   cache_bytes_ = 0;
 
   overfetched_pages_ = 0;
+  page_cache_hits_ = 0;
+  page_cache_misses_ = 0;
+  coalesced_page_reads_ = 0;
+
+  pages_verified_ = 0;
+  page_checksum_failures_ = 0;
+  scrubbed_segments_ = 0;
+  scrubbed_pages_ = 0;
+  scrub_checksum_failures_ = 0;
+  scrub_invariant_violations_ = 0;
+
+  segment_lock_waits_ = 0;
+  page_lock_waits_ = 0;
+  reorg_reader_waits_ = 0;
+  write_retries_ = 0;
 }
 
 }  // namespace pg
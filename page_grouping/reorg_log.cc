@@ -0,0 +1,98 @@
+#include "reorg_log.h"
+
+namespace tl {
+namespace pg {
+
+const char* ReorgTriggerName(const ReorgTrigger trigger) {
+  switch (trigger) {
+    case ReorgTrigger::kOverflowFull:
+      return "overflow_full";
+    case ReorgTrigger::kBatchThreshold:
+      return "batch_threshold";
+    case ReorgTrigger::kFlatten:
+      return "flatten";
+    case ReorgTrigger::kTierMigration:
+      return "tier_migration";
+  }
+  return "unknown";
+}
+
+ReorgLog::ReorgLog(size_t capacity,
+                   std::optional<std::filesystem::path> csv_path)
+    : capacity_(capacity),
+      epoch_(std::chrono::steady_clock::now()),
+      next_(0),
+      num_recorded_(0) {
+  if (!csv_path.has_value()) return;
+  const bool write_header = !std::filesystem::exists(*csv_path) ||
+                            std::filesystem::file_size(*csv_path) == 0;
+  sink_.open(*csv_path, std::ios::out | std::ios::app);
+  if (write_header) {
+    PrintCsvHeader(sink_);
+  }
+}
+
+void ReorgLog::Record(const ReorgEvent& event) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  ++num_recorded_;
+  if (sink_.is_open()) {
+    // Reorgs already issue many page I/Os, so flushing each event is cheap in
+    // comparison and keeps the file usable while the DB is still running.
+    PrintEventAsCsv(sink_, event);
+    sink_.flush();
+  }
+  if (capacity_ == 0) return;
+  if (events_.size() < capacity_) {
+    events_.push_back(event);
+  } else {
+    events_[next_] = event;
+    next_ = (next_ + 1) % capacity_;
+  }
+}
+
+std::vector<ReorgEvent> ReorgLog::GetEvents() const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  std::vector<ReorgEvent> events;
+  events.reserve(events_.size());
+  // When the buffer has wrapped around, `next_` points to the oldest event.
+  events.insert(events.end(), events_.begin() + next_, events_.end());
+  events.insert(events.end(), events_.begin(), events_.begin() + next_);
+  return events;
+}
+
+uint64_t ReorgLog::NumRecorded() const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return num_recorded_;
+}
+
+void ReorgLog::PrintAsCsv(std::ostream& out) const {
+  const auto events = GetEvents();
+  PrintCsvHeader(out);
+  for (const auto& event : events) {
+    PrintEventAsCsv(out, event);
+  }
+}
+
+void ReorgLog::PrintCsvHeader(std::ostream& out) {
+  out << "start_us,trigger,lower,upper,segments_in,segments_out,pages_read,"
+         "pages_written,records_merged,forecasted_inserts,"
+         "records_per_page_goal,lock_wait_us,duration_us"
+      << std::endl;
+}
+
+void ReorgLog::PrintEventAsCsv(std::ostream& out,
+                               const ReorgEvent& event) const {
+  using std::chrono::duration_cast;
+  using std::chrono::microseconds;
+  out << duration_cast<microseconds>(event.start - epoch_).count() << ","
+      << ReorgTriggerName(event.trigger) << "," << event.lower << ","
+      << event.upper << "," << event.segments_in << "," << event.segments_out
+      << "," << event.pages_read << "," << event.pages_written << ","
+      << event.records_merged << "," << event.forecasted_inserts << ","
+      << event.records_per_page_goal << ","
+      << duration_cast<microseconds>(event.lock_wait).count() << ","
+      << duration_cast<microseconds>(event.duration).count() << "\n";
+}
+
+}  // namespace pg
+}  // namespace tl
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <vector>
+
+#include "key.h"
+
+namespace tl {
+namespace pg {
+
+// The reason a reorganization (segment rewrite or chain flatten) ran.
+enum class ReorgTrigger : uint8_t {
+  // A write did not fit into a page and its overflow page was already full (or
+  // overflow creation is disabled).
+  kOverflowFull = 0,
+  // A write batch to a single segment exceeded the reorg threshold
+  // (`records_per_page_goal` x `pages_in_segment` x 2).
+  kBatchThreshold = 1,
+  // An explicit `FlattenRange()` request.
+  kFlatten = 2,
+  // A cold segment was moved to the capacity tier (see `TieringOptions`).
+  kTierMigration = 3,
+};
+
+const char* ReorgTriggerName(ReorgTrigger trigger);
+
+// Describes one completed reorganization (one `RewriteSegmentsImpl()` or
+// `FlattenChain()` call). Aborted reorgs (e.g., due to an intervening reorg)
+// are not recorded.
+struct ReorgEvent {
+  ReorgTrigger trigger = ReorgTrigger::kOverflowFull;
+
+  // The key range covered by the reorg, `[lower, upper)`.
+  Key lower = 0;
+  Key upper = 0;
+
+  // Number of segments (or pages in page chain mode) replaced by the reorg and
+  // the number of segments (pages) that replaced them.
+  uint64_t segments_in = 0;
+  uint64_t segments_out = 0;
+
+  // Number of pages read (including overflows) and written (including
+  // invalidations of the old segments and overflows).
+  uint64_t pages_read = 0;
+  uint64_t pages_written = 0;
+
+  // Number of in-memory records merged in by the reorg.
+  uint64_t records_merged = 0;
+
+  // The forecasted number of future inserts into the key range that was used
+  // to size the new segments (0 if forecasting was not used), along with the
+  // resulting records per page goal.
+  double forecasted_inserts = 0;
+  uint64_t records_per_page_goal = 0;
+
+  // When the reorg started (before acquiring any locks), the time spent waiting
+  // to acquire and upgrade segment locks, and the total time taken.
+  std::chrono::steady_clock::time_point start;
+  std::chrono::nanoseconds lock_wait{0};
+  std::chrono::nanoseconds duration{0};
+};
+
+// Keeps the most recent `capacity` reorg events in memory and optionally
+// appends every event to a CSV file. This class' methods are thread-safe.
+class ReorgLog {
+ public:
+  // If `csv_path` is provided, events are also appended to this file (the CSV
+  // header is written if the file is empty).
+  ReorgLog(size_t capacity, std::optional<std::filesystem::path> csv_path);
+
+  void Record(const ReorgEvent& event);
+
+  // Returns the events currently in the ring buffer in the order they were
+  // recorded (oldest first).
+  std::vector<ReorgEvent> GetEvents() const;
+
+  // The total number of events recorded (including ones that have since been
+  // evicted from the ring buffer).
+  uint64_t NumRecorded() const;
+
+  // Writes the events currently in the ring buffer as CSV (with a header).
+  void PrintAsCsv(std::ostream& out) const;
+
+  static void PrintCsvHeader(std::ostream& out);
+
+ private:
+  void PrintEventAsCsv(std::ostream& out, const ReorgEvent& event) const;
+
+  mutable std::mutex mutex_;
+  const size_t capacity_;
+  // Event start times are reported relative to this time point.
+  const std::chrono::steady_clock::time_point epoch_;
+  std::vector<ReorgEvent> events_;
+  // The index in `events_` that the next event will overwrite (once
+  // `events_` is full).
+  size_t next_;
+  uint64_t num_recorded_;
+  std::ofstream sink_;
+};
+
+}  // namespace pg
+}  // namespace tl
@@ -0,0 +1,81 @@
+#include "segment_access_tracker.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace tl {
+namespace pg {
+
+SegmentAccessTracker::SegmentAccessTracker(const size_t sample_interval)
+    : sample_interval_(sample_interval) {
+  if (sample_interval_ == 0) {
+    throw std::runtime_error("The access sample interval must be positive.");
+  }
+}
+
+size_t SegmentAccessTracker::ThreadStripe() {
+  static std::atomic<size_t> next_stripe(0);
+  thread_local const size_t stripe =
+      next_stripe.fetch_add(1, std::memory_order_relaxed) % kNumStripes;
+  return stripe;
+}
+
+void SegmentAccessTracker::Add(const Key segment_base,
+                               const SegmentAccessType type,
+                               const uint64_t amount) {
+  SegmentAccessCounts counts;
+  counts.Bump(type, amount);
+  counts_.upsert(
+      segment_base,
+      [type, amount](SegmentAccessCounts& existing) {
+        existing.Bump(type, amount);
+      },
+      counts);
+}
+
+void SegmentAccessTracker::Move(const Key from, const Key to) {
+  if (from == to) return;
+  SegmentAccessCounts counts;
+  const bool found = counts_.erase_fn(from, [&counts](auto& existing) {
+    counts = existing;
+    return true;
+  });
+  if (!found) return;
+  counts_.upsert(
+      to, [&counts](SegmentAccessCounts& existing) { existing += counts; },
+      counts);
+}
+
+std::vector<std::pair<Key, SegmentAccessCounts>>
+SegmentAccessTracker::Snapshot() const {
+  std::vector<std::pair<Key, SegmentAccessCounts>> snapshot;
+  {
+    const auto locked = counts_.lock_table();
+    snapshot.reserve(locked.size());
+    for (const auto& entry : locked) {
+      snapshot.emplace_back(entry.first, entry.second);
+    }
+  }
+  std::sort(snapshot.begin(), snapshot.end(),
+            [](const auto& left, const auto& right) {
+              return left.first < right.first;
+            });
+  return snapshot;
+}
+
+void SegmentAccessTracker::Clear() { counts_.clear(); }
+
+void PrintAccessHeatmapAsCsv(std::ostream& out,
+                             const std::vector<SegmentAccessStats>& heatmap) {
+  out << "lower,upper,page_count,reads,writes,overflow_hits,cache_misses"
+      << std::endl;
+  for (const auto& seg : heatmap) {
+    out << seg.lower << "," << seg.upper << "," << seg.page_count << ","
+        << seg.counts.reads << "," << seg.counts.writes << ","
+        << seg.counts.overflow_hits << "," << seg.counts.cache_misses
+        << std::endl;
+  }
+}
+
+}  // namespace pg
+}  // namespace tl
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+#include "key.h"
+#include "libcuckoo/cuckoohash_map.hh"
+
+namespace tl {
+namespace pg {
+
+enum class SegmentAccessType : uint8_t {
+  kRead = 0,
+  kWrite = 1,
+  kOverflowHit = 2,
+  kCacheMiss = 3,
+};
+
+// Access counters for a single segment.
+struct SegmentAccessCounts {
+  // Read requests served by the segment (point reads and scans).
+  uint64_t reads = 0;
+  // Records written into the segment.
+  uint64_t writes = 0;
+  // Accesses that needed to read or write the segment's overflow page(s).
+  uint64_t overflow_hits = 0;
+  // Point reads that missed the record cache and were sent to the segment.
+  uint64_t cache_misses = 0;
+
+  uint64_t Total() const {
+    return reads + writes + overflow_hits + cache_misses;
+  }
+
+  void Bump(SegmentAccessType type, uint64_t amount) {
+    switch (type) {
+      case SegmentAccessType::kRead:
+        reads += amount;
+        break;
+      case SegmentAccessType::kWrite:
+        writes += amount;
+        break;
+      case SegmentAccessType::kOverflowHit:
+        overflow_hits += amount;
+        break;
+      case SegmentAccessType::kCacheMiss:
+        cache_misses += amount;
+        break;
+    }
+  }
+
+  SegmentAccessCounts& operator+=(const SegmentAccessCounts& other) {
+    reads += other.reads;
+    writes += other.writes;
+    overflow_hits += other.overflow_hits;
+    cache_misses += other.cache_misses;
+    return *this;
+  }
+
+  SegmentAccessCounts& operator*=(uint64_t factor) {
+    reads *= factor;
+    writes *= factor;
+    overflow_hits *= factor;
+    cache_misses *= factor;
+    return *this;
+  }
+};
+
+// The (estimated) accesses to a segment currently in the index.
+struct SegmentAccessStats {
+  // The segment's key boundaries. Lower is inclusive; upper is exclusive.
+  Key lower, upper;
+  size_t page_count;
+  SegmentAccessCounts counts;
+};
+
+// Writes `heatmap` as CSV (with a header), one row per segment.
+void PrintAccessHeatmapAsCsv(std::ostream& out,
+                             const std::vector<SegmentAccessStats>& heatmap);
+
+// Keeps sampled per-segment access counters, keyed by the segment's base key.
+// Only one out of every `sample_interval` accesses is recorded, so the counters
+// must be scaled by `sample_interval()` to estimate the true number of
+// accesses. Each tracker keeps its own sampling counters, which are striped
+// across threads to avoid contention.
+//
+// When a reorganization replaces a segment, its counters should be moved to
+// the new segment that contains its base key (see `Move()`), so that the
+// tracker holds at most one entry per segment. Counters can still be added
+// for a replaced segment by a racing access, so callers should attribute each
+// base key to the segment that currently contains it (see
+// `Manager::GetAccessHeatmap()`).
+//
+// This class' methods are thread-safe.
+class SegmentAccessTracker {
+ public:
+  // `sample_interval` must be positive.
+  explicit SegmentAccessTracker(size_t sample_interval);
+
+  // Returns true iff the calling thread should record its next access.
+  bool ShouldSample() {
+    const uint64_t count = counters_[ThreadStripe()].value.fetch_add(
+        1, std::memory_order_relaxed);
+    return count % sample_interval_ == 0;
+  }
+
+  void Add(Key segment_base, SegmentAccessType type, uint64_t amount);
+
+  // Adds the counters of `from` to the counters of `to` and removes `from`.
+  // Does nothing if `from` has no counters or `from == to`.
+  void Move(Key from, Key to);
+
+  // Returns the raw (unscaled) counters sorted by segment base key.
+  std::vector<std::pair<Key, SegmentAccessCounts>> Snapshot() const;
+
+  void Clear();
+
+  // The number of segment base keys with counters.
+  size_t size() const { return counts_.size(); }
+
+  size_t sample_interval() const { return sample_interval_; }
+
+ private:
+  static constexpr size_t kNumStripes = 16;
+  // The stripe of the sampling counters used by the calling thread.
+  static size_t ThreadStripe();
+
+  struct alignas(64) Counter {
+    std::atomic<uint64_t> value{0};
+  };
+
+  const size_t sample_interval_;
+  mutable libcuckoo::cuckoohash_map<Key, SegmentAccessCounts> counts_;
+
+  // The number of accesses made so far, per stripe. The first access in each
+  // stripe is recorded.
+  std::array<Counter, kNumStripes> counters_;
+};
+
+}  // namespace pg
+}  // namespace tl
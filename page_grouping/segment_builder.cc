@@ -7,6 +7,7 @@
 #include "plr/data.h"
 #include "plr/greedy.h"
 #include "plr/pgm.h"
+#include "segment_info.h"
 
 namespace tl {
 namespace pg {
@@ -156,13 +157,12 @@ std::vector<Segment> SegmentBuilder::Offer(std::pair<Key, Slice> record) {
     }
 
     const size_t segment_size = SegmentPageCounts()[segment_size_idx];
+    const plr::Line64 page_model = PageModelFor(*line);
     const size_t actual_records_in_segment =
-        ComputeNumRecordsInSegment(*line, segment_size_idx);
+        ComputeNumRecordsInSegment(page_model, segment_size);
 
     // start_x/end_x are unused, so we put dummy values.
-    auto model =
-        plr::BoundedLine64(line->line().Rescale(records_per_page_goal_),
-                           /*start_x=*/0, /*end_x=*/1);
+    auto model = plr::BoundedLine64(page_model, /*start_x=*/0, /*end_x=*/1);
     std::vector<Segment> segments = {
         CreateSegmentUsing(std::move(model), /*page_count=*/segment_size,
                            actual_records_in_segment)};
@@ -224,13 +224,12 @@ std::vector<Segment> SegmentBuilder::Finish() {
     }
 
     const size_t segment_size = SegmentPageCounts()[segment_size_idx];
+    const plr::Line64 page_model = PageModelFor(*line);
     const size_t actual_records_in_segment =
-        ComputeNumRecordsInSegment(*line, segment_size_idx);
+        ComputeNumRecordsInSegment(page_model, segment_size);
 
     // start_x/end_x are unused, so we put dummy values.
-    auto model =
-        plr::BoundedLine64(line->line().Rescale(records_per_page_goal_),
-                           /*start_x=*/0, /*end_x=*/1);
+    auto model = plr::BoundedLine64(page_model, /*start_x=*/0, /*end_x=*/1);
     std::vector<Segment> segments = {CreateSegmentUsing(
         std::move(model),
         /*page_count=*/segment_size, actual_records_in_segment)};
@@ -304,26 +303,30 @@ int SegmentBuilder::ComputeSegmentSizeIndex(
   return segment_size_idx;
 }
 
+plr::Line64 SegmentBuilder::PageModelFor(
+    const plr::BoundedLine64& model) const {
+  // The index stores quantized models (see `SegmentInfo`), so the quantized
+  // model is used to both size the segment and place its records.
+  return SegmentInfo::QuantizeModel(
+      model.line().Rescale(records_per_page_goal_));
+}
+
 size_t SegmentBuilder::ComputeNumRecordsInSegment(
-    const plr::BoundedLine64& model, const int segment_size_idx) const {
+    const plr::Line64& page_model, const size_t segment_size) const {
   // Compute how many records can we actually fit in the segment based on the
   // model.
-  const size_t segment_size = SegmentPageCounts()[segment_size_idx];
   assert(segment_size > 1);
 
-  const size_t records_in_segment =
-      allowed_records_per_segment_[segment_size_idx];
-
-  // Use the model to determine how many records to place in the segment,
-  // based on the desired goal. We use binary search against the model to
-  // minimize the effect of precision errors.
+  // Use the model to determine how many records to place in the segment: the
+  // records that it maps to one of the segment's pages. We use binary search
+  // against the model to minimize the effect of precision errors.
   const auto cutoff_it = std::lower_bound(
-      processed_records_.begin(), processed_records_.end(), records_in_segment,
-      [this, &model](const std::pair<Key, Slice>& rec,
-                     const size_t recs_in_segment) {
+      processed_records_.begin(), processed_records_.end(), segment_size,
+      [this, &page_model](const std::pair<Key, Slice>& rec,
+                          const size_t pages_in_segment) {
         const Key key_a = rec.first;
-        const auto pos_a = model.line()(key_a - base_key_);
-        return pos_a < recs_in_segment;
+        const auto page_a = page_model(key_a - base_key_);
+        return page_a < pages_in_segment;
       });
   assert(cutoff_it != processed_records_.begin());
   const size_t actual_records_in_segment =
@@ -337,6 +340,7 @@ Segment SegmentBuilder::CreateSegmentUsing(
   Segment s;
   s.base_key = base_key_;
   s.page_count = page_count;
+  // Models are already quantized (see `PageModelFor()`).
   s.model = std::move(model);
   s.records.reserve(std::min(num_records, processed_records_.size()));
   for (size_t i = 0; i < num_records && !processed_records_.empty(); ++i) {
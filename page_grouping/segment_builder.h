@@ -64,8 +64,9 @@ class SegmentBuilder {
   std::vector<Segment> DrainRemainingRecordsAndReset(
       std::vector<Segment> to_return);
   int ComputeSegmentSizeIndex(const plr::BoundedLine64& model) const;
-  size_t ComputeNumRecordsInSegment(const plr::BoundedLine64& model,
-                                    const int segment_size_idx) const;
+  plr::Line64 PageModelFor(const plr::BoundedLine64& model) const;
+  size_t ComputeNumRecordsInSegment(const plr::Line64& page_model,
+                                    const size_t segment_size) const;
   Segment CreateSegmentUsing(std::optional<plr::BoundedLine64> model,
                              size_t page_count, size_t num_records);
 
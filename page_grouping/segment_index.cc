@@ -3,6 +3,7 @@
 #include <algorithm>
 
 #include "rand_exp_backoff.h"
+#include "treeline/pg_stats.h"
 
 namespace {
 
@@ -38,6 +39,7 @@ SegmentIndex::Entry SegmentIndex::SegmentForKeyWithLock(
         return IndexIteratorToEntry(it);
       }
     }
+    PageGroupedDBStats::Local().BumpSegmentLockWaits();
     backoff.Wait();
   }
 }
@@ -53,6 +55,19 @@ std::optional<SegmentIndex::Entry> SegmentIndex::NextSegmentForKey(
   return IndexIteratorToEntry(it);
 }
 
+SegmentIndex::Entry SegmentIndex::SegmentForKeyUnlatched(const Key key) const {
+  return IndexIteratorToEntry(SegmentForKeyImpl(key));
+}
+
+std::optional<SegmentIndex::Entry> SegmentIndex::NextSegmentForKeyUnlatched(
+    const Key key) const {
+  const auto it = index_.upper_bound(key);
+  if (it == index_.end()) {
+    return std::optional<Entry>();
+  }
+  return IndexIteratorToEntry(it);
+}
+
 std::optional<SegmentIndex::Entry> SegmentIndex::NextSegmentForKeyWithLock(
     const Key key, LockManager::SegmentMode mode) const {
   RandExpBackoff backoff(kBackoffSaturate);
@@ -70,6 +85,7 @@ std::optional<SegmentIndex::Entry> SegmentIndex::NextSegmentForKeyWithLock(
         return IndexIteratorToEntry(it);
       }
     }
+    PageGroupedDBStats::Local().BumpSegmentLockWaits();
     backoff.Wait();
   }
 }
@@ -188,6 +204,7 @@ bool SegmentIndex::LockSegmentsForRewrite(
       lock_granted = lock_manager_->TryAcquireSegmentLock(
           seg.sinfo.id(), LockManager::SegmentMode::kReorg);
       if (lock_granted) break;
+      PageGroupedDBStats::Local().BumpSegmentLockWaits();
       backoff.Wait();
     }
 
@@ -281,6 +298,16 @@ SegmentIndex::Entry SegmentIndex::IndexIteratorToEntry(
   return entry;
 }
 
+std::vector<SegmentIndex::Entry> SegmentIndex::GetAllSegments() const {
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  std::vector<Entry> segments;
+  segments.reserve(index_.size());
+  for (auto it = index_.begin(); it != index_.end(); ++it) {
+    segments.push_back(IndexIteratorToEntry(it));
+  }
+  return segments;
+}
+
 uint64_t SegmentIndex::GetSizeFootprint() const {
   std::shared_lock<std::shared_mutex> lock(mutex_);
   return bytes_allocated_ + sizeof(*this);
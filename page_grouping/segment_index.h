@@ -4,6 +4,7 @@
 #include <optional>
 #include <shared_mutex>
 #include <utility>
+#include <vector>
 
 #include "treeline/pg_db.h"
 #include "lock_manager.h"
@@ -64,6 +65,12 @@ class SegmentIndex {
   Entry SegmentForKey(const Key key) const;
   std::optional<Entry> NextSegmentForKey(const Key key) const;
 
+  // Similar to the methods above, but does not acquire the index latch either.
+  // These are only safe to use when the index is never modified (i.e., when
+  // the DB was opened in read-only mode).
+  Entry SegmentForKeyUnlatched(const Key key) const;
+  std::optional<Entry> NextSegmentForKeyUnlatched(const Key key) const;
+
   // Find a contiguous segment range to rewrite and acquire locks in `kReorg`
   // mode on the segments. If the returned vector is empty, the caller must
   // retry the call.
@@ -91,6 +98,10 @@ class SegmentIndex {
     c(index_);
   }
 
+  // Returns a snapshot of all the segments in the index, in key order. No
+  // segment locks are acquired.
+  std::vector<Entry> GetAllSegments() const;
+
   uint64_t GetSizeFootprint() const;
   uint64_t GetNumEntries() const;
 
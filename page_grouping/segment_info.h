@@ -1,6 +1,9 @@
 #pragma once
 
+#include <cmath>
+#include <limits>
 #include <optional>
+#include <stdexcept>
 
 #include "key.h"
 #include "persist/segment_id.h"
@@ -11,11 +14,43 @@ namespace pg {
 
 class SegmentInfo {
  public:
+  // `model` must be exactly representable using `float`s (see
+  // `CanStoreExactly()`).
   SegmentInfo(SegmentId id, std::optional<plr::Line64> model)
-      : raw_id_(id.value() & kSegmentIdMask), model_(model) {}
+      : raw_id_(id.value() & kSegmentIdMask),
+        slope_(kNoModel),
+        intercept_(0.0f) {
+    if (!model.has_value()) return;
+    if (!CanStoreExactly(*model)) {
+      throw std::runtime_error(
+          "SegmentInfo: The segment's model cannot be stored exactly.");
+    }
+    slope_ = static_cast<float>(model->slope());
+    intercept_ = static_cast<float>(model->intercept());
+  }
 
   // Represents an invalid `SegmentInfo`.
-  SegmentInfo() : raw_id_(kInvalidSegmentId) {}
+  SegmentInfo()
+      : raw_id_(kInvalidSegmentId), slope_(kNoModel), intercept_(0.0f) {}
+
+  // Rounds `model`'s parameters to the nearest `float`s. Segment models are
+  // quantized when they are created so that the index can store them compactly
+  // while still mapping keys to exactly the same pages.
+  static plr::Line64 QuantizeModel(const plr::Line64& model) {
+    // N.B. GCC 12 at -O2 and above can vectorize the two round trips through
+    // `float` and then drop them, returning `model` unchanged. Forcing the
+    // rounded values through memory prevents that.
+    const volatile float slope = static_cast<float>(model.slope());
+    const volatile float intercept = static_cast<float>(model.intercept());
+    return plr::Line64(slope, intercept);
+  }
+
+  // Returns true iff `model` can be stored without changing the pages it maps
+  // keys to (i.e., it was quantized). Models written by builds that did not
+  // quantize them generally cannot.
+  static bool CanStoreExactly(const plr::Line64& model) {
+    return QuantizeModel(model) == model;
+  }
 
   SegmentId id() const {
     return raw_id_ == kInvalidSegmentId ? SegmentId()
@@ -24,16 +59,20 @@ class SegmentInfo {
 
   size_t page_count() const { return 1ULL << id().GetFileId(); }
 
-  const std::optional<plr::Line64>& model() const { return model_; }
+  std::optional<plr::Line64> model() const {
+    if (std::isnan(slope_)) return std::optional<plr::Line64>();
+    return plr::Line64(slope_, intercept_);
+  }
 
   size_t PageForKey(Key base_key, Key candidate) const {
     const size_t pages = page_count();
     if (pages == 1) return 0;
-    return pg::PageForKey(base_key, *model_, pages, candidate);
+    return pg::PageForKey(base_key, plr::Line64(slope_, intercept_), pages,
+                          candidate);
   }
 
   bool operator==(const SegmentInfo& other) const {
-    return raw_id_ == other.raw_id_ && model_ == other.model_;
+    return raw_id_ == other.raw_id_ && model() == other.model();
   }
 
   void SetOverflow(bool overflow) {
@@ -51,12 +90,18 @@ class SegmentInfo {
   // overflow. The remaining 63 bits hold the `SegmentId` value. If all 63 bits
   // are set to 1, we assume the ID is invalid.
   size_t raw_id_;
-  std::optional<plr::Line64> model_;
+  // The segment's model (y = slope_ * x + intercept_). `slope_` is NaN if the
+  // segment does not have a model.
+  float slope_, intercept_;
 
   static constexpr size_t kHasOverflowMask = (1ULL << 63);
   static constexpr size_t kSegmentIdMask = ~(kHasOverflowMask);
   static constexpr size_t kInvalidSegmentId = kSegmentIdMask;
+  static constexpr float kNoModel = std::numeric_limits<float>::quiet_NaN();
 };
 
+// Each `SegmentIndex` entry stores a `SegmentInfo`, so it should stay small.
+static_assert(sizeof(SegmentInfo) == 16);
+
 }  // namespace pg
 }  // namespace tl
@@ -1,5 +1,8 @@
 #include "record_cache.h"
 
+#include <algorithm>
+#include <string_view>
+
 #include "treeline/pg_stats.h"
 
 namespace tl {
@@ -7,12 +10,17 @@ namespace tl {
 std::vector<RecordCacheEntry> RecordCache::cache_entries{};
 
 RecordCache::RecordCache(const uint64_t capacity, bool use_lru,
-                         WriteOutFn write_out, KeyBoundsFn key_bounds)
+                         WriteOutFn write_out, KeyBoundsFn key_bounds,
+                         const size_t deferred_io_batch_size,
+                         const uint8_t deferred_io_max_deferrals)
     : capacity_(capacity),
       use_lru_(use_lru),
       clock_(0),
       write_out_(std::move(write_out)),
-      key_bounds_(std::move(key_bounds)) {
+      key_bounds_(std::move(key_bounds)),
+      deferred_io_batch_size_(deferred_io_batch_size),
+      deferred_io_max_deferrals_(deferred_io_max_deferrals) {
+  assert(deferred_io_max_deferrals_ <= RecordCacheEntry::kMaxDeferrals);
   tree_ = std::make_shared<MasstreeWrapper<RecordCacheEntry>>();
   cache_entries.resize(capacity_);
   if (use_lru_) {
@@ -39,7 +47,7 @@ RecordCache::~RecordCache() {
 
 Status RecordCache::Put(const Slice& key, const Slice& value, bool is_dirty,
                         format::WriteType write_type, uint8_t priority,
-                        bool safe) {
+                        bool safe, const WriteOutVersion* read_version) {
 retry:
   uint64_t index;
 #ifndef NDEBUG
@@ -58,17 +66,32 @@ retry:
 
   // If this key is not cached, need to make room by evicting first.
   if (!found) {
-    index = SelectForEviction();
-    entry = &cache_entries[index];
-    if (safe) entry->Lock(/*exclusive = */ true);
-    if (entry->IsValid()) {
+    while (true) {
+      index = SelectForEviction();
+      entry = &cache_entries[index];
+      if (safe) entry->Lock(/*exclusive = */ true);
+      if (!entry->IsValid()) break;
+      if (entry->IsDirty() && DeferWriteOut(index)) {
+        // Keep the dirty record and pick a different entry to evict. This
+        // terminates because each record can only be deferred a bounded
+        // number of times.
+        if (safe) entry->Unlock();
+        continue;
+      }
       if (entry->IsDirty()) {
         pg::PageGroupedDBStats::Local().BumpCacheDirtyEvictions();
       } else {
         pg::PageGroupedDBStats::Local().BumpCacheCleanEvictions();
       }
-      WriteOutIfDirty(index);
+      const Status status = WriteOutIfDirty(index);
+      if (!status.ok()) {
+        // The dirty record could not be written out, so it cannot be evicted.
+        if (use_lru_) lru_queue_->MoveToBack(index);
+        if (safe) entry->Unlock();
+        return status;
+      }
       tree_->remove_value(entry->GetKey().data(), entry->GetKey().size());
+      break;
     }
   } else {
     entry = &cache_entries[index];
@@ -100,6 +123,7 @@ retry:
 
   // Update metadata.
   entry->SetValidTo(true);
+  if (!found || !entry->IsDirty()) entry->SetDeferralsTo(0);
   entry->SetDirtyTo(found ? (is_dirty || entry->IsDirty()) : (is_dirty));
   if (is_dirty) entry->SetWriteType(write_type);
   entry->SetPriorityTo(priority);
@@ -108,7 +132,11 @@ retry:
     bool success = tree_->insert_value(key.data(), key.size(), entry);
 
     if (!success) {  // Another thread cached the same key concurrently.
-      // Set this cache entry up for eviction.
+      // Set this cache entry up for eviction. It must also be invalidated
+      // because it is not in the tree; evicting a valid entry removes its key
+      // from the tree, which would orphan the other thread's entry.
+      FreeIfValid(index);
+      entry->SetValidTo(false);
       entry->SetDirtyTo(false);
       entry->SetPriorityTo(0);
       if (safe) entry->Unlock();
@@ -120,6 +148,20 @@ retry:
       // Otherwise, we need to retry this write.
       goto retry;
     }
+
+    // A write out completed after the record was read, so `value` may be
+    // stale. Writers that raced with this insert are waiting for the entry
+    // lock; they will retry after seeing that the entry is invalid.
+    if (read_version != nullptr &&
+        (read_version->counter == nullptr ||
+         read_version->counter->load() != read_version->value)) {
+      tree_->remove_value(key.data(), key.size());
+      FreeIfValid(index);
+      entry->SetValidTo(false);
+      entry->SetPriorityTo(0);
+      if (safe) entry->Unlock();
+      return Status::OK();
+    }
   }
 
   if (safe) entry->Unlock();
@@ -128,9 +170,49 @@ retry:
 }
 
 Status RecordCache::PutFromRead(const Slice& key, const Slice& value,
-                                uint8_t priority) {
+                                uint8_t priority,
+                                const WriteOutVersion* read_version) {
   return Put(key, value, /*is_dirty = */ false,
-             /*** ignored */ format::WriteType::kWrite /***/, priority);
+             /*** ignored */ format::WriteType::kWrite /***/, priority,
+             /*safe = */ true, read_version);
+}
+
+RecordCache::WriteOutVersion RecordCache::GetWriteOutVersion(
+    const Slice& key) const {
+  const auto& counter =
+      key_write_out_versions_[WriteOutVersionStripe(key)].value;
+  return {&counter, counter.load()};
+}
+
+RecordCache::WriteOutVersion RecordCache::GetPageWriteOutVersion(
+    const Slice& key) const {
+  if (!key_bounds_) return {nullptr, 0};
+  const auto bounds = key_bounds_(key_utils::ExtractHead64(key));
+  const auto& counter =
+      page_write_out_versions_[PageVersionStripe(bounds)].value;
+  return {&counter, counter.load(), bounds};
+}
+
+RecordCache::WriteOutVersion RecordCache::RecheckPageWriteOutVersion(
+    const Slice& key, const WriteOutVersion version) const {
+  if (version.counter == nullptr ||
+      key_bounds_(key_utils::ExtractHead64(key)) != version.page_bounds) {
+    return {nullptr, 0};
+  }
+  return version;
+}
+
+size_t RecordCache::WriteOutVersionStripe(const Slice& key) {
+  return std::hash<std::string_view>{}(
+             std::string_view(key.data(), key.size())) %
+         kWriteOutVersionStripes;
+}
+
+size_t RecordCache::PageVersionStripe(
+    const std::pair<key_utils::KeyHead, key_utils::KeyHead>& bounds) {
+  return std::hash<key_utils::KeyHead>{}(bounds.first ^
+                                         (bounds.second * 0x9E3779B97F4A7C15)) %
+         kWriteOutVersionStripes;
 }
 
 Status RecordCache::GetCacheIndex(const Slice& key, bool exclusive,
@@ -144,7 +226,16 @@ Status RecordCache::GetCacheIndex(const Slice& key, bool exclusive,
       pg::PageGroupedDBStats::Local().BumpCacheMisses();
       return Status::NotFound("Key not in cache");
     }
-    if (safe) locked_successfully = entry->TryLock(exclusive);
+    if (safe) {
+      locked_successfully = entry->TryLock(exclusive);
+      // The entry may have been evicted (and reused for a different key)
+      // between the lookup and the lock acquisition.
+      if (locked_successfully &&
+          (!entry->IsValid() || entry->GetKey().compare(key) != 0)) {
+        entry->Unlock();
+        locked_successfully = false;
+      }
+    }
   } while (!locked_successfully && safe);
 
   *index_out = entry->FindIndexWithin(&cache_entries);
@@ -188,7 +279,7 @@ uint64_t RecordCache::WriteOutDirty() {
     if (!cache_entries[i].IsDirty()) continue;
 
     cache_entries[i].Lock(/*exclusive = */ false);
-    count += WriteOutIfDirty(i);
+    WriteOutIfDirty(i, &count);
     cache_entries[i].Unlock();
   }
   return count;
@@ -234,15 +325,15 @@ uint64_t RecordCache::SelectForEviction() {
   return candidate;
 }
 
-uint64_t RecordCache::WriteOutIfDirty(uint64_t index) {
+Status RecordCache::WriteOutIfDirty(uint64_t index, uint64_t* num_written) {
   // Do nothing if not dirty, or if using a standalone record cache.
   auto entry = &cache_entries[index];
-  bool was_dirty = entry->IsDirty();
-  if (!was_dirty) return 0;
+  if (!entry->IsDirty()) return Status::OK();
   if (!write_out_) {
     // Skip the write out because a write out function was not provided.
     entry->SetDirtyTo(false);
-    return was_dirty;
+    if (num_written != nullptr) ++(*num_written);
+    return Status::OK();
   }
 
   Slice key = entry->GetKey();
@@ -250,10 +341,15 @@ uint64_t RecordCache::WriteOutIfDirty(uint64_t index) {
   std::vector<uint64_t> indices;
   WriteOutBatch batch;
 
+  std::pair<key_utils::KeyHead, key_utils::KeyHead> bounds;
   if (key_bounds_) {
-    auto [_, upper_bound] = key_bounds_(tl::key_utils::ExtractHead64(key));
+    // Gather the dirty records on the whole page (or segment), including the
+    // ones that precede `key`.
+    bounds = key_bounds_(tl::key_utils::ExtractHead64(key));
+    const auto [lower_bound, upper_bound] = bounds;
     Status s =
-        GetRangeImpl(key, key_utils::IntKeyAsSlice(upper_bound).as<Slice>(),
+        GetRangeImpl(key_utils::IntKeyAsSlice(lower_bound).as<Slice>(),
+                     key_utils::IntKeyAsSlice(upper_bound).as<Slice>(),
                      &indices, index);
     for (auto& idx : indices) {
       entry = &cache_entries[idx];
@@ -269,13 +365,68 @@ uint64_t RecordCache::WriteOutIfDirty(uint64_t index) {
   }
 
   assert(write_out_);
-  write_out_(batch);
+  const Status status = write_out_(batch);
+  if (!status.ok()) {
+    for (auto& idx : indices) {
+      if (idx != index) cache_entries[idx].Unlock();
+    }
+    return status;
+  }
+  for (const auto& record : batch) {
+    const Slice& record_key = std::get<0>(record);
+    ++key_write_out_versions_[WriteOutVersionStripe(record_key)].value;
+  }
+  if (key_bounds_) {
+    ++page_write_out_versions_[PageVersionStripe(bounds)].value;
+    // If the write out reorganized the page (or a concurrent reorganization
+    // did), readers may have taken the version of the records' new pages.
+    if (key_bounds_(key_utils::ExtractHead64(key)) != bounds) {
+      std::pair<key_utils::KeyHead, key_utils::KeyHead> prev_bounds = bounds;
+      for (const auto& record : batch) {
+        const auto record_bounds =
+            key_bounds_(key_utils::ExtractHead64(std::get<0>(record)));
+        if (record_bounds == prev_bounds) continue;
+        ++page_write_out_versions_[PageVersionStripe(record_bounds)].value;
+        prev_bounds = record_bounds;
+      }
+    }
+  }
 
   for (auto& idx : indices) {
     cache_entries[idx].SetDirtyTo(false);
     if (idx != index) cache_entries[idx].Unlock();
   }
-  return batch.size();
+  if (num_written != nullptr) *num_written += batch.size();
+  return Status::OK();
+}
+
+bool RecordCache::DeferWriteOut(const uint64_t index) {
+  auto entry = &cache_entries[index];
+  if (deferred_io_batch_size_ <= 1 || !write_out_ || !key_bounds_ ||
+      entry->GetDeferrals() >= deferred_io_max_deferrals_) {
+    return false;
+  }
+
+  // Count the dirty records that would be written out along with this one.
+  // This only touches the cache, so it is much cheaper than the page read and
+  // write that it may save.
+  auto [lower_bound, upper_bound] =
+      key_bounds_(tl::key_utils::ExtractHead64(entry->GetKey()));
+  std::vector<uint64_t> indices;
+  GetRangeImpl(key_utils::IntKeyAsSlice(lower_bound).as<Slice>(),
+               key_utils::IntKeyAsSlice(upper_bound).as<Slice>(), &indices,
+               index);
+  size_t num_dirty = 0;
+  for (auto& idx : indices) {
+    if (cache_entries[idx].IsDirty()) ++num_dirty;
+    if (idx != index) cache_entries[idx].Unlock();
+  }
+  if (num_dirty >= deferred_io_batch_size_) return false;
+
+  entry->SetDeferralsTo(entry->GetDeferrals() + 1);
+  if (use_lru_) lru_queue_->MoveToBack(index);
+  pg::PageGroupedDBStats::Local().BumpCacheDeferredWriteOuts();
+  return true;
 }
 
 bool RecordCache::FreeIfValid(uint64_t index) {
@@ -299,7 +450,7 @@ uint64_t RecordCache::ClearCache(bool write_out_dirty) {
     cache_entries[i].SetPriorityTo(0);
     if (write_out_dirty) {
       cache_entries[i].Lock(/*exclusive = */ false);
-      count += WriteOutIfDirty(i);
+      WriteOutIfDirty(i, &count);
       cache_entries[i].Unlock();
     } else {
       cache_entries[i].SetDirtyTo(false);
@@ -325,6 +476,33 @@ std::vector<std::pair<Slice, Slice>> RecordCache::ExtractDirty() {
   return dirty_records;
 }
 
+std::vector<Slice> RecordCache::GetHotKeys(const size_t max_keys) const {
+  // NOTE: This method is not thread safe and cannot be called concurrently
+  // with any other public method. So we do not take locks.
+  std::vector<std::pair<uint8_t, uint64_t>> candidates;
+  for (uint64_t i = 0; i < capacity_; ++i) {
+    if (!cache_entries[i].IsValid() || cache_entries[i].IsDelete()) {
+      continue;
+    }
+    candidates.emplace_back(cache_entries[i].GetPriority(), i);
+  }
+  const auto hotter = [](const auto& left, const auto& right) {
+    return left.first > right.first;
+  };
+  if (candidates.size() > max_keys) {
+    std::nth_element(candidates.begin(), candidates.begin() + max_keys,
+                     candidates.end(), hotter);
+    candidates.resize(max_keys);
+  }
+
+  std::vector<Slice> keys;
+  keys.reserve(candidates.size());
+  for (const auto& [_, index] : candidates) {
+    keys.push_back(cache_entries[index].GetKey());
+  }
+  return keys;
+}
+
 uint64_t RecordCache::GetSizeFootprintEstimate() const {
   const uint64_t entries = capacity_ * sizeof(RecordCacheEntry);
   uint64_t entry_payloads = 0;
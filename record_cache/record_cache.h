@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <functional>
 #include <memory>
@@ -37,8 +38,19 @@ class RecordCache {
   static std::vector<RecordCacheEntry> cache_entries;
 
   // A function that should implement record write out functionality. We use
-  // this to decouple the cache from the database's persistence logic.
-  using WriteOutFn = std::function<void(const WriteOutBatch&)>;
+  // this to decouple the cache from the database's persistence logic. If the
+  // function returns a non-OK status, none of the batch's records are
+  // considered written and they stay dirty in the cache.
+  using WriteOutFn = std::function<Status(const WriteOutBatch&)>;
+
+  // Identifies the dirty record write outs that completed before a record was
+  // read from persistent storage. See `PutFromRead()`. A version with a null
+  // `counter` is never current. Page versions also record the page's bounds.
+  struct WriteOutVersion {
+    const std::atomic<uint64_t>* counter;
+    uint64_t value;
+    std::pair<key_utils::KeyHead, key_utils::KeyHead> page_bounds = {0, 0};
+  };
 
   // A function that should return the lower (inclusive) and upper (exclusive)
   // bounds of the page that the argument should be placed on.
@@ -50,12 +62,24 @@ class RecordCache {
   // measured in the number of records. Setting `use_lru` will use LRU as the
   // eviction policy instead of the clock-priority algorithm.
   //
-  // The last two arguments can optionally be omitted when using a standalone
-  // RecordCache. In that case, no persistence guarantees are provided, and data
-  // will be lost when exceeding the size of the record cache.
+  // The `write_out` and `key_bounds` arguments can optionally be omitted when
+  // using a standalone RecordCache. In that case, no persistence guarantees are
+  // provided, and data will be lost when exceeding the size of the record
+  // cache.
+  //
+  // If `deferred_io_batch_size` is larger than 1, an evicted dirty record will
+  // not be written out if fewer than `deferred_io_batch_size` dirty records
+  // fall within its `key_bounds`. The record instead stays in the cache
+  // (another entry is evicted), so that more records for the same page can
+  // accumulate. A record's write out is deferred at most
+  // `deferred_io_max_deferrals` times, which must be at most
+  // `RecordCacheEntry::kMaxDeferrals`. Deferral needs a `key_bounds`
+  // function.
   RecordCache(uint64_t capacity, bool use_lru = false,
               WriteOutFn write_out = WriteOutFn(),
-              KeyBoundsFn key_bounds = KeyBoundsFn());
+              KeyBoundsFn key_bounds = KeyBoundsFn(),
+              size_t deferred_io_batch_size = 1,
+              uint8_t deferred_io_max_deferrals = 0);
 
   // Destroys the record cache, after writing back any dirty records.
   ~RecordCache();
@@ -74,15 +98,46 @@ class RecordCache {
   //
   // Setting `safe = false` lets us switch to a thread-unsafe variant that does
   // not acquire locks. It is intended purely for performance benchmarking.
+  //
+  // If `read_version` is provided and a dirty record write out completed since
+  // it was taken, the record will not be cached (see `PutFromRead()`).
+  //
+  // Returns the write out function's status if a dirty record needed to be
+  // evicted but could not be written out (nothing is cached in that case).
   Status Put(const Slice& key, const Slice& value, bool is_dirty = false,
              format::WriteType write_type = format::WriteType::kWrite,
-             uint8_t priority = kDefaultPriority, bool safe = true);
+             uint8_t priority = kDefaultPriority, bool safe = true,
+             const WriteOutVersion* read_version = nullptr);
 
   // Cache the pair `key`-`value`, originating from a read. This is a
   // convenience method that calls `Put()` with `is_dirty` set to false and
   // `EntryType::kWrite`.
+  //
+  // When reads run concurrently with writes, a record read from persistent
+  // storage may be stale by the time it is cached: a newer (dirty) version of
+  // the record may have been written out and evicted in the meantime. Callers
+  // should pass the `GetWriteOutVersion()` taken before the read; the record
+  // will not be cached if a write out that may affect it completed since then.
   Status PutFromRead(const Slice& key, const Slice& value,
-                     uint8_t priority = kDefaultPriority);
+                     uint8_t priority = kDefaultPriority,
+                     const WriteOutVersion* read_version = nullptr);
+
+  // Returns a version that changes whenever a dirty record that may have the
+  // same key as `key` is written out.
+  WriteOutVersion GetWriteOutVersion(const Slice& key) const;
+
+  // Returns a version that changes whenever a dirty record on the same page as
+  // `key` (as given by the `key_bounds` function) is written out. Used for the
+  // other records read along with `key` (e.g., by optimistic caching). Without
+  // a `key_bounds` function the version is never current, so those records are
+  // not cached.
+  WriteOutVersion GetPageWriteOutVersion(const Slice& key) const;
+
+  // Returns `version` (taken by `GetPageWriteOutVersion(key)` before a read)
+  // if `key`'s page bounds are unchanged. Otherwise a reorganization ran during
+  // the read and the returned version is never current.
+  WriteOutVersion RecheckPageWriteOutVersion(const Slice& key,
+                                             WriteOutVersion version) const;
 
   // Retrieve the index of the cache entry associated with `key`, if any, and
   // lock it for reading or writing based on `exclusive`. If an entry is found,
@@ -108,7 +163,8 @@ class RecordCache {
                   std::vector<uint64_t>* indices_out) const;
 
   // Writes out all dirty cache entries to the appropriate longer-term data
-  // structure. Returns the number of dirty entries written out.
+  // structure. Returns the number of dirty entries written out (entries whose
+  // write out fails stay dirty).
   uint64_t WriteOutDirty();
 
   // Clears the cache: any clean cache records are deleted and any dirty cached
@@ -126,6 +182,14 @@ class RecordCache {
   // until the next call to a public method.
   std::vector<std::pair<Slice, Slice>> ExtractDirty();
 
+  // Returns the keys of (at most) `max_keys` cached records, preferring the
+  // records with the highest eviction priority (i.e., the "hottest" records).
+  //
+  // This method is NOT thread safe and cannot run concurrently with any other
+  // public methods. The returned keys are only valid until the next call to a
+  // public method.
+  std::vector<Slice> GetHotKeys(size_t max_keys) const;
+
   // Get an estimate of the cache's size footprint. The returned size is missing
   // the size of ART. This method is NOT thread safe and cannot run concurrently
   // with any other public methods.
@@ -151,13 +215,21 @@ class RecordCache {
 
   // Writes out the cache entry at `index`, if dirty, to the appropriate
   // longer-term data structure. If a write out takes place, also writes out
-  // all other cached dirty entries that correspond to the same page.
+  // all other cached dirty entries that correspond to the same page (entries
+  // that precede the entry at `index` are skipped if they are locked).
   //
-  // Returns the number of dirty entries written out.
+  // Adds the number of dirty entries written out to `num_written` (if not
+  // null). Returns the write out function's status on failure; the entries
+  // then stay dirty.
   //
   // The caller should ensure that it owns the mutex for the entry in question
   // (at least in non-exclusive mode).
-  uint64_t WriteOutIfDirty(uint64_t index);
+  Status WriteOutIfDirty(uint64_t index, uint64_t* num_written = nullptr);
+
+  // Returns true if the write out of the dirty cache entry at `index` should
+  // be deferred (see the constructor), and records the deferral. The caller
+  // should own the mutex for the entry in question.
+  bool DeferWriteOut(uint64_t index);
 
   // Frees the cache-owned copy of the record stored in the cache entry at
   // `index`, if the entry is valid. Returns true if the entry was valid.
@@ -195,8 +267,28 @@ class RecordCache {
   // records from the same page when writing out a dirty record.
   KeyBoundsFn key_bounds_;
 
+  // Deferred write out parameters (see the constructor).
+  const size_t deferred_io_batch_size_;
+  const uint8_t deferred_io_max_deferrals_;
+
   std::shared_ptr<MasstreeWrapper<RecordCacheEntry>> tree_;
 
+  // Incremented after dirty records are written out (see
+  // `GetWriteOutVersion()` and `GetPageWriteOutVersion()`). Keys and page
+  // bounds are hashed onto `kWriteOutVersionStripes` counters each, so that
+  // concurrent write outs of different pages do not contend on one counter.
+  // Each counter has its own cache line.
+  static constexpr size_t kWriteOutVersionStripes = 1024;
+  struct alignas(64) VersionCounter {
+    std::atomic<uint64_t> value = 0;
+  };
+  static size_t WriteOutVersionStripe(const Slice& key);
+  static size_t PageVersionStripe(
+      const std::pair<key_utils::KeyHead, key_utils::KeyHead>& bounds);
+  std::array<VersionCounter, kWriteOutVersionStripes> key_write_out_versions_;
+  std::array<VersionCounter, kWriteOutVersionStripes>
+      page_write_out_versions_;
+
   std::unique_ptr<HashQueue<uint64_t>> lru_queue_;
 };
 
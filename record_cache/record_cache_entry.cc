@@ -7,8 +7,11 @@ namespace tl {
 const uint8_t RecordCacheEntry::kValidMask = 0x80;      // 1000 0000
 const uint8_t RecordCacheEntry::kDirtyMask = 0x40;      // 0100 0000
 const uint8_t RecordCacheEntry::kWriteTypeMask = 0x20;  // 0010 0000
+const uint8_t RecordCacheEntry::kDeferralsMask = 0x18;  // 0001 1000
 const uint8_t RecordCacheEntry::kPriorityMask = 0x07;   // 0000 0111
 
+const uint8_t RecordCacheEntry::kMaxDeferrals = 3;
+
 RecordCacheEntry::RecordCacheEntry() : metadata_(0) {
   pthread_rwlock_init(&rwlock_, nullptr);
 }
@@ -142,6 +145,23 @@ uint8_t RecordCacheEntry::DecrementPriority(bool return_post) {
   }
 }
 
+uint8_t RecordCacheEntry::GetDeferrals() {
+  return (metadata_ & kDeferralsMask) >> 3;
+}
+
+void RecordCacheEntry::SetDeferralsTo(uint8_t deferrals) {
+  if (deferrals > kMaxDeferrals) deferrals = kMaxDeferrals;
+
+  uint8_t old_metadata = metadata_.load();
+  uint8_t new_metadata;
+
+  do {
+    // For subsequent iterations, compare_exchange_weak() will have updated
+    // `old_metadata` appropriately when failing.
+    new_metadata = (old_metadata & ~kDeferralsMask) | (deferrals << 3);
+  } while (!metadata_.compare_exchange_weak(old_metadata, new_metadata));
+}
+
 Slice RecordCacheEntry::GetKey() const { return key_; }
 void RecordCacheEntry::SetKey(Slice key) { key_ = key; }
 
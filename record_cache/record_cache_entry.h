@@ -52,6 +52,12 @@ class RecordCacheEntry {
   uint8_t IncrementPriority(bool return_post = true);  // With upper bound.
   uint8_t DecrementPriority(bool return_post = true);  // With lower bound.
 
+  // Modify the number of times the write out of this (dirty) entry was
+  // deferred. At most `kMaxDeferrals` deferrals can be recorded.
+  static const uint8_t kMaxDeferrals;
+  uint8_t GetDeferrals();
+  void SetDeferralsTo(uint8_t deferrals);  // Clamped to `kMaxDeferrals`.
+
   // Access/modify key
   Slice GetKey() const;
   void SetKey(Slice key);
@@ -74,6 +80,7 @@ class RecordCacheEntry {
   static const uint8_t kValidMask;
   static const uint8_t kDirtyMask;
   static const uint8_t kWriteTypeMask;
+  static const uint8_t kDeferralsMask;
   static const uint8_t kPriorityMask;
 
   // Extracts the priority from `flags`, assuming the same encoding is used as
@@ -91,8 +98,8 @@ class RecordCacheEntry {
 
   // The metadata associated with this entry.
   //
-  //  bit       7   |   6   |     5     |  4  3  | 2  1  0
-  //  field   valid | dirty | WriteType | unused | priority
+  //  bit       7   |   6   |     5     |    4  3   | 2  1  0
+  //  field   valid | dirty | WriteType | deferrals | priority
   std::atomic<uint8_t> metadata_;
 };
 
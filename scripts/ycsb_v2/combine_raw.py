@@ -8,6 +8,15 @@ import conductor.lib as cond
 import pandas as pd
 
 
+# Page-grouped TreeLine counters reported by the thread scaling experiments.
+CONTENTION_COUNTERS = [
+    "segment_lock_waits",
+    "page_lock_waits",
+    "reorg_reader_waits",
+    "write_retries",
+]
+
+
 def process_iostat(iostat_file, device, trace_out_file):
     with open(iostat_file, "r") as iostatf:
         iostat = json.load(iostatf)
@@ -47,6 +56,7 @@ def main():
     parser = argparse.ArgumentParser()
     parser.add_argument("--for-factor", action="store_true")
     parser.add_argument("--for-prefetch", action="store_true")
+    parser.add_argument("--for-scaling", action="store_true")
     args = parser.parse_args()
     deps = cond.get_deps_paths()
     out_dir = cond.get_output_path()
@@ -133,6 +143,28 @@ def main():
                 df.insert(5, "variant", variant)
                 df.insert(6, "order", order)
 
+            elif args.for_scaling:
+                # e.g.: scaling-synth-pg_llsm-64B-a-zipfian-64
+                exp_parts = exp_inst.name.split("-")
+                dataset = exp_parts[1]
+                db = exp_parts[2]
+                config = exp_parts[3]
+                workload = exp_parts[4]
+                dist = exp_parts[5]
+                threads = int(exp_parts[6])
+
+                df.insert(0, "dataset", dataset)
+                df.insert(1, "config", config)
+                df.insert(2, "dist", dist)
+                df.insert(3, "workload", workload)
+                df.insert(4, "threads", threads)
+
+                # Include the contention counters.
+                counters = pd.read_csv(exp_inst / "counters.csv")
+                for name, value in zip(counters["name"], counters["value"]):
+                    if name in CONTENTION_COUNTERS:
+                        df[name] = value
+
             else:
                 # e.g.: synth-pg_llsm-64B-a-zipfian-1
                 # NOTE: We don't need to extract the DB because it is already
@@ -229,6 +261,27 @@ def main():
                 "disk_usage_bytes",
             ]
         ]
+    elif args.for_scaling:
+        combined.sort_values(
+            ["dataset", "config", "dist", "db", "workload", "threads"],
+            inplace=True,
+            ignore_index=True,
+        )
+        combined = combined[
+            [
+                "dataset",
+                "config",
+                "dist",
+                "db",
+                "workload",
+                "threads",
+                *orig_columns,
+                *CONTENTION_COUNTERS,
+                "phys_read_kb",
+                "phys_written_kb",
+                "disk_usage_bytes",
+            ]
+        ]
     else:
         combined.sort_values(
             ["dataset", "config", "dist", "db", "workload", "threads"],
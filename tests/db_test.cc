@@ -1462,8 +1462,10 @@ TEST_F(DBTest, RecordCacheWriteOutBatchingSimple) {
   status = static_cast<tl::DBImpl*>(db)->rec_cache_->GetCacheIndex(
       smallest_key, /*exclusive = */ false, &idx);
   static_cast<tl::DBImpl*>(db)->rec_cache_->cache_entries[idx].Unlock();
-  auto written_out =
-      static_cast<tl::DBImpl*>(db)->rec_cache_->WriteOutIfDirty(idx);
+  uint64_t written_out = 0;
+  ASSERT_TRUE(static_cast<tl::DBImpl*>(db)
+                  ->rec_cache_->WriteOutIfDirty(idx, &written_out)
+                  .ok());
   ASSERT_EQ(written_out, lexicographic_keys.size());
 }
 
@@ -1519,8 +1521,10 @@ TEST_F(DBTest, RecordCacheWriteOutBatchingMultiPage) {
   status = static_cast<tl::DBImpl*>(db)->rec_cache_->GetCacheIndex(
       smallest_key, /*exclusive = */ false, &idx);
   static_cast<tl::DBImpl*>(db)->rec_cache_->cache_entries[idx].Unlock();
-  auto written_out =
-      static_cast<tl::DBImpl*>(db)->rec_cache_->WriteOutIfDirty(idx);
+  uint64_t written_out = 0;
+  ASSERT_TRUE(static_cast<tl::DBImpl*>(db)
+                  ->rec_cache_->WriteOutIfDirty(idx, &written_out)
+                  .ok());
   ASSERT_EQ(written_out, records_per_page);
 
   // Helper functions.
@@ -1544,8 +1548,10 @@ TEST_F(DBTest, RecordCacheWriteOutBatchingMultiPage) {
                                                num_pages](const uint64_t n) {
     auto written_total = 0;
     for (auto i = 0; i < options.record_cache_capacity; ++i) {
-      auto written_out =
-          static_cast<tl::DBImpl*>(db)->rec_cache_->WriteOutIfDirty(i);
+      uint64_t written_out = 0;
+      ASSERT_TRUE(static_cast<tl::DBImpl*>(db)
+                      ->rec_cache_->WriteOutIfDirty(i, &written_out)
+                      .ok());
       ASSERT_TRUE((written_out == n) || (written_out == 0));
       written_total += written_out;
     }
@@ -1613,8 +1619,10 @@ TEST_F(DBTest, RecordCacheClearHalfDirty) {
   status = static_cast<tl::DBImpl*>(db)->rec_cache_->GetCacheIndex(
       smallest_key, /*exclusive = */ false, &idx);
   static_cast<tl::DBImpl*>(db)->rec_cache_->cache_entries[idx].Unlock();
-  auto written_out =
-      static_cast<tl::DBImpl*>(db)->rec_cache_->WriteOutIfDirty(idx);
+  uint64_t written_out = 0;
+  ASSERT_TRUE(static_cast<tl::DBImpl*>(db)
+                  ->rec_cache_->WriteOutIfDirty(idx, &written_out)
+                  .ok());
   ASSERT_EQ(written_out, records_per_page);
 
   // Re-dirty half the cache.
@@ -1746,8 +1754,10 @@ TEST_F(DBTest, RecordCacheWriteOutOverride) {
   status = static_cast<tl::DBImpl*>(db)->rec_cache_->GetCacheIndex(
       smallest_key, /*exclusive = */ false, &idx);
   static_cast<tl::DBImpl*>(db)->rec_cache_->cache_entries[idx].Unlock();
-  auto written_out =
-      static_cast<tl::DBImpl*>(db)->rec_cache_->WriteOutIfDirty(idx);
+  uint64_t written_out = 0;
+  ASSERT_TRUE(static_cast<tl::DBImpl*>(db)
+                  ->rec_cache_->WriteOutIfDirty(idx, &written_out)
+                  .ok());
   ASSERT_EQ(written_out, 1);
 }
 
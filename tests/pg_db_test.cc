@@ -1,12 +1,23 @@
 #include "treeline/pg_db.h"
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
 #include <numeric>
+#include <random>
+#include <thread>
+#include <tuple>
 #include <vector>
 
 #include "gtest/gtest.h"
 #include "treeline/pg_options.h"
+#include "treeline/pg_stats.h"
+#include "util/op_trace.h"
 
 namespace {
 
@@ -348,4 +359,1558 @@ TEST_F(PGDBTest, ReservedKeyUse) {
                   .IsInvalidArgument());
 }
 
+TEST_F(PGDBTest, CaptureTrace) {
+  PageGroupedDB* db = nullptr;
+  auto options = GetCommonTestOptions();
+  options.trace_path = (kDBDir / "ops.trace").string();
+  ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).ok());
+  ASSERT_NE(db, nullptr);
+
+  const std::string value = "Test 1";
+  const auto dataset = GetRangeDataset(10, 100, value);
+  // Rejected requests are not traced.
+  ASSERT_TRUE(db->Put(WriteOptions(), 15, value).IsNotSupportedError());
+  ASSERT_TRUE(db->BulkLoad(dataset).ok());
+  ASSERT_TRUE(db->BulkLoad(dataset).IsNotSupportedError());
+  ASSERT_TRUE(db->Put(WriteOptions(), 0, value).IsInvalidArgument());
+
+  // Each thread issues a read, an insert, an update, and a scan per key.
+  constexpr size_t kOpsPerThread = 20;
+  const auto worker = [db, &value](const Key first_key) {
+    std::string out;
+    std::vector<std::pair<Key, std::string>> scan_out;
+    WriteOptions update;
+    update.is_update = true;
+    for (Key key = first_key; key < first_key + kOpsPerThread; ++key) {
+      ASSERT_TRUE(db->Get(key * 10, &out).ok());
+      ASSERT_TRUE(db->Put(WriteOptions(), key * 10 + 1, value).ok());
+      ASSERT_TRUE(db->Put(update, key * 10, value).ok());
+      ASSERT_TRUE(db->GetRange(key * 10, 3, &scan_out).ok());
+    }
+  };
+  std::thread t1(worker, 1), t2(worker, 50);
+  t1.join();
+  t2.join();
+  delete db;
+
+  std::vector<TraceRecord> records;
+  ASSERT_TRUE(ReadOpTrace(options.trace_path, &records).ok());
+  ASSERT_EQ(records.size(), dataset.size() + 2 * 4 * kOpsPerThread);
+
+  // The bulk load happened first, on this thread.
+  for (size_t i = 0; i < dataset.size(); ++i) {
+    ASSERT_EQ(records[i].op, TraceOp::kBulkLoad);
+    ASSERT_EQ(records[i].key, dataset[i].first);
+    ASSERT_EQ(records[i].value_size, value.size());
+    ASSERT_EQ(records[i].thread_id, 0);
+  }
+
+  // Each worker's operations must appear in issue order.
+  std::vector<std::vector<TraceRecord>> per_thread(3);
+  for (size_t i = dataset.size(); i < records.size(); ++i) {
+    ASSERT_GE(records[i].thread_id, 1);
+    ASSERT_LE(records[i].thread_id, 2);
+    per_thread[records[i].thread_id].push_back(records[i]);
+  }
+  for (size_t t = 1; t <= 2; ++t) {
+    const auto& ops = per_thread[t];
+    ASSERT_EQ(ops.size(), 4 * kOpsPerThread);
+    const Key first_key = ops[0].key / 10;
+    for (size_t i = 0; i < kOpsPerThread; ++i) {
+      const Key key = (first_key + i) * 10;
+      EXPECT_EQ(ops[4 * i].op, TraceOp::kRead);
+      EXPECT_EQ(ops[4 * i].key, key);
+      EXPECT_EQ(ops[4 * i + 1].op, TraceOp::kInsert);
+      EXPECT_EQ(ops[4 * i + 1].key, key + 1);
+      EXPECT_EQ(ops[4 * i + 1].value_size, value.size());
+      EXPECT_EQ(ops[4 * i + 2].op, TraceOp::kUpdate);
+      EXPECT_EQ(ops[4 * i + 2].key, key);
+      EXPECT_EQ(ops[4 * i + 3].op, TraceOp::kScan);
+      EXPECT_EQ(ops[4 * i + 3].scan_length, 3);
+    }
+    for (size_t i = 1; i < ops.size(); ++i) {
+      EXPECT_LE(ops[i - 1].timestamp_ns, ops[i].timestamp_ns);
+    }
+  }
+}
+
+TEST_F(PGDBTest, TraceWriterThreadBuffers) {
+  // Enough records to fill several per-thread buffers.
+  constexpr size_t kNumThreads = 3;
+  constexpr uint64_t kRecordsPerThread = 10000;
+  const auto path = kDBDir / "ops.trace";
+  {
+    std::unique_ptr<OpTraceWriter> writer;
+    ASSERT_TRUE(OpTraceWriter::Open(path, &writer).ok());
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < kNumThreads; ++t) {
+      threads.emplace_back([&writer]() {
+        for (uint64_t key = 0; key < kRecordsPerThread; ++key) {
+          writer->Record(TraceOp::kRead, key);
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+  std::vector<TraceRecord> records;
+  ASSERT_TRUE(ReadOpTrace(path, &records).ok());
+  ASSERT_EQ(records.size(), kNumThreads * kRecordsPerThread);
+  std::vector<uint64_t> next_key(kNumThreads, 0);
+  for (const auto& record : records) {
+    ASSERT_LT(record.thread_id, kNumThreads);
+    ASSERT_EQ(record.key, next_key[record.thread_id]++);
+  }
+}
+
+TEST_F(PGDBTest, TraceWriterManyWriters) {
+  // One thread records to many writers (some of them at the same time). Each
+  // writer keeps its own buffer for the thread.
+  constexpr size_t kNumRounds = 50;
+  constexpr uint64_t kRecordsPerWriter = 100;
+  const auto path_a = kDBDir / "a.trace";
+  const auto path_b = kDBDir / "b.trace";
+  for (size_t round = 0; round < kNumRounds; ++round) {
+    std::unique_ptr<OpTraceWriter> writer_a, writer_b;
+    ASSERT_TRUE(OpTraceWriter::Open(path_a, &writer_a).ok());
+    ASSERT_TRUE(OpTraceWriter::Open(path_b, &writer_b).ok());
+    for (uint64_t key = 0; key < kRecordsPerWriter; ++key) {
+      writer_a->Record(TraceOp::kRead, key);
+      writer_b->Record(TraceOp::kInsert, key, /*value_size=*/8);
+    }
+    writer_a.reset();
+    writer_b.reset();
+
+    for (const auto& path : {path_a, path_b}) {
+      std::vector<TraceRecord> records;
+      ASSERT_TRUE(ReadOpTrace(path, &records).ok());
+      ASSERT_EQ(records.size(), kRecordsPerWriter);
+      for (uint64_t key = 0; key < kRecordsPerWriter; ++key) {
+        ASSERT_EQ(records[key].key, key);
+        ASSERT_EQ(records[key].thread_id, 0);
+        ASSERT_EQ(records[key].op,
+                  path == path_a ? TraceOp::kRead : TraceOp::kInsert);
+      }
+    }
+  }
+}
+
+TEST_F(PGDBTest, ConcurrentPutGetScanFlatten) {
+  PageGroupedDB* db = nullptr;
+  auto options = GetCommonTestOptions();
+  // Use small pages and a small record cache to trigger frequent record cache
+  // write outs and reorganizations.
+  options.records_per_page_goal = 8;
+  options.records_per_page_epsilon = 2;
+  options.record_cache_capacity = 256;
+  options.num_bg_threads = 4;
+  ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).ok());
+  ASSERT_NE(db, nullptr);
+
+  constexpr size_t kNumRecords = 2000;
+  constexpr size_t kNumWriters = 4;
+  const std::string load_value(16, 'L');
+  const auto dataset = GetRangeDataset(10, kNumRecords, load_value);
+  ASSERT_TRUE(db->BulkLoad(dataset).ok());
+
+  // Writer `t` inserts keys `i * 10 + t + 1` and updates the loaded keys
+  // `i * 10` where `i % kNumWriters == t`, so each key has a single writer.
+  const auto updated_value = [](const size_t writer) {
+    return std::string(16, static_cast<char>('a' + writer));
+  };
+  const auto writer = [db, &updated_value](const size_t t) {
+    const std::string value = updated_value(t);
+    WriteOptions update;
+    update.is_update = true;
+    for (Key i = 1; i <= kNumRecords; ++i) {
+      ASSERT_TRUE(db->Put(WriteOptions(), i * 10 + t + 1, value).ok());
+      if (i % kNumWriters == t) {
+        ASSERT_TRUE(db->Put(update, i * 10, value).ok());
+      }
+    }
+  };
+
+  std::atomic<bool> writers_done(false);
+  const auto reader = [db, &writers_done](const size_t seed) {
+    std::mt19937 prng(seed);
+    std::uniform_int_distribution<Key> dist(1, kNumRecords);
+    std::string out;
+    while (!writers_done.load()) {
+      ASSERT_TRUE(db->Get(dist(prng) * 10, &out).ok());
+      ASSERT_EQ(out.size(), 16);
+    }
+  };
+  const auto scanner = [db, &writers_done]() {
+    std::mt19937 prng(1337);
+    std::uniform_int_distribution<Key> dist(1, kNumRecords);
+    std::vector<std::pair<Key, std::string>> scan_out;
+    while (!writers_done.load()) {
+      const Key start = dist(prng) * 10;
+      scan_out.clear();
+      ASSERT_TRUE(db->GetRange(start, 20, &scan_out).ok());
+      ASSERT_FALSE(scan_out.empty());
+      ASSERT_LE(scan_out.size(), 20);
+      // The loaded keys are never removed, so the scan must start with `start`.
+      ASSERT_EQ(scan_out.front().first, start);
+      for (size_t i = 1; i < scan_out.size(); ++i) {
+        ASSERT_LT(scan_out[i - 1].first, scan_out[i].first);
+      }
+    }
+  };
+  const auto flattener = [db, &writers_done]() {
+    while (!writers_done.load()) {
+      ASSERT_TRUE(db->FlattenRange().ok());
+    }
+  };
+
+  std::vector<std::thread> readers;
+  readers.emplace_back(reader, 1);
+  readers.emplace_back(reader, 2);
+  readers.emplace_back(scanner);
+  readers.emplace_back(flattener);
+  std::vector<std::thread> writers;
+  for (size_t t = 0; t < kNumWriters; ++t) {
+    writers.emplace_back(writer, t);
+  }
+  for (auto& thread : writers) {
+    thread.join();
+  }
+  writers_done.store(true);
+  for (auto& thread : readers) {
+    thread.join();
+  }
+
+  // Every key must have its writer's latest value.
+  std::string out;
+  for (Key i = 1; i <= kNumRecords; ++i) {
+    ASSERT_TRUE(db->Get(i * 10, &out).ok());
+    ASSERT_EQ(out, updated_value(i % kNumWriters));
+    for (size_t t = 0; t < kNumWriters; ++t) {
+      ASSERT_TRUE(db->Get(i * 10 + t + 1, &out).ok());
+      ASSERT_EQ(out, updated_value(t));
+    }
+  }
+  delete db;
+}
+
+TEST_F(PGDBTest, SimulatedDevice) {
+  PageGroupedDB* db = nullptr;
+  auto options = GetCommonTestOptions();
+  options.use_simulated_device = true;
+  options.simulated_device.read_latency_us = 500;
+  options.simulated_device.write_latency_us = 100;
+  options.bypass_cache = true;
+  ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).ok());
+  ASSERT_NE(db, nullptr);
+
+  const std::string value = "Test 1";
+  const auto dataset = GetRangeDataset(10, 1000, value);
+  ASSERT_TRUE(db->BulkLoad(dataset).ok());
+  const std::string new_value = "Test 2";
+  ASSERT_TRUE(db->Put(WriteOptions(), 102, new_value).ok());
+  ASSERT_TRUE(db->Put(WriteOptions(), 20, new_value).ok());
+
+  // Each read should take at least the simulated read latency (the cache is
+  // bypassed, so every read incurs I/O).
+  constexpr size_t kNumReads = 20;
+  std::string out;
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t i = 1; i <= kNumReads; ++i) {
+    ASSERT_TRUE(db->Get(i * 10, &out).ok());
+    ASSERT_EQ(out, i == 2 ? new_value : value);
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  ASSERT_GE(elapsed, std::chrono::microseconds(
+                         kNumReads * options.simulated_device.read_latency_us));
+
+  // The pages should be written back to the DB's files when it is closed.
+  delete db;
+  db = nullptr;
+  options.use_simulated_device = false;
+  ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).ok());
+  ASSERT_NE(db, nullptr);
+  std::vector<std::pair<Key, std::string>> scan_out;
+  ASSERT_TRUE(db->GetRange(1, 2000, &scan_out).ok());
+  ASSERT_EQ(scan_out.size(), dataset.size() + 1);
+  ASSERT_TRUE(db->Get(102, &out).ok());
+  ASSERT_EQ(out, new_value);
+  ASSERT_TRUE(db->Get(20, &out).ok());
+  ASSERT_EQ(out, new_value);
+  ASSERT_TRUE(db->Get(30, &out).ok());
+  ASSERT_EQ(out, value);
+
+  delete db;
+  db = nullptr;
+}
+
+TEST_F(PGDBTest, InMemoryStorage) {
+  PageGroupedDB* db = nullptr;
+  auto options = GetCommonTestOptions();
+  options.use_in_memory_storage = true;
+  options.in_memory_max_file_mib = 64;
+  options.in_memory_use_huge_pages = true;
+  options.bypass_cache = true;
+  ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).ok());
+  ASSERT_NE(db, nullptr);
+
+  const std::string value = "Test 1";
+  const auto dataset = GetRangeDataset(10, 1000, value);
+  ASSERT_TRUE(db->BulkLoad(dataset).ok());
+
+  // Trigger overflows and reorganizations.
+  const std::string new_value = "Test 2";
+  for (Key key = 11; key < 2000; key += 2) {
+    ASSERT_TRUE(db->Put(WriteOptions(), key, new_value).ok());
+  }
+
+  std::string out;
+  for (Key key = 10; key < 2000; ++key) {
+    if (key % 10 == 0) {
+      ASSERT_TRUE(db->Get(key, &out).ok());
+      ASSERT_EQ(out, value);
+    } else if (key % 2 == 1) {
+      ASSERT_TRUE(db->Get(key, &out).ok());
+      ASSERT_EQ(out, new_value);
+    } else {
+      ASSERT_TRUE(db->Get(key, &out).IsNotFound());
+    }
+  }
+
+  std::vector<std::pair<Key, std::string>> scan_out;
+  ASSERT_TRUE(db->GetRange(10, 10, &scan_out).ok());
+  ASSERT_EQ(scan_out.size(), 10);
+  ASSERT_EQ(scan_out.front().first, 10);
+  ASSERT_EQ(scan_out.back().first, 25);
+
+  // No segment files should have been created.
+  for (const auto& entry : std::filesystem::directory_iterator(kDBDir)) {
+    ASSERT_NE(entry.path().filename().string().rfind("sf-", 0), 0);
+  }
+
+  // In-memory databases always start out empty.
+  delete db;
+  db = nullptr;
+  ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).ok());
+  ASSERT_NE(db, nullptr);
+  ASSERT_TRUE(db->Get(10, &out).IsNotFound());
+  ASSERT_TRUE(db->BulkLoad(dataset).ok());
+  ASSERT_TRUE(db->Get(10, &out).ok());
+  ASSERT_EQ(out, value);
+
+  delete db;
+  db = nullptr;
+}
+
+TEST_F(PGDBTest, ReadOnly) {
+  PageGroupedDB* db = nullptr;
+  auto options = GetCommonTestOptions();
+  options.read_only = true;
+  // Only existing DBs can be opened in read-only mode.
+  ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).IsInvalidArgument());
+
+  options.read_only = false;
+  ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).ok());
+  ASSERT_NE(db, nullptr);
+  const std::string value = "Test 1";
+  const auto dataset = GetRangeDataset(10, 1000, value);
+  ASSERT_TRUE(db->BulkLoad(dataset).ok());
+  const std::string new_value = "Test 2";
+  for (Key key = 11; key < 2000; key += 2) {
+    ASSERT_TRUE(db->Put(WriteOptions(), key, new_value).ok());
+  }
+  delete db;
+  db = nullptr;
+
+  options.read_only = true;
+  ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).ok());
+  ASSERT_NE(db, nullptr);
+  ASSERT_TRUE(db->Put(WriteOptions(), 15, value).IsNotSupportedError());
+  ASSERT_TRUE(db->BulkLoad(dataset).IsNotSupportedError());
+  ASSERT_TRUE(db->FlattenRange().IsNotSupportedError());
+
+  // Readers can run concurrently.
+  std::vector<std::thread> readers;
+  std::atomic<size_t> num_errors(0);
+  for (size_t t = 0; t < 4; ++t) {
+    readers.emplace_back([&]() {
+      std::string out;
+      for (Key key = 10; key < 2000; ++key) {
+        const Status s = db->Get(key, &out);
+        if (key % 10 == 0) {
+          if (!s.ok() || out != value) ++num_errors;
+        } else if (key % 2 == 1) {
+          if (!s.ok() || out != new_value) ++num_errors;
+        } else if (!s.IsNotFound()) {
+          ++num_errors;
+        }
+      }
+    });
+  }
+  for (auto& reader : readers) {
+    reader.join();
+  }
+  ASSERT_EQ(num_errors, 0);
+
+  std::vector<std::pair<Key, std::string>> scan_out;
+  ASSERT_TRUE(db->GetRange(15, 2000, &scan_out).ok());
+  ASSERT_EQ(scan_out.size(), 993 + 999);
+  ASSERT_EQ(scan_out.front().first, 15);
+  ASSERT_EQ(scan_out.front().second, new_value);
+  ASSERT_EQ(scan_out.back().first, 10000);
+  for (size_t i = 1; i < scan_out.size(); ++i) {
+    ASSERT_LT(scan_out[i - 1].first, scan_out[i].first);
+  }
+  delete db;
+  db = nullptr;
+
+  // The DB should still be writable when it is opened normally.
+  options.read_only = false;
+  ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).ok());
+  ASSERT_TRUE(db->Put(WriteOptions(), 15, value).ok());
+  std::string out;
+  ASSERT_TRUE(db->Get(15, &out).ok());
+  ASSERT_EQ(out, value);
+  delete db;
+  db = nullptr;
+}
+
+TEST_F(PGDBTest, TieredStorage) {
+  const std::filesystem::path capacity_dir = kDBDir.string() + "-capacity";
+  std::filesystem::remove_all(capacity_dir);
+
+  PageGroupedDB* db = nullptr;
+  auto options = GetCommonTestOptions();
+  options.bypass_cache = true;
+  options.tiering.capacity_tier_path = capacity_dir;
+  options.tiering.migration_interval_ms = 10;
+  ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).ok());
+  ASSERT_NE(db, nullptr);
+
+  const std::string value = "Test 1";
+  const auto dataset = GetRangeDataset(10, 1000, value);
+  ASSERT_TRUE(db->BulkLoad(dataset).ok());
+
+  // No segments are accessed, so the background thread should eventually
+  // move them to the capacity tier.
+  const auto get_migrated = []() {
+    uint64_t migrated = 0;
+    PageGroupedDBStats::RunOnGlobal([&migrated](const auto& stats) {
+      migrated = stats.GetSegmentsMigrated();
+    });
+    return migrated;
+  };
+  const uint64_t migrated_before = get_migrated();
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (get_migrated() == migrated_before &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  ASSERT_GT(get_migrated(), migrated_before);
+
+  // Migrated segments should still be readable and writable.
+  const std::string new_value = "Test 2";
+  for (Key key = 11; key < 2000; key += 2) {
+    ASSERT_TRUE(db->Put(WriteOptions(), key, new_value).ok());
+  }
+  const auto check_contents = [&]() {
+    std::string out;
+    for (Key key = 10; key < 2000; ++key) {
+      if (key % 10 == 0) {
+        ASSERT_TRUE(db->Get(key, &out).ok());
+        ASSERT_EQ(out, value);
+      } else if (key % 2 == 1) {
+        ASSERT_TRUE(db->Get(key, &out).ok());
+        ASSERT_EQ(out, new_value);
+      } else {
+        ASSERT_TRUE(db->Get(key, &out).IsNotFound());
+      }
+    }
+    std::vector<std::pair<Key, std::string>> scan_out;
+    ASSERT_TRUE(db->GetRange(15, 2000, &scan_out).ok());
+    ASSERT_EQ(scan_out.size(), 993 + 999);
+    ASSERT_EQ(scan_out.back().first, 10000);
+  };
+  check_contents();
+  delete db;
+  db = nullptr;
+
+  bool capacity_tier_used = false;
+  for (const auto& entry : std::filesystem::directory_iterator(capacity_dir)) {
+    if (std::filesystem::file_size(entry.path()) > 0) {
+      capacity_tier_used = true;
+    }
+  }
+  ASSERT_TRUE(capacity_tier_used);
+
+  // Both tiers should be recovered when the DB is reopened.
+  options.tiering.migration_interval_ms = 0;
+  ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).ok());
+  ASSERT_NE(db, nullptr);
+  check_contents();
+  delete db;
+  db = nullptr;
+  std::filesystem::remove_all(capacity_dir);
+}
+
+TEST_F(PGDBTest, PersistHotKeys) {
+  PageGroupedDB* db = nullptr;
+  auto options = GetCommonTestOptions();
+  options.persist_hot_keys = true;
+  ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).ok());
+  ASSERT_NE(db, nullptr);
+
+  const std::string value = "Test 1";
+  const auto dataset = GetRangeDataset(10, 1000, value);
+  ASSERT_TRUE(db->BulkLoad(dataset).ok());
+  const std::string new_value = "Test 2";
+  ASSERT_TRUE(db->Put(WriteOptions(), 15, new_value).ok());
+  std::string out;
+  for (Key key = 10; key <= 2000; key += 10) {
+    ASSERT_TRUE(db->Get(key, &out).ok());
+  }
+  delete db;
+  db = nullptr;
+  ASSERT_TRUE(std::filesystem::exists(kDBDir / "hot_keys"));
+
+  const auto get_warmed = []() {
+    uint64_t warmed = 0;
+    PageGroupedDBStats::RunOnGlobal([&warmed](const auto& stats) {
+      warmed = stats.GetCacheWarmupRecords();
+    });
+    return warmed;
+  };
+  const uint64_t warmed_before = get_warmed();
+  ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).ok());
+  ASSERT_NE(db, nullptr);
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (get_warmed() == warmed_before &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  // All 200 keys that were read plus the key that was written.
+  ASSERT_EQ(get_warmed() - warmed_before, 201);
+
+  // The warmed up records should be served by the record cache.
+  PageGroupedDBStats::Local().Reset();
+  ASSERT_TRUE(db->Get(15, &out).ok());
+  ASSERT_EQ(out, new_value);
+  for (Key key = 10; key <= 2000; key += 10) {
+    ASSERT_TRUE(db->Get(key, &out).ok());
+    ASSERT_EQ(out, value);
+  }
+  ASSERT_EQ(PageGroupedDBStats::Local().GetCacheHits(), 201);
+  delete db;
+  db = nullptr;
+}
+
+TEST_F(PGDBTest, PersistHotKeysCorruptPage) {
+  PageGroupedDB* db = nullptr;
+  auto options = GetCommonTestOptions();
+  options.use_segments = false;
+  options.records_per_page_goal = 44;
+  options.records_per_page_epsilon = 5;
+  options.persist_hot_keys = true;
+  ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).ok());
+  ASSERT_NE(db, nullptr);
+
+  const std::string value = "Test 1";
+  const auto dataset = GetRangeDataset(10, 1000, value);
+  ASSERT_TRUE(db->BulkLoad(dataset).ok());
+  std::string out;
+  for (const auto& record : dataset) {
+    ASSERT_TRUE(db->Get(record.first, &out).ok());
+  }
+  delete db;
+  db = nullptr;
+
+  // Corrupt the first page (see the `PageChecksums` test).
+  {
+    std::fstream file(kDBDir / "sf-0",
+                      std::ios::in | std::ios::out | std::ios::binary);
+    ASSERT_TRUE(file.is_open());
+    file.seekg(2048);
+    const char byte = file.get();
+    file.seekp(2048);
+    file.put(byte ^ 0xFF);
+  }
+
+  const auto get_stats = []() {
+    std::pair<uint64_t, uint64_t> warmed_and_errors;
+    PageGroupedDBStats::RunOnGlobal([&warmed_and_errors](const auto& stats) {
+      warmed_and_errors = {stats.GetCacheWarmupRecords(),
+                           stats.GetCacheWarmupReadErrors()};
+    });
+    return warmed_and_errors;
+  };
+  const auto before = get_stats();
+  ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).ok());
+  ASSERT_NE(db, nullptr);
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (get_stats() == before &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  // The keys on the corrupted page are skipped; the others are warmed up.
+  const auto after = get_stats();
+  ASSERT_EQ(after.second - before.second, 1);
+  ASSERT_GT(after.first - before.first, 0);
+  ASSERT_LT(after.first - before.first, dataset.size());
+  ASSERT_TRUE(db->Get(10, &out).IsCorruption());
+  delete db;
+  db = nullptr;
+}
+
+TEST_F(PGDBTest, PersistHotKeysFenceKeys) {
+  PageGroupedDB* db = nullptr;
+  auto options = GetCommonTestOptions();
+  options.use_segments = false;
+  options.records_per_page_goal = 44;
+  options.records_per_page_epsilon = 5;
+  options.persist_hot_keys = true;
+  ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).ok());
+  ASSERT_NE(db, nullptr);
+
+  // The keys are consecutive, so the last key on each page is equal to the
+  // page's (inclusive) upper fence.
+  const std::string value = "Test 1";
+  const auto dataset = GetRangeDataset(1, 1000, value);
+  ASSERT_TRUE(db->BulkLoad(dataset).ok());
+  std::string out;
+  for (const auto& record : dataset) {
+    ASSERT_TRUE(db->Get(record.first, &out).ok());
+  }
+  delete db;
+  db = nullptr;
+
+  // Each page read by the warm up goes through the page cache, so a page that
+  // is read more than once shows up as a page cache hit.
+  struct WarmupStats {
+    uint64_t warmed, page_hits, page_misses;
+  };
+  const auto get_stats = []() {
+    WarmupStats result;
+    PageGroupedDBStats::RunOnGlobal([&result](const auto& stats) {
+      result = {stats.GetCacheWarmupRecords(), stats.GetPageCacheHits(),
+                stats.GetPageCacheMisses()};
+    });
+    return result;
+  };
+  const auto before = get_stats();
+  options.page_cache_pages = 1024;
+  ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).ok());
+  ASSERT_NE(db, nullptr);
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (get_stats().warmed == before.warmed &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  // Every key is warmed up from its own page, which is read exactly once.
+  const auto after = get_stats();
+  ASSERT_EQ(after.warmed - before.warmed, dataset.size());
+  ASSERT_EQ(after.page_hits - before.page_hits, 0);
+  ASSERT_GT(after.page_misses - before.page_misses, 0);
+  ASSERT_LT(after.page_misses - before.page_misses, dataset.size() / 20);
+  delete db;
+  db = nullptr;
+}
+
+TEST_F(PGDBTest, PersistHotKeysInMemory) {
+  PageGroupedDB* db = nullptr;
+  auto options = GetCommonTestOptions();
+  options.use_in_memory_storage = true;
+  options.persist_hot_keys = true;
+  ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).ok());
+  ASSERT_NE(db, nullptr);
+  const std::string value = "Test 1";
+  ASSERT_TRUE(db->BulkLoad(GetRangeDataset(10, 100, value)).ok());
+  std::string out;
+  ASSERT_TRUE(db->Get(10, &out).ok());
+  delete db;
+  db = nullptr;
+  // In-memory DBs do not outlive the process, so there is nothing to warm up.
+  ASSERT_FALSE(std::filesystem::exists(kDBDir / "hot_keys"));
+}
+
+TEST_F(PGDBTest, PersistHotKeysSaveError) {
+  PageGroupedDB* db = nullptr;
+  auto options = GetCommonTestOptions();
+  options.persist_hot_keys = true;
+  ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).ok());
+  ASSERT_NE(db, nullptr);
+  const std::string value = "Test 1";
+  ASSERT_TRUE(db->BulkLoad(GetRangeDataset(10, 100, value)).ok());
+  std::string out;
+  ASSERT_TRUE(db->Get(10, &out).ok());
+
+  // The hot keys cannot be written over a directory. The failure is reported
+  // in the stats and the DB still shuts down.
+  std::filesystem::create_directory(kDBDir / "hot_keys");
+  PageGroupedDBStats::Local().Reset();
+  delete db;
+  db = nullptr;
+  ASSERT_EQ(PageGroupedDBStats::Local().GetHotKeysSaveErrors(), 1);
+  ASSERT_TRUE(std::filesystem::is_directory(kDBDir / "hot_keys"));
+}
+
+TEST_F(PGDBTest, SegmentWriteout) {
+  PageGroupedDB* db = nullptr;
+  auto options = GetCommonTestOptions();
+  options.record_cache_capacity = 64;
+  options.rec_cache_segment_writeout = true;
+  ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).ok());
+  ASSERT_NE(db, nullptr);
+
+  const std::string value = "Test 1";
+  const auto dataset = GetRangeDataset(10, 1000, value);
+  ASSERT_TRUE(db->BulkLoad(dataset).ok());
+
+  // The cache is small, so the writes are written out while they are made.
+  // Each write out covers a whole segment and many of them span several
+  // pages (and overflow pages).
+  const std::string new_value = "Test 2";
+  std::vector<Key> keys;
+  for (Key key = 11; key < 10000; key += 2) {
+    keys.push_back(key);
+  }
+  std::mt19937 prng(42);
+  std::shuffle(keys.begin(), keys.end(), prng);
+  for (const Key key : keys) {
+    ASSERT_TRUE(db->Put(WriteOptions(), key, new_value).ok());
+  }
+
+  const auto check_contents = [&]() {
+    std::string out;
+    for (Key key = 10; key <= 10000; ++key) {
+      if (key % 10 == 0) {
+        ASSERT_TRUE(db->Get(key, &out).ok());
+        ASSERT_EQ(out, value);
+      } else if (key % 2 == 1) {
+        ASSERT_TRUE(db->Get(key, &out).ok());
+        ASSERT_EQ(out, new_value);
+      } else {
+        ASSERT_TRUE(db->Get(key, &out).IsNotFound());
+      }
+    }
+  };
+  check_contents();
+  delete db;
+  db = nullptr;
+
+  ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).ok());
+  ASSERT_NE(db, nullptr);
+  check_contents();
+  std::vector<std::pair<Key, std::string>> scan_out;
+  ASSERT_TRUE(db->GetRange(10, 20000, &scan_out).ok());
+  ASSERT_EQ(scan_out.size(), dataset.size() + keys.size());
+  delete db;
+  db = nullptr;
+}
+
+TEST_F(PGDBTest, DeferredWriteOut) {
+  PageGroupedDB* db = nullptr;
+  auto options = GetCommonTestOptions();
+  options.record_cache_capacity = 64;
+  options.deferred_io_batch_size = 8;
+  options.deferred_io_max_deferrals = 3;
+  ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).ok());
+  ASSERT_NE(db, nullptr);
+
+  const std::string value = "Test 1";
+  const auto dataset = GetRangeDataset(10, 1000, value);
+  ASSERT_TRUE(db->BulkLoad(dataset).ok());
+
+  // Sparse updates: most evicted dirty records are the only dirty record on
+  // their page when they are first selected for eviction.
+  const std::string new_value = "Test 2";
+  std::vector<Key> keys;
+  for (Key key = 11; key < 10000; key += 20) {
+    keys.push_back(key);
+  }
+  std::mt19937 prng(42);
+  std::shuffle(keys.begin(), keys.end(), prng);
+  PageGroupedDBStats::Local().Reset();
+  for (const Key key : keys) {
+    ASSERT_TRUE(db->Put(WriteOptions(), key, new_value).ok());
+  }
+  ASSERT_GT(PageGroupedDBStats::Local().GetCacheDeferredWriteOuts(), 0);
+
+  const auto check_contents = [&]() {
+    std::string out;
+    for (Key key = 10; key <= 10000; ++key) {
+      if (key % 10 == 0) {
+        ASSERT_TRUE(db->Get(key, &out).ok());
+        ASSERT_EQ(out, value);
+      } else if (key % 20 == 11) {
+        ASSERT_TRUE(db->Get(key, &out).ok());
+        ASSERT_EQ(out, new_value);
+      } else {
+        ASSERT_TRUE(db->Get(key, &out).IsNotFound());
+      }
+    }
+  };
+  check_contents();
+  delete db;
+  db = nullptr;
+
+  // Deferred records must still be written out when the DB shuts down.
+  ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).ok());
+  ASSERT_NE(db, nullptr);
+  check_contents();
+  delete db;
+  db = nullptr;
+}
+
+TEST_F(PGDBTest, DeferredWriteOutInvalidMaxDeferrals) {
+  PageGroupedDB* db = nullptr;
+  auto options = GetCommonTestOptions();
+  options.deferred_io_batch_size = 8;
+  // The record cache can only count up to 3 deferrals per record.
+  options.deferred_io_max_deferrals = 4;
+  ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).IsInvalidArgument());
+  ASSERT_EQ(db, nullptr);
+}
+
+TEST_F(PGDBTest, PageCache) {
+  PageGroupedDB* db = nullptr;
+  auto options = GetCommonTestOptions();
+  options.bypass_cache = true;
+  options.page_cache_pages = 64;
+  ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).ok());
+  ASSERT_NE(db, nullptr);
+
+  const std::string value = "Test 1";
+  const auto dataset = GetRangeDataset(10, 1000, value);
+  ASSERT_TRUE(db->BulkLoad(dataset).ok());
+
+  // The record cache is bypassed, so repeated reads of the same page are
+  // served by the page cache.
+  std::string out;
+  PageGroupedDBStats::Local().Reset();
+  ASSERT_TRUE(db->Get(100, &out).ok());
+  ASSERT_EQ(out, value);
+  ASSERT_EQ(PageGroupedDBStats::Local().GetPageCacheHits(), 0);
+  ASSERT_TRUE(db->Get(110, &out).ok());
+  ASSERT_EQ(out, value);
+  ASSERT_TRUE(db->Get(105, &out).IsNotFound());
+  ASSERT_EQ(PageGroupedDBStats::Local().GetPageCacheHits(), 2);
+
+  // Writes invalidate the cached pages.
+  const std::string new_value = "Test 2";
+  for (Key key = 10; key <= 10000; key += 10) {
+    ASSERT_TRUE(db->Get(key, &out).ok());
+    ASSERT_TRUE(db->Put(WriteOptions(), key, new_value).ok());
+    ASSERT_TRUE(db->Put(WriteOptions(), key + 5, new_value).ok());
+    ASSERT_TRUE(db->Get(key, &out).ok());
+    ASSERT_EQ(out, new_value);
+  }
+
+  // Repeated scans are served by the page cache (this includes pages that
+  // were reorganized by the inserts above).
+  std::vector<std::pair<Key, std::string>> scan_out;
+  ASSERT_TRUE(db->GetRange(10, 50, &scan_out).ok());
+  scan_out.clear();
+  PageGroupedDBStats::Local().Reset();
+  ASSERT_TRUE(db->GetRange(10, 50, &scan_out).ok());
+  ASSERT_EQ(scan_out.size(), 50);
+  ASSERT_GT(PageGroupedDBStats::Local().GetPageCacheHits(), 0);
+  ASSERT_EQ(PageGroupedDBStats::Local().GetPageCacheMisses(), 0);
+  for (size_t i = 0; i < scan_out.size(); ++i) {
+    ASSERT_EQ(scan_out[i].first, 10 + i * 5);
+    ASSERT_EQ(scan_out[i].second, new_value);
+  }
+  delete db;
+  db = nullptr;
+
+  ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).ok());
+  ASSERT_NE(db, nullptr);
+  for (Key key = 10; key <= 10000; key += 5) {
+    ASSERT_TRUE(db->Get(key, &out).ok());
+    ASSERT_EQ(out, new_value);
+  }
+  delete db;
+  db = nullptr;
+}
+
+TEST_F(PGDBTest, PinnedGet) {
+  for (const bool bypass_cache : {false, true}) {
+    SCOPED_TRACE(bypass_cache);
+    std::filesystem::remove_all(kDBDir);
+    std::filesystem::create_directory(kDBDir);
+
+    PageGroupedDB* db = nullptr;
+    auto options = GetCommonTestOptions();
+    options.bypass_cache = bypass_cache;
+    ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).ok());
+    ASSERT_NE(db, nullptr);
+
+    const std::string value = "Test 1";
+    const auto dataset = GetRangeDataset(10, 1000, value);
+    ASSERT_TRUE(db->BulkLoad(dataset).ok());
+
+    // The first read goes to disk and caches the record, so the second read
+    // can return the cached value in place.
+    PinnableValue out;
+    ASSERT_TRUE(db->Get(100, &out).ok());
+    ASSERT_FALSE(out.IsPinned());
+    ASSERT_EQ(out.value().ToString(), value);
+    ASSERT_TRUE(db->Get(100, &out).ok());
+    ASSERT_EQ(out.IsPinned(), !bypass_cache);
+    ASSERT_EQ(out.value().ToString(), value);
+
+    // Moving the handle keeps the value.
+    PinnableValue moved(std::move(out));
+    ASSERT_FALSE(out.IsPinned());
+    ASSERT_EQ(moved.value().ToString(), value);
+    moved.Reset();
+    ASSERT_FALSE(moved.IsPinned());
+
+    // Released handles do not block writes.
+    const std::string new_value = "Test 2";
+    ASSERT_TRUE(db->Put(WriteOptions(), 100, new_value).ok());
+    ASSERT_TRUE(db->Put(WriteOptions(), 105, new_value).ok());
+    for (const Key key : {100, 105}) {
+      ASSERT_TRUE(db->Get(key, &out).ok());
+      ASSERT_EQ(out.IsPinned(), !bypass_cache);
+      ASSERT_EQ(out.value().ToString(), new_value);
+    }
+    ASSERT_TRUE(db->Get(103, &out).IsNotFound());
+    ASSERT_FALSE(out.IsPinned());
+    ASSERT_TRUE(out.value().empty());
+
+    // Concurrent readers can pin the same cached record.
+    std::vector<std::thread> threads;
+    std::atomic<size_t> num_errors(0);
+    for (size_t t = 0; t < 4; ++t) {
+      threads.emplace_back([&db, &num_errors, &value]() {
+        PinnableValue thread_out;
+        for (Key key = 10; key <= 1000; key += 10) {
+          if (key == 100) continue;
+          if (!db->Get(key, &thread_out).ok() ||
+              thread_out.value().compare(Slice(value)) != 0) {
+            ++num_errors;
+          }
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    ASSERT_EQ(num_errors.load(), 0);
+
+    delete db;
+    db = nullptr;
+  }
+}
+
+TEST_F(PGDBTest, AsyncApi) {
+  for (const size_t num_async_threads : {1, 4}) {
+    SCOPED_TRACE(num_async_threads);
+    std::filesystem::remove_all(kDBDir);
+    std::filesystem::create_directory(kDBDir);
+
+    PageGroupedDB* db = nullptr;
+    auto options = GetCommonTestOptions();
+    options.num_async_threads = num_async_threads;
+    ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).ok());
+    ASSERT_NE(db, nullptr);
+
+    // Requests on an empty DB complete inline.
+    bool done = false;
+    db->GetAsync(100, [&done](const Status& status, std::string value) {
+      ASSERT_TRUE(status.IsNotFound());
+      done = true;
+    });
+    ASSERT_TRUE(done);
+
+    const std::string value = "Test 1";
+    const auto dataset = GetRangeDataset(10, 1000, value);
+    ASSERT_TRUE(db->BulkLoad(dataset).ok());
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t num_pending = 0;
+    std::atomic<size_t> num_errors(0);
+    const auto finish_one = [&mutex, &cv, &num_pending]() {
+      std::unique_lock<std::mutex> lock(mutex);
+      if (--num_pending == 0) cv.notify_all();
+    };
+    const auto wait_for_all = [&mutex, &cv, &num_pending]() {
+      std::unique_lock<std::mutex> lock(mutex);
+      cv.wait(lock, [&num_pending]() { return num_pending == 0; });
+    };
+    const auto start = [&mutex, &num_pending](const size_t count) {
+      std::unique_lock<std::mutex> lock(mutex);
+      num_pending += count;
+    };
+
+    // Concurrent reads of records on disk.
+    start(100);
+    for (Key key = 10; key <= 1000; key += 10) {
+      db->GetAsync(key, [&](const Status& status, std::string result) {
+        if (!status.ok() || result != value) ++num_errors;
+        finish_one();
+      });
+    }
+    wait_for_all();
+    ASSERT_EQ(num_errors.load(), 0);
+
+    // A cached record is returned inline.
+    done = false;
+    db->GetAsync(500, [&done, &value](const Status& status, std::string res) {
+      ASSERT_TRUE(status.ok());
+      ASSERT_EQ(res, value);
+      done = true;
+    });
+    ASSERT_TRUE(done);
+
+    // Concurrent writes, followed by reads and scans that observe them.
+    const std::string new_value = "Test 2";
+    start(99);
+    for (Key key = 15; key < 1000; key += 10) {
+      db->PutAsync(WriteOptions(), key, new_value,
+                   [&](const Status& status) {
+                     if (!status.ok()) ++num_errors;
+                     finish_one();
+                   });
+    }
+    wait_for_all();
+    ASSERT_EQ(num_errors.load(), 0);
+
+    start(99);
+    for (Key key = 15; key < 1000; key += 10) {
+      db->GetAsync(key, [&](const Status& status, std::string result) {
+        if (!status.ok() || result != new_value) ++num_errors;
+        finish_one();
+      });
+    }
+    std::vector<std::pair<Key, std::string>> scanned;
+    start(1);
+    db->GetRangeAsync(
+        10, 20,
+        [&](const Status& status,
+            std::vector<std::pair<Key, std::string>> results) {
+          if (!status.ok()) ++num_errors;
+          scanned = std::move(results);
+          finish_one();
+        });
+    wait_for_all();
+    ASSERT_EQ(num_errors.load(), 0);
+    ASSERT_EQ(scanned.size(), 20);
+    for (size_t i = 0; i < scanned.size(); ++i) {
+      ASSERT_EQ(scanned[i].first, 10 + i * 5);
+      ASSERT_EQ(scanned[i].second, i % 2 == 0 ? value : new_value);
+    }
+
+    delete db;
+    db = nullptr;
+  }
+}
+
+TEST_F(PGDBTest, AsyncApiDisabled) {
+  PageGroupedDB* db = nullptr;
+  auto options = GetCommonTestOptions();
+  options.num_async_threads = 0;
+  ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).ok());
+  ASSERT_NE(db, nullptr);
+  ASSERT_TRUE(db->BulkLoad(GetRangeDataset(10, 1000, "Test 1")).ok());
+
+  // All the asynchronous methods fail inline.
+  size_t num_done = 0;
+  db->GetAsync(10, [&num_done](const Status& status, std::string value) {
+    ASSERT_TRUE(status.IsNotSupportedError());
+    ++num_done;
+  });
+  db->GetRangeAsync(
+      10, 10,
+      [&num_done](const Status& status,
+                  std::vector<std::pair<Key, std::string>> results) {
+        ASSERT_TRUE(status.IsNotSupportedError());
+        ASSERT_TRUE(results.empty());
+        ++num_done;
+      });
+  db->PutAsync(WriteOptions(), 15, "Test 2",
+               [&num_done](const Status& status) {
+                 ASSERT_TRUE(status.IsNotSupportedError());
+                 ++num_done;
+               });
+  ASSERT_EQ(num_done, 3);
+
+  // The synchronous methods are unaffected.
+  std::string out;
+  ASSERT_TRUE(db->Get(10, &out).ok());
+  ASSERT_TRUE(db->Get(15, &out).IsNotFound());
+  delete db;
+  db = nullptr;
+}
+
+TEST_F(PGDBTest, CoalescedPageReads) {
+  PageGroupedDB* db = nullptr;
+  auto options = GetCommonTestOptions();
+  options.bypass_cache = true;
+  options.coalesce_page_reads = true;
+  // A slow device makes the concurrent reads of a page overlap.
+  options.use_simulated_device = true;
+  options.simulated_device.read_latency_us = 2000;
+  ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).ok());
+  ASSERT_NE(db, nullptr);
+
+  const std::string value = "Test 1";
+  const auto dataset = GetRangeDataset(10, 1000, value);
+  ASSERT_TRUE(db->BulkLoad(dataset).ok());
+  const std::string new_value = "Test 2";
+  ASSERT_TRUE(db->Put(WriteOptions(), 50, new_value).ok());
+
+  const auto get_coalesced_reads = []() {
+    uint64_t result = 0;
+    PageGroupedDBStats::RunOnGlobal([&result](const auto& stats) {
+      result = stats.GetCoalescedPageReads();
+    });
+    return result;
+  };
+  const uint64_t coalesced_before = get_coalesced_reads();
+
+  // All the threads read records on the same page.
+  constexpr size_t kNumThreads = 8;
+  constexpr size_t kReadsPerThread = 20;
+  std::atomic<size_t> num_errors(0);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&db, &num_errors, &value, &new_value, t]() {
+      std::string out;
+      for (size_t i = 0; i < kReadsPerThread; ++i) {
+        const Key key = 10 + ((t + i) % 10) * 10;
+        if (!db->Get(key, &out).ok() ||
+            out != (key == 50 ? new_value : value)) {
+          ++num_errors;
+        }
+        if (!db->Get(key + 5, &out).IsNotFound()) ++num_errors;
+      }
+      PageGroupedDBStats::Local().PostToGlobal();
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  ASSERT_EQ(num_errors.load(), 0);
+  ASSERT_GT(get_coalesced_reads(), coalesced_before);
+
+  // Reads after a write see the new record.
+  ASSERT_TRUE(db->Put(WriteOptions(), 60, new_value).ok());
+  std::string out;
+  ASSERT_TRUE(db->Get(60, &out).ok());
+  ASSERT_EQ(out, new_value);
+  delete db;
+  db = nullptr;
+}
+
+TEST_F(PGDBTest, CompressedPages) {
+  // The page goal is too large for regular pages. About a quarter of the
+  // values are unique, so some pages are also too large to compress fully and
+  // their remaining records are placed in overflow pages.
+  const size_t num_records = 3000;
+  std::vector<std::string> values;
+  values.reserve(num_records);
+  for (size_t i = 0; i < num_records; ++i) {
+    values.push_back(i % 4 == 0 ? "Unique value " + std::to_string(i)
+                                : "Test 1");
+  }
+  std::vector<Record> dataset;
+  for (size_t i = 0; i < num_records; ++i) {
+    dataset.emplace_back((i + 1) * 10, Slice(values[i]));
+  }
+  const std::string new_value = "Test 2";
+  const auto expected_value = [&](const Key key) {
+    if (key % 10 != 0 || (key / 10) % 2 == 1) return new_value;
+    return values[key / 10 - 1];
+  };
+
+  for (const bool use_segments : {true, false}) {
+    SCOPED_TRACE(use_segments);
+    std::filesystem::remove_all(kDBDir);
+    std::filesystem::create_directory(kDBDir);
+
+    PageGroupedDB* db = nullptr;
+    auto options = GetCommonTestOptions();
+    options.use_segments = use_segments;
+    options.bypass_cache = true;
+    options.compress_pages = true;
+    options.records_per_page_goal = 600;
+    options.records_per_page_epsilon = 10;
+    ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).ok());
+    ASSERT_NE(db, nullptr);
+
+    PageGroupedDBStats::Local().Reset();
+    ASSERT_TRUE(db->BulkLoad(dataset).ok());
+    ASSERT_GT(PageGroupedDBStats::Local().GetPagesCompressed(), 0);
+    ASSERT_GT(PageGroupedDBStats::Local().GetOverflowsCreated(), 0);
+
+    std::string out;
+    for (const auto& [key, value] : dataset) {
+      ASSERT_TRUE(db->Get(key, &out).ok());
+      ASSERT_EQ(out, value.ToString());
+      ASSERT_TRUE(db->Get(key + 5, &out).IsNotFound());
+    }
+
+    // Compressed pages are read-only, so these writes go to overflow pages
+    // (and eventually cause the pages to be rewritten).
+    for (Key key = 10; key <= num_records * 10; key += 20) {
+      ASSERT_TRUE(db->Put(WriteOptions(), key, new_value).ok());
+    }
+    for (Key key = 15; key <= 5005; key += 10) {
+      ASSERT_TRUE(db->Put(WriteOptions(), key, new_value).ok());
+    }
+    for (Key key = 10; key <= num_records * 10; key += 10) {
+      ASSERT_TRUE(db->Get(key, &out).ok());
+      ASSERT_EQ(out, expected_value(key));
+    }
+
+    // Scans return the newest version of each record.
+    std::vector<std::pair<Key, std::string>> scan_out;
+    ASSERT_TRUE(db->GetRange(10, 1000, &scan_out).ok());
+    ASSERT_EQ(scan_out.size(), 1000);
+    for (size_t i = 0; i < scan_out.size(); ++i) {
+      ASSERT_EQ(scan_out[i].first, 10 + i * 5);
+      ASSERT_EQ(scan_out[i].second, expected_value(scan_out[i].first));
+    }
+    delete db;
+    db = nullptr;
+
+    ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).ok());
+    ASSERT_NE(db, nullptr);
+    for (Key key = 10; key <= num_records * 10; key += 5) {
+      if (key > 5005 && key % 10 != 0) continue;
+      ASSERT_TRUE(db->Get(key, &out).ok());
+      ASSERT_EQ(out, expected_value(key));
+    }
+    delete db;
+    db = nullptr;
+  }
+}
+
+TEST_F(PGDBTest, DeltaPages) {
+  // The values are long enough for the bulk loaded pages to be about half
+  // full. The inserts all go to a few pages and make them overflow.
+  const std::string value(32, 'a');
+  const std::string new_value(32, 'b');
+  const size_t num_records = 5000;
+  const auto dataset = GetRangeDataset(10, num_records, value);
+  std::map<Key, std::string> expected;
+  for (const auto& [key, _] : dataset) expected[key] = value;
+  std::vector<Key> inserts;
+  for (Key key = 1001; key < 3000; ++key) {
+    if (key % 10 != 0) inserts.push_back(key);
+  }
+  std::shuffle(inserts.begin(), inserts.end(), std::mt19937(42));
+  for (const Key key : inserts) expected[key] = new_value;
+
+  for (const bool use_segments : {true, false}) {
+    SCOPED_TRACE(use_segments);
+    // The same workload is run with overflow pages and then with delta logs.
+    uint64_t rewrites_with_overflows = 0;
+    for (const size_t delta_pages : {0, 8}) {
+      SCOPED_TRACE(delta_pages);
+      std::filesystem::remove_all(kDBDir);
+      std::filesystem::create_directory(kDBDir);
+
+      PageGroupedDB* db = nullptr;
+      auto options = GetCommonTestOptions();
+      options.use_segments = use_segments;
+      options.bypass_cache = true;
+      options.records_per_page_goal = 60;
+      options.delta_pages_per_segment = delta_pages;
+      ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).ok());
+      ASSERT_NE(db, nullptr);
+      ASSERT_TRUE(db->BulkLoad(dataset).ok());
+
+      PageGroupedDBStats::Local().Reset();
+      for (const Key key : inserts) {
+        ASSERT_TRUE(db->Put(WriteOptions(), key, new_value).ok());
+      }
+      // Updates of records that are already in the delta logs.
+      for (size_t i = 0; i < inserts.size(); i += 7) {
+        ASSERT_TRUE(db->Put(WriteOptions(), inserts[i], new_value).ok());
+      }
+
+      const auto check_reads = [&]() {
+        std::string out;
+        for (const auto& [key, val] : expected) {
+          ASSERT_TRUE(db->Get(key, &out).ok());
+          ASSERT_EQ(out, val);
+        }
+        ASSERT_TRUE(db->Get(num_records * 10 + 5, &out).IsNotFound());
+
+        std::vector<std::pair<Key, std::string>> scan_out;
+        ASSERT_TRUE(db->GetRange(1, expected.size(), &scan_out).ok());
+        ASSERT_EQ(scan_out.size(), expected.size());
+        auto it = expected.begin();
+        for (size_t i = 0; i < scan_out.size(); ++i, ++it) {
+          ASSERT_EQ(scan_out[i].first, it->first);
+          ASSERT_EQ(scan_out[i].second, it->second);
+        }
+        // A scan that starts in the middle of a page.
+        std::vector<std::pair<Key, std::string>> short_scan_out;
+        ASSERT_TRUE(db->GetRange(1500, 10, &short_scan_out).ok());
+        ASSERT_EQ(short_scan_out.size(), 10);
+        for (size_t i = 0; i < short_scan_out.size(); ++i) {
+          ASSERT_EQ(short_scan_out[i].first, 1500 + i);
+        }
+      };
+      check_reads();
+      if (delta_pages == 0) {
+        rewrites_with_overflows = PageGroupedDBStats::Local().GetRewrites();
+        ASSERT_EQ(PageGroupedDBStats::Local().GetDeltaPagesCreated(), 0);
+      } else {
+        ASSERT_GT(PageGroupedDBStats::Local().GetDeltaPagesCreated(), 0);
+        ASSERT_GT(PageGroupedDBStats::Local().GetDeltaPageReads(), 0);
+        ASSERT_LT(PageGroupedDBStats::Local().GetRewrites(),
+                  rewrites_with_overflows);
+      }
+
+      // The delta logs are recovered when the DB is reopened.
+      delete db;
+      db = nullptr;
+      ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).ok());
+      ASSERT_NE(db, nullptr);
+      check_reads();
+
+      // Merges the delta logs back into the segments.
+      if (use_segments) {
+        ASSERT_TRUE(db->FlattenRange().ok());
+        check_reads();
+      }
+      delete db;
+      db = nullptr;
+    }
+  }
+}
+
+TEST_F(PGDBTest, PageChecksums) {
+  auto options = GetCommonTestOptions();
+  options.use_segments = false;
+  options.bypass_cache = true;
+  options.records_per_page_goal = 44;
+  options.records_per_page_epsilon = 5;
+
+  const std::string value = "Test 1";
+  const auto dataset = GetRangeDataset(10, 1000, value);
+  PageGroupedDB* db = nullptr;
+  ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).ok());
+  ASSERT_NE(db, nullptr);
+  ASSERT_TRUE(db->BulkLoad(dataset).ok());
+  delete db;
+  db = nullptr;
+
+  // Corrupt a byte in the free space of the first page (it holds the smallest
+  // keys). The page's records are unaffected, but its checksum no longer
+  // matches.
+  {
+    std::fstream file(kDBDir / "sf-0",
+                      std::ios::in | std::ios::out | std::ios::binary);
+    ASSERT_TRUE(file.is_open());
+    file.seekg(2048);
+    const char byte = file.get();
+    file.seekp(2048);
+    file.put(byte ^ 0xFF);
+  }
+
+  std::string out;
+  std::vector<std::pair<Key, std::string>> scan_out;
+  ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).ok());
+  ASSERT_NE(db, nullptr);
+  PageGroupedDBStats::Local().Reset();
+  ASSERT_TRUE(db->Get(10, &out).IsCorruption());
+  ASSERT_TRUE(db->GetRange(10, 10, &scan_out).IsCorruption());
+  ASSERT_EQ(PageGroupedDBStats::Local().GetPageChecksumFailures(), 2);
+  // Other pages can still be read.
+  ASSERT_TRUE(db->Get(dataset.back().first, &out).ok());
+  ASSERT_EQ(out, value);
+  delete db;
+  db = nullptr;
+
+  // Without verification, the corrupted page's records are returned as-is.
+  options.verify_page_checksums = false;
+  ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).ok());
+  ASSERT_NE(db, nullptr);
+  PageGroupedDBStats::Local().Reset();
+  ASSERT_TRUE(db->Get(10, &out).ok());
+  ASSERT_EQ(out, value);
+  ASSERT_TRUE(db->GetRange(10, 10, &scan_out).ok());
+  ASSERT_EQ(scan_out.size(), 10);
+  ASSERT_EQ(PageGroupedDBStats::Local().GetPagesVerified(), 0);
+  delete db;
+  db = nullptr;
+}
+
+TEST_F(PGDBTest, PageChecksumsOnWrite) {
+  auto options = GetCommonTestOptions();
+  options.use_segments = false;
+  options.bypass_cache = true;
+  options.records_per_page_goal = 44;
+  options.records_per_page_epsilon = 5;
+
+  const std::string value = "Test 1";
+  const std::string new_value = "Test 2";
+  const auto dataset = GetRangeDataset(10, 1000, value);
+  PageGroupedDB* db = nullptr;
+  ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).ok());
+  ASSERT_NE(db, nullptr);
+  ASSERT_TRUE(db->BulkLoad(dataset).ok());
+  delete db;
+  db = nullptr;
+
+  // Corrupt the first page's free space (see `PageChecksums`).
+  {
+    std::fstream file(kDBDir / "sf-0",
+                      std::ios::in | std::ios::out | std::ios::binary);
+    ASSERT_TRUE(file.is_open());
+    file.seekg(2048);
+    const char byte = file.get();
+    file.seekp(2048);
+    file.put(byte ^ 0xFF);
+  }
+
+  // Writes to the corrupted page fail; writes to other pages succeed.
+  std::string out;
+  ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).ok());
+  ASSERT_NE(db, nullptr);
+  ASSERT_TRUE(db->Put(WriteOptions(), 10, new_value).IsCorruption());
+  ASSERT_TRUE(db->Put(WriteOptions(), dataset.back().first, new_value).ok());
+  ASSERT_TRUE(db->Get(dataset.back().first, &out).ok());
+  ASSERT_EQ(out, new_value);
+  delete db;
+  db = nullptr;
+
+  // With the record cache, a dirty record that cannot be written out stays in
+  // the cache.
+  options.bypass_cache = false;
+  options.record_cache_capacity = 1;
+  ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).ok());
+  ASSERT_NE(db, nullptr);
+  ASSERT_TRUE(db->Put(WriteOptions(), 10, new_value).ok());
+  ASSERT_TRUE(
+      db->Put(WriteOptions(), dataset.back().first, value).IsCorruption());
+  ASSERT_TRUE(db->Get(10, &out).ok());
+  ASSERT_EQ(out, new_value);
+  delete db;
+  db = nullptr;
+
+  // The failed writes did not modify the corrupted page (its checksum was not
+  // recomputed).
+  options.bypass_cache = true;
+  ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).ok());
+  ASSERT_NE(db, nullptr);
+  ASSERT_TRUE(db->Get(10, &out).IsCorruption());
+  options.verify_page_checksums = false;
+  delete db;
+  db = nullptr;
+  ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).ok());
+  ASSERT_NE(db, nullptr);
+  ASSERT_TRUE(db->Get(10, &out).ok());
+  ASSERT_EQ(out, value);
+  delete db;
+  db = nullptr;
+}
+
+TEST_F(PGDBTest, PageChecksumsOlderPages) {
+  auto options = GetCommonTestOptions();
+  options.use_segments = false;
+  options.bypass_cache = true;
+  options.records_per_page_goal = 44;
+  options.records_per_page_epsilon = 5;
+
+  const std::string value = "Test 1";
+  const auto dataset = GetRangeDataset(10, 1000, value);
+  PageGroupedDB* db = nullptr;
+  ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).ok());
+  ASSERT_NE(db, nullptr);
+  ASSERT_TRUE(db->BulkLoad(dataset).ok());
+  delete db;
+  db = nullptr;
+
+  // Make the first page look like one written before page checksums were
+  // added: its header's checksum flag (byte 104, see `PackedMap`) is cleared
+  // and the checksum bytes that follow it are zero. Then modify its free
+  // space; older pages cannot be verified, so this goes undetected.
+  {
+    std::fstream file(kDBDir / "sf-0",
+                      std::ios::in | std::ios::out | std::ios::binary);
+    ASSERT_TRUE(file.is_open());
+    file.seekg(104);
+    const char flags = file.get();
+    file.seekp(104);
+    file.put(static_cast<char>(flags & ~0x10));
+    file.put(0);
+    file.put(0);
+    file.put(0);
+    file.seekg(2048);
+    const char byte = file.get();
+    file.seekp(2048);
+    file.put(byte ^ 0xFF);
+  }
+
+  std::string out;
+  ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).ok());
+  ASSERT_NE(db, nullptr);
+  PageGroupedDBStats::Local().Reset();
+  ASSERT_TRUE(db->Get(10, &out).ok());
+  ASSERT_EQ(out, value);
+  ASSERT_EQ(PageGroupedDBStats::Local().GetPageChecksumFailures(), 0);
+  delete db;
+  db = nullptr;
+}
+
+TEST_F(PGDBTest, Scrubber) {
+  PageGroupedDB* db = nullptr;
+  auto options = GetCommonTestOptions();
+  options.bypass_cache = true;
+  options.scrubber.interval_ms = 1;
+  options.scrubber.max_pages_per_second = 0;
+  ASSERT_TRUE(PageGroupedDB::Open(options, kDBDir, &db).ok());
+  ASSERT_NE(db, nullptr);
+
+  const std::string value = "Test 1";
+  const auto dataset = GetRangeDataset(10, 5000, value);
+  ASSERT_TRUE(db->BulkLoad(dataset).ok());
+
+  const auto get_scrub_stats = []() {
+    std::tuple<uint64_t, uint64_t, uint64_t> result;
+    PageGroupedDBStats::RunOnGlobal([&result](const auto& stats) {
+      result = {stats.GetScrubbedSegments(), stats.GetScrubChecksumFailures(),
+                stats.GetScrubInvariantViolations()};
+    });
+    return result;
+  };
+  const auto [segments_before, checksum_failures_before,
+              violations_before] = get_scrub_stats();
+
+  // Writes (which create overflow pages and cause reorganizations) run
+  // concurrently with the scrubber, which should not report any problems.
+  const std::string new_value = "Test 2";
+  for (Key key = 15; key < 50000; key += 10) {
+    ASSERT_TRUE(db->Put(WriteOptions(), key, new_value).ok());
+  }
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (std::get<0>(get_scrub_stats()) == segments_before &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  const auto [segments_after, checksum_failures_after, violations_after] =
+      get_scrub_stats();
+  ASSERT_GT(segments_after, segments_before);
+  ASSERT_EQ(checksum_failures_after, checksum_failures_before);
+  ASSERT_EQ(violations_after, violations_before);
+
+  // Closing the DB should not wait for a paused scrubber.
+  db->SetScrubberPaused(true);
+  delete db;
+  db = nullptr;
+}
+
 }  // namespace
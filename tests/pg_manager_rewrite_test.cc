@@ -1,5 +1,6 @@
 #include <algorithm>
 #include <filesystem>
+#include <fstream>
 #include <numeric>
 #include <utility>
 #include <vector>
@@ -9,6 +10,7 @@
 #include "treeline/slice.h"
 #include "page_grouping/key.h"
 #include "page_grouping/manager.h"
+#include "page_grouping/reorg_log.h"
 #include "page_grouping/segment_info.h"
 #include "pg_datasets.h"
 
@@ -323,4 +325,111 @@ TEST_F(PGManagerRewriteTest, InsertMiddlePages) {
   }
 }
 
+TEST_F(PGManagerRewriteTest, ReorgLogSegments) {
+  auto options = GetOptions(/*goal=*/15, /*epsilon=*/5, /*use_segments=*/true);
+  options.write_reorg_log = true;
+
+  // Create a new dataset by multiplying each sequential key by 1000.
+  std::vector<uint64_t> new_keys;
+  new_keys.reserve(Datasets::kSequentialKeys.size());
+  for (const auto& k : Datasets::kSequentialKeys) {
+    new_keys.push_back(k * 1000);
+  }
+  const std::vector<std::pair<uint64_t, Slice>> dataset =
+      BuildRecords(new_keys, u8"08 bytes");
+
+  // Insert a few records into each gap, one at a time, to create overflows
+  // and eventually trigger rewrites.
+  const std::string inserted_value = u8"08+bytes";
+  Manager m = Manager::LoadIntoNew(kDBDir, dataset, options);
+  ASSERT_TRUE(m.GetReorgEvents().empty());
+  const size_t mid = new_keys.size() / 2;
+  for (uint64_t offset = 1; offset <= 100; ++offset) {
+    for (size_t i = mid - 10; i < mid + 10; ++i) {
+      ASSERT_TRUE(
+          m.PutBatch({{new_keys[i] + offset, Slice(inserted_value)}}).ok());
+    }
+  }
+
+  const auto events = m.GetReorgEvents();
+  ASSERT_FALSE(events.empty());
+  for (const auto& event : events) {
+    ASSERT_EQ(event.trigger, ReorgTrigger::kOverflowFull);
+    ASSERT_LT(event.lower, event.upper);
+    ASSERT_GE(event.segments_in, 1);
+    ASSERT_GE(event.segments_out, 1);
+    ASSERT_GE(event.pages_read, event.segments_in);
+    ASSERT_GE(event.pages_written, event.segments_out + event.segments_in);
+    ASSERT_EQ(event.records_merged, 1);
+    ASSERT_LE(event.lock_wait, event.duration);
+  }
+
+  // An explicit flatten should be logged with its own trigger.
+  ASSERT_TRUE(m.FlattenRange().ok());
+  const auto after_flatten = m.GetReorgEvents();
+  ASSERT_GE(after_flatten.size(), events.size());
+  for (size_t i = events.size(); i < after_flatten.size(); ++i) {
+    ASSERT_EQ(after_flatten[i].trigger, ReorgTrigger::kFlatten);
+    ASSERT_EQ(after_flatten[i].records_merged, 0);
+  }
+
+  // The CSV sink has a header and one line per event.
+  std::ifstream csv(kDBDir / "debug" / "reorg_log.csv");
+  ASSERT_TRUE(csv.is_open());
+  size_t num_lines = 0;
+  std::string line;
+  while (std::getline(csv, line)) {
+    ++num_lines;
+  }
+  ASSERT_EQ(num_lines, after_flatten.size() + 1);
+}
+
+TEST_F(PGManagerRewriteTest, ReorgLogPages) {
+  auto options = GetOptions(/*goal=*/15, /*epsilon=*/5, /*use_segments=*/false);
+
+  std::vector<uint64_t> new_keys;
+  new_keys.reserve(Datasets::kSequentialKeys.size());
+  for (const auto& k : Datasets::kSequentialKeys) {
+    new_keys.push_back(k * 1000);
+  }
+  const std::vector<std::pair<uint64_t, Slice>> dataset =
+      BuildRecords(new_keys, u8"08 bytes");
+
+  // A large batch into a single page triggers an immediate flatten.
+  const std::string inserted_value = u8"08+bytes";
+  const size_t mid = new_keys.size() / 2;
+  std::vector<std::pair<uint64_t, Slice>> inserts;
+  for (uint64_t offset = 1; offset <= 100; ++offset) {
+    inserts.emplace_back(new_keys[mid] + offset, inserted_value);
+  }
+
+  Manager m = Manager::LoadIntoNew(kDBDir, dataset, options);
+  ASSERT_TRUE(m.PutBatch(inserts).ok());
+
+  const auto events = m.GetReorgEvents();
+  ASSERT_EQ(events.size(), 1);
+  ASSERT_EQ(events[0].trigger, ReorgTrigger::kBatchThreshold);
+  ASSERT_EQ(events[0].segments_in, 1);
+  ASSERT_GT(events[0].segments_out, 1);
+  ASSERT_EQ(events[0].records_merged, inserts.size());
+  ASSERT_LE(events[0].lower, inserts.front().first);
+  ASSERT_GT(events[0].upper, inserts.back().first);
+}
+
+TEST(ReorgLogTest, RingBuffer) {
+  ReorgLog log(/*capacity=*/2, /*csv_path=*/std::nullopt);
+  for (Key i = 1; i <= 3; ++i) {
+    ReorgEvent event;
+    event.lower = i;
+    event.upper = i + 1;
+    event.start = std::chrono::steady_clock::now();
+    log.Record(event);
+  }
+  ASSERT_EQ(log.NumRecorded(), 3);
+  const auto events = log.GetEvents();
+  ASSERT_EQ(events.size(), 2);
+  ASSERT_EQ(events[0].lower, 2);
+  ASSERT_EQ(events[1].lower, 3);
+}
+
 }  // namespace
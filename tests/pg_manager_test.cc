@@ -1,4 +1,7 @@
+#include <algorithm>
 #include <filesystem>
+#include <fstream>
+#include <optional>
 #include <random>
 #include <string>
 #include <vector>
@@ -6,9 +9,15 @@
 #include "gtest/gtest.h"
 #include "page_grouping/key.h"
 #include "page_grouping/manager.h"
+#include "page_grouping/persist/cached_segment_file.h"
+#include "page_grouping/persist/memory_segment_file.h"
+#include "page_grouping/persist/page.h"
+#include "page_grouping/plr/data.h"
+#include "page_grouping/segment_access_tracker.h"
 #include "page_grouping/segment_info.h"
 #include "pg_datasets.h"
 #include "treeline/pg_options.h"
+#include "treeline/pg_stats.h"
 #include "treeline/slice.h"
 #include "util/key.h"
 
@@ -85,6 +94,45 @@ TEST_F(PGManagerTest, CreateReopenSegments) {
   }
 }
 
+TEST_F(PGManagerTest, ReopenIncompatibleModel) {
+  auto options = GetOptions(/*goal=*/15, /*epsilon=*/5, /*use_segments=*/true);
+  options.use_memory_based_io = false;
+
+  std::vector<std::pair<uint64_t, Slice>> dataset =
+      BuildRecords(Datasets::kUniformKeys, u8"08 bytes");
+  SegmentId seg_id;
+  {
+    Manager m = Manager::LoadIntoNew(kDBDir, dataset, options);
+    for (auto it = m.IndexBeginIterator(); it != m.IndexEndIterator(); ++it) {
+      if (it->second.model().has_value()) {
+        seg_id = it->second.id();
+        break;
+      }
+    }
+  }
+  ASSERT_TRUE(seg_id.IsValid());
+
+  // Simulate a segment written by an older version, which stored models with
+  // full precision.
+  {
+    std::fstream file(kDBDir / ("sf-" + std::to_string(seg_id.GetFileId())),
+                      std::ios::in | std::ios::out | std::ios::binary);
+    ASSERT_TRUE(file.is_open());
+    std::vector<char> buf(pg::Page::kSize);
+    file.seekg(seg_id.GetOffset() * pg::Page::kSize);
+    file.read(buf.data(), pg::Page::kSize);
+    pg::Page page(buf.data());
+    page.SetModel(plr::Line64(0.1, 0.0));
+    page.ComputeAndSetPageChecksum();
+    file.seekp(seg_id.GetOffset() * pg::Page::kSize);
+    file.write(buf.data(), pg::Page::kSize);
+  }
+
+  std::optional<Manager> m;
+  ASSERT_TRUE(Manager::Reopen(kDBDir, options, &m).IsNotSupportedError());
+  ASSERT_FALSE(m.has_value());
+}
+
 TEST_F(PGManagerTest, CreateReopenPages) {
   auto options = GetOptions(/*goal=*/15, /*epsilon=*/5, /*use_segments=*/false);
 
@@ -692,4 +740,262 @@ TEST_F(PGManagerTest, PageBoundsConsistency) {
   }
 }
 
+TEST_F(PGManagerTest, AccessHeatmap) {
+  auto options = GetOptions(/*goal=*/15, /*epsilon=*/5, /*use_segments=*/true);
+  options.access_sample_interval = 1;
+
+  std::vector<std::pair<uint64_t, Slice>> dataset =
+      BuildRecords(Datasets::kSequentialKeys, u8"08 bytes");
+  Manager m = Manager::LoadIntoNew(kDBDir, dataset, options);
+  ASSERT_TRUE(m.GetAccessHeatmap().empty());
+
+  // Read one key repeatedly, read a second key once, and write to a third
+  // part of the key space.
+  const Key hot_key = dataset[10].first;
+  const Key cold_key = dataset[dataset.size() / 2].first;
+  const Key write_key = dataset[dataset.size() - 10].first;
+  std::string out;
+  for (size_t i = 0; i < 10; ++i) {
+    ASSERT_TRUE(m.Get(hot_key, &out).ok());
+  }
+  ASSERT_TRUE(m.Get(cold_key, &out).ok());
+  m.RecordCacheMiss(cold_key);
+  const std::string value = u8"08+bytes";
+  ASSERT_TRUE(m.PutBatch({{write_key, value}, {write_key + 1, value}}).ok());
+
+  const auto heatmap = m.GetAccessHeatmap();
+  ASSERT_EQ(heatmap.size(), 3);
+  uint64_t total_reads = 0, total_writes = 0, total_misses = 0;
+  for (size_t i = 0; i < heatmap.size(); ++i) {
+    if (i > 0) ASSERT_LE(heatmap[i - 1].upper, heatmap[i].lower);
+    total_reads += heatmap[i].counts.reads;
+    total_writes += heatmap[i].counts.writes;
+    total_misses += heatmap[i].counts.cache_misses;
+  }
+  ASSERT_EQ(total_reads, 11);
+  ASSERT_EQ(total_writes, 2);
+  ASSERT_EQ(total_misses, 1);
+
+  const auto hottest = m.GetHottestSegments(/*k=*/1);
+  ASSERT_EQ(hottest.size(), 1);
+  ASSERT_LE(hottest[0].lower, hot_key);
+  ASSERT_GT(hottest[0].upper, hot_key);
+  ASSERT_EQ(hottest[0].counts.reads, 10);
+  ASSERT_EQ(m.GetHottestSegments(/*k=*/10).size(), 3);
+
+  // Counters for rewritten segments are attributed to the new segments.
+  ASSERT_TRUE(m.FlattenRange().ok());
+  uint64_t reads_after_flatten = 0;
+  for (const auto& seg : m.GetAccessHeatmap()) {
+    reads_after_flatten += seg.counts.reads;
+  }
+  ASSERT_EQ(reads_after_flatten, total_reads);
+}
+
+TEST_F(PGManagerTest, AccessTrackerBoundedAcrossReorgs) {
+  auto options = GetOptions(/*goal=*/4, /*epsilon=*/1, /*use_segments=*/true);
+  options.access_sample_interval = 1;
+
+  // 512 B string.
+  std::string value;
+  value.resize(512);
+  std::mt19937 prng(42);
+  std::uniform_int_distribution<Key> key_dist(1, 1000000);
+  std::vector<Key> keys;
+  for (size_t i = 0; i < 128; ++i) keys.push_back(key_dist(prng));
+  std::sort(keys.begin(), keys.end());
+  keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+  Manager m = Manager::LoadIntoNew(kDBDir, BuildRecords(keys, value), options);
+
+  // Each round inserts random keys (forcing reorganizations that move the
+  // segment boundaries) and then reads every key, so every current segment
+  // has counters.
+  PageGroupedDBStats::Local().Reset();
+  std::string out;
+  uint64_t num_reads = 0;
+  for (size_t round = 0; round < 20; ++round) {
+    std::vector<Key> inserts;
+    for (size_t i = 0; i < 64; ++i) inserts.push_back(key_dist(prng));
+    std::sort(inserts.begin(), inserts.end());
+    inserts.erase(std::unique(inserts.begin(), inserts.end()), inserts.end());
+    ASSERT_TRUE(m.PutBatch(BuildRecords(inserts, value)).ok());
+    keys.insert(keys.end(), inserts.begin(), inserts.end());
+    for (const Key key : keys) {
+      ASSERT_TRUE(m.Get(key, &out).ok());
+    }
+    num_reads += keys.size();
+    // The counters of replaced segments are moved to their replacements.
+    m.PostStats();
+    ASSERT_LE(m.GetNumTrackedSegments(),
+              PageGroupedDBStats::Local().GetSegments());
+  }
+  ASSERT_GT(PageGroupedDBStats::Local().GetRewrites(), 0);
+  ASSERT_GT(m.GetNumTrackedSegments(), 0);
+
+  // No accesses are lost.
+  uint64_t total_reads = 0;
+  for (const auto& seg : m.GetAccessHeatmap()) {
+    total_reads += seg.counts.reads;
+  }
+  ASSERT_EQ(total_reads, num_reads);
+}
+
+TEST_F(PGManagerTest, ScrubSegments) {
+  auto options = GetOptions(/*goal=*/15, /*epsilon=*/5, /*use_segments=*/true);
+  std::vector<std::pair<uint64_t, Slice>> dataset =
+      BuildRecords(Datasets::kUniformKeys, u8"08 bytes");
+  // The inserted records do not fit on the pages.
+  const std::string value(256, 0xFF);
+  std::vector<std::pair<uint64_t, Slice>> inserts;
+  for (const auto& record : dataset) {
+    inserts.emplace_back(record.first + 1, value);
+  }
+
+  size_t num_segments = 0;
+  SegmentId corrupt_id;
+  {
+    Manager m = Manager::LoadIntoNew(kDBDir, dataset, options);
+    // Create overflow pages.
+    PageGroupedDBStats::Local().Reset();
+    ASSERT_TRUE(m.PutBatch(inserts).ok());
+    ASSERT_GT(PageGroupedDBStats::Local().GetOverflowsCreated(), 0);
+    for (auto it = m.IndexBeginIterator(); it != m.IndexEndIterator(); ++it) {
+      ++num_segments;
+      if (!corrupt_id.IsValid() && it->second.page_count() > 1) {
+        corrupt_id = it->second.id();
+      }
+    }
+    ASSERT_TRUE(corrupt_id.IsValid());
+
+    PageGroupedDBStats::Local().Reset();
+    size_t pages_read = 0, throttle_calls = 0;
+    ASSERT_EQ(m.ScrubSegments([&](const size_t pages) {
+      pages_read += pages;
+      ++throttle_calls;
+      return true;
+    }),
+              0);
+    ASSERT_EQ(throttle_calls, num_segments);
+    ASSERT_EQ(PageGroupedDBStats::Local().GetScrubbedSegments(), num_segments);
+    ASSERT_EQ(PageGroupedDBStats::Local().GetScrubbedPages(), pages_read);
+    ASSERT_GT(pages_read, num_segments);
+    ASSERT_EQ(PageGroupedDBStats::Local().GetScrubChecksumFailures(), 0);
+    ASSERT_EQ(PageGroupedDBStats::Local().GetScrubInvariantViolations(), 0);
+
+    // The pass stops when the throttle returns false.
+    PageGroupedDBStats::Local().Reset();
+    m.ScrubSegments([](const size_t pages) { return false; });
+    ASSERT_EQ(PageGroupedDBStats::Local().GetScrubbedSegments(), 1);
+  }
+
+  // Corrupt a byte in the second page of a multi-page segment.
+  {
+    std::fstream file(kDBDir / ("sf-" + std::to_string(corrupt_id.GetFileId())),
+                      std::ios::in | std::ios::out | std::ios::binary);
+    ASSERT_TRUE(file.is_open());
+    const size_t offset = (corrupt_id.GetOffset() + 1) * pg::Page::kSize + 2048;
+    file.seekg(offset);
+    const char byte = file.get();
+    file.seekp(offset);
+    file.put(byte ^ 0xFF);
+  }
+  {
+    Manager m = Manager::Reopen(kDBDir, options);
+    PageGroupedDBStats::Local().Reset();
+    ASSERT_EQ(m.ScrubSegments([](const size_t pages) { return true; }), 1);
+    ASSERT_EQ(PageGroupedDBStats::Local().GetScrubbedSegments(), num_segments);
+    ASSERT_EQ(PageGroupedDBStats::Local().GetScrubChecksumFailures(), 1);
+    ASSERT_EQ(PageGroupedDBStats::Local().GetScrubInvariantViolations(), 0);
+  }
+}
+
+TEST(SegmentAccessTrackerTest, IndependentSampleIntervals) {
+  // Trackers used by the same thread sample at their own rates.
+  SegmentAccessTracker every(/*sample_interval=*/1);
+  SegmentAccessTracker fourth(/*sample_interval=*/4);
+  size_t every_samples = 0, fourth_samples = 0;
+  for (size_t i = 0; i < 16; ++i) {
+    if (every.ShouldSample()) ++every_samples;
+    if (fourth.ShouldSample()) ++fourth_samples;
+  }
+  ASSERT_EQ(every_samples, 16);
+  ASSERT_EQ(fourth_samples, 4);
+}
+
+TEST(SegmentAccessTrackerTest, Move) {
+  SegmentAccessTracker tracker(/*sample_interval=*/1);
+  tracker.Add(10, SegmentAccessType::kRead, 3);
+  tracker.Add(20, SegmentAccessType::kWrite, 2);
+  tracker.Add(20, SegmentAccessType::kRead, 1);
+
+  // Merges into existing counters.
+  tracker.Move(20, 10);
+  ASSERT_EQ(tracker.size(), 1);
+  // Creates the destination's counters.
+  tracker.Move(10, 30);
+  // Missing sources and self moves do nothing.
+  tracker.Move(40, 30);
+  tracker.Move(30, 30);
+
+  const auto snapshot = tracker.Snapshot();
+  ASSERT_EQ(snapshot.size(), 1);
+  ASSERT_EQ(snapshot[0].first, 30);
+  ASSERT_EQ(snapshot[0].second.reads, 4);
+  ASSERT_EQ(snapshot[0].second.writes, 2);
+}
+
+TEST(PageCacheTest, PartialHitsFetchMissingPages) {
+  constexpr size_t kPages = 4;
+  auto cache = std::make_shared<PageCache>(/*capacity_pages=*/64);
+  CachedSegmentFile file(
+      std::make_unique<MemorySegmentFile>(/*pages_per_segment=*/kPages,
+                                          /*max_bytes=*/1 << 20,
+                                          /*use_huge_pages=*/false),
+      /*file_index=*/0, cache);
+  const size_t offset = file.AllocateSegment();
+  PageBuffer in = PageMemoryAllocator::Allocate(kPages);
+  PageBuffer out = PageMemoryAllocator::Allocate(kPages);
+  for (size_t i = 0; i < kPages; ++i) {
+    memset(in.get() + i * pg::Page::kSize, 'a' + i, pg::Page::kSize);
+  }
+  ASSERT_TRUE(file.WritePages(offset, in.get(), kPages).ok());
+
+  // Cache the first page, then read all pages. Only the uncached pages are
+  // read from the file.
+  PageGroupedDBStats::Local().Reset();
+  ASSERT_TRUE(file.ReadPages(offset, out.get(), /*num_pages=*/1).ok());
+  ASSERT_EQ(PageGroupedDBStats::Local().GetPageCacheMisses(), 1);
+  ASSERT_TRUE(file.ReadPages(offset, out.get(), kPages).ok());
+  ASSERT_EQ(PageGroupedDBStats::Local().GetPageCacheHits(), 1);
+  ASSERT_EQ(PageGroupedDBStats::Local().GetPageCacheMisses(), kPages);
+  ASSERT_EQ(memcmp(in.get(), out.get(), kPages * pg::Page::kSize), 0);
+
+  memset(out.get(), 0, kPages * pg::Page::kSize);
+  ASSERT_TRUE(file.ReadPages(offset, out.get(), kPages).ok());
+  ASSERT_EQ(PageGroupedDBStats::Local().GetPageCacheHits(), 1 + kPages);
+  ASSERT_EQ(PageGroupedDBStats::Local().GetPageCacheMisses(), kPages);
+  ASSERT_EQ(memcmp(in.get(), out.get(), kPages * pg::Page::kSize), 0);
+}
+
+TEST(PageCacheTest, InvalidationOnlyAffectsItsPage) {
+  PageCache cache(/*capacity_pages=*/16);
+  PageBuffer page = PageMemoryAllocator::Allocate(/*num_pages=*/1);
+  memset(page.get(), 'x', pg::Page::kSize);
+
+  // Pages 1 and 17 share a shard. Invalidating one of them while the other is
+  // being read does not keep the other out of the cache.
+  const uint64_t version = cache.GetVersion(1);
+  cache.Invalidate(17);
+  cache.Insert(1, page.get(), version);
+  PageBuffer out = PageMemoryAllocator::Allocate(/*num_pages=*/1);
+  ASSERT_TRUE(cache.Lookup(1, out.get()));
+  ASSERT_EQ(memcmp(page.get(), out.get(), pg::Page::kSize), 0);
+
+  // Invalidating the page itself does.
+  const uint64_t stale_version = cache.GetVersion(2);
+  cache.Invalidate(2);
+  cache.Insert(2, page.get(), stale_version);
+  ASSERT_FALSE(cache.Lookup(2, out.get()));
+}
+
 }  // namespace
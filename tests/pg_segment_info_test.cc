@@ -1,8 +1,16 @@
 #include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
 #include "gtest/gtest.h"
+#include "page_grouping/key.h"
 #include "page_grouping/persist/segment_id.h"
 #include "page_grouping/plr/data.h"
+#include "page_grouping/segment_builder.h"
 #include "page_grouping/segment_info.h"
+#include "pg_datasets.h"
+#include "treeline/slice.h"
 
 namespace {
 
@@ -34,4 +42,55 @@ TEST(SegmentInfoTest, SetOverflow) {
   ASSERT_TRUE(info.HasOverflow());
 }
 
+TEST(SegmentInfoTest, CompactModel) {
+  SegmentId id(2, 128);
+  SegmentInfo info(id, std::optional<plr::Line64>());
+  ASSERT_FALSE(info.model().has_value());
+
+  // Models that are not exactly representable cannot be stored.
+  ASSERT_THROW(SegmentInfo(id, plr::Line64(0.1, 0.0)), std::runtime_error);
+  const plr::Line64 quantized =
+      SegmentInfo::QuantizeModel(plr::Line64(0.1, 0.0));
+  SegmentInfo with_model(id, quantized);
+  ASSERT_TRUE(with_model.model().has_value());
+  ASSERT_EQ(*with_model.model(), quantized);
+}
+
+TEST(SegmentInfoTest, RecordsFitPages) {
+  std::vector<std::pair<uint64_t, Slice>> records;
+  records.reserve(Datasets::kUniformKeys.size());
+  for (const auto& key : Datasets::kUniformKeys) {
+    records.emplace_back(key, Slice());
+  }
+  const size_t goal = 44;
+  const size_t epsilon = 5;
+  SegmentBuilder builder(goal, epsilon);
+  const auto segments = builder.BuildFromDataset(records);
+
+  // The builder sizes and fills segments using the compact model that the
+  // index stores. Each record must map to one of the segment's pages, and no
+  // page can receive more records than the model's error bound allows.
+  size_t multi_page_segments = 0;
+  for (const auto& seg : segments) {
+    if (seg.page_count == 1) continue;
+    ++multi_page_segments;
+    ASSERT_TRUE(seg.model.has_value());
+    ASSERT_TRUE(SegmentInfo::CanStoreExactly(seg.model->line()));
+    const size_t file_id =
+        SegmentBuilder::PageCountToSegment().find(seg.page_count)->second;
+    SegmentInfo info(SegmentId(file_id, 0), seg.model->line());
+
+    std::vector<size_t> records_per_page(seg.page_count, 0);
+    for (const auto& rec : seg.records) {
+      const size_t page_idx = info.PageForKey(seg.base_key, rec.first);
+      ASSERT_LT(page_idx, seg.page_count);
+      ++records_per_page[page_idx];
+    }
+    for (const size_t count : records_per_page) {
+      ASSERT_LE(count, goal + 2 * epsilon);
+    }
+  }
+  ASSERT_GT(multi_page_segments, 0);
+}
+
 }  // namespace
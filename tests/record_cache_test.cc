@@ -214,4 +214,52 @@ TEST(RecordCacheTest, PreferNonDirtyEviction) {
   }
 }
 
+TEST(RecordCacheTest, PageWriteOutVersion) {
+  // Each "page" holds 100 consecutive keys.
+  const auto key_bounds = [](key_utils::KeyHead key) {
+    const key_utils::KeyHead lower = key / 100 * 100;
+    return std::make_pair(lower, lower + 100);
+  };
+  const auto write_out = [](const WriteOutBatch&) { return Status::OK(); };
+  auto rc = RecordCache(/*capacity=*/10, /*use_lru=*/false, write_out,
+                        key_bounds);
+  const key_utils::IntKeyAsSlice key1(10), key2(20), key3(160);
+  const Slice value = "bbb";
+  const auto page1_version = rc.GetPageWriteOutVersion(key2.as<Slice>());
+  const auto page2_version = rc.GetPageWriteOutVersion(key3.as<Slice>());
+
+  ASSERT_TRUE(rc.Put(key1.as<Slice>(), value, /*is_dirty=*/true).ok());
+  ASSERT_EQ(rc.WriteOutDirty(), 1);
+
+  // Only the written page's version changes.
+  uint64_t index_out;
+  ASSERT_TRUE(rc.PutFromRead(key2.as<Slice>(), value,
+                             RecordCache::kDefaultPriority, &page1_version)
+                  .ok());
+  ASSERT_TRUE(rc.GetCacheIndex(key2.as<Slice>(), false, &index_out)
+                  .IsNotFound());
+  ASSERT_TRUE(rc.PutFromRead(key3.as<Slice>(), value,
+                             RecordCache::kDefaultPriority, &page2_version)
+                  .ok());
+  ASSERT_TRUE(rc.GetCacheIndex(key3.as<Slice>(), false, &index_out).ok());
+  rc.cache_entries[index_out].Unlock();
+
+  // A change in the page's bounds invalidates the version.
+  const auto moved = rc.RecheckPageWriteOutVersion(
+      key2.as<Slice>(), rc.GetPageWriteOutVersion(key3.as<Slice>()));
+  ASSERT_EQ(moved.counter, nullptr);
+}
+
+TEST(RecordCacheTest, PageWriteOutVersionWithoutKeyBounds) {
+  auto rc = RecordCache(/*capacity=*/5);
+  const key_utils::IntKeyAsSlice key(10);
+  const auto version = rc.GetPageWriteOutVersion(key.as<Slice>());
+  ASSERT_TRUE(rc.PutFromRead(key.as<Slice>(), "bbb",
+                             RecordCache::kDefaultPriority, &version)
+                  .ok());
+  uint64_t index_out;
+  ASSERT_TRUE(
+      rc.GetCacheIndex(key.as<Slice>(), false, &index_out).IsNotFound());
+}
+
 }  // namespace
@@ -203,7 +203,11 @@ class MasstreeWrapper {
           num_records_(num_records),
           indices_out_(indices_out),
           cache_entries_(cache_entries),
-          index_locked_already_(index_locked_already) {}
+          index_locked_already_(index_locked_already) {
+      if (cache_entries_ != nullptr && index_locked_already_.has_value()) {
+        locked_key_ = (*cache_entries_)[*index_locked_already_].GetKey();
+      }
+    }
 
     template <typename ScanStackElt, typename Key>
     void visit_leaf(const ScanStackElt& iter, const Key& key, threadinfo&) {
@@ -216,8 +220,7 @@ class MasstreeWrapper {
       }
 
       if (scan_by_length_) {
-        ++scanned_so_far_;
-        lock_and_log(val);
+        if (lock_and_log(key, val)) ++scanned_so_far_;
         return true;
       }
 
@@ -231,7 +234,7 @@ class MasstreeWrapper {
           ((res == 0) && (end_key_length_ > static_cast<std::size_t>(key.len)));
 
       if (smaller_than_end_key || same_as_end_key_but_shorter) {
-        lock_and_log(val);
+        lock_and_log(key, val);
         return true;
       }
 
@@ -239,19 +242,36 @@ class MasstreeWrapper {
     }
 
    private:
-    void lock_and_log(tl::RecordCacheEntry* val) {
+    // Returns false if the entry was skipped because it was evicted (and
+    // possibly reused for a different key) before it could be locked.
+    bool lock_and_log(const Str key, tl::RecordCacheEntry* val) {
       if (cache_entries_ != nullptr) {
         uint64_t index = val->FindIndexWithin(cache_entries_);
-        
+
         if (!index_locked_already_.has_value() ||
-            index_locked_already_.value() != index)
-          val->Lock(/*exclusive = */ false);
+            index_locked_already_.value() != index) {
+          // Entries that precede the already locked entry are only locked if
+          // they are free. Blocking on them could deadlock with a thread that
+          // holds one of them while waiting for the already locked entry.
+          if (index_locked_already_.has_value() &&
+              tl::Slice(key.s, key.len).compare(locked_key_) < 0) {
+            if (!val->TryLock(/*exclusive = */ false)) return false;
+          } else {
+            val->Lock(/*exclusive = */ false);
+          }
+          if (!val->IsValid() ||
+              val->GetKey().compare(tl::Slice(key.s, key.len)) != 0) {
+            val->Unlock();
+            return false;
+          }
+        }
         val->IncrementPriority();
 
         if (indices_out_ != nullptr) {
           indices_out_->emplace_back(index);
         }
       }
+      return true;
     }
 
     const char* const end_key_;
@@ -262,6 +282,8 @@ class MasstreeWrapper {
     std::vector<uint64_t>* indices_out_;
     std::vector<tl::RecordCacheEntry>* cache_entries_;
     std::optional<uint64_t> index_locked_already_;
+    // The key of the entry at `index_locked_already_`, if any.
+    tl::Slice locked_key_;
 
     uint64_t scanned_so_far_ = 0;
   };
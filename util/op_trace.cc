@@ -0,0 +1,192 @@
+#include "util/op_trace.h"
+
+#include <cstring>
+
+namespace {
+
+using namespace tl;
+
+// Identifies trace files (followed by a 4 byte format version).
+const char kTraceMagic[] = "TLOPTRC";
+constexpr uint32_t kTraceVersion = 1;
+constexpr size_t kHeaderSize = sizeof(kTraceMagic) + sizeof(kTraceVersion);
+
+// Used to tell writers apart in `cached_buffer` (a writer's address could be
+// reused after it is destroyed). IDs are never reused.
+std::atomic<uint64_t> next_instance_id(1);
+
+// The calling thread's buffer in the writer it recorded to most recently, so
+// that recording usually does not need the writer's `buffers_mutex_`. The
+// buffer is owned by the writer; it is only used while `instance_id` matches a
+// live writer. The thread-local state does not grow with the number of writers.
+struct CachedBuffer {
+  uint64_t instance_id = 0;
+  void* buffer = nullptr;
+};
+thread_local CachedBuffer cached_buffer;
+
+}  // namespace
+
+namespace tl {
+
+Status OpTraceWriter::Open(const std::filesystem::path& path,
+                           std::unique_ptr<OpTraceWriter>* writer_out) {
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if (!out) {
+    return Status::IOError("Failed to create the trace file:", path.string());
+  }
+  out.write(kTraceMagic, sizeof(kTraceMagic));
+  out.write(reinterpret_cast<const char*>(&kTraceVersion),
+            sizeof(kTraceVersion));
+  if (!out) {
+    return Status::IOError("Failed to write the trace header:", path.string());
+  }
+  writer_out->reset(new OpTraceWriter(std::move(out)));
+  return Status::OK();
+}
+
+OpTraceWriter::OpTraceWriter(std::ofstream out)
+    : instance_id_(next_instance_id++),
+      start_(std::chrono::steady_clock::now()),
+      stop_writer_(false),
+      out_(std::move(out)),
+      write_failed_(false) {
+  writer_ = std::thread(&OpTraceWriter::WriterMain, this);
+}
+
+OpTraceWriter::~OpTraceWriter() {
+  {
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    stop_writer_ = true;
+  }
+  queue_cv_.notify_one();
+  writer_.join();
+  Flush();
+}
+
+void OpTraceWriter::Record(const TraceOp op, const uint64_t key,
+                           const uint32_t value_size,
+                           const uint32_t scan_length) {
+  TraceRecord record;
+  record.timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now() - start_)
+                            .count();
+  record.key = key;
+  record.value_size = value_size;
+  record.scan_length = scan_length;
+  record.op = op;
+
+  ThreadBuffer* const buffer = GetThreadBuffer();
+  record.thread_id = buffer->thread_id;
+  std::unique_lock<std::mutex> lock(buffer->mutex);
+  buffer->records.push_back(record);
+  if (buffer->records.size() >= kBufferedRecords) HandOff(buffer);
+}
+
+Status OpTraceWriter::Flush() {
+  std::unique_lock<std::mutex> file_lock(file_mutex_);
+  {
+    std::unique_lock<std::mutex> lock(buffers_mutex_);
+    for (const auto& buffer : thread_buffers_) {
+      std::unique_lock<std::mutex> buffer_lock(buffer->mutex);
+      if (!buffer->records.empty()) HandOff(buffer.get());
+    }
+  }
+  return WriteQueued();
+}
+
+OpTraceWriter::ThreadBuffer* OpTraceWriter::GetThreadBuffer() {
+  if (cached_buffer.instance_id == instance_id_) {
+    return static_cast<ThreadBuffer*>(cached_buffer.buffer);
+  }
+  std::unique_lock<std::mutex> lock(buffers_mutex_);
+  ThreadBuffer*& buffer = buffer_for_thread_[std::this_thread::get_id()];
+  if (buffer == nullptr) {
+    thread_buffers_.push_back(std::make_unique<ThreadBuffer>(
+        static_cast<uint16_t>(thread_buffers_.size())));
+    thread_buffers_.back()->records.reserve(kBufferedRecords);
+    buffer = thread_buffers_.back().get();
+  }
+  cached_buffer.instance_id = instance_id_;
+  cached_buffer.buffer = buffer;
+  return buffer;
+}
+
+void OpTraceWriter::HandOff(ThreadBuffer* const buffer) {
+  std::vector<TraceRecord> batch;
+  batch.reserve(kBufferedRecords);
+  batch.swap(buffer->records);
+  {
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    queue_.push_back(std::move(batch));
+  }
+  queue_cv_.notify_one();
+}
+
+Status OpTraceWriter::WriteQueued() {
+  std::deque<std::vector<TraceRecord>> batches;
+  {
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    batches.swap(queue_);
+  }
+  for (const auto& batch : batches) {
+    out_.write(reinterpret_cast<const char*>(batch.data()),
+               batch.size() * sizeof(TraceRecord));
+  }
+  if (!batches.empty()) out_.flush();
+  if (!out_) write_failed_ = true;
+  if (write_failed_) {
+    return Status::IOError("Failed to write to the trace file.");
+  }
+  return Status::OK();
+}
+
+void OpTraceWriter::WriterMain() {
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(queue_mutex_);
+      queue_cv_.wait(lock,
+                     [this]() { return stop_writer_ || !queue_.empty(); });
+      if (stop_writer_) return;
+    }
+    // Batches are taken off the queue while `file_mutex_` is held, so each
+    // thread's batches are written in order.
+    std::unique_lock<std::mutex> file_lock(file_mutex_);
+    WriteQueued();
+  }
+}
+
+Status ReadOpTrace(const std::filesystem::path& path,
+                   std::vector<TraceRecord>* records_out) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    return Status::IOError("Failed to open the trace file:", path.string());
+  }
+
+  char header[kHeaderSize];
+  in.read(header, kHeaderSize);
+  if (!in || std::memcmp(header, kTraceMagic, sizeof(kTraceMagic)) != 0) {
+    return Status::Corruption("Not a trace file:", path.string());
+  }
+  uint32_t version;
+  std::memcpy(&version, header + sizeof(kTraceMagic), sizeof(version));
+  if (version != kTraceVersion) {
+    return Status::NotSupported("Unsupported trace file version:",
+                                std::to_string(version));
+  }
+
+  const size_t file_size = std::filesystem::file_size(path);
+  if ((file_size - kHeaderSize) % sizeof(TraceRecord) != 0) {
+    return Status::Corruption("Truncated trace file:", path.string());
+  }
+  records_out->resize((file_size - kHeaderSize) / sizeof(TraceRecord));
+  in.read(reinterpret_cast<char*>(records_out->data()),
+          records_out->size() * sizeof(TraceRecord));
+  if (!in) {
+    records_out->clear();
+    return Status::IOError("Failed to read the trace file:", path.string());
+  }
+  return Status::OK();
+}
+
+}  // namespace tl
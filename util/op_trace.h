@@ -0,0 +1,131 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "treeline/status.h"
+
+namespace tl {
+
+// The operation types recorded in an operation trace.
+enum class TraceOp : uint8_t {
+  // A record inserted by a bulk load. A bulk load is recorded as one
+  // `kBulkLoad` entry per record (in key order).
+  kBulkLoad = 0,
+  kRead = 1,
+  kInsert = 2,
+  kUpdate = 3,
+  kScan = 4,
+  kDelete = 5,
+};
+
+// A traced operation. Trace files store these records back-to-back (in the
+// machine's byte order) after a short header.
+struct TraceRecord {
+  // Time when the operation was issued, in nanoseconds since the trace was
+  // opened.
+  uint64_t timestamp_ns;
+  // For databases with variable length keys, this is the key's 8-byte prefix
+  // (see `key_utils::ExtractHead64()`).
+  uint64_t key;
+  // Set for writes and bulk loaded records; 0 otherwise.
+  uint32_t value_size;
+  // Set for scans; 0 otherwise.
+  uint32_t scan_length;
+  // A dense ID for the thread that issued the operation, assigned in the order
+  // in which the threads first issue an operation. Records with the same
+  // `thread_id` appear in the trace in the order they were issued.
+  uint16_t thread_id;
+  TraceOp op;
+} __attribute__((packed));
+
+// Records the operations issued against a database to a binary trace file (see
+// `ReadOpTrace()` to read the trace back).
+//
+// Each thread buffers its records separately, so recording an operation does
+// not contend with other threads. Full buffers are handed to a background
+// thread that writes them to the file. As a result, records from different
+// threads are not ordered by timestamp in the file.
+//
+// This class' methods are thread-safe.
+class OpTraceWriter {
+ public:
+  // Creates (or truncates) the trace file at `path`.
+  static Status Open(const std::filesystem::path& path,
+                     std::unique_ptr<OpTraceWriter>* writer_out);
+
+  // Flushes any buffered records.
+  ~OpTraceWriter();
+
+  OpTraceWriter(const OpTraceWriter&) = delete;
+  OpTraceWriter& operator=(const OpTraceWriter&) = delete;
+
+  // Records an operation issued by the calling thread.
+  void Record(TraceOp op, uint64_t key, uint32_t value_size = 0,
+              uint32_t scan_length = 0);
+
+  // Writes out the records buffered by all threads.
+  Status Flush();
+
+ private:
+  // The number of records a thread buffers before they are written out.
+  static constexpr size_t kBufferedRecords = 4096;
+
+  // A thread's buffered records. `mutex` is only contended by `Flush()`.
+  struct ThreadBuffer {
+    explicit ThreadBuffer(uint16_t thread_id) : thread_id(thread_id) {}
+    const uint16_t thread_id;
+    std::mutex mutex;
+    std::vector<TraceRecord> records;
+  };
+
+  OpTraceWriter(std::ofstream out);
+  // Returns the calling thread's buffer, creating it if needed.
+  ThreadBuffer* GetThreadBuffer();
+  // Queues the records in `buffer` to be written out.
+  // REQUIRES: `buffer->mutex` is held.
+  void HandOff(ThreadBuffer* buffer);
+  // Writes out all the queued records.
+  // REQUIRES: `file_mutex_` is held.
+  Status WriteQueued();
+  void WriterMain();
+
+  const uint64_t instance_id_;
+  const std::chrono::steady_clock::time_point start_;
+
+  // Protects `thread_buffers_` (which is ordered by thread ID) and
+  // `buffer_for_thread_`. The buffers live as long as the writer.
+  std::mutex buffers_mutex_;
+  std::vector<std::unique_ptr<ThreadBuffer>> thread_buffers_;
+  std::unordered_map<std::thread::id, ThreadBuffer*> buffer_for_thread_;
+
+  // Record batches waiting to be written out. Each thread's batches are
+  // queued in the order in which they were recorded.
+  std::mutex queue_mutex_;
+  std::condition_variable queue_cv_;
+  std::deque<std::vector<TraceRecord>> queue_;
+  bool stop_writer_;
+
+  // Held while writing to `out_`.
+  std::mutex file_mutex_;
+  std::ofstream out_;
+  bool write_failed_;
+
+  std::thread writer_;
+};
+
+// Reads all the records in the trace file at `path` into `records_out`.
+Status ReadOpTrace(const std::filesystem::path& path,
+                   std::vector<TraceRecord>* records_out);
+
+}  // namespace tl